@@ -0,0 +1,46 @@
+/*
+ * SkyOS ARM64 异常帧
+ * 文件: include/exception.h
+ *
+ * boot/start.S的kernel_entry在EL1栈上保存完整的x0-x30、异常前的SP、
+ * ELR_EL1和SPSR_EL1，C处理程序可以读取和修改任何寄存器，
+ * kernel_exit按同一布局恢复后eret。偏移量与start.S中的S_*一致。
+ */
+
+#ifndef _SKYOS_EXCEPTION_H_
+#define _SKYOS_EXCEPTION_H_
+
+#include <stdint.h>
+
+struct pt_regs {
+    uint64_t regs[31];          /* x0-x30 */
+    uint64_t sp;                /* 异常发生前的SP */
+    uint64_t pc;                /* ELR_EL1：返回地址 */
+    uint64_t pstate;            /* SPSR_EL1 */
+};
+
+/* ESR_EL1.EC 异常类别 */
+#define ESR_EC_SHIFT        26
+#define ESR_EC_UNKNOWN      0x00
+#define ESR_EC_FP_ASIMD     0x07
+#define ESR_EC_SVC64        0x15
+#define ESR_EC_IABT_CUR     0x21
+#define ESR_EC_PC_ALIGN     0x22
+#define ESR_EC_DABT_CUR     0x25
+#define ESR_EC_SP_ALIGN     0x26
+#define ESR_EC_BRK64        0x3C
+#define ESR_ISS_MASK        0x1FFFFFF
+
+/* 向量表中的非预期入口 (handle_bad_mode的reason参数) */
+#define BAD_SYNC            0
+#define BAD_IRQ             1
+#define BAD_FIQ             2
+#define BAD_SERROR          3
+
+void handle_sync(struct pt_regs *regs);
+void handle_irq(struct pt_regs *regs);
+void handle_bad_mode(struct pt_regs *regs, uint32_t reason);
+void print_exception_stats(void);
+void test_exceptions(void);
+
+#endif /* _SKYOS_EXCEPTION_H_ */
@@ -0,0 +1,45 @@
+/*
+ * SkyOS ARM64 本地中断屏蔽
+ * 文件: include/irqflags.h
+ *
+ * 通过PSTATE.DAIF的I位屏蔽IRQ；local_irq_save/restore保存并恢复原状态，
+ * 可嵌套使用。
+ */
+
+#ifndef _SKYOS_IRQFLAGS_H_
+#define _SKYOS_IRQFLAGS_H_
+
+#include <stdint.h>
+
+#define DAIF_I_BIT  (1 << 7)
+#define DAIF_F_BIT  (1 << 6)
+
+static inline void local_irq_enable(void) {
+    asm volatile("msr daifclr, #2" : : : "memory");
+}
+
+static inline void local_irq_disable(void) {
+    asm volatile("msr daifset, #2" : : : "memory");
+}
+
+/* 保存DAIF并屏蔽IRQ */
+static inline uint64_t local_irq_save(void) {
+    uint64_t flags;
+    asm volatile("mrs %0, daif\n"
+                 "msr daifset, #2" : "=r"(flags) : : "memory");
+    return flags;
+}
+
+/* 恢复之前保存的IRQ状态 */
+static inline void local_irq_restore(uint64_t flags) {
+    asm volatile("msr daif, %0" : : "r"(flags) : "memory");
+}
+
+/* 当前IRQ是否被屏蔽 */
+static inline int irqs_disabled(void) {
+    uint64_t daif;
+    asm volatile("mrs %0, daif" : "=r"(daif));
+    return (daif & DAIF_I_BIT) != 0;
+}
+
+#endif /* _SKYOS_IRQFLAGS_H_ */
@@ -0,0 +1,52 @@
+/*
+ * SkyOS ARM64 系统调用号与调用包装
+ * 文件: include/syscall.h
+ *
+ * 与ARM32版本相同，系统调用号放在SVC指令的立即数中
+ * (handle_sync从ESR_EL1.ISS取出)，参数通过x0-x3传递，返回值在x0。
+ */
+
+#ifndef _SKYOS_SYSCALL_H_
+#define _SKYOS_SYSCALL_H_
+
+#include <stdint.h>
+#include "exception.h"
+
+/* 系统调用号定义 (与ARM32版本编号一致) */
+#define SYS_INVALID 0
+#define SYS_WRITE   1
+#define SYS_READ    2
+#define SYS_EXIT    3
+#define SYS_GETTIME 4
+#define SYS_PRINT   5
+
+#define SYSCALL_MAX 16
+
+/* 系统调用处理函数 (参数x0-x3，返回值放回x0) */
+typedef uint64_t (*syscall_func_t)(uint64_t, uint64_t, uint64_t, uint64_t);
+
+void handle_svc(uint32_t syscall_num, struct pt_regs *regs);
+void test_syscalls(void);
+void print_syscall_stats(void);
+
+/*
+ * kernel_entry保存并恢复全部通用寄存器，调用方只有x0被改写。
+ */
+#define syscall4(num, a1, a2, a3, a4) ({                                \
+    register uint64_t __x0 asm("x0") = (uint64_t)(a1);                  \
+    register uint64_t __x1 asm("x1") = (uint64_t)(a2);                  \
+    register uint64_t __x2 asm("x2") = (uint64_t)(a3);                  \
+    register uint64_t __x3 asm("x3") = (uint64_t)(a4);                  \
+    asm volatile("svc %[nr]"                                            \
+                 : "+r"(__x0)                                           \
+                 : [nr] "i"(num), "r"(__x1), "r"(__x2), "r"(__x3)       \
+                 : "memory");                                           \
+    __x0;                                                               \
+})
+
+#define syscall3(num, a1, a2, a3)   syscall4(num, a1, a2, a3, 0)
+#define syscall2(num, a1, a2)       syscall4(num, a1, a2, 0, 0)
+#define syscall1(num, a1)           syscall4(num, a1, 0, 0, 0)
+#define syscall0(num)               syscall4(num, 0, 0, 0, 0)
+
+#endif /* _SKYOS_SYSCALL_H_ */
@@ -0,0 +1,26 @@
+/*
+ * SkyOS ARM64 系统寄存器访问
+ * 文件: include/sysreg.h
+ */
+
+#ifndef _SKYOS_SYSREG_H_
+#define _SKYOS_SYSREG_H_
+
+#include <stdint.h>
+
+#define read_sysreg(r) ({                                       \
+    uint64_t __val;                                             \
+    asm volatile("mrs %0, " #r : "=r"(__val));                  \
+    __val;                                                      \
+})
+
+#define write_sysreg(v, r) do {                                 \
+    uint64_t __val = (uint64_t)(v);                             \
+    asm volatile("msr " #r ", %x0" : : "rZ"(__val));            \
+} while (0)
+
+#define isb()       asm volatile("isb" : : : "memory")
+#define dsb(opt)    asm volatile("dsb " #opt : : : "memory")
+#define wfi()       asm volatile("wfi" : : : "memory")
+
+#endif /* _SKYOS_SYSREG_H_ */
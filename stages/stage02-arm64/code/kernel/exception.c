@@ -0,0 +1,191 @@
+/*
+ * SkyOS ARM64 异常处理程序
+ * 文件: kernel/exception.c
+ *
+ * EL1同步异常统一从handle_sync进入，按ESR_EL1.EC分类：
+ * SVC分发到系统调用，BRK用于自检，指令/数据访问异常打印FAR_EL1后停机。
+ * IRQ由gic.c中的handle_irq处理。
+ */
+
+#include <stdint.h>
+#include "exception.h"
+#include "syscall.h"
+#include "sysreg.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_hex(uint32_t value);
+extern void uart_put_dec(uint32_t value);
+extern void uart_put_hex64(uint64_t value);
+
+/* 自检使用的BRK立即数 */
+#define BRK_TEST_IMM    0x42
+
+/* 异常统计计数器 */
+static uint32_t svc_count = 0;
+static uint32_t brk_count = 0;
+static uint32_t iabt_count = 0;
+static uint32_t dabt_count = 0;
+static uint32_t unknown_count = 0;
+static uint32_t bad_mode_count = 0;
+
+static const char *const bad_mode_names[] = {
+    "Synchronous", "IRQ", "FIQ", "SError"
+};
+
+/* 打印异常现场 */
+static void dump_regs(const struct pt_regs *regs) {
+    for (int i = 0; i < 31; i++) {
+        uart_puts(i < 10 ? "  X0" : "  X");
+        uart_put_dec(i);
+        uart_puts(" = ");
+        uart_put_hex64(regs->regs[i]);
+        uart_puts((i & 1) ? "\r\n" : "");
+    }
+    uart_puts("\r\n  SP = ");
+    uart_put_hex64(regs->sp);
+    uart_puts("\r\n  PC = ");
+    uart_put_hex64(regs->pc);
+    uart_puts("\r\n  PSTATE = ");
+    uart_put_hex64(regs->pstate);
+    uart_puts("\r\n");
+}
+
+static void halt(const char *why) {
+    uart_puts(why);
+    uart_puts("****************************************\r\n");
+    while (1) {
+        wfi();
+    }
+}
+
+/* 指令/数据访问异常：打印故障地址和状态后停机 */
+static void handle_abort(struct pt_regs *regs, uint32_t esr, const char *what) {
+    uart_puts("\r\n*** ");
+    uart_puts(what);
+    uart_puts(" ***\r\n");
+    uart_puts("Fault information:\r\n");
+    uart_puts("  Fault Address (FAR_EL1): ");
+    uart_put_hex64(read_sysreg(far_el1));
+    uart_puts("\r\n  Syndrome (ESR_EL1): ");
+    uart_put_hex(esr);
+    uart_puts("\r\n  Fault status (DFSC/IFSC): ");
+    uart_put_hex(esr & 0x3F);
+    uart_puts("\r\n");
+    dump_regs(regs);
+    halt("System halted due to abort.\r\n");
+}
+
+/* EL1同步异常入口 (boot/start.S el1h_sync) */
+void handle_sync(struct pt_regs *regs) {
+    uint32_t esr = (uint32_t)read_sysreg(esr_el1);
+    uint32_t ec = esr >> ESR_EC_SHIFT;
+    uint32_t iss = esr & ESR_ISS_MASK;
+
+    switch (ec) {
+    case ESR_EC_SVC64:
+        /* ELR_EL1已指向svc的下一条指令 */
+        svc_count++;
+        handle_svc(iss & 0xFFFF, regs);
+        return;
+    case ESR_EC_BRK64:
+        brk_count++;
+        if ((iss & 0xFFFF) == BRK_TEST_IMM) {
+            /* 自检：修改帧中的x0，跳过brk返回 */
+            regs->regs[0]++;
+            regs->pc += 4;
+            return;
+        }
+        uart_puts("\r\n*** BRK #");
+        uart_put_hex(iss & 0xFFFF);
+        uart_puts(" ***\r\n");
+        dump_regs(regs);
+        halt("System halted due to breakpoint.\r\n");
+        return;
+    case ESR_EC_IABT_CUR:
+        iabt_count++;
+        handle_abort(regs, esr, "INSTRUCTION ABORT EXCEPTION");
+        return;
+    case ESR_EC_DABT_CUR:
+        dabt_count++;
+        handle_abort(regs, esr, "DATA ABORT EXCEPTION");
+        return;
+    default:
+        unknown_count++;
+        uart_puts("\r\n*** UNHANDLED SYNCHRONOUS EXCEPTION ***\r\n");
+        uart_puts("  ESR_EL1: ");
+        uart_put_hex(esr);
+        uart_puts(" (EC ");
+        uart_put_hex(ec);
+        uart_puts(")\r\n  FAR_EL1: ");
+        uart_put_hex64(read_sysreg(far_el1));
+        uart_puts("\r\n");
+        dump_regs(regs);
+        halt("System halted due to unhandled exception.\r\n");
+    }
+}
+
+/* 向量表中不应到达的入口 (EL0、SP_EL0、FIQ、SError) */
+void handle_bad_mode(struct pt_regs *regs, uint32_t reason) {
+    bad_mode_count++;
+    uart_puts("\r\n*** UNEXPECTED ");
+    uart_puts(bad_mode_names[reason & 3]);
+    uart_puts(" EXCEPTION ***\r\n");
+    uart_puts("  ESR_EL1: ");
+    uart_put_hex((uint32_t)read_sysreg(esr_el1));
+    uart_puts("\r\n");
+    dump_regs(regs);
+    halt("System halted due to unexpected exception.\r\n");
+}
+
+/* 获取异常统计信息 */
+void print_exception_stats(void) {
+    uart_puts("\r\n=== Exception Statistics ===\r\n");
+    uart_puts("System Calls (SVC): "); uart_put_hex(svc_count); uart_puts("\r\n");
+    uart_puts("Breakpoints (BRK): "); uart_put_hex(brk_count); uart_puts("\r\n");
+    uart_puts("Instruction Aborts: "); uart_put_hex(iabt_count); uart_puts("\r\n");
+    uart_puts("Data Aborts: "); uart_put_hex(dabt_count); uart_puts("\r\n");
+    uart_puts("Unknown: "); uart_put_hex(unknown_count); uart_puts("\r\n");
+    uart_puts("Unexpected vectors: "); uart_put_hex(bad_mode_count); uart_puts("\r\n");
+    uart_puts("============================\r\n");
+}
+
+/*
+ * 测试异常处理：brk陷入后处理程序把x0加1并跳过brk。
+ * x9-x15是调用者保存寄存器，C处理程序会随意使用，
+ * 返回后仍保持原值说明kernel_entry/kernel_exit保存了完整的帧。
+ */
+void test_exceptions(void) {
+    register uint64_t x0 asm("x0") = 0x1000;
+    uint64_t x9, x15;
+
+    uart_puts("\r\n=== Testing Exception Handling ===\r\n");
+    asm volatile("mov x9, #0x5a5a\n"
+                 "movk x9, #0xa5a5, lsl #16\n"
+                 "mov x15, #0x1234\n"
+                 "brk %[imm]\n"
+                 "mov %[x9], x9\n"
+                 "mov %[x15], x15"
+                 : "+r"(x0), [x9] "=r"(x9), [x15] "=r"(x15)
+                 : [imm] "i"(BRK_TEST_IMM)
+                 : "x9", "x15", "memory");
+
+    uart_puts("BRK round trip: x0 = ");
+    uart_put_hex64(x0);
+    uart_puts(x0 == 0x1001 ? " (handler ran)" : " (UNEXPECTED)");
+    uart_puts("\r\n  x9 = ");
+    uart_put_hex64(x9);
+    uart_puts(", x15 = ");
+    uart_put_hex64(x15);
+    uart_puts((x9 == 0xa5a55a5a && x15 == 0x1234) ? " (preserved)" : " (CORRUPTED)");
+    uart_puts("\r\n");
+
+    /* 测试数据访问异常 (注释掉，避免系统崩溃) */
+    /*
+    uart_puts("Testing data abort...\r\n");
+    volatile uint32_t *invalid_ptr = (uint32_t *)0xFFFFFFFFFFFFFFF0ULL;
+    *invalid_ptr = 0x12345678;
+    */
+
+    uart_puts("===================================\r\n");
+}
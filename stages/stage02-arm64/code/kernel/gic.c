@@ -0,0 +1,383 @@
+/*
+ * SkyOS ARM GICv3 中断控制器实现
+ * 文件: kernel/gic.c
+ *
+ * GICv3由三部分组成：
+ * 1. 分发器 (GICD)：SPI (INTID 32+) 的使能、优先级和路由 (IROUTER按亲和性)
+ * 2. 重分发器 (GICR)：每个CPU一个，管理该CPU的SGI/PPI (INTID 0-31)
+ * 3. CPU接口：通过ICC_*_EL1系统寄存器访问，应答 (IAR)、结束 (EOIR)、
+ *    发送SGI都是一条mrs/msr，不再像GICv2那样经过内存映射的CPU接口
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "exception.h"
+#include "sysreg.h"
+#include "irqflags.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_hex(uint32_t value);
+extern void uart_put_dec(uint32_t value);
+extern void timer_handle_interrupt(void);
+
+/* QEMU virt machine (gic-version=3) 地址 */
+#define GICD_BASE       0x08000000UL    /* 分发器基址 */
+#define GICR_BASE       0x080A0000UL    /* 第一个重分发器基址 */
+#define GICR_STRIDE     0x20000         /* 每个重分发器：RD_base + SGI_base 两个64KB帧 */
+#define GICR_SGI_OFFSET 0x10000
+
+/* GIC分发器寄存器偏移 */
+#define GICD_CTLR       0x0000  /* 分发器控制寄存器 */
+#define GICD_TYPER      0x0004  /* 分发器类型寄存器 */
+#define GICD_IIDR       0x0008  /* 分发器实现标识寄存器 */
+#define GICD_IGROUPR    0x0080  /* 中断组寄存器 */
+#define GICD_ISENABLER  0x0100  /* 中断使能设置寄存器 */
+#define GICD_ICENABLER  0x0180  /* 中断使能清除寄存器 */
+#define GICD_ICPENDR    0x0280  /* 中断挂起清除寄存器 */
+#define GICD_IPRIORITYR 0x0400  /* 中断优先级寄存器 */
+#define GICD_IROUTER    0x6000  /* SPI路由寄存器 (64位，按INTID) */
+#define GICD_PIDR2      0xFFE8  /* 外设ID2：架构版本 */
+
+#define GICD_CTLR_RWP       (1U << 31)  /* 写操作尚未生效 */
+#define GICD_CTLR_ARE       (1U << 4)   /* 亲和性路由使能 */
+#define GICD_CTLR_GRP1      (1U << 1)
+#define GICD_CTLR_GRP0      (1U << 0)
+
+/* 重分发器寄存器偏移 (RD_base帧) */
+#define GICR_CTLR       0x0000
+#define GICR_IIDR       0x0004
+#define GICR_TYPER      0x0008  /* 64位：[63:32]亲和性，bit4为最后一个 */
+#define GICR_WAKER      0x0014
+
+#define GICR_TYPER_LAST             (1U << 4)
+#define GICR_WAKER_PROCESSOR_SLEEP  (1U << 1)
+#define GICR_WAKER_CHILDREN_ASLEEP  (1U << 2)
+
+/* 重分发器SGI_base帧 (INTID 0-31) */
+#define GICR_IGROUPR0       0x0080
+#define GICR_ISENABLER0     0x0100
+#define GICR_ICENABLER0     0x0180
+#define GICR_ICPENDR0       0x0280
+#define GICR_IPRIORITYR     0x0400
+
+/* 中断号定义 */
+#define GIC_SGI_MAX         16
+#define TIMER_PHYS_IRQ      30      /* EL1物理定时器 (PPI 14) */
+#define GIC_SPURIOUS_IRQ    1020    /* 1020-1023为特殊INTID */
+#define GIC_MAX_IRQ         1020
+
+/* 默认优先级 (数值越小优先级越高) */
+#define GIC_PRIORITY_DEFAULT    0xA0
+#define GIC_PRIORITY_TIMER      0x80
+
+/* SGI延迟测试 */
+#define SGI_TEST_ID         1
+#define SGI_TEST_ROUNDS     64
+
+#define REG32(addr)     (*(volatile uint32_t *)(addr))
+#define REG64(addr)     (*(volatile uint64_t *)(addr))
+
+static uintptr_t gicr_base = 0;     /* 本CPU的重分发器 */
+static uint32_t gic_max_irq = 0;
+static uint32_t gic_version = 0;
+
+/* 中断统计 */
+static uint32_t irq_count = 0;
+static uint32_t spurious_count = 0;
+static uint32_t sgi_count = 0;
+static uint32_t unhandled_count = 0;
+static uint32_t irq_counts[64];     /* INTID 0-63 的分类计数 */
+
+/* SGI延迟测试：发送时刻和处理程序记录的到达时刻 (PMCCNTR_EL0) */
+static volatile uint64_t sgi_sent_cycles = 0;
+static volatile uint64_t sgi_seen_cycles = 0;
+
+static inline void pmu_cycle_enable(void) {
+    /* PMCR_EL0.E | C (复位周期计数器)，PMCNTENSET_EL0.C */
+    write_sysreg(read_sysreg(pmcr_el0) | (1 << 0) | (1 << 2), pmcr_el0);
+    write_sysreg(1UL << 31, pmcntenset_el0);
+    isb();
+}
+
+static inline uint64_t pmu_cycles(void) {
+    isb();
+    return read_sysreg(pmccntr_el0);
+}
+
+/* 等待分发器的寄存器写入生效 */
+static void gicd_wait_rwp(void) {
+    while (REG32(GICD_BASE + GICD_CTLR) & GICD_CTLR_RWP) {
+        /* 空等待 */
+    }
+}
+
+/* 按MPIDR亲和性查找本CPU的重分发器 */
+static uintptr_t gicr_find(void) {
+    uint64_t mpidr = read_sysreg(mpidr_el1);
+    uint32_t aff = (uint32_t)(((mpidr >> 32) & 0xFF) << 24) | (uint32_t)(mpidr & 0xFFFFFF);
+    uintptr_t rd = GICR_BASE;
+
+    for (;;) {
+        uint64_t typer = REG64(rd + GICR_TYPER);
+        if ((uint32_t)(typer >> 32) == aff) {
+            return rd;
+        }
+        if (typer & GICR_TYPER_LAST) {
+            return 0;
+        }
+        rd += GICR_STRIDE;
+    }
+}
+
+/* 唤醒重分发器：清ProcessorSleep并等待ChildrenAsleep清零 */
+static void gicr_wake(uintptr_t rd) {
+    REG32(rd + GICR_WAKER) &= ~GICR_WAKER_PROCESSOR_SLEEP;
+    while (REG32(rd + GICR_WAKER) & GICR_WAKER_CHILDREN_ASLEEP) {
+        /* 空等待 */
+    }
+}
+
+static void gic_set_priority(uint32_t irq_id, uint8_t priority) {
+    uintptr_t base = irq_id < 32 ? gicr_base + GICR_SGI_OFFSET : GICD_BASE;
+    *(volatile uint8_t *)(base + GICD_IPRIORITYR + irq_id) = priority;
+}
+
+/* 使能中断：SGI/PPI在本CPU的重分发器中，SPI在分发器中 */
+void gic_enable_interrupt(uint32_t irq_id) {
+    if (irq_id < 32) {
+        REG32(gicr_base + GICR_SGI_OFFSET + GICR_ISENABLER0) = 1U << irq_id;
+    } else if (irq_id < gic_max_irq) {
+        REG32(GICD_BASE + GICD_ISENABLER + (irq_id / 32) * 4) = 1U << (irq_id % 32);
+    }
+}
+
+void gic_disable_interrupt(uint32_t irq_id) {
+    if (irq_id < 32) {
+        REG32(gicr_base + GICR_SGI_OFFSET + GICR_ICENABLER0) = 1U << irq_id;
+    } else if (irq_id < gic_max_irq) {
+        REG32(GICD_BASE + GICD_ICENABLER + (irq_id / 32) * 4) = 1U << (irq_id % 32);
+        gicd_wait_rwp();
+    }
+}
+
+/* 发送SGI到本CPU (ICC_SGI1R_EL1：TargetList为Aff0位图，Aff1-3取自MPIDR) */
+void gic_send_sgi(uint32_t sgi_id) {
+    uint64_t mpidr = read_sysreg(mpidr_el1);
+    uint64_t val = (1UL << (mpidr & 0xF)) |
+                   (((mpidr >> 8) & 0xFF) << 16) |
+                   ((uint64_t)(sgi_id & 0xF) << 24) |
+                   (((mpidr >> 16) & 0xFF) << 32) |
+                   (((mpidr >> 32) & 0xFF) << 48);
+
+    write_sysreg(val, icc_sgi1r_el1);
+    isb();
+}
+
+/* 初始化GICv3 */
+void gic_init(void) {
+    uint32_t typer;
+
+    uart_puts("初始化GICv3中断控制器...\r\n");
+
+    /* 1. 使用系统寄存器接口 (EL2已经放开ICC_SRE_EL1) */
+    write_sysreg(read_sysreg(icc_sre_el1) | 1, icc_sre_el1);
+    isb();
+
+    /* 2. 分发器：先关闭，所有SPI设为Group1、默认优先级、路由到本CPU */
+    REG32(GICD_BASE + GICD_CTLR) = 0;
+    gicd_wait_rwp();
+    typer = REG32(GICD_BASE + GICD_TYPER);
+    gic_max_irq = ((typer & 0x1F) + 1) * 32;
+    if (gic_max_irq > GIC_MAX_IRQ) {
+        gic_max_irq = GIC_MAX_IRQ;
+    }
+    gic_version = (REG32(GICD_BASE + GICD_PIDR2) >> 4) & 0xF;
+
+    for (uint32_t i = 32; i < gic_max_irq; i += 32) {
+        REG32(GICD_BASE + GICD_ICENABLER + (i / 32) * 4) = 0xFFFFFFFF;
+        REG32(GICD_BASE + GICD_ICPENDR + (i / 32) * 4) = 0xFFFFFFFF;
+        REG32(GICD_BASE + GICD_IGROUPR + (i / 32) * 4) = 0xFFFFFFFF;
+    }
+    for (uint32_t i = 32; i < gic_max_irq; i++) {
+        *(volatile uint8_t *)(GICD_BASE + GICD_IPRIORITYR + i) = GIC_PRIORITY_DEFAULT;
+        REG64(GICD_BASE + GICD_IROUTER + i * 8) = read_sysreg(mpidr_el1) & 0xFF00FFFFFFUL;
+    }
+    gicd_wait_rwp();
+    REG32(GICD_BASE + GICD_CTLR) = GICD_CTLR_ARE | GICD_CTLR_GRP1 | GICD_CTLR_GRP0;
+    gicd_wait_rwp();
+
+    /* 3. 重分发器：唤醒，SGI/PPI设为Group1、默认优先级 */
+    gicr_base = gicr_find();
+    if (gicr_base == 0) {
+        uart_puts("❌ 找不到本CPU的GIC重分发器\r\n");
+        return;
+    }
+    gicr_wake(gicr_base);
+    REG32(gicr_base + GICR_SGI_OFFSET + GICR_ICENABLER0) = 0xFFFFFFFF;
+    REG32(gicr_base + GICR_SGI_OFFSET + GICR_ICPENDR0) = 0xFFFFFFFF;
+    REG32(gicr_base + GICR_SGI_OFFSET + GICR_IGROUPR0) = 0xFFFFFFFF;
+    for (uint32_t i = 0; i < 32; i++) {
+        gic_set_priority(i, GIC_PRIORITY_DEFAULT);
+    }
+
+    /* 4. CPU接口：放行所有优先级，不分组抢占，EOI同时降优先级和去激活 */
+    write_sysreg(0xFF, icc_pmr_el1);
+    write_sysreg(0, icc_bpr1_el1);
+    write_sysreg(0, icc_ctlr_el1);
+    write_sysreg(1, icc_igrpen1_el1);
+    isb();
+
+    /* 5. SGI用于延迟测试 */
+    gic_enable_interrupt(SGI_TEST_ID);
+    pmu_cycle_enable();
+
+    uart_puts("✅ GICv3初始化完成 (最大中断号: ");
+    uart_put_dec(gic_max_irq);
+    uart_puts(")\r\n");
+}
+
+/* 定时器PPI：提高优先级并使能 */
+void gic_setup_timer_irq(void) {
+    gic_set_priority(TIMER_PHYS_IRQ, GIC_PRIORITY_TIMER);
+    gic_enable_interrupt(TIMER_PHYS_IRQ);
+}
+
+/* IRQ异常入口 (boot/start.S el1h_irq)：应答、分发、结束 */
+void handle_irq(struct pt_regs *regs) {
+    uint32_t irq_id = (uint32_t)read_sysreg(icc_iar1_el1) & 0xFFFFFF;
+
+    (void)regs;
+    if (irq_id >= GIC_SPURIOUS_IRQ && irq_id <= 1023) {
+        spurious_count++;
+        return;
+    }
+    irq_count++;
+    if (irq_id < 64) {
+        irq_counts[irq_id]++;
+    }
+
+    if (irq_id < GIC_SGI_MAX) {
+        sgi_count++;
+        if (irq_id == SGI_TEST_ID) {
+            sgi_seen_cycles = pmu_cycles();
+        }
+    } else if (irq_id == TIMER_PHYS_IRQ) {
+        timer_handle_interrupt();
+    } else {
+        unhandled_count++;
+        uart_puts("⚠️  未处理的中断: ");
+        uart_put_dec(irq_id);
+        uart_puts("\r\n");
+    }
+
+    write_sysreg(irq_id, icc_eoir1_el1);
+    isb();
+}
+
+/*
+ * SGI往返延迟：写ICC_SGI1R_EL1到处理程序读到中断号之间的周期数，
+ * 整个路径上没有一次对GIC CPU接口的内存映射访问
+ */
+void gic_test_sgi(void) {
+    uint64_t total = 0, min = ~0UL, max = 0;
+    uint32_t ok = 0;
+
+    uart_puts("\r\n=== GICv3 SGI延迟测试 ===\r\n");
+    for (uint32_t i = 0; i < SGI_TEST_ROUNDS; i++) {
+        uint64_t flags = local_irq_save();
+        sgi_seen_cycles = 0;
+        sgi_sent_cycles = pmu_cycles();
+        gic_send_sgi(SGI_TEST_ID);
+        local_irq_restore(flags);
+
+        for (uint32_t spin = 0; spin < 100000 && sgi_seen_cycles == 0; spin++) {
+            /* 等待处理程序记录到达时刻 */
+        }
+        if (sgi_seen_cycles == 0) {
+            continue;
+        }
+        uint64_t d = sgi_seen_cycles - sgi_sent_cycles;
+        total += d;
+        min = d < min ? d : min;
+        max = d > max ? d : max;
+        ok++;
+    }
+    uart_puts("完成: ");
+    uart_put_dec(ok);
+    uart_puts("/");
+    uart_put_dec(SGI_TEST_ROUNDS);
+    if (ok) {
+        uart_puts(", 周期 平均 ");
+        uart_put_dec((uint32_t)(total / ok));
+        uart_puts(" 最小 ");
+        uart_put_dec((uint32_t)min);
+        uart_puts(" 最大 ");
+        uart_put_dec((uint32_t)max);
+    }
+    uart_puts("\r\n=========================\r\n");
+}
+
+/* 打印GIC状态 */
+void gic_print_status(void) {
+    uart_puts("\r\n=== GICv3 状态 ===\r\n");
+    uart_puts("GICD_CTLR: ");
+    uart_put_hex(REG32(GICD_BASE + GICD_CTLR));
+    uart_puts("\r\nGICR基址: ");
+    uart_put_hex((uint32_t)gicr_base);
+    if (gicr_base) {
+        uart_puts("\r\nGICR_WAKER: ");
+        uart_put_hex(REG32(gicr_base + GICR_WAKER));
+        uart_puts("\r\nSGI/PPI使能: ");
+        uart_put_hex(REG32(gicr_base + GICR_SGI_OFFSET + GICR_ISENABLER0));
+    }
+    uart_puts("\r\nICC_PMR_EL1: ");
+    uart_put_hex((uint32_t)read_sysreg(icc_pmr_el1));
+    uart_puts("\r\nICC_IGRPEN1_EL1: ");
+    uart_put_hex((uint32_t)read_sysreg(icc_igrpen1_el1));
+    uart_puts("\r\nICC_RPR_EL1 (运行优先级): ");
+    uart_put_hex((uint32_t)read_sysreg(icc_rpr_el1));
+    uart_puts("\r\n==================\r\n");
+}
+
+/* 打印中断统计 */
+void gic_print_interrupt_stats(void) {
+    uart_puts("\r\n=== 中断统计 ===\r\n");
+    uart_puts("总中断数: ");
+    uart_put_dec(irq_count);
+    uart_puts(", SGI: ");
+    uart_put_dec(sgi_count);
+    uart_puts(", 伪中断: ");
+    uart_put_dec(spurious_count);
+    uart_puts(", 未处理: ");
+    uart_put_dec(unhandled_count);
+    uart_puts("\r\n");
+    for (uint32_t i = 0; i < 64; i++) {
+        if (irq_counts[i]) {
+            uart_puts("  INTID ");
+            uart_put_dec(i);
+            uart_puts(": ");
+            uart_put_dec(irq_counts[i]);
+            uart_puts("\r\n");
+        }
+    }
+    uart_puts("================\r\n");
+}
+
+/* 打印GIC版本信息 */
+void gic_print_version_info(void) {
+    uint32_t iidr = REG32(GICD_BASE + GICD_IIDR);
+
+    uart_puts("\r\n=== GIC版本信息 ===\r\n");
+    uart_puts("架构版本: GICv");
+    uart_put_dec(gic_version);
+    uart_puts("\r\nGICD_IIDR: ");
+    uart_put_hex(iidr);
+    uart_puts(" (实现者 ");
+    uart_put_hex(iidr & 0xFFF);
+    uart_puts(")\r\n支持中断数: ");
+    uart_put_dec(gic_max_irq);
+    uart_puts("\r\nCPU接口: 系统寄存器 (ICC_SRE_EL1 = ");
+    uart_put_hex((uint32_t)read_sysreg(icc_sre_el1));
+    uart_puts(")\r\n===================\r\n");
+}
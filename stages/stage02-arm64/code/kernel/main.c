@@ -0,0 +1,184 @@
+/*
+ * SkyOS ARM64 主函数 - 阶段2：异常处理与中断
+ * 文件: kernel/main.c
+ *
+ * 这是EL1内核的C语言入口点，在boot/start.S完成EL2->EL1切换、
+ * 设置向量表和清零BSS之后调用。功能：
+ * 1. PL011串口输出
+ * 2. 演示异常处理机制 (BRK往返、完整寄存器帧)
+ * 3. 测试系统调用功能 (SVC)
+ * 4. 初始化GICv3和Generic Timer，测量SGI延迟
+ * 5. 基础的内核主循环
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "exception.h"
+#include "syscall.h"
+#include "sysreg.h"
+#include "irqflags.h"
+
+/* QEMU virt machine UART0 */
+#define UART0_BASE      0x09000000UL
+#define UART_DR         (UART0_BASE + 0x00)     /* 数据寄存器 */
+#define UART_FR         (UART0_BASE + 0x18)     /* 标志寄存器 */
+#define UART_FR_TXFF    (1 << 5)                /* 发送FIFO满 */
+
+/* 简单的寄存器读写宏 */
+#define REG(addr) (*(volatile uint32_t *)(addr))
+
+/* 外部函数声明 */
+extern void enable_irq(void);
+extern void disable_irq(void);
+extern uint64_t boot_dtb_addr;
+
+/* 定时器和GIC函数声明 */
+extern void gic_init(void);
+extern void gic_test_sgi(void);
+extern void gic_print_status(void);
+extern void gic_print_interrupt_stats(void);
+extern void gic_print_version_info(void);
+extern void timer_init(void);
+extern void timer_print_status(void);
+extern void timer_delay_ms(uint32_t milliseconds);
+extern uint32_t timer_get_interrupt_count(void);
+extern uint32_t get_timer_ticks(void);
+
+/* UART输出字符函数 */
+void uart_putc(char c) {
+    /* 等待发送FIFO不满 */
+    while (REG(UART_FR) & UART_FR_TXFF) {
+        /* 空等待 */
+    }
+
+    /* 发送字符 */
+    REG(UART_DR) = c;
+}
+
+/* UART输出字符串函数 */
+void uart_puts(const char *str) {
+    while (*str) {
+        uart_putc(*str++);
+    }
+}
+
+/* 输出十六进制数字 */
+void uart_put_hex(uint32_t value) {
+    const char hex_chars[] = "0123456789ABCDEF";
+
+    uart_puts("0x");
+    for (int i = 28; i >= 0; i -= 4) {
+        uart_putc(hex_chars[(value >> i) & 0xF]);
+    }
+}
+
+/* 输出64位十六进制数字 */
+void uart_put_hex64(uint64_t value) {
+    const char hex_chars[] = "0123456789ABCDEF";
+
+    uart_puts("0x");
+    for (int i = 60; i >= 0; i -= 4) {
+        uart_putc(hex_chars[(value >> i) & 0xF]);
+    }
+}
+
+/* 输出十进制数字 */
+void uart_put_dec(uint32_t value) {
+    char buf[11];
+    int i = 10;
+
+    buf[i] = '\0';
+    do {
+        buf[--i] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    uart_puts(&buf[i]);
+}
+
+/* 打印CPU信息 */
+static void print_cpu_info(void) {
+    uint64_t midr = read_sysreg(midr_el1);
+    uint64_t mpidr = read_sysreg(mpidr_el1);
+    uint64_t el = (read_sysreg(CurrentEL) >> 2) & 3;
+
+    uart_puts("\r\n=== CPU信息 ===\r\n");
+    uart_puts("异常级别: EL");
+    uart_put_dec((uint32_t)el);
+    uart_puts("\r\nMIDR_EL1: ");
+    uart_put_hex((uint32_t)midr);
+    uart_puts(" (实现者 ");
+    uart_put_hex((uint32_t)(midr >> 24) & 0xFF);
+    uart_puts(", 型号 ");
+    uart_put_hex((uint32_t)(midr >> 4) & 0xFFF);
+    uart_puts(")\r\nMPIDR_EL1: ");
+    uart_put_hex64(mpidr);
+    uart_puts("\r\nVBAR_EL1: ");
+    uart_put_hex64(read_sysreg(vbar_el1));
+    uart_puts("\r\n设备树地址: ");
+    uart_put_hex64(boot_dtb_addr);
+    uart_puts("\r\n===============\r\n");
+}
+
+/* 主函数 */
+int main(void) {
+    uart_puts("\r\n");
+    uart_puts("========================================\r\n");
+    uart_puts("  SkyOS ARM64 阶段2：异常处理与中断\r\n");
+    uart_puts("========================================\r\n");
+
+    print_cpu_info();
+
+    /* 异常和系统调用在打开中断之前验证 */
+    test_exceptions();
+    test_syscalls();
+
+    gic_init();
+    gic_print_version_info();
+    timer_init();
+
+    uart_puts("启用IRQ中断...\r\n");
+    enable_irq();
+
+    gic_test_sgi();
+    gic_print_status();
+
+    uint32_t counter = 0;
+    while (1) {
+        timer_delay_ms(1000);
+        counter++;
+
+        uart_puts("\r\n💓 主程序心跳 #");
+        uart_put_hex(counter);
+        uart_puts("\r\n");
+
+        /* 每5次心跳显示详细统计信息 */
+        if (counter % 5 == 0) {
+            print_exception_stats();
+            print_syscall_stats();
+            gic_print_interrupt_stats();
+            timer_print_status();
+        } else {
+            /* 简单状态显示 */
+            uart_puts("  定时器中断数: ");
+            uart_put_hex(timer_get_interrupt_count());
+            uart_puts("\r\n");
+        }
+
+        /* 每10次心跳测试一次系统调用 */
+        if (counter % 10 == 0) {
+            uart_puts("\r\n--- 定期系统调用测试 ---\r\n");
+            uint64_t result = syscall0(SYS_GETTIME);
+            uart_puts("当前系统时间: ");
+            uart_put_hex((uint32_t)result);
+            uart_puts(" 滴答\r\n");
+            uart_puts("----------------------------\r\n");
+        }
+
+        /* 每20次心跳显示GIC状态 */
+        if (counter % 20 == 0) {
+            gic_print_status();
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,194 @@
+/*
+ * SkyOS ARM64 系统调用实现
+ * 文件: kernel/syscall.c
+ *
+ * handle_sync识别出SVC后调用handle_svc，参数和返回值直接在异常帧的x0-x3中读写
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "syscall.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_putc(char c);
+extern void uart_put_hex(uint32_t value);
+extern void uart_put_hex64(uint64_t value);
+extern uint32_t get_timer_ticks(void);
+
+/* 系统调用统计 */
+static uint32_t syscall_counts[SYSCALL_MAX] = {0};
+static uint32_t total_syscalls = 0;
+
+/* 系统调用：写数据到控制台 (fd 1/2) */
+static uint64_t sys_write(uint64_t fd, uint64_t buf, uint64_t count) {
+    const char *p = (const char *)buf;
+
+    if (fd != 1 && fd != 2) {
+        return (uint64_t)-1;
+    }
+    for (uint64_t i = 0; i < count; i++) {
+        uart_putc(p[i]);
+    }
+    return count;
+}
+
+/* 系统调用：从控制台读取 (尚无输入驱动，返回固定字符串) */
+static uint64_t sys_read(uint64_t fd, uint64_t buf, uint64_t count) {
+    static const char msg[] = "test input";
+    char *p = (char *)buf;
+    uint64_t n = 0;
+
+    if (fd != 0 || count == 0) {
+        return (uint64_t)-1;
+    }
+    while (n < count - 1 && msg[n]) {
+        p[n] = msg[n];
+        n++;
+    }
+    p[n] = '\0';
+    return n;
+}
+
+/* 系统调用：退出程序 */
+static uint64_t sys_exit(uint64_t exit_code) {
+    uart_puts("\r\n=== Program Exit ===\r\n");
+    uart_puts("Exit code: ");
+    uart_put_hex((uint32_t)exit_code);
+    uart_puts("\r\n");
+    uart_puts("System halted by user exit.\r\n");
+    while (1) {
+        asm volatile("wfi");
+    }
+    return 0;
+}
+
+/* 系统调用：获取系统时间 */
+static uint64_t sys_gettime(void) {
+    return get_timer_ticks();
+}
+
+/* 系统调用：打印字符串 (便利函数) */
+static uint64_t sys_print(uint64_t str) {
+    const char *s = (const char *)str;
+    uint64_t len = 0;
+
+    while (s[len]) {
+        len++;
+    }
+    return sys_write(1, str, len);
+}
+
+struct syscall_desc {
+    syscall_func_t fn;
+    const char *name;
+};
+
+#define SYSCALL_DESC(nr, f, n)  [nr] = { .fn = (syscall_func_t)(f), .name = (n) }
+
+static const struct syscall_desc syscall_table[SYSCALL_MAX] = {
+    SYSCALL_DESC(SYS_WRITE,   sys_write,   "write"),
+    SYSCALL_DESC(SYS_READ,    sys_read,    "read"),
+    SYSCALL_DESC(SYS_EXIT,    sys_exit,    "exit"),
+    SYSCALL_DESC(SYS_GETTIME, sys_gettime, "gettime"),
+    SYSCALL_DESC(SYS_PRINT,   sys_print,   "print"),
+};
+
+/* SVC处理函数 (handle_sync中调用) */
+void handle_svc(uint32_t syscall_num, struct pt_regs *regs) {
+    uint64_t result = (uint64_t)-1;     /* 默认返回错误 */
+    syscall_func_t fn = NULL;
+
+    total_syscalls++;
+    if (syscall_num < SYSCALL_MAX) {
+        syscall_counts[syscall_num]++;
+        fn = syscall_table[syscall_num].fn;
+    }
+
+    /* 调试输出 */
+    uart_puts("SVC #");
+    uart_put_hex(syscall_num);
+    if (fn) {
+        uart_puts(" (");
+        uart_puts(syscall_table[syscall_num].name);
+        uart_puts(")");
+    }
+    uart_puts(" called with args: ");
+    uart_put_hex64(regs->regs[0]);
+    uart_puts(", ");
+    uart_put_hex64(regs->regs[1]);
+    uart_puts(", ");
+    uart_put_hex64(regs->regs[2]);
+    uart_puts("\r\n");
+
+    if (fn != NULL) {
+        result = fn(regs->regs[0], regs->regs[1], regs->regs[2], regs->regs[3]);
+    } else {
+        uart_puts("ERROR: Unknown system call number: ");
+        uart_put_hex(syscall_num);
+        uart_puts("\r\n");
+    }
+
+    /* 将返回值放入x0 */
+    regs->regs[0] = result;
+}
+
+/* 测试系统调用 */
+void test_syscalls(void) {
+    uart_puts("\r\n=== Testing System Calls ===\r\n");
+
+    const char *msg1 = "Hello from syscall write!\r\n";
+    uint64_t result1 = syscall3(SYS_WRITE, 1, msg1, 27);
+    uart_puts("Write syscall returned: ");
+    uart_put_hex((uint32_t)result1);
+    uart_puts("\r\n");
+
+    const char *msg2 = "Hello from syscall print!\r\n";
+    uint64_t result2 = syscall1(SYS_PRINT, msg2);
+    uart_puts("Print syscall returned: ");
+    uart_put_hex((uint32_t)result2);
+    uart_puts("\r\n");
+
+    uint64_t time = syscall0(SYS_GETTIME);
+    uart_puts("Current time from syscall: ");
+    uart_put_hex((uint32_t)time);
+    uart_puts(" ticks\r\n");
+
+    char buffer[64];
+    uint64_t result4 = syscall3(SYS_READ, 0, buffer, sizeof(buffer));
+    uart_puts("Read syscall returned: ");
+    uart_put_hex((uint32_t)result4);
+    uart_puts(" bytes: \"");
+    uart_puts(buffer);
+    uart_puts("\"\r\n");
+
+    uint64_t result5 = syscall0(9);
+    uart_puts("Invalid syscall returned: ");
+    uart_put_hex64(result5);
+    uart_puts("\r\n");
+
+    uart_puts("=============================\r\n");
+}
+
+/* 获取系统调用统计信息 */
+void print_syscall_stats(void) {
+    uart_puts("\r\n=== System Call Statistics ===\r\n");
+    uart_puts("Total system calls: ");
+    uart_put_hex(total_syscalls);
+    uart_puts("\r\n");
+    for (uint32_t i = 1; i < SYSCALL_MAX; i++) {
+        if (syscall_counts[i] > 0) {
+            uart_puts("  ");
+            if (syscall_table[i].name) {
+                uart_puts(syscall_table[i].name);
+            } else {
+                uart_puts("syscall_");
+                uart_put_hex(i);
+            }
+            uart_puts(": ");
+            uart_put_hex(syscall_counts[i]);
+            uart_puts(" calls\r\n");
+        }
+    }
+    uart_puts("==============================\r\n");
+}
@@ -0,0 +1,144 @@
+/*
+ * SkyOS ARM64 Generic Timer实现
+ * 文件: kernel/timer.c
+ *
+ * 使用EL1物理定时器 (CNTP_*_EL0)，100Hz周期中断，INTID 30。
+ * 寄存器访问都是mrs/msr，EL2已在boot/start.S中放开EL1的访问权限。
+ */
+
+#include <stdint.h>
+#include "sysreg.h"
+#include "irqflags.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_hex(uint32_t value);
+extern void uart_put_hex64(uint64_t value);
+extern void uart_put_dec(uint32_t value);
+extern void gic_setup_timer_irq(void);
+
+/* CNTP_CTL_EL0 控制位 */
+#define CNTP_CTL_ENABLE     (1 << 0)
+#define CNTP_CTL_IMASK      (1 << 1)
+#define CNTP_CTL_ISTATUS    (1 << 2)
+
+#define TIMER_HZ            100
+
+static uint32_t timer_frequency = 0;
+static uint32_t timer_interval = 0;
+static volatile uint32_t timer_ticks = 0;
+static volatile uint32_t timer_interrupts = 0;
+
+uint32_t timer_get_frequency(void) {
+    return (uint32_t)read_sysreg(cntfrq_el0);
+}
+
+uint64_t timer_get_counter(void) {
+    isb();
+    return read_sysreg(cntpct_el0);
+}
+
+static inline void timer_set_tval(uint32_t tval) {
+    write_sysreg(tval, cntp_tval_el0);
+}
+
+/* 初始化定时器：每10ms一次中断 */
+void timer_init(void) {
+    uart_puts("初始化ARM Generic Timer...\r\n");
+
+    timer_frequency = timer_get_frequency();
+    timer_interval = timer_frequency / TIMER_HZ;
+
+    uart_puts("定时器频率: ");
+    uart_put_dec(timer_frequency);
+    uart_puts(" Hz, 间隔: ");
+    uart_put_dec(timer_interval);
+    uart_puts(" 计数\r\n");
+
+    timer_set_tval(timer_interval);
+    write_sysreg(CNTP_CTL_ENABLE, cntp_ctl_el0);
+    isb();
+    gic_setup_timer_irq();
+
+    uart_puts("✅ 定时器初始化完成\r\n");
+}
+
+/* 定时器中断处理函数 */
+void timer_handle_interrupt(void) {
+    timer_interrupts++;
+    timer_ticks++;
+
+    /* 重新设置下次中断 (写TVAL同时清除ISTATUS) */
+    timer_set_tval(timer_interval);
+
+    /* 每秒输出一次统计信息 (100次中断 = 1秒) */
+    if (timer_ticks % TIMER_HZ == 0) {
+        uart_puts("⏰ 定时器: ");
+        uart_put_dec(timer_ticks / TIMER_HZ);
+        uart_puts("秒 (");
+        uart_put_dec(timer_ticks);
+        uart_puts(" 滴答)\r\n");
+    }
+}
+
+/* 获取当前滴答数 */
+uint32_t get_timer_ticks(void) {
+    return timer_ticks;
+}
+
+/* 获取定时器中断计数 */
+uint32_t timer_get_interrupt_count(void) {
+    return timer_interrupts;
+}
+
+/* 延时函数：IRQ打开时wfi等待定时器中断，否则忙等计数器 */
+void timer_delay_ms(uint32_t milliseconds) {
+    uint32_t target = timer_ticks + milliseconds / (1000 / TIMER_HZ);
+
+    if (irqs_disabled()) {
+        uint64_t end = timer_get_counter() +
+                       (uint64_t)milliseconds * (timer_frequency / 1000);
+        while (timer_get_counter() < end) {
+            /* 空等待 */
+        }
+        return;
+    }
+    while ((int32_t)(timer_ticks - target) < 0) {
+        wfi();
+    }
+}
+
+/* 获取定时器状态信息 */
+void timer_print_status(void) {
+    uint32_t ctl = (uint32_t)read_sysreg(cntp_ctl_el0);
+
+    uart_puts("\r\n=== ARM Generic Timer 状态 ===\r\n");
+    uart_puts("频率: ");
+    uart_put_dec(timer_frequency);
+    uart_puts(" Hz\r\n");
+
+    uart_puts("控制寄存器: ");
+    uart_put_hex(ctl);
+    uart_puts(" (");
+    uart_puts((ctl & CNTP_CTL_ENABLE) ? "启用" : "禁用");
+    uart_puts((ctl & CNTP_CTL_IMASK) ? ", 中断屏蔽" : ", 中断使能");
+    if (ctl & CNTP_CTL_ISTATUS) {
+        uart_puts(", 中断挂起");
+    }
+    uart_puts(")\r\n");
+
+    uart_puts("定时器值: ");
+    uart_put_hex((uint32_t)read_sysreg(cntp_tval_el0));
+    uart_puts("\r\n物理计数器: ");
+    uart_put_hex64(timer_get_counter());
+    uart_puts("\r\n总滴答数: ");
+    uart_put_dec(timer_ticks);
+    uart_puts("\r\n中断次数: ");
+    uart_put_dec(timer_interrupts);
+    uart_puts("\r\n运行时间: ");
+    uart_put_dec(timer_ticks / TIMER_HZ);
+    uart_puts(".");
+    uart_put_dec((timer_ticks % TIMER_HZ) / 10);
+    uart_puts(" 秒\r\n");
+    uart_puts("=============================\r\n");
+}
@@ -0,0 +1,215 @@
+/*
+ * SkyOS 主机测试环境：假GIC v2
+ * 文件: host/fake_gic.c
+ *
+ * 只模拟内核用到的行为：使能/挂起的置位/清除寄存器、优先级和目标字节、
+ * SGIR、IAR按中断号从小到大确认挂起且使能的中断、EOIR结束中断。
+ * 其余寄存器写入什么读回什么。单CPU，不模拟优先级抢占。
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "hal_host.h"
+
+/* 外部函数声明 */
+extern void handle_irq(uint32_t *frame);
+
+#define GICD_CTLR       0x000
+#define GICD_TYPER      0x004
+#define GICD_IIDR       0x008
+#define GICD_ISENABLER  0x100
+#define GICD_ICENABLER  0x180
+#define GICD_ISPENDR    0x200
+#define GICD_ICPENDR    0x280
+#define GICD_IPRIORITYR 0x400
+#define GICD_ITARGETSR  0x800
+#define GICD_SGIR       0xF00
+
+#define GICC_CTLR       0x000
+#define GICC_IAR        0x00C
+#define GICC_EOIR       0x010
+#define GICC_RPR        0x014
+#define GICC_HPPIR      0x018
+
+#define GIC_SPURIOUS    1023
+#define NR_WORDS        (HOST_GIC_NR_IRQS / 32)
+
+struct fake_gic {
+    uint32_t dist_ctlr, cpu_ctlr;
+    uint32_t enabled[NR_WORDS];
+    uint32_t pending[NR_WORDS];
+    uint32_t active[NR_WORDS];
+    uint8_t priority[HOST_GIC_NR_IRQS];
+    uint8_t target[HOST_GIC_NR_IRQS];
+    uint32_t dist_regs[0x1000 / 4];     /* 其他分发器寄存器 */
+    uint32_t cpu_regs[0x100 / 4];       /* 其他CPU接口寄存器 */
+    uint32_t last_sgi;
+    uint32_t eoi_count;
+};
+
+static struct fake_gic gic;
+
+static int bit_test(const uint32_t *map, uint32_t irq) {
+    return (map[irq / 32] >> (irq % 32)) & 1;
+}
+
+/* 挂起且使能的最小中断号，没有时返回GIC_SPURIOUS */
+static uint32_t fake_gic_highest(void) {
+    if (!(gic.dist_ctlr & 1) || !(gic.cpu_ctlr & 1)) {
+        return GIC_SPURIOUS;
+    }
+    for (uint32_t w = 0; w < NR_WORDS; w++) {
+        uint32_t bits = gic.pending[w] & gic.enabled[w];
+        if (bits) {
+            return w * 32 + __builtin_ctz(bits);
+        }
+    }
+    return GIC_SPURIOUS;
+}
+
+static uint32_t bytes_read(const uint8_t *bytes, uint32_t off) {
+    uint32_t irq = off & ~3u;
+    if (irq + 3 >= HOST_GIC_NR_IRQS) {
+        return 0;
+    }
+    return bytes[irq] | bytes[irq + 1] << 8 | bytes[irq + 2] << 16 | (uint32_t)bytes[irq + 3] << 24;
+}
+
+static void bytes_write(uint8_t *bytes, uint32_t off, uint32_t val) {
+    uint32_t irq = off & ~3u;
+    if (irq + 3 >= HOST_GIC_NR_IRQS) {
+        return;
+    }
+    for (uint32_t i = 0; i < 4; i++) {
+        bytes[irq + i] = (val >> (i * 8)) & 0xFF;
+    }
+}
+
+static uint32_t gicd_rd(void *ctx, uint32_t off) {
+    (void)ctx;
+    if (off == GICD_CTLR) return gic.dist_ctlr;
+    if (off == GICD_TYPER) return NR_WORDS - 1;         /* 单CPU */
+    if (off == GICD_IIDR) return 0x0200043B;            /* ARM GIC-400 */
+    if (off >= GICD_ISENABLER && off < GICD_ISENABLER + NR_WORDS * 4)
+        return gic.enabled[(off - GICD_ISENABLER) / 4];
+    if (off >= GICD_ICENABLER && off < GICD_ICENABLER + NR_WORDS * 4)
+        return gic.enabled[(off - GICD_ICENABLER) / 4];
+    if (off >= GICD_ISPENDR && off < GICD_ISPENDR + NR_WORDS * 4)
+        return gic.pending[(off - GICD_ISPENDR) / 4];
+    if (off >= GICD_ICPENDR && off < GICD_ICPENDR + NR_WORDS * 4)
+        return gic.pending[(off - GICD_ICPENDR) / 4];
+    if (off >= GICD_IPRIORITYR && off < GICD_IPRIORITYR + HOST_GIC_NR_IRQS)
+        return bytes_read(gic.priority, off - GICD_IPRIORITYR);
+    if (off >= GICD_ITARGETSR && off < GICD_ITARGETSR + HOST_GIC_NR_IRQS)
+        return bytes_read(gic.target, off - GICD_ITARGETSR);
+    return gic.dist_regs[(off & 0xFFF) / 4];
+}
+
+static void gicd_wr(void *ctx, uint32_t off, uint32_t val) {
+    (void)ctx;
+    if (off == GICD_CTLR) {
+        gic.dist_ctlr = val;
+    } else if (off >= GICD_ISENABLER && off < GICD_ISENABLER + NR_WORDS * 4) {
+        gic.enabled[(off - GICD_ISENABLER) / 4] |= val;
+    } else if (off >= GICD_ICENABLER && off < GICD_ICENABLER + NR_WORDS * 4) {
+        gic.enabled[(off - GICD_ICENABLER) / 4] &= ~val;
+    } else if (off >= GICD_ISPENDR && off < GICD_ISPENDR + NR_WORDS * 4) {
+        gic.pending[(off - GICD_ISPENDR) / 4] |= val;
+    } else if (off >= GICD_ICPENDR && off < GICD_ICPENDR + NR_WORDS * 4) {
+        gic.pending[(off - GICD_ICPENDR) / 4] &= ~val;
+    } else if (off >= GICD_IPRIORITYR && off < GICD_IPRIORITYR + HOST_GIC_NR_IRQS) {
+        bytes_write(gic.priority, off - GICD_IPRIORITYR, val);
+    } else if (off >= GICD_ITARGETSR && off < GICD_ITARGETSR + HOST_GIC_NR_IRQS) {
+        bytes_write(gic.target, off - GICD_ITARGETSR, val);
+    } else if (off == GICD_SGIR) {
+        /* 目标列表包含CPU 0时挂起 */
+        gic.last_sgi = val;
+        if ((val >> 16) & 1) {
+            fake_gic_raise(val & 0xF);
+        }
+    } else {
+        gic.dist_regs[(off & 0xFFF) / 4] = val;
+    }
+}
+
+static uint32_t gicc_rd(void *ctx, uint32_t off) {
+    uint32_t irq;
+
+    (void)ctx;
+    switch (off) {
+    case GICC_CTLR:
+        return gic.cpu_ctlr;
+    case GICC_IAR:
+        irq = fake_gic_highest();
+        if (irq != GIC_SPURIOUS) {
+            gic.pending[irq / 32] &= ~(1u << (irq % 32));
+            gic.active[irq / 32] |= 1u << (irq % 32);
+        }
+        return irq;
+    case GICC_HPPIR:
+        return fake_gic_highest();
+    case GICC_RPR:
+        return 0xFF;
+    default:
+        return gic.cpu_regs[(off & 0xFF) / 4];
+    }
+}
+
+static void gicc_wr(void *ctx, uint32_t off, uint32_t val) {
+    uint32_t irq = val & 0x3FF;
+
+    (void)ctx;
+    if (off == GICC_CTLR) {
+        gic.cpu_ctlr = val;
+    } else if (off == GICC_EOIR) {
+        if (irq < HOST_GIC_NR_IRQS) {
+            gic.active[irq / 32] &= ~(1u << (irq % 32));
+        }
+        gic.eoi_count++;
+    } else {
+        gic.cpu_regs[(off & 0xFF) / 4] = val;
+    }
+}
+
+void fake_gic_install(void) {
+    memset(&gic, 0, sizeof(gic));
+    host_mmio_map(HOST_GICD_BASE, 0x1000, gicd_rd, gicd_wr, NULL);
+    host_mmio_map(HOST_GICC_BASE, 0x100, gicc_rd, gicc_wr, NULL);
+}
+
+void fake_gic_raise(uint32_t irq_id) {
+    if (irq_id < HOST_GIC_NR_IRQS) {
+        gic.pending[irq_id / 32] |= 1u << (irq_id % 32);
+    }
+}
+
+int fake_gic_enabled(uint32_t irq_id) {
+    return irq_id < HOST_GIC_NR_IRQS && bit_test(gic.enabled, irq_id);
+}
+
+uint32_t fake_gic_priority(uint32_t irq_id) {
+    return irq_id < HOST_GIC_NR_IRQS ? gic.priority[irq_id] : 0;
+}
+
+uint32_t fake_gic_target(uint32_t irq_id) {
+    return irq_id < HOST_GIC_NR_IRQS ? gic.target[irq_id] : 0;
+}
+
+uint32_t fake_gic_last_sgi(void) {
+    return gic.last_sgi;
+}
+
+uint32_t fake_gic_eoi_count(void) {
+    return gic.eoi_count;
+}
+
+uint32_t fake_gic_dispatch(void) {
+    uint32_t n = 0;
+
+    while (n < 64 && fake_gic_highest() != GIC_SPURIOUS) {
+        handle_irq(NULL);
+        n++;
+    }
+    return n;
+}
@@ -0,0 +1,259 @@
+/*
+ * SkyOS 主机测试环境：hal.h的主机实现
+ * 文件: host/hal_host.c
+ *
+ * CP15寄存器是host_cp15中的普通变量；MMIO按地址区间分发到钩子，
+ * 没有钩子的地址存放在一个开放寻址的稀疏表中 (写入什么读回什么)。
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "hal.h"
+#include "driver.h"
+#include "syscall.h"
+#include "hal_host.h"
+
+/* 外部函数声明 */
+extern void handle_swi(uint32_t syscall_num, struct syscall_regs *regs);
+extern uint32_t gic_timer_irq(void);
+
+/* QEMU virt的定时器频率 */
+#define HOST_CNTFRQ         62500000
+
+#define CNTP_CTL_ENABLE     (1 << 0)
+#define CNTP_CTL_IMASK      (1 << 1)
+#define CNTP_CTL_ISTATUS    (1 << 2)
+
+struct host_cp15 host_cp15 = { .cntfrq = HOST_CNTFRQ };
+uint32_t host_cpsr = 0;
+
+/* ===== CP15 ===== */
+
+int host_timer_pending(void) {
+    return (host_cp15.cntp_ctl & (CNTP_CTL_ENABLE | CNTP_CTL_IMASK)) == CNTP_CTL_ENABLE &&
+           host_cp15.cntpct >= host_cp15.cntp_cval;
+}
+
+uint32_t read_cntfrq(void) { return host_cp15.cntfrq; }
+uint64_t read_cntpct(void) { return host_cp15.cntpct; }
+uint64_t read_cntvct(void) { return host_cp15.cntpct; }
+
+uint32_t read_cntp_tval(void) {
+    return (uint32_t)(host_cp15.cntp_cval - host_cp15.cntpct);
+}
+
+/* TVAL是有符号的相对值 */
+void write_cntp_tval(uint32_t tval) {
+    host_cp15.cntp_cval = host_cp15.cntpct + (int64_t)(int32_t)tval;
+}
+
+void write_cntp_cval(uint64_t cval) { host_cp15.cntp_cval = cval; }
+
+uint32_t read_cntp_ctl(void) {
+    uint32_t ctl = host_cp15.cntp_ctl & (CNTP_CTL_ENABLE | CNTP_CTL_IMASK);
+    if ((ctl & CNTP_CTL_ENABLE) && host_cp15.cntpct >= host_cp15.cntp_cval) {
+        ctl |= CNTP_CTL_ISTATUS;
+    }
+    return ctl;
+}
+
+void write_cntp_ctl(uint32_t ctl) {
+    host_cp15.cntp_ctl = ctl & (CNTP_CTL_ENABLE | CNTP_CTL_IMASK);
+}
+
+uint32_t read_cntkctl(void) { return host_cp15.cntkctl; }
+void write_cntkctl(uint32_t val) { host_cp15.cntkctl = val; }
+uint32_t read_dfsr(void) { return host_cp15.dfsr; }
+uint32_t read_far(void) { return host_cp15.far; }
+uint32_t read_ifsr(void) { return host_cp15.ifsr; }
+uint32_t read_ifar(void) { return host_cp15.ifar; }
+uint32_t read_mpidr(void) { return host_cp15.mpidr; }
+
+/* 等待中断：定时器已设定时直接把时间推进到截止时间 (中断由测试分发) */
+void cpu_wfi(void) {
+    host_cp15.wfi_count++;
+    if ((host_cp15.cntp_ctl & CNTP_CTL_ENABLE) && host_cp15.cntp_cval > host_cp15.cntpct) {
+        host_cp15.cntpct = host_cp15.cntp_cval;
+    }
+}
+
+void cpu_dsb_wfi(void) {
+    cpu_wfi();
+}
+
+/* ===== MMIO ===== */
+
+#define HOST_MMIO_REGIONS   8
+#define HOST_MMIO_SLOTS     4096        /* 2的幂 */
+
+struct host_mmio_region {
+    uint32_t base, size;
+    host_mmio_read_t rd;
+    host_mmio_write_t wr;
+    void *ctx;
+};
+
+struct host_mmio_slot {
+    uint32_t addr;
+    uint32_t val;
+    uint32_t used;
+};
+
+static struct host_mmio_region mmio_regions[HOST_MMIO_REGIONS];
+static uint32_t mmio_nr_regions;
+static struct host_mmio_slot mmio_slots[HOST_MMIO_SLOTS];
+static uint32_t mmio_nr_writes;
+
+int host_mmio_map(uint32_t base, uint32_t size, host_mmio_read_t rd,
+                  host_mmio_write_t wr, void *ctx) {
+    if (mmio_nr_regions == HOST_MMIO_REGIONS) {
+        return -1;
+    }
+    mmio_regions[mmio_nr_regions++] = (struct host_mmio_region){ base, size, rd, wr, ctx };
+    return 0;
+}
+
+static struct host_mmio_region *mmio_find_region(uint32_t addr) {
+    for (uint32_t i = 0; i < mmio_nr_regions; i++) {
+        if (addr - mmio_regions[i].base < mmio_regions[i].size) {
+            return &mmio_regions[i];
+        }
+    }
+    return NULL;
+}
+
+static struct host_mmio_slot *mmio_slot(uint32_t addr, int create) {
+    uint32_t h = (addr >> 2) * 2654435761u;
+
+    for (uint32_t n = 0; n < HOST_MMIO_SLOTS; n++) {
+        struct host_mmio_slot *s = &mmio_slots[(h + n) & (HOST_MMIO_SLOTS - 1)];
+        if (s->used && s->addr == addr) {
+            return s;
+        }
+        if (!s->used) {
+            if (!create) {
+                return NULL;
+            }
+            s->used = 1;
+            s->addr = addr;
+            return s;
+        }
+    }
+    fprintf(stderr, "host: MMIO寄存器表已满\n");
+    abort();
+}
+
+uint32_t host_mmio_peek(uint32_t addr) {
+    struct host_mmio_slot *s = mmio_slot(addr, 0);
+    return s ? s->val : 0;
+}
+
+void host_mmio_poke(uint32_t addr, uint32_t val) {
+    mmio_slot(addr, 1)->val = val;
+}
+
+uint32_t host_mmio_writes(void) {
+    return mmio_nr_writes;
+}
+
+uint32_t mmio_read32(uint32_t addr) {
+    struct host_mmio_region *r = mmio_find_region(addr);
+
+    if (r && r->rd) {
+        return r->rd(r->ctx, addr - r->base);
+    }
+    return host_mmio_peek(addr);
+}
+
+void mmio_write32(uint32_t addr, uint32_t val) {
+    struct host_mmio_region *r = mmio_find_region(addr);
+
+    mmio_nr_writes++;
+    if (r && r->wr) {
+        r->wr(r->ctx, addr - r->base, val);
+        return;
+    }
+    host_mmio_poke(addr, val);
+}
+
+/* ===== 系统调用 ===== */
+
+/* syscall.h的syscall4在主机上调用这里：构造寄存器帧，结果从r0取回 */
+uint32_t host_syscall(uint32_t num, uint32_t a1, uint32_t a2, uint32_t a3, uint32_t a4) {
+    struct syscall_regs regs;
+
+    memset(&regs, 0, sizeof(regs));
+    regs.r0 = a1;
+    regs.r1 = a2;
+    regs.r2 = a3;
+    regs.r3 = a4;
+    handle_swi(num, &regs);
+    return regs.r0;
+}
+
+/* ===== 驱动 ===== */
+
+extern const struct platform_driver __start_platform_drivers[];
+extern const struct platform_driver __stop_platform_drivers[];
+
+int host_probe(const char *name, const struct fdt_device *node) {
+    static struct platform_device pdevs[8];
+    static uint32_t nr_pdevs;
+
+    for (const struct platform_driver *drv = __start_platform_drivers;
+         drv < __stop_platform_drivers; drv++) {
+        if (strcmp(drv->name, name) == 0 && nr_pdevs < 8) {
+            /* platform_device在测试进程中一直有效 (驱动可能保存指针) */
+            struct platform_device *pdev = &pdevs[nr_pdevs++];
+            pdev->node = node;
+            pdev->driver = drv;
+            pdev->state = DEV_STATE_PENDING;
+            return drv->probe(pdev);
+        }
+    }
+    fprintf(stderr, "host: 没有名为%s的驱动\n", name);
+    abort();
+}
+
+static const struct fdt_device host_gic_node = {
+    .name = "intc@8000000",
+    .compatible = "arm,cortex-a15-gic",
+    .compatible_len = sizeof("arm,cortex-a15-gic"),
+    .reg_base = { HOST_GICD_BASE, HOST_GICC_BASE },
+    .reg_size = { 0x10000, 0x10000 },
+    .nr_reg = 2,
+};
+
+/* 安全物理、非安全物理、虚拟、Hyp定时器 (已换算为GIC中断ID) */
+static const struct fdt_device host_timer_node = {
+    .name = "timer",
+    .compatible = "arm,armv7-timer",
+    .compatible_len = sizeof("arm,armv7-timer"),
+    .irqs = { 29, 30, 27, 26 },
+    .nr_irqs = 4,
+};
+
+void host_boot_timer(void) {
+    fake_gic_install();
+    if (host_probe("gic", &host_gic_node) != 0 ||
+        host_probe("timer", &host_timer_node) != 0) {
+        fprintf(stderr, "host: GIC/定时器探测失败\n");
+        abort();
+    }
+}
+
+void host_advance_ticks(uint32_t ticks) {
+    uint32_t interval = host_cp15.cntfrq / 100;
+
+    for (uint32_t i = 0; i < ticks; i++) {
+        host_cp15.cntpct += interval;
+        /* 电平触发：处理程序设定下一个截止时间后条件消失 */
+        for (uint32_t n = 0; n < 4 && host_timer_pending(); n++) {
+            fake_gic_raise(gic_timer_irq());
+            fake_gic_dispatch();
+        }
+    }
+}
@@ -0,0 +1,108 @@
+/*
+ * SkyOS 主机测试环境
+ * 文件: host/hal_host.h
+ *
+ * 在Linux上用普通gcc编译内核源码 (-DSKYOS_HOST)，hal.h中的寄存器访问
+ * 落到这里的假寄存器文件：
+ * - CP15：结构体host_cp15，测试直接读写 (计数器只在测试推进时变化)
+ * - MMIO：按地址区间挂读写钩子 (如假GIC)，其余地址是普通的稀疏寄存器存储
+ * - 串口：uart_*输出收集到缓冲区，测试检查输出内容
+ *
+ * 主机是64位进程，内核代码中的32位地址不能解引用。链接时使用-no-pie，
+ * 静态数据的地址在4GB以下，可以作为系统调用参数传递。
+ */
+
+#ifndef _SKYOS_HAL_HOST_H_
+#define _SKYOS_HAL_HOST_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "fdt.h"
+#include "hal.h"
+
+/* ===== CP15 ===== */
+
+struct host_cp15 {
+    uint32_t cntfrq;
+    uint64_t cntpct;            /* 物理计数器，虚拟计数器与之相同 */
+    uint64_t cntp_cval;
+    uint32_t cntp_ctl;          /* ISTATUS位读取时根据cval计算 */
+    uint32_t cntkctl;
+    uint32_t dfsr, far, ifsr, ifar;
+    uint32_t mpidr;
+    uint32_t wfi_count;
+};
+
+extern struct host_cp15 host_cp15;
+extern uint32_t host_cpsr;
+
+/* 定时器条件成立 (使能、未屏蔽且计数器到达cval) */
+int host_timer_pending(void);
+
+/* ===== MMIO ===== */
+
+typedef uint32_t (*host_mmio_read_t)(void *ctx, uint32_t offset);
+typedef void (*host_mmio_write_t)(void *ctx, uint32_t offset, uint32_t val);
+
+/* 在[base, base+size)挂读写钩子，返回0成功 */
+int host_mmio_map(uint32_t base, uint32_t size, host_mmio_read_t rd,
+                  host_mmio_write_t wr, void *ctx);
+/* 稀疏寄存器存储中的值 (没有钩子的地址)，未写过为0 */
+uint32_t host_mmio_peek(uint32_t addr);
+void host_mmio_poke(uint32_t addr, uint32_t val);
+uint32_t host_mmio_writes(void);
+
+/* ===== 假GIC v2 (host/fake_gic.c) ===== */
+
+#define HOST_GICD_BASE      0x08000000
+#define HOST_GICC_BASE      0x08010000
+#define HOST_GIC_NR_IRQS    128
+
+void fake_gic_install(void);
+void fake_gic_raise(uint32_t irq_id);
+int fake_gic_enabled(uint32_t irq_id);
+uint32_t fake_gic_priority(uint32_t irq_id);
+uint32_t fake_gic_target(uint32_t irq_id);
+uint32_t fake_gic_last_sgi(void);
+uint32_t fake_gic_eoi_count(void);
+/* 分发挂起的中断 (经handle_irq)，返回处理的个数 */
+uint32_t fake_gic_dispatch(void);
+
+/* ===== 驱动 ===== */
+
+/* 按名字查找PLATFORM_DRIVER并用给定的设备树节点探测，返回probe的返回值 */
+int host_probe(const char *name, const struct fdt_device *node);
+
+/* 安装假GIC、探测GIC和定时器驱动 (定时器中断为PPI 14) */
+void host_boot_timer(void);
+/* 推进ticks个滴答的时间，逐个分发到期的定时器中断 */
+void host_advance_ticks(uint32_t ticks);
+
+/* ===== 串口输出 ===== */
+
+const char *host_uart_output(void);
+void host_uart_clear(void);
+/* 输出中是否包含s */
+int host_uart_contains(const char *s);
+
+/* ===== 其他模块的桩 (host/stubs.c、host/stubs_task.c) ===== */
+
+/* 结束宽限期：执行所有排队的call_rcu回调 */
+void host_rcu_barrier(void);
+
+struct task;
+extern struct task *host_current_task;
+extern uint32_t host_tasks_woken;
+extern uint32_t host_sched_ticks;
+
+/* ===== 调度器测试程序的桩 (host/sched/stubs.c) ===== */
+
+/* 每个CPU持有惰性FP状态的任务 (fpu_task_owns) */
+extern struct task *host_fpu_owner[NR_CPUS];
+/* cpu_switch_to的调用次数和已上线RCU的CPU */
+extern uint32_t host_switches;
+extern uint32_t host_rcu_online_mask;
+/* cpu_switch_to中调用：此时prev尚未完成切出 (on_cpu仍为1) */
+extern void (*host_switch_hook)(struct task *prev, struct task *next);
+
+#endif /* _SKYOS_HAL_HOST_H_ */
@@ -0,0 +1,97 @@
+/*
+ * SkyOS 主机测试环境：测试运行器
+ * 文件: host/main.c
+ *
+ * 用法: skyos-host [-b] [名字片段]
+ *   默认运行所有TEST，-b运行所有BENCH；给出名字片段时只运行名字包含它的项。
+ * 每项在子进程中运行；有失败时退出码为1。
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "test.h"
+
+extern const struct host_test __start_host_tests[];
+extern const struct host_test __stop_host_tests[];
+
+#define MAX_TESTS   256
+
+/* 链接段中的顺序不确定，按定义位置排序 */
+static int test_cmp(const void *a, const void *b) {
+    const struct host_test *x = *(const struct host_test *const *)a;
+    const struct host_test *y = *(const struct host_test *const *)b;
+    int c = strcmp(x->file, y->file);
+    return c ? c : x->line - y->line;
+}
+
+/* 在子进程中运行一项，返回0表示通过 */
+static int run_one(const struct host_test *t) {
+    pid_t pid;
+    int status;
+
+    fflush(stdout);
+    pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return -1;
+    }
+    if (pid == 0) {
+        t->fn();
+        fflush(stdout);
+        _exit(0);
+    }
+    if (waitpid(pid, &status, 0) < 0) {
+        perror("waitpid");
+        return -1;
+    }
+    if (WIFSIGNALED(status)) {
+        fprintf(stderr, "  被信号%d终止\n", WTERMSIG(status));
+        return -1;
+    }
+    return WEXITSTATUS(status) == 0 ? 0 : -1;
+}
+
+int main(int argc, char **argv) {
+    static const struct host_test *tests[MAX_TESTS];
+    const char *filter = NULL;
+    int bench = 0;
+    uint32_t nr_tests = 0, passed = 0, failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-b") == 0) {
+            bench = 1;
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    for (const struct host_test *t = __start_host_tests; t < __stop_host_tests; t++) {
+        if (t->bench == bench && (!filter || strstr(t->name, filter)) && nr_tests < MAX_TESTS) {
+            tests[nr_tests++] = t;
+        }
+    }
+    qsort(tests, nr_tests, sizeof(tests[0]), test_cmp);
+
+    printf("=== SkyOS主机%s ===\n", bench ? "微基准" : "单元测试");
+    for (uint32_t i = 0; i < nr_tests; i++) {
+        const struct host_test *t = tests[i];
+        if (bench) {
+            printf("%s:\n", t->name);
+        }
+        if (run_one(t) == 0) {
+            passed++;
+            if (!bench) {
+                printf("  通过  %s\n", t->name);
+            }
+        } else {
+            failed++;
+            printf("  失败  %s\n", t->name);
+        }
+    }
+    printf("=== %u 通过, %u 失败 ===\n", passed, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * SkyOS 主机测试环境：调度器测试程序 (skyos-host-sched) 的桩
+ * 文件: host/sched/stubs.c
+ *
+ * kernel/task.c调用的上下文切换、PMU、FPU和RCU函数：
+ * - cpu_switch_to不切换栈，直接返回，相当于next完成切入后立刻执行
+ *   task_finish_switch；测试可以挂钩子检查切出完成之前的状态
+ * - fpu_task_owns按host_fpu_owner[cpu]判断惰性FP状态的持有者 (与kernel/fpu.c一样每CPU一个)，
+ *   fpu_task_release清除本CPU的持有者
+ * 多个CPU通过改写host_cp15.mpidr轮流模拟，同一时刻只有一个CPU在执行。
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "task.h"
+#include "pmu.h"
+#include "fpu.h"
+#include "irqflags.h"
+#include "hal_host.h"
+
+struct task *host_fpu_owner[NR_CPUS];
+uint32_t host_switches = 0;
+uint32_t host_rcu_online_mask = 0;
+void (*host_switch_hook)(struct task *prev, struct task *next) = NULL;
+
+/* ctx是struct task的第一个成员 */
+void cpu_switch_to(struct task_context *prev, struct task_context *next) {
+    host_switches++;
+    if (host_switch_hook) {
+        host_switch_hook((struct task *)prev, (struct task *)next);
+    }
+}
+
+void enable_irq(void) {
+    host_cpsr &= ~CPSR_I_BIT;
+}
+
+void rcu_cpu_online(uint32_t cpu) {
+    host_rcu_online_mask |= 1u << cpu;
+}
+
+void pmu_task_switch(struct pmu_task_ctx *prev, struct pmu_task_ctx *next) {
+    (void)prev;
+    (void)next;
+}
+
+void pmu_task_read(const struct pmu_task_ctx *ctx, int running, struct pmu_counts *out) {
+    (void)ctx;
+    (void)running;
+    memset(out, 0, sizeof(*out));
+}
+
+/* 与kernel/fpu.c相同：亲和性已不允许本CPU的持有者切出时放弃持有 */
+void fpu_task_switch(struct task *prev, struct task *next) {
+    (void)next;
+    if (!(prev->affinity & (1u << cpu_id()))) {
+        fpu_task_release(prev);
+    }
+}
+
+void fpu_task_release(struct task *t) {
+    if (host_fpu_owner[cpu_id()] == t) {
+        host_fpu_owner[cpu_id()] = NULL;
+    }
+}
+
+void fpu_task_exit(struct task *t) {
+    for (uint32_t cpu = 0; cpu < NR_CPUS; cpu++) {
+        if (host_fpu_owner[cpu] == t) {
+            host_fpu_owner[cpu] = NULL;
+        }
+    }
+}
+
+int fpu_task_owns(const struct task *t) {
+    for (uint32_t cpu = 0; cpu < NR_CPUS; cpu++) {
+        if (host_fpu_owner[cpu] == t) {
+            return 1;
+        }
+    }
+    return 0;
+}
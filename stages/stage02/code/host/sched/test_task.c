@@ -0,0 +1,296 @@
+/*
+ * SkyOS 主机测试：SMP调度器 (kernel/task.c)
+ * 文件: host/sched/test_task.c
+ *
+ * QEMU只启动0号CPU，内核自检走不到迁移和均衡路径，这里在主机上覆盖：
+ * 改写host_cp15.mpidr切换"当前CPU"，task_cpu_online让1号CPU上线，
+ * 定时器滴答 (host_advance_ticks) 在当前CPU上执行sched_tick。
+ * 任务不会真正运行：cpu_switch_to直接返回 (见host/sched/stubs.c)。
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "task.h"
+#include "page_alloc.h"
+#include "timer.h"
+#include "test.h"
+
+#define BALANCE_TICKS   10      /* 与kernel/task.c的SCHED_BALANCE_TICKS相同 */
+#define HOT_TICKS       2       /* SCHED_HOT_TICKS */
+#define IPI_SGI         3       /* SCHED_IPI_SGI */
+#define NR_TEST_TASKS   4
+
+static void run_on(uint32_t cpu) {
+    host_cp15.mpidr = cpu;
+}
+
+static void noop_entry(void *arg) {
+    (void)arg;
+}
+
+/* 0号CPU启动并登记main，online_cpu1为真时1号CPU随后上线 */
+static void sched_boot(int online_cpu1) {
+    page_alloc_init();
+    host_boot_timer();
+    run_on(0);
+    task_init();
+    if (online_cpu1) {
+        run_on(1);
+        task_cpu_online();
+        run_on(0);
+    }
+}
+
+static void create_tasks(struct task **t, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        t[i] = task_create("t", noop_entry, NULL);
+        CHECK(t[i] != NULL);
+    }
+}
+
+TEST(sched_cpu_online) {
+    struct task *boot1;
+
+    sched_boot(1);
+    CHECK(task_current() == task_find(0));
+    CHECK_EQ(task_current()->affinity, 1u << 0);
+
+    run_on(1);
+    boot1 = task_current();
+    CHECK(boot1 != NULL && boot1 != task_find(0));
+    CHECK_EQ(boot1->cpu, 1);
+    CHECK_EQ(boot1->affinity, 1u << 1);
+    CHECK_EQ(host_rcu_online_mask, 1u << 1);
+
+    /* CPU的启动上下文不能离开该CPU */
+    CHECK_EQ(task_set_affinity(boot1, 1u << 0), -SCHED_EINVAL);
+}
+
+/* 新任务：本CPU队列空时留在本CPU，否则放到队列最短的在线CPU并发SGI唤醒它 */
+TEST(sched_create_placement) {
+    struct task *t[3];
+
+    sched_boot(1);
+    create_tasks(t, 3);
+    CHECK_EQ(t[0]->cpu, 0);
+    CHECK_EQ(t[0]->migrations, 0);
+    CHECK_EQ(t[1]->cpu, 1);
+    CHECK_EQ(t[1]->migrations, 0);         /* 首次放置不算迁移 */
+    CHECK_EQ(fake_gic_last_sgi(), ((1u << 1) << 16) | IPI_SGI);
+    /* 队列一样长时优先原CPU，离线的2、3号CPU不参与 */
+    CHECK_EQ(t[2]->cpu, 0);
+    CHECK(t[0]->on_rq && t[1]->on_rq && t[2]->on_rq);
+}
+
+/* 周期均衡：1号CPU的第BALANCE_TICKS个滴答从0号CPU拉走一半差距 */
+TEST(sched_periodic_pull) {
+    struct task *t[NR_TEST_TASKS];
+
+    sched_boot(0);
+    create_tasks(t, NR_TEST_TASKS);
+    for (uint32_t i = 0; i < NR_TEST_TASKS; i++) {
+        CHECK_EQ(t[i]->cpu, 0);
+    }
+
+    run_on(1);
+    task_cpu_online();
+    host_advance_ticks(BALANCE_TICKS - 1);
+    CHECK_EQ(t[0]->cpu, 0);
+    host_advance_ticks(1);
+
+    CHECK_EQ(t[0]->cpu, 1);
+    CHECK_EQ(t[1]->cpu, 1);
+    CHECK_EQ(t[2]->cpu, 0);
+    CHECK_EQ(t[3]->cpu, 0);
+    CHECK_EQ(t[0]->migrations, 1);
+    CHECK(t[0]->on_rq && t[1]->on_rq);
+
+    host_uart_clear();
+    sched_print_stats();
+    CHECK(host_uart_contains("迁入 2, 迁出 0, 均衡 1"));
+}
+
+/* 均衡不迁移持有惰性FP状态的任务和缓存仍热的任务 */
+TEST(sched_pull_skips_fpu_and_hot) {
+    struct task *t[NR_TEST_TASKS];
+
+    sched_boot(0);
+    create_tasks(t, NR_TEST_TASKS);
+    host_fpu_owner[0] = t[0];
+    t[1]->last_ran = get_timer_ticks() + BALANCE_TICKS;     /* 均衡时刚切出 */
+
+    run_on(1);
+    task_cpu_online();
+    host_advance_ticks(BALANCE_TICKS);
+
+    CHECK_EQ(t[0]->cpu, 0);
+    CHECK_EQ(t[1]->cpu, 0);
+    CHECK_EQ(t[2]->cpu, 1);
+    CHECK_EQ(t[3]->cpu, 1);
+
+    host_uart_clear();
+    sched_print_stats();
+    CHECK(host_uart_contains("缓存热跳过: 1"));
+}
+
+/* 空闲拉取：对方队列非空就拉一个；连续几次都因缓存热拉不到后忽略热度 */
+TEST(sched_idle_pull) {
+    struct task *t[2];
+    uint32_t now;
+
+    sched_boot(1);
+    run_on(1);
+    CHECK_EQ(sched_idle_switch(), 0);       /* 两边都没有排队的任务 */
+
+    run_on(0);
+    t[0] = task_create("hot0", noop_entry, NULL);
+    t[1] = task_create("hot1", noop_entry, NULL);
+    CHECK(t[0] && t[1]);
+    /* 第二个任务放到了空闲的1号CPU，挪回来让0号CPU排两个 */
+    CHECK_EQ(task_set_affinity(t[1], 1u << 0), 0);
+    CHECK_EQ(t[1]->cpu, 0);
+    CHECK_EQ(task_set_affinity(t[1], SCHED_ALL_CPUS), 0);
+
+    now = get_timer_ticks();
+    t[0]->last_ran = now;
+    t[1]->last_ran = now;
+    run_on(1);
+    for (uint32_t i = 0; i < 3; i++) {
+        CHECK_EQ(sched_idle_switch(), 0);
+    }
+    CHECK_EQ(sched_idle_switch(), 1);
+    CHECK(task_current() == t[0]);
+    CHECK_EQ(t[0]->cpu, 1);
+    CHECK_EQ(t[0]->on_cpu, 1);
+    CHECK_EQ(t[1]->cpu, 0);
+}
+
+/* 亲和性：排队中的任务立即迁到允许的CPU，均衡不拉走绑定的任务 */
+TEST(sched_affinity) {
+    struct task *t[NR_TEST_TASKS];
+
+    sched_boot(0);
+    create_tasks(t, NR_TEST_TASKS);
+    for (uint32_t i = 0; i < NR_TEST_TASKS; i++) {
+        CHECK_EQ(sys_sched_setaffinity(t[i]->id, 1u << 0), 0);
+    }
+    run_on(1);
+    task_cpu_online();
+    CHECK_EQ(sched_idle_switch(), 0);
+    host_advance_ticks(BALANCE_TICKS);
+    for (uint32_t i = 0; i < NR_TEST_TASKS; i++) {
+        CHECK_EQ(t[i]->cpu, 0);
+    }
+
+    run_on(0);
+    CHECK_EQ(sys_sched_setaffinity(t[2]->id, 1u << 1), 0);
+    CHECK_EQ(t[2]->cpu, 1);
+    CHECK_EQ(t[2]->migrations, 1);
+    CHECK_EQ(fake_gic_last_sgi(), ((1u << 1) << 16) | IPI_SGI);
+    CHECK_EQ(sys_sched_getaffinity(t[2]->id), 1u << 1);
+
+    /* 参数检查 */
+    CHECK_EQ(sys_sched_setaffinity(t[2]->id, 0), (uint32_t)-SCHED_EINVAL);
+    CHECK_EQ(sys_sched_setaffinity(t[2]->id, 1u << 2), (uint32_t)-SCHED_EINVAL);
+    CHECK_EQ(sys_sched_setaffinity(9999, 1u << 0), (uint32_t)-SCHED_ESRCH);
+    CHECK_EQ(sys_sched_getaffinity(0), 1u << 0);
+}
+
+/*
+ * 切出中的任务：当前任务的亲和性改到1号CPU后，task_yield先把它排到1号CPU
+ * 再切走；切出完成 (task_finish_switch) 之前on_cpu仍为1，1号CPU要等它清零
+ */
+static struct task *handoff_task;
+static uint32_t handoff_hook_calls;
+
+static void handoff_hook(struct task *prev, struct task *next) {
+    if (prev != handoff_task) {
+        return;
+    }
+    handoff_hook_calls++;
+    CHECK_EQ(prev->on_cpu, 1);
+    CHECK_EQ(prev->on_rq, 1);
+    CHECK_EQ(prev->cpu, 1);
+    CHECK_EQ(next->on_cpu, 1);
+}
+
+TEST(sched_on_cpu_handoff) {
+    struct task *a, *main_task;
+
+    sched_boot(1);
+    main_task = task_current();
+    a = task_create("a", noop_entry, NULL);
+    CHECK(a != NULL);
+    CHECK_EQ(a->cpu, 0);
+
+    /* 0号CPU切到a，main排回队尾 */
+    task_yield();
+    CHECK(task_current() == a);
+    CHECK_EQ(a->on_cpu, 1);
+    CHECK_EQ(main_task->on_cpu, 0);
+
+    handoff_task = a;
+    host_switch_hook = handoff_hook;
+    CHECK_EQ(task_set_affinity(a, 1u << 1), 0);
+    CHECK_EQ(handoff_hook_calls, 1);
+    CHECK(task_current() == main_task);
+    CHECK_EQ(a->on_cpu, 0);
+    CHECK_EQ(fake_gic_last_sgi(), ((1u << 1) << 16) | IPI_SGI);
+
+    /* 1号CPU的空闲循环发现队列中的a并切换过去 */
+    run_on(1);
+    CHECK_EQ(sched_idle_switch(), 1);
+    CHECK(task_current() == a);
+    CHECK_EQ(a->on_cpu, 1);
+    CHECK_EQ(a->on_rq, 0);
+    CHECK_EQ(a->migrations, 1);
+}
+
+/*
+ * 持有惰性FP状态的任务：寄存器只在原CPU上，唤醒和修改亲和性都不把它迁走；
+ * 它在原CPU上让出时先放弃持有 (kernel/fpu.c保存状态)，再迁到允许的CPU
+ */
+TEST(sched_fpu_owner_stays) {
+    struct task *a, *b, *main_task;
+
+    sched_boot(1);
+    main_task = task_current();
+    a = task_create("a", noop_entry, NULL);
+    CHECK(a != NULL);
+    CHECK_EQ(a->cpu, 0);
+
+    /* a在0号CPU上运行后阻塞，成为0号CPU的持有者 */
+    task_yield();
+    CHECK(task_current() == a);
+    host_fpu_owner[0] = a;
+    a->state = TASK_BLOCKED;
+    task_yield();
+    CHECK(task_current() == main_task);
+
+    /* 0号CPU排着b、缓存已冷：不持有时会唤醒到空闲的1号CPU */
+    b = task_create("b", noop_entry, NULL);
+    CHECK(b != NULL);
+    CHECK_EQ(task_set_affinity(b, 1u << 0), 0);
+    a->last_ran = get_timer_ticks() - HOT_TICKS;
+    run_on(1);
+    CHECK_EQ(task_wake(a), 1);
+    CHECK_EQ(a->cpu, 0);
+    CHECK_EQ(a->on_rq, 1);
+    CHECK_EQ(a->migrations, 0);
+
+    /* 排队中的持有者不立即迁移 */
+    run_on(0);
+    CHECK_EQ(task_set_affinity(a, 1u << 1), 0);
+    CHECK_EQ(a->cpu, 0);
+    CHECK_EQ(a->on_rq, 1);
+
+    /* 在0号CPU上再运行一次，让出时放弃持有后迁到1号CPU */
+    task_yield();
+    CHECK(task_current() == b);
+    task_yield();
+    CHECK(task_current() == a);
+    task_yield();
+    CHECK(host_fpu_owner[0] == NULL);
+    CHECK_EQ(a->cpu, 1);
+    CHECK_EQ(a->migrations, 1);
+}
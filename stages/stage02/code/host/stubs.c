@@ -0,0 +1,304 @@
+/*
+ * SkyOS 主机测试环境：未参与编译的模块的桩
+ * 文件: host/stubs.c
+ *
+ * 只有被测模块 (gic/timer/syscall/page_alloc/kprintf) 编译进测试程序，
+ * 它们调用的其他内核函数在这里用最简单的方式实现：
+ * - 串口输出收集到缓冲区 (设置SKYOS_HOST_VERBOSE时同时打印)
+ * - 自旋锁只检查加锁/解锁是否配对，重复加锁直接abort
+ * - call_rcu的回调排队，测试调用host_rcu_barrier时执行 (模拟宽限期结束)；
+ *   queue_work立即执行
+ * 任务相关的函数在host/stubs_task.c中 (调度器测试程序链接真正的kernel/task.c)。
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "spinlock.h"
+#include "rcu.h"
+#include "workqueue.h"
+#include "task.h"
+#include "syscall.h"
+#include "vfs.h"
+#include "futex.h"
+#include "pipe.h"
+#include "ring.h"
+#include "ipc.h"
+#include "idle.h"
+#include "vdso.h"
+#include "pmu.h"
+#include "fdt.h"
+#include "hal_host.h"
+
+/* ===== 串口 ===== */
+
+#define UART_CAPTURE_SIZE   65536
+
+static char uart_buf[UART_CAPTURE_SIZE];
+static uint32_t uart_len;
+
+void uart_putc(char c) {
+    static int verbose = -1;
+
+    if (verbose < 0) {
+        verbose = getenv("SKYOS_HOST_VERBOSE") != NULL;
+    }
+    if (verbose) {
+        fputc(c, stdout);
+    }
+    /* 满了丢掉前一半，保留最近的输出 */
+    if (uart_len == UART_CAPTURE_SIZE - 1) {
+        memmove(uart_buf, uart_buf + UART_CAPTURE_SIZE / 2, UART_CAPTURE_SIZE / 2);
+        uart_len -= UART_CAPTURE_SIZE / 2;
+    }
+    uart_buf[uart_len++] = c;
+    uart_buf[uart_len] = '\0';
+}
+
+void uart_puts(const char *str) {
+    while (*str) {
+        uart_putc(*str++);
+    }
+}
+
+void uart_put_hex(uint32_t value) {
+    char buf[11];
+    snprintf(buf, sizeof(buf), "0x%08X", value);
+    uart_puts(buf);
+}
+
+void uart_put_dec(uint32_t value) {
+    char buf[11];
+    snprintf(buf, sizeof(buf), "%u", value);
+    uart_puts(buf);
+}
+
+const char *host_uart_output(void) {
+    return uart_buf;
+}
+
+void host_uart_clear(void) {
+    uart_len = 0;
+    uart_buf[0] = '\0';
+}
+
+int host_uart_contains(const char *s) {
+    return strstr(uart_buf, s) != NULL;
+}
+
+/* ===== 同步 ===== */
+
+void spin_lock_init(struct spinlock *lock, const char *name) {
+    lock->slock = 0;
+    lock->name = name;
+}
+
+void spin_lock(struct spinlock *lock) {
+    if (lock->tickets.owner != lock->tickets.next) {
+        fprintf(stderr, "host: 重复获取自旋锁 %s\n", lock->name);
+        abort();
+    }
+    lock->tickets.next++;
+}
+
+int spin_trylock(struct spinlock *lock) {
+    if (lock->tickets.owner != lock->tickets.next) {
+        return 0;
+    }
+    lock->tickets.next++;
+    return 1;
+}
+
+void spin_unlock(struct spinlock *lock) {
+    if (lock->tickets.owner == lock->tickets.next) {
+        fprintf(stderr, "host: 释放未持有的自旋锁 %s\n", lock->name);
+        abort();
+    }
+    lock->tickets.owner++;
+}
+
+static struct rcu_head *rcu_pending_list;
+
+/* 调用者可能持有回调要获取的锁，回调不能在这里直接执行 */
+void call_rcu(struct rcu_head *head, void (*func)(struct rcu_head *head)) {
+    head->func = func;
+    head->next = rcu_pending_list;
+    rcu_pending_list = head;
+}
+
+void host_rcu_barrier(void) {
+    while (rcu_pending_list) {
+        struct rcu_head *head = rcu_pending_list;
+        rcu_pending_list = head->next;
+        head->func(head);
+    }
+}
+
+void rcu_note_qs(void) {
+}
+
+void rcu_tick(void) {
+}
+
+int queue_work(struct work_struct *work) {
+    work->func(work);
+    return 0;
+}
+
+/* ===== 空闲任务、vDSO、PMU、设备树 ===== */
+
+void idle_irq_enter(void) {
+}
+
+void idle_irq_exit(void) {
+}
+
+void idle_tick(uint32_t ticks) {
+    (void)ticks;
+}
+
+void idle_print_load(void) {
+}
+
+void vdso_init(uint32_t freq) {
+    (void)freq;
+}
+
+void vdso_update(uint32_t ticks) {
+    (void)ticks;
+}
+
+uint32_t sys_vdso_page(void) {
+    return 0;
+}
+
+void pmu_read(struct pmu_counts *out) {
+    memset(out, 0, sizeof(*out));
+}
+
+void pmu_sub(struct pmu_counts *out, const struct pmu_counts *end, const struct pmu_counts *start) {
+    (void)end;
+    (void)start;
+    memset(out, 0, sizeof(*out));
+}
+
+void pmu_print_counts(const struct pmu_counts *c) {
+    (void)c;
+    uart_puts("\r\n");
+}
+
+int fdt_memory(uint32_t *base, uint32_t *size) {
+    (void)base;
+    (void)size;
+    return -1;
+}
+
+int fdt_blob_region(uint32_t *addr, uint32_t *size) {
+    (void)addr;
+    (void)size;
+    return -1;
+}
+
+/* ===== 系统调用的目标 (参数中的指针在主机上不可用，只返回错误) ===== */
+
+int vfs_open(const char *path, uint32_t flags) {
+    (void)path;
+    (void)flags;
+    return -1;
+}
+
+int vfs_close(int fd) {
+    (void)fd;
+    return -1;
+}
+
+int vfs_read(int fd, void *buf, uint32_t count) {
+    (void)fd;
+    (void)buf;
+    (void)count;
+    return -1;
+}
+
+/* 控制台写入按长度计数，不读取缓冲区 */
+int vfs_write(int fd, const void *buf, uint32_t count) {
+    (void)buf;
+    return fd <= 2 ? (int)count : -1;
+}
+
+int vfs_lseek(int fd, int32_t offset, uint32_t whence) {
+    (void)fd;
+    (void)offset;
+    (void)whence;
+    return -1;
+}
+
+uint32_t vfs_mmap(int fd, uint32_t offset, uint32_t len) {
+    (void)fd;
+    (void)offset;
+    (void)len;
+    return 0;
+}
+
+int vfs_munmap(void *addr, uint32_t len) {
+    (void)addr;
+    (void)len;
+    return -1;
+}
+
+uint32_t sys_futex(volatile uint32_t *uaddr, uint32_t op, uint32_t val) {
+    (void)uaddr;
+    (void)op;
+    (void)val;
+    return (uint32_t)-1;
+}
+
+uint32_t sys_pipe(uint32_t *fds) {
+    (void)fds;
+    return (uint32_t)-1;
+}
+
+uint32_t sys_ring_create(uint32_t pages) {
+    (void)pages;
+    return 0;
+}
+
+uint32_t sys_ring_destroy(struct ring_shared *r) {
+    (void)r;
+    return (uint32_t)-1;
+}
+
+uint32_t sys_ring_wait(struct ring_shared *r, uint32_t side, uint32_t seen) {
+    (void)r;
+    (void)side;
+    (void)seen;
+    return (uint32_t)-1;
+}
+
+uint32_t sys_ring_wake(struct ring_shared *r, uint32_t side) {
+    (void)r;
+    (void)side;
+    return (uint32_t)-1;
+}
+
+/* IPC走完整寄存器帧的入口，返回错误 */
+void ipc_send(struct syscall_regs *regs) {
+    regs->r0 = (uint32_t)-1;
+}
+
+void ipc_recv(struct syscall_regs *regs) {
+    regs->r0 = (uint32_t)-1;
+}
+
+void ipc_call(struct syscall_regs *regs) {
+    regs->r0 = (uint32_t)-1;
+}
+
+void ipc_reply(struct syscall_regs *regs) {
+    regs->r0 = (uint32_t)-1;
+}
+
+void ipc_reply_recv(struct syscall_regs *regs) {
+    regs->r0 = (uint32_t)-1;
+}
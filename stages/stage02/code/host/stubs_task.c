@@ -0,0 +1,46 @@
+/*
+ * SkyOS 主机测试环境：任务相关函数的桩
+ * 文件: host/stubs_task.c
+ *
+ * 只链接进skyos-host：定时器等模块调用的任务函数只计数，测试通过
+ * host_current_task设置当前任务。skyos-host-sched链接真正的kernel/task.c。
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "task.h"
+#include "hal_host.h"
+
+/* ===== 任务 ===== */
+
+struct task *host_current_task = NULL;
+uint32_t host_tasks_woken = 0;
+uint32_t host_sched_ticks = 0;
+
+struct task *task_current(void) {
+    return host_current_task;
+}
+
+void task_schedule(void) {
+}
+
+int task_wake(struct task *t) {
+    t->state = TASK_RUNNABLE;
+    host_tasks_woken++;
+    return 0;
+}
+
+void sched_tick(void) {
+    host_sched_ticks++;
+}
+
+uint32_t sys_sched_setaffinity(uint32_t tid, uint32_t mask) {
+    (void)tid;
+    (void)mask;
+    return (uint32_t)-1;
+}
+
+uint32_t sys_sched_getaffinity(uint32_t tid) {
+    (void)tid;
+    return 1;
+}
@@ -0,0 +1,76 @@
+/*
+ * SkyOS 主机测试环境：测试和微基准的注册
+ * 文件: host/test.h
+ *
+ * TEST(name)/BENCH(name)定义的函数放入链接段host_tests，由host/main.c
+ * 遍历执行 (与PLATFORM_DRIVER相同的方式，新增测试文件不需要改别处)。
+ * 每个测试在fork出的子进程中运行，内核模块的静态变量从初始状态开始，
+ * 测试之间互不影响；CHECK失败或崩溃只影响当前测试。
+ */
+
+#ifndef _SKYOS_HOST_TEST_H_
+#define _SKYOS_HOST_TEST_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "hal_host.h"
+
+struct host_test {
+    const char *name;
+    void (*fn)(void);
+    int bench;
+    int line;
+    const char *file;           /* 按文件名和行号排序后运行 */
+};
+
+#define HOST_TEST_ENTRY(prefix, tname, is_bench)                            \
+    static void prefix##_##tname(void);                                     \
+    static const struct host_test prefix##_entry_##tname                    \
+    __attribute__((used, section("host_tests"), aligned(8))) = {            \
+        .name = #tname, .fn = prefix##_##tname, .bench = (is_bench),        \
+        .line = __LINE__, .file = __FILE__ };                               \
+    static void prefix##_##tname(void)
+
+#define TEST(tname)     HOST_TEST_ENTRY(host_test, tname, 0)
+#define BENCH(tname)    HOST_TEST_ENTRY(host_bench, tname, 1)
+
+/* 失败时打印位置并结束当前测试 (子进程) */
+#define CHECK(cond) do {                                                    \
+    if (!(cond)) {                                                          \
+        fprintf(stderr, "  %s:%d: CHECK(%s) 失败\n", __FILE__, __LINE__, #cond); \
+        exit(1);                                                            \
+    }                                                                       \
+} while (0)
+
+#define CHECK_EQ(a, b) do {                                                 \
+    unsigned long long _a = (unsigned long long)(a);                        \
+    unsigned long long _b = (unsigned long long)(b);                        \
+    if (_a != _b) {                                                         \
+        fprintf(stderr, "  %s:%d: CHECK_EQ(%s, %s) 失败: 0x%llx != 0x%llx\n", \
+                __FILE__, __LINE__, #a, #b, _a, _b);                        \
+        exit(1);                                                            \
+    }                                                                       \
+} while (0)
+
+/* ===== 微基准 ===== */
+
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* 输出一行结果：每次操作的纳秒数 */
+static inline void bench_report(const char *what, uint64_t ops, uint64_t ns) {
+    printf("  %10.1f ns/次  %10llu 次  %s\n", ops ? (double)ns / (double)ops : 0.0,
+           (unsigned long long)ops, what);
+}
+
+/* 防止编译器把基准循环中的结果优化掉 */
+static inline void bench_keep(uint64_t v) {
+    asm volatile("" : : "r"(v) : "memory");
+}
+
+#endif /* _SKYOS_HOST_TEST_H_ */
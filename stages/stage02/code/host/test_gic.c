@@ -0,0 +1,190 @@
+/*
+ * SkyOS 主机测试：GIC驱动与中断分发 (kernel/gic.c)
+ * 文件: host/test_gic.c
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "hal.h"
+#include "test.h"
+
+/* 外部函数声明 */
+typedef void (*irq_handler_t)(uint32_t irq_id, void *data);
+extern int gic_request_irq(uint32_t irq_id, irq_handler_t handler, void *data);
+extern void gic_free_irq(uint32_t irq_id);
+extern void gic_enable_interrupt(uint32_t irq_id);
+extern void gic_disable_interrupt(uint32_t irq_id);
+extern uint32_t gic_is_interrupt_enabled(uint32_t irq_id);
+extern void gic_send_sgi(uint32_t sgi_id, uint32_t target_cpu_mask);
+extern uint32_t gic_timer_irq(void);
+extern void handle_irq(uint32_t *frame);
+extern uint32_t *irq_get_regs(void);
+
+static uint32_t last_irq;
+static void *last_data;
+static uint32_t handler_calls;
+static uint32_t other_calls;
+
+static void count_handler(uint32_t irq_id, void *data) {
+    last_irq = irq_id;
+    last_data = data;
+    handler_calls++;
+}
+
+static void other_handler(uint32_t irq_id, void *data) {
+    (void)irq_id;
+    (void)data;
+    other_calls++;
+}
+
+/* 探测后分发器和CPU接口使能，定时器中断 (PPI 14) 按设备树配置 */
+TEST(gic_probe) {
+    host_boot_timer();
+
+    CHECK_EQ(mmio_read32(HOST_GICD_BASE + 0x000), 1);
+    CHECK_EQ(mmio_read32(HOST_GICC_BASE + 0x000), 1);
+    CHECK_EQ(mmio_read32(HOST_GICC_BASE + 0x004), 0xFF);
+    CHECK_EQ(gic_timer_irq(), 30);
+    CHECK(fake_gic_enabled(30));
+    CHECK_EQ(fake_gic_priority(30), 0x80);
+    CHECK(!fake_gic_enabled(40));
+    CHECK(host_uart_contains("GIC初始化完成"));
+}
+
+/* 设备树中少于两个reg时不绑定 */
+TEST(gic_probe_missing_reg) {
+    static const struct fdt_device node = { .name = "intc", .nr_reg = 1 };
+
+    fake_gic_install();
+    CHECK(host_probe("gic", &node) != 0);
+}
+
+TEST(gic_enable_disable) {
+    host_boot_timer();
+
+    gic_enable_interrupt(45);
+    CHECK(fake_gic_enabled(45));
+    CHECK_EQ(gic_is_interrupt_enabled(45), 1);
+    /* ISENABLER写1置位，其他中断不受影响 */
+    gic_enable_interrupt(46);
+    CHECK(fake_gic_enabled(45));
+    gic_disable_interrupt(45);
+    CHECK(!fake_gic_enabled(45));
+    CHECK(fake_gic_enabled(46));
+    CHECK_EQ(gic_is_interrupt_enabled(45), 0);
+}
+
+/* 注册的处理程序收到中断号和data，结束后写EOIR */
+TEST(gic_request_irq_dispatch) {
+    static int cookie;
+    host_boot_timer();
+
+    CHECK_EQ(gic_request_irq(40, count_handler, &cookie), 0);
+    CHECK(fake_gic_enabled(40));
+    CHECK_EQ(fake_gic_priority(40), 0x80);
+    CHECK_EQ(fake_gic_target(40), 0x01);
+
+    fake_gic_raise(40);
+    CHECK_EQ(fake_gic_dispatch(), 1);
+    CHECK_EQ(handler_calls, 1);
+    CHECK_EQ(last_irq, 40);
+    CHECK(last_data == &cookie);
+    CHECK_EQ(fake_gic_eoi_count(), 1);
+    CHECK(irq_get_regs() == NULL);
+}
+
+/* 注销后中断被禁用，挂起也不会分发 */
+TEST(gic_free_irq) {
+    host_boot_timer();
+
+    CHECK_EQ(gic_request_irq(41, count_handler, NULL), 0);
+    gic_free_irq(41);
+    CHECK(!fake_gic_enabled(41));
+    fake_gic_raise(41);
+    CHECK_EQ(fake_gic_dispatch(), 0);
+    CHECK_EQ(handler_calls, 0);
+}
+
+/* 已注册时替换处理程序；旧描述符在宽限期后经call_rcu回收 */
+TEST(gic_replace_and_recycle) {
+    uint32_t n;
+    host_boot_timer();
+
+    CHECK_EQ(gic_request_irq(42, count_handler, NULL), 0);
+    CHECK_EQ(gic_request_irq(42, other_handler, NULL), 0);
+    fake_gic_raise(42);
+    fake_gic_dispatch();
+    CHECK_EQ(handler_calls, 0);
+    CHECK_EQ(other_calls, 1);
+
+    for (uint32_t i = 0; i < 1000; i++) {
+        CHECK_EQ(gic_request_irq(43, count_handler, NULL), 0);
+        gic_free_irq(43);
+        host_rcu_barrier();
+    }
+
+    /* 宽限期结束前旧描述符不能重用，池会用完 */
+    n = 0;
+    while (n < 64 && gic_request_irq(43, count_handler, NULL) == 0) {
+        n++;
+    }
+    CHECK(n < 64);
+    host_rcu_barrier();
+    CHECK_EQ(gic_request_irq(43, count_handler, NULL), 0);
+    CHECK(gic_request_irq(256, count_handler, NULL) < 0);
+    CHECK(gic_request_irq(44, NULL, NULL) < 0);
+}
+
+/* SGI写入SGIR (目标列表在[23:16])，发给自己的SGI经同一路径分发 */
+TEST(gic_sgi) {
+    host_boot_timer();
+
+    CHECK_EQ(gic_request_irq(5, count_handler, NULL), 0);
+    gic_send_sgi(5, 0x01);
+    CHECK_EQ(fake_gic_last_sgi(), (1u << 16) | 5);
+    CHECK_EQ(fake_gic_dispatch(), 1);
+    CHECK_EQ(last_irq, 5);
+
+    gic_send_sgi(5, 0x02);
+    CHECK_EQ(fake_gic_dispatch(), 0);
+}
+
+/* 没有处理程序的中断和伪中断只记录日志，仍然写EOIR */
+TEST(gic_unknown_and_spurious) {
+    host_boot_timer();
+
+    gic_enable_interrupt(50);
+    fake_gic_raise(50);
+    CHECK_EQ(fake_gic_dispatch(), 1);
+    CHECK(host_uart_contains("未知IRQ: 0x00000032"));
+
+    handle_irq(NULL);
+    CHECK(host_uart_contains("伪IRQ中断"));
+    CHECK_EQ(fake_gic_eoi_count(), 2);
+}
+
+/* ===== 微基准 ===== */
+
+/* IRQ分发：IAR→查表→处理程序→EOIR (经假GIC的MMIO钩子) */
+BENCH(irq_dispatch) {
+    const uint32_t loops = 1000000;
+    uint64_t start;
+
+    host_boot_timer();
+    gic_request_irq(40, count_handler, NULL);
+
+    start = bench_now_ns();
+    for (uint32_t i = 0; i < loops; i++) {
+        fake_gic_raise(40);
+        handle_irq(NULL);
+    }
+    bench_report("handle_irq (注册的SPI)", loops, bench_now_ns() - start);
+    CHECK_EQ(handler_calls, loops);
+
+    start = bench_now_ns();
+    for (uint32_t i = 0; i < loops; i++) {
+        gic_request_irq(41, other_handler, NULL);
+        host_rcu_barrier();
+    }
+    bench_report("gic_request_irq (替换+RCU回收)", loops, bench_now_ns() - start);
+}
@@ -0,0 +1,154 @@
+/*
+ * SkyOS 主机测试：格式化和内核日志环 (kernel/kprintf.c)
+ * 文件: host/test_kprintf.c
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "kprintf.h"
+#include "test.h"
+
+#define CHECK_FMT(expect, ...) do {                                         \
+    char _buf[128];                                                         \
+    int _len = ksnprintf(_buf, sizeof(_buf), __VA_ARGS__);                  \
+    if (strcmp(_buf, (expect)) != 0 || _len != (int)strlen(expect)) {      \
+        fprintf(stderr, "  %s:%d: \"%s\" (%d) != \"%s\"\n",                  \
+                __FILE__, __LINE__, _buf, _len, (expect));                  \
+        exit(1);                                                            \
+    }                                                                       \
+} while (0)
+
+TEST(kprintf_format) {
+    const char *volatile null_str = NULL;   /* 编译器看不到NULL，不报format警告 */
+
+    CHECK_FMT("-42|   42|42   |00042", "%d|%5d|%-5d|%05d", -42, 42, 42, 42);
+    CHECK_FMT("-2147483648 4294967295", "%d %u", (int32_t)0x80000000, 0xFFFFFFFFu);
+    CHECK_FMT("beef BEEF 00001234 0xff", "%x %X %08X %#x", 0xbeefu, 0xbeefu, 0x1234u, 255u);
+    CHECK_FMT("18446744073709551615 -9000000000", "%llu %lld",
+              18446744073709551615ull, -9000000000ll);
+    CHECK_FMT("abc|abc|  xy|xy  |z%", "%s|%.3s|%4s|%-4s|%c%%", "abc", "abcdef", "xy", "xy", 'z');
+    CHECK_FMT("(null)", "%s", null_str);
+    CHECK_FMT("0x00001000", "%p", (void *)0x1000);
+}
+
+/* 截断时仍以'\0'结尾，返回值是完整长度 */
+TEST(kprintf_truncate) {
+    char small[8];
+
+    CHECK_EQ(ksnprintf(small, sizeof(small), "%s", "0123456789"), 10);
+    CHECK(strcmp(small, "0123456") == 0);
+    CHECK_EQ(ksnprintf(small, 0, "%u", 12345u), 5);
+}
+
+/* 内核自带的kprintf自检在主机上同样通过 */
+TEST(kprintf_selftest) {
+    host_boot_timer();
+    klog_init();
+
+    test_kprintf();
+    CHECK(host_uart_contains("格式化: 通过"));
+    CHECK(host_uart_contains("结果: 通过"));
+}
+
+/* 级别数值小于控制台级别的记录才输出；换行输出为"\r\n" */
+TEST(klog_console_level) {
+    klog_init();
+
+    kprintf("info %u\n", 1u);
+    CHECK(host_uart_contains("info 1\r\n"));
+    kprintf(KERN_DEBUG "debug\n");
+    CHECK(!host_uart_contains("debug"));
+
+    klog_set_console_level(LOGLEVEL_ERR + 1);
+    pr_warn("warning\n");
+    pr_err("error\n");
+    CHECK(!host_uart_contains("warning"));
+    CHECK(host_uart_contains("error\r\n"));
+}
+
+/* 异步模式：普通级别等刷新工作输出，错误级别同步输出 */
+TEST(klog_async_flush) {
+    host_boot_timer();
+    klog_init();
+    klog_start_async();
+    host_uart_clear();
+
+    kprintf("deferred\n");
+    CHECK(!host_uart_contains("deferred"));
+    pr_err("urgent\n");
+    CHECK(host_uart_contains("deferred\r\nurgent\r\n"));
+
+    kprintf("kicked\n");
+    klog_kick();
+    CHECK(host_uart_contains("kicked"));
+
+    /* 没有人触发时由定时器兜底刷新 */
+    kprintf("by timer\n");
+    host_advance_ticks(20);
+    CHECK(host_uart_contains("by timer"));
+}
+
+/* 刷新落后超过一圈时丢弃最旧的记录 */
+TEST(klog_overrun) {
+    klog_init();
+    klog_start_async();
+    host_uart_clear();
+
+    for (uint32_t i = 0; i < LOG_NR_RECORDS + 44; i++) {
+        kprintf("rec %u\n", i);
+    }
+    klog_kick();
+    CHECK(!host_uart_contains("rec 43\r\n"));
+    CHECK(host_uart_contains("rec 44\r\n"));
+    CHECK(host_uart_contains("rec 299\r\n"));
+
+    /* 还有klog_start_async写的一条 */
+    klog_print_stats();
+    CHECK(host_uart_contains("丢弃: 45"));
+}
+
+/* 超长记录在UTF-8字符边界截断 */
+TEST(klog_long_record) {
+    char line[LOG_TEXT_MAX * 2];
+
+    klog_init();
+    for (uint32_t i = 0; i + 3 < sizeof(line); i += 3) {
+        memcpy(&line[i], "日", 3);
+        line[i + 3] = '\0';
+    }
+    host_uart_clear();
+    kprintf("%s", line);
+    CHECK_EQ(strlen(host_uart_output()), LOG_TEXT_MAX / 3 * 3);
+}
+
+/* ===== 微基准 ===== */
+
+BENCH(kprintf) {
+    const uint32_t loops = 1000000;
+    char buf[LOG_TEXT_MAX];
+    uint64_t start;
+
+    start = bench_now_ns();
+    for (uint32_t i = 0; i < loops; i++) {
+        bench_keep(ksnprintf(buf, sizeof(buf), "tick %u cpu %u: %08x %s\n",
+                             i, 0u, i * 2654435761u, "done"));
+    }
+    bench_report("ksnprintf", loops, bench_now_ns() - start);
+
+    /* 异步模式下只写日志环 */
+    klog_init();
+    klog_start_async();
+    start = bench_now_ns();
+    for (uint32_t i = 0; i < loops; i++) {
+        kprintf("tick %u cpu %u: %08x %s\n", i, 0u, i * 2654435761u, "done");
+    }
+    bench_report("kprintf (写日志环)", loops, bench_now_ns() - start);
+
+    /* 每条都同步刷新到 (收集输出的) 串口 */
+    start = bench_now_ns();
+    for (uint32_t i = 0; i < loops / 10; i++) {
+        pr_err("tick %u cpu %u: %08x %s\n", i, 0u, i * 2654435761u, "done");
+    }
+    bench_report("pr_err (同步输出)", loops / 10, bench_now_ns() - start);
+}
@@ -0,0 +1,151 @@
+/*
+ * SkyOS 主机测试：物理页分配器 (kernel/page_alloc.c)
+ * 文件: host/test_page_alloc.c
+ *
+ * 分配器只管理位图，返回的地址不会被解引用；测试程序链接时把
+ * __kernel_end定义为HOST_KERNEL_END (见Makefile的host-test)。
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "page_alloc.h"
+#include "test.h"
+
+#define HOST_KERNEL_END 0x40100000
+#define HOST_PAGES      ((RAM_BASE + RAM_SIZE - HOST_KERNEL_END) / PAGE_SIZE)
+
+static uint32_t addr_of(void *p) {
+    return (uint32_t)(uintptr_t)p;
+}
+
+TEST(page_alloc_init) {
+    page_alloc_init();
+
+    CHECK_EQ(page_free_count(), HOST_PAGES);
+    CHECK(host_uart_contains("页分配器: 起始 0x40100000"));
+}
+
+/* 单页从低地址开始依次分配，释放后的页优先重用 */
+TEST(page_alloc_single) {
+    void *a, *b, *c;
+
+    page_alloc_init();
+    a = alloc_page();
+    b = alloc_page();
+    CHECK_EQ(addr_of(a), HOST_KERNEL_END);
+    CHECK_EQ(addr_of(b), HOST_KERNEL_END + PAGE_SIZE);
+    CHECK_EQ(page_free_count(), HOST_PAGES - 2);
+
+    free_page(a);
+    c = alloc_page();
+    CHECK(c == a);
+    free_page(b);
+    free_page(c);
+    CHECK_EQ(page_free_count(), HOST_PAGES);
+}
+
+/* 连续多页：首次适配，跳过已用的页 */
+TEST(page_alloc_contiguous) {
+    void *one, *run, *hole;
+
+    page_alloc_init();
+    one = alloc_page();
+    hole = alloc_page();
+    alloc_page();
+    free_page(hole);
+
+    /* 第1页空出的洞放不下4页 */
+    run = alloc_pages(4);
+    CHECK_EQ(addr_of(run), HOST_KERNEL_END + 3 * PAGE_SIZE);
+    CHECK_EQ(addr_of(alloc_pages(1)), addr_of(hole));
+    free_pages(run, 4);
+    CHECK_EQ(page_free_count(), HOST_PAGES - 3);
+    (void)one;
+}
+
+/* 分配完所有页后失败，全部释放后恢复 */
+TEST(page_alloc_exhaust) {
+    static uint32_t pages[HOST_PAGES];
+
+    page_alloc_init();
+    for (uint32_t i = 0; i < HOST_PAGES; i++) {
+        void *p = alloc_page();
+        CHECK(p != NULL);
+        pages[i] = addr_of(p);
+    }
+    CHECK(alloc_page() == NULL);
+    CHECK(alloc_pages(2) == NULL);
+    CHECK_EQ(page_free_count(), 0);
+    CHECK_EQ(pages[HOST_PAGES - 1], RAM_BASE + RAM_SIZE - PAGE_SIZE);
+
+    for (uint32_t i = 0; i < HOST_PAGES; i++) {
+        free_page((void *)(uintptr_t)pages[i]);
+    }
+    CHECK_EQ(page_free_count(), HOST_PAGES);
+}
+
+/* 保留区间按页取整；重复、越界和未对齐的释放被忽略 */
+TEST(page_reserve_and_bad_free) {
+    page_alloc_init();
+
+    page_reserve(HOST_KERNEL_END + 100, PAGE_SIZE);
+    CHECK_EQ(page_free_count(), HOST_PAGES - 2);
+    CHECK_EQ(addr_of(alloc_page()), HOST_KERNEL_END + 2 * PAGE_SIZE);
+
+    page_reserve(RAM_BASE, PAGE_SIZE);
+    CHECK_EQ(page_free_count(), HOST_PAGES - 3);
+
+    free_page((void *)(uintptr_t)(HOST_KERNEL_END + 2 * PAGE_SIZE + 4));
+    free_page((void *)(uintptr_t)RAM_BASE);
+    free_page(NULL);
+    CHECK_EQ(page_free_count(), HOST_PAGES - 3);
+    free_page((void *)(uintptr_t)(HOST_KERNEL_END + 2 * PAGE_SIZE));
+    free_page((void *)(uintptr_t)(HOST_KERNEL_END + 2 * PAGE_SIZE));
+    CHECK_EQ(page_free_count(), HOST_PAGES - 2);
+}
+
+/* ===== 微基准 ===== */
+
+BENCH(page_alloc) {
+    static uint32_t pages[HOST_PAGES];
+    const uint32_t loops = 2000000;
+    uint64_t start;
+    uint32_t n;
+
+    page_alloc_init();
+
+    /* 分配后立即释放：提示字始终命中 */
+    start = bench_now_ns();
+    for (uint32_t i = 0; i < loops; i++) {
+        free_page(alloc_page());
+    }
+    bench_report("alloc_page+free_page (空闲)", loops, bench_now_ns() - start);
+
+    /* 分配全部页再全部释放 */
+    start = bench_now_ns();
+    for (n = 0; n < HOST_PAGES; n++) {
+        pages[n] = addr_of(alloc_page());
+    }
+    bench_report("alloc_page (直到耗尽)", n, bench_now_ns() - start);
+    start = bench_now_ns();
+    for (uint32_t i = 0; i < n; i++) {
+        free_page((void *)(uintptr_t)pages[i]);
+    }
+    bench_report("free_page", n, bench_now_ns() - start);
+
+    /* 隔页占用后，单页分配要跳过半满的字，连续分配只能从高端找 */
+    for (n = 0; n < HOST_PAGES; n++) {
+        pages[n] = addr_of(alloc_page());
+    }
+    for (uint32_t i = 0; i < HOST_PAGES / 2; i += 2) {
+        free_page((void *)(uintptr_t)pages[i]);
+    }
+    for (uint32_t i = HOST_PAGES / 2; i < HOST_PAGES; i++) {
+        free_page((void *)(uintptr_t)pages[i]);
+    }
+    start = bench_now_ns();
+    for (uint32_t i = 0; i < 10000; i++) {
+        free_pages(alloc_pages(8), 8);
+    }
+    bench_report("alloc_pages(8)+free_pages (碎片化)", 10000, bench_now_ns() - start);
+}
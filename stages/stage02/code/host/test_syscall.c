@@ -0,0 +1,143 @@
+/*
+ * SkyOS 主机测试：系统调用分发表 (kernel/syscall.c)
+ * 文件: host/test_syscall.c
+ *
+ * syscall.h的syscallN在主机上直接调用handle_swi。参数按32位传递，
+ * 指针参数只能指向静态数据 (-no-pie链接，地址在4GB以下)。
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "syscall.h"
+#include "kprintf.h"
+#include "test.h"
+
+#define SYS_TEST    30
+
+static const char hello[] = "hello, syscall\n";
+
+static uint32_t sys_test_sum(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    return a + 2 * b + 3 * c + 4 * d;
+}
+
+static uint32_t sys_test_const(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    (void)a;
+    (void)b;
+    (void)c;
+    (void)d;
+    return 0x5A5A;
+}
+
+TEST(syscall_builtin) {
+    host_boot_timer();
+    syscall_init();
+
+    host_advance_ticks(3);
+    CHECK_EQ(syscall0(SYS_GETTIME), 3);
+    CHECK_EQ(syscall3(SYS_WRITE, 1, hello, sizeof(hello) - 1), sizeof(hello) - 1);
+    CHECK_EQ(syscall3(SYS_WRITE, 7, hello, 1), (uint32_t)-1);
+    CHECK_EQ(syscall1(SYS_PRINT, hello), strlen(hello));
+    CHECK_EQ(syscall_total_count(), 4);
+}
+
+/* 未注册、越界的调用号返回-1并记录错误 */
+TEST(syscall_invalid) {
+    syscall_init();
+
+    CHECK_EQ(syscall0(SYS_INVALID), (uint32_t)-1);
+    CHECK_EQ(syscall0(SYS_TEST), (uint32_t)-1);
+    CHECK_EQ(syscall0(99), (uint32_t)-1);
+    CHECK(host_uart_contains("Unknown system call number: 0x00000063"));
+    CHECK_EQ(syscall_total_count(), 3);
+}
+
+/* 运行时注册的调用收到r0-r3，注销后返回错误 */
+TEST(syscall_register) {
+    syscall_init();
+
+    CHECK_EQ(syscall_register(SYS_TEST, sys_test_sum, "test_sum"), 0);
+    CHECK_EQ(syscall4(SYS_TEST, 1, 2, 3, 4), 1 + 4 + 9 + 16);
+    CHECK(host_uart_contains("SWI #0x0000001E (test_sum) called with args: "
+                             "0x00000001, 0x00000002, 0x00000003, 0x00000004"));
+
+    /* 替换内置调用 */
+    CHECK_EQ(syscall_register(SYS_GETTIME, sys_test_const, "const"), 0);
+    CHECK_EQ(syscall0(SYS_GETTIME), 0x5A5A);
+
+    CHECK_EQ(syscall_unregister(SYS_TEST), 0);
+    CHECK_EQ(syscall4(SYS_TEST, 1, 2, 3, 4), (uint32_t)-1);
+
+    CHECK(syscall_register(SYS_INVALID, sys_test_sum, "bad") < 0);
+    CHECK(syscall_register(SYSCALL_MAX, sys_test_sum, "bad") < 0);
+    CHECK(syscall_register(SYS_TEST, NULL, "bad") < 0);
+    CHECK(syscall_unregister(SYSCALL_MAX) < 0);
+}
+
+/* 被替换的描述符在宽限期后经call_rcu放回池中 */
+TEST(syscall_register_recycle) {
+    uint32_t n;
+
+    syscall_init();
+
+    for (uint32_t i = 0; i < 1000; i++) {
+        CHECK_EQ(syscall_register(SYS_TEST, (i & 1) ? sys_test_sum : sys_test_const, "t"), 0);
+        host_rcu_barrier();
+    }
+    CHECK_EQ(syscall4(SYS_TEST, 1, 1, 1, 1), 10);
+
+    /* 宽限期结束前被替换的描述符仍在使用中 */
+    n = 0;
+    while (n < 64 && syscall_register(SYS_TEST, sys_test_sum, "t") == 0) {
+        n++;
+    }
+    CHECK(n < 64);
+    host_rcu_barrier();
+    CHECK_EQ(syscall_register(SYS_TEST, sys_test_const, "t"), 0);
+}
+
+/* 热路径调用不打印跟踪；完整寄存器帧的调用 (IPC) 不经过参数转换 */
+TEST(syscall_notrace_and_regs) {
+    syscall_init();
+
+    syscall0(SYS_GETTIME);
+    syscall3(SYS_WRITE, 1, hello, 1);
+    CHECK(!host_uart_contains("SWI #"));
+
+    CHECK_EQ(syscall2(SYS_IPC_SEND, 1, 2), (uint32_t)-1);
+    CHECK(!host_uart_contains("SWI #"));
+
+    syscall1(SYS_CLOSE, 3);
+    CHECK(host_uart_contains("SWI #0x00000007 (close)"));
+}
+
+/* ===== 微基准 ===== */
+
+/* 分发路径：计数、RCU读表、调用处理函数 (不含SVC陷入本身) */
+BENCH(syscall_dispatch) {
+    const uint32_t loops = 5000000;
+    uint64_t start;
+
+    syscall_init();
+    start = bench_now_ns();
+    for (uint32_t i = 0; i < loops; i++) {
+        bench_keep(syscall0(SYS_GETTIME));
+    }
+    bench_report("gettime (内置, 不跟踪)", loops, bench_now_ns() - start);
+
+    syscall_register(SYS_TEST, sys_test_sum, "test_sum");
+    start = bench_now_ns();
+    for (uint32_t i = 0; i < loops / 10; i++) {
+        bench_keep(syscall4(SYS_TEST, i, 1, 2, 3));
+    }
+    bench_report("动态注册 (跟踪写串口)", loops / 10, bench_now_ns() - start);
+
+    /* 日志环异步输出时跟踪只写入日志环 */
+    klog_init();
+    klog_start_async();
+    start = bench_now_ns();
+    for (uint32_t i = 0; i < loops / 10; i++) {
+        bench_keep(syscall4(SYS_TEST, i, 1, 2, 3));
+    }
+    bench_report("动态注册 (跟踪写日志环)", loops / 10, bench_now_ns() - start);
+}
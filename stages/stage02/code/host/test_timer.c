@@ -0,0 +1,230 @@
+/*
+ * SkyOS 主机测试：ARM Generic Timer、周期回调和定时睡眠 (kernel/timer.c)
+ * 文件: host/test_timer.c
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "timer.h"
+#include "task.h"
+#include "idle.h"
+#include "test.h"
+
+/* 外部函数声明 */
+extern int timer_register_callback(void (*fn)(void *data), void *data, uint32_t period_ticks);
+extern uint32_t timer_get_interrupt_count(void);
+
+#define TIMER_INTERVAL  (62500000 / 100)
+
+static uint32_t cb_calls[8];
+
+static void count_cb(void *data) {
+    cb_calls[(uintptr_t)data]++;
+}
+
+/* 当前任务睡眠ms毫秒 (进入定时睡眠链表，由定时器中断唤醒) */
+static void sleep_as(struct task *t, uint32_t ms) {
+    host_current_task = t;
+    t->state = TASK_RUNNABLE;
+    timer_delay_ms(ms);
+    host_current_task = NULL;
+}
+
+/* 探测后按CVAL设定第一个滴答，定时器使能且不屏蔽 */
+TEST(timer_probe) {
+    host_cp15.cntpct = 12345;
+    host_boot_timer();
+
+    CHECK_EQ(timer_get_frequency(), 62500000);
+    CHECK_EQ(host_cp15.cntp_ctl, 1);
+    CHECK_EQ(host_cp15.cntp_cval, 12345 + TIMER_INTERVAL);
+    CHECK(!host_timer_pending());
+}
+
+/* 每个截止时间一次中断、一个滴答，并驱动调度器 */
+TEST(timer_ticks) {
+    host_boot_timer();
+
+    host_advance_ticks(5);
+    CHECK_EQ(get_timer_ticks(), 5);
+    CHECK_EQ(timer_get_interrupt_count(), 5);
+    CHECK_EQ(host_sched_ticks, 5);
+    CHECK_EQ(fake_gic_eoi_count(), 5);
+
+    /* 截止时间之前的残留中断不计滴答 */
+    fake_gic_raise(30);
+    fake_gic_dispatch();
+    CHECK_EQ(get_timer_ticks(), 5);
+    CHECK_EQ(timer_get_interrupt_count(), 6);
+}
+
+/* 每100个滴答输出一次运行时间 */
+TEST(timer_second_message) {
+    host_boot_timer();
+
+    host_advance_ticks(99);
+    CHECK(!host_uart_contains("定时器: 1秒"));
+    host_advance_ticks(1);
+    CHECK(host_uart_contains("定时器: 1秒 (100 滴答, 100 中断)"));
+}
+
+TEST(timer_callbacks) {
+    host_boot_timer();
+
+    CHECK_EQ(timer_register_callback(count_cb, (void *)0, 3), 0);
+    CHECK_EQ(timer_register_callback(count_cb, (void *)1, 0), 0);  /* 周期0按1处理 */
+    host_advance_ticks(9);
+    CHECK_EQ(cb_calls[0], 3);
+    CHECK_EQ(cb_calls[1], 9);
+
+    /* 表满 (8项) 时注册失败 */
+    for (uint32_t i = 2; i < 8; i++) {
+        CHECK_EQ(timer_register_callback(count_cb, (void *)(uintptr_t)i, 100), 0);
+    }
+    CHECK(timer_register_callback(count_cb, NULL, 1) < 0);
+}
+
+/* 睡眠链表按唤醒滴答排序，到期的任务在定时器中断中被唤醒 */
+TEST(timer_sleepers) {
+    static struct task t[3];
+    host_boot_timer();
+
+    sleep_as(&t[0], 30);
+    sleep_as(&t[1], 10);
+    sleep_as(&t[2], 20);
+    CHECK_EQ(t[0].state, TASK_BLOCKED);
+    CHECK_EQ(timer_next_event(), 1);
+
+    host_advance_ticks(1);
+    CHECK_EQ(t[1].state, TASK_RUNNABLE);
+    CHECK_EQ(t[2].state, TASK_BLOCKED);
+    CHECK_EQ(host_tasks_woken, 1);
+    CHECK_EQ(timer_next_event(), 1);
+
+    host_advance_ticks(2);
+    CHECK_EQ(t[0].state, TASK_RUNNABLE);
+    CHECK_EQ(t[2].state, TASK_RUNNABLE);
+    CHECK_EQ(host_tasks_woken, 3);
+}
+
+/* 没有事件时为上限，周期回调计入下一个事件 */
+TEST(timer_next_event) {
+    host_boot_timer();
+
+    CHECK_EQ(timer_next_event(), 50);
+    timer_register_callback(count_cb, (void *)0, 7);
+    CHECK_EQ(timer_next_event(), 7);
+}
+
+/* 停滴答期间不产生中断，恢复后一次中断补上错过的滴答 */
+TEST(timer_stop_tick_catch_up) {
+    host_boot_timer();
+    host_advance_ticks(1);
+
+    timer_stop_tick(10);
+    CHECK_EQ(host_cp15.cntp_cval, host_cp15.cntpct + 10 * TIMER_INTERVAL);
+
+    /* 4个滴答后被其他中断唤醒 */
+    host_cp15.cntpct += 4 * TIMER_INTERVAL;
+    CHECK(!host_timer_pending());
+    timer_restart_tick();
+    CHECK(host_timer_pending());
+    fake_gic_raise(30);
+    fake_gic_dispatch();
+    CHECK_EQ(get_timer_ticks(), 5);
+    CHECK_EQ(timer_get_interrupt_count(), 2);
+    CHECK(!host_timer_pending());
+
+    /* 少于2个滴答不值得停 */
+    timer_stop_tick(1);
+    CHECK_EQ(host_cp15.cntp_cval, host_cp15.cntpct + TIMER_INTERVAL);
+}
+
+/* 停满10个滴答：到期时一次中断推进10个滴答 */
+TEST(timer_stop_tick_full) {
+    host_boot_timer();
+
+    timer_stop_tick(10);
+    host_advance_ticks(9);
+    CHECK_EQ(timer_get_interrupt_count(), 0);
+    host_advance_ticks(1);
+    CHECK_EQ(get_timer_ticks(), 10);
+    CHECK_EQ(timer_get_interrupt_count(), 1);
+}
+
+/* 计数器差值换算 (频率按整MHz计：62.5MHz算作62) */
+TEST(timer_counter_conversion) {
+    host_boot_timer();
+
+    CHECK_EQ(timer_counter_to_ns(62), 1000);
+    CHECK_EQ(timer_counter_to_ns(93), 1500);
+    CHECK_EQ(timer_counter_mbps(1000000, 62 * 1000), 1000);
+    CHECK_EQ(timer_counter_mbps(1000, 10), 0);      /* 不足1微秒 */
+}
+
+/* ===== 微基准 ===== */
+
+/* 一个滴答的完整路径：IRQ分发、CVAL重设、回调表扫描、睡眠链表检查 */
+BENCH(timer_tick) {
+    const uint32_t loops = 200000;
+    uint64_t start;
+
+    host_boot_timer();
+    start = bench_now_ns();
+    host_advance_ticks(loops);
+    bench_report("滴答 (无回调)", loops, bench_now_ns() - start);
+
+    for (uint32_t i = 0; i < 8; i++) {
+        timer_register_callback(count_cb, (void *)(uintptr_t)i, i + 1);
+    }
+    start = bench_now_ns();
+    host_advance_ticks(loops);
+    bench_report("滴答 (8个回调)", loops, bench_now_ns() - start);
+}
+
+/* 定时睡眠链表：按唤醒时间有序插入是O(n)，到期唤醒是O(1)/个 */
+BENCH(timer_sleep_list) {
+    static struct task tasks[1024];
+    static const uint32_t sizes[] = { 16, 128, 1024 };
+
+    for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        uint32_t n = sizes[s], seed = 1, woken;
+        uint64_t start, t_insert, t_wake;
+        char what[64];
+        pid_t pid;
+        int status;
+
+        /* 每种规模在新的子进程里从空链表开始 */
+        fflush(stdout);
+        pid = fork();
+        if (pid != 0) {
+            CHECK(pid > 0 && waitpid(pid, &status, 0) == pid);
+            CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+            continue;
+        }
+        host_boot_timer();
+        memset(tasks, 0, sizeof(tasks));
+        start = bench_now_ns();
+        for (uint32_t i = 0; i < n; i++) {
+            seed = seed * 1103515245 + 12345;
+            sleep_as(&tasks[i], 10 + (seed >> 16) % 1000 * 10);
+        }
+        t_insert = bench_now_ns() - start;
+
+        start = bench_now_ns();
+        host_advance_ticks(1001);
+        t_wake = bench_now_ns() - start;
+        woken = host_tasks_woken;
+
+        snprintf(what, sizeof(what), "睡眠插入 (%u个任务)", n);
+        bench_report(what, n, t_insert);
+        snprintf(what, sizeof(what), "1001个滴答 (唤醒%u个任务)", woken);
+        bench_report(what, 1001, t_wake);
+        CHECK_EQ(woken, n);
+        fflush(stdout);
+        _exit(0);
+    }
+}
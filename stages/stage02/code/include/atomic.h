@@ -0,0 +1,124 @@
+/*
+ * SkyOS 原子操作与内存屏障
+ * 文件: include/atomic.h
+ *
+ * 基于ARMv7的ldrex/strex独占访问：strex失败 (期间有其他CPU或异常
+ * 打断了独占监视器) 时重试。屏障使用内部共享域 (ish)，
+ * 多核之间可见即可，不需要等待外设。
+ *
+ * 主机测试 (SKYOS_HOST) 时换成编译器的__atomic内建函数，语义相同。
+ */
+
+#ifndef _SKYOS_ATOMIC_H_
+#define _SKYOS_ATOMIC_H_
+
+#include <stdint.h>
+
+#ifdef SKYOS_HOST
+
+#define smp_mb()    __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define smp_wmb()   __atomic_thread_fence(__ATOMIC_RELEASE)
+#define smp_rmb()   __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define dsb_sev()   __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define wfe()       do { } while (0)
+
+#else
+
+#define smp_mb()    asm volatile("dmb ish" : : : "memory")
+#define smp_wmb()   asm volatile("dmb ishst" : : : "memory")
+#define smp_rmb()   asm volatile("dmb ish" : : : "memory")     /* ARMv7没有只排序读的dmb */
+#define dsb_sev()   asm volatile("dsb ishst\n" "sev" : : : "memory")
+#define wfe()       asm volatile("wfe" : : : "memory")
+
+#endif /* SKYOS_HOST */
+
+#define READ_ONCE(x)        (*(volatile __typeof__(x) *)&(x))
+#define WRITE_ONCE(x, v)    (*(volatile __typeof__(x) *)&(x) = (v))
+
+/* *p += v，返回新值 (不含屏障，用于统计计数) */
+#ifdef SKYOS_HOST
+
+static inline uint32_t atomic_add_return_relaxed(volatile uint32_t *p, uint32_t v) {
+    return __atomic_add_fetch(p, v, __ATOMIC_RELAXED);
+}
+
+#else
+
+static inline uint32_t atomic_add_return_relaxed(volatile uint32_t *p, uint32_t v) {
+    uint32_t val, tmp;
+    asm volatile("1: ldrex %0, [%2]\n"
+                 "   add %0, %0, %3\n"
+                 "   strex %1, %0, [%2]\n"
+                 "   teq %1, #0\n"
+                 "   bne 1b"
+                 : "=&r"(val), "=&r"(tmp)
+                 : "r"(p), "Ir"(v)
+                 : "memory", "cc");
+    return val;
+}
+
+#endif /* SKYOS_HOST */
+
+static inline void atomic_inc(volatile uint32_t *p) {
+    atomic_add_return_relaxed(p, 1);
+}
+
+/* 带完整屏障的加法，返回新值 */
+static inline uint32_t atomic_add_return(volatile uint32_t *p, uint32_t v) {
+    uint32_t val;
+    smp_mb();
+    val = atomic_add_return_relaxed(p, v);
+    smp_mb();
+    return val;
+}
+
+#ifdef SKYOS_HOST
+
+/* 写入v，返回原来的值 */
+static inline uint32_t atomic_xchg(volatile uint32_t *p, uint32_t v) {
+    return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST);
+}
+
+/* 若*p == old则写入new，返回*p原来的值 */
+static inline uint32_t atomic_cmpxchg(volatile uint32_t *p, uint32_t old, uint32_t new) {
+    __atomic_compare_exchange_n(p, &old, new, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return old;
+}
+
+#else
+
+/* 写入v，返回原来的值 */
+static inline uint32_t atomic_xchg(volatile uint32_t *p, uint32_t v) {
+    uint32_t prev, tmp;
+    smp_mb();
+    asm volatile("1: ldrex %0, [%2]\n"
+                 "   strex %1, %3, [%2]\n"
+                 "   teq %1, #0\n"
+                 "   bne 1b"
+                 : "=&r"(prev), "=&r"(tmp)
+                 : "r"(p), "r"(v)
+                 : "memory", "cc");
+    smp_mb();
+    return prev;
+}
+
+/* 若*p == old则写入new，返回*p原来的值 */
+static inline uint32_t atomic_cmpxchg(volatile uint32_t *p, uint32_t old, uint32_t new) {
+    uint32_t prev, tmp;
+    smp_mb();
+    asm volatile("1: ldrex %0, [%2]\n"
+                 "   mov %1, #0\n"
+                 "   teq %0, %3\n"
+                 "   strexeq %1, %4, [%2]\n"
+                 "   teq %1, #0\n"
+                 "   bne 1b"
+                 : "=&r"(prev), "=&r"(tmp)
+                 : "r"(p), "r"(old), "r"(new)
+                 : "memory", "cc");
+    smp_mb();
+    return prev;
+}
+
+#endif /* SKYOS_HOST */
+
+#endif /* _SKYOS_ATOMIC_H_ */
@@ -0,0 +1,55 @@
+/*
+ * SkyOS 块缓冲区缓存
+ * 文件: include/bcache.h
+ *
+ * 位于块设备驱动与文件系统之间，以扇区为单位缓存数据：
+ * - 哈希索引查找，CLOCK算法淘汰
+ * - 写回：脏块挂在脏链表上，由定时器回调批量异步写回
+ * - 顺序读检测与预读
+ */
+
+#ifndef _SKYOS_BCACHE_H_
+#define _SKYOS_BCACHE_H_
+
+#include <stdint.h>
+#include "blkdev.h"
+
+#define BCACHE_BLOCK_SIZE   BLK_SECTOR_SIZE
+
+/* 缓冲区标志 */
+#define B_VALID     (1 << 0)    /* 数据有效 */
+#define B_DIRTY     (1 << 1)    /* 已修改，等待写回 */
+#define B_BUSY      (1 << 2)    /* I/O进行中 */
+#define B_READAHEAD (1 << 3)    /* 由预读载入，尚未被访问 */
+#define B_ERROR     (1 << 4)    /* 最近一次I/O失败 */
+
+struct buf {
+    struct blk_device *dev;
+    uint32_t blockno;
+    volatile uint32_t flags;
+    uint32_t refcnt;            /* 引用计数，>0时不能被淘汰 */
+    uint32_t clock_ref;         /* CLOCK访问位 */
+    uint32_t dirty_tick;        /* 变脏时的滴答数 */
+    uint8_t *data;
+
+    struct buf *hash_next;
+    struct buf *dirty_next;
+    struct buf *dirty_prev;
+
+    /* 一次I/O可覆盖多个连续块：首块的req承载整个请求 */
+    struct blk_request req;
+    struct buf *io_next;        /* 同一请求中的下一个缓冲区 */
+    struct blk_request *io_req; /* 本缓冲区所在的请求 */
+};
+
+void bcache_init(void);
+struct buf *bread(struct blk_device *dev, uint32_t blockno);
+struct buf *bget(struct blk_device *dev, uint32_t blockno);
+void bdirty(struct buf *b);
+void brelse(struct buf *b);
+int bwrite(struct buf *b);
+void bcache_readahead(struct blk_device *dev, uint32_t blockno, uint32_t count);
+void bcache_flush(int wait);
+void bcache_print_stats(void);
+
+#endif /* _SKYOS_BCACHE_H_ */
@@ -0,0 +1,91 @@
+/*
+ * SkyOS 块设备抽象层
+ * 文件: include/blkdev.h
+ *
+ * 块设备驱动(virtio-blk等)向上提供统一的请求接口：
+ * - 请求以扇区(512字节)为单位，可携带多个分散的数据段(scatter-gather)
+ * - submit一次可提交一批请求，由驱动决定如何合并门铃(doorbell)
+ * - 完成方式支持中断和轮询两种
+ */
+
+#ifndef _SKYOS_BLKDEV_H_
+#define _SKYOS_BLKDEV_H_
+
+#include <stdint.h>
+
+#define BLK_SECTOR_SIZE     512
+#define BLK_MAX_SEGS        8       /* 单个请求最多的数据段数 */
+#define BLK_MAX_DEVICES     4
+
+/* 请求类型 */
+#define BLK_REQ_READ        0
+#define BLK_REQ_WRITE       1
+#define BLK_REQ_FLUSH       2
+
+/* 请求状态 */
+#define BLK_STATUS_OK       0
+#define BLK_STATUS_IOERR    1
+#define BLK_STATUS_UNSUPP   2
+#define BLK_STATUS_PENDING  0xFF
+
+/* 数据段：一段连续的内存缓冲区 */
+struct blk_seg {
+    void *buf;
+    uint32_t len;               /* 字节数，必须是扇区大小的整数倍 */
+};
+
+struct blk_request;
+typedef void (*blk_end_io_t)(struct blk_request *req);
+
+/* 块设备请求 */
+struct blk_request {
+    uint32_t type;              /* BLK_REQ_* */
+    uint64_t sector;            /* 起始扇区 */
+    uint32_t nr_segs;
+    struct blk_seg segs[BLK_MAX_SEGS];
+
+    volatile uint32_t status;   /* BLK_STATUS_*，完成前为PENDING */
+    volatile uint32_t done;     /* 完成标志 */
+    blk_end_io_t end_io;        /* 完成回调 (可为NULL，在完成上下文中调用) */
+    void *private_data;         /* 调用者私有数据 */
+};
+
+struct blk_device;
+
+/* 块设备驱动操作 */
+struct blk_ops {
+    /* 提交一批请求，返回成功入队的请求数 */
+    uint32_t (*submit)(struct blk_device *dev, struct blk_request **reqs, uint32_t count);
+    /* 轮询完成队列，返回本次完成的请求数 */
+    uint32_t (*poll)(struct blk_device *dev);
+};
+
+/* 块设备 */
+struct blk_device {
+    const char *name;
+    uint64_t capacity;          /* 容量 (扇区数) */
+    uint32_t max_segs;          /* 单请求支持的最大数据段数 */
+    uint32_t polling;           /* 1: 轮询模式，0: 中断模式 */
+    const struct blk_ops *ops;
+    void *driver_data;
+
+    /* 统计信息 */
+    uint32_t stat_requests;
+    uint32_t stat_batches;
+    uint32_t stat_sectors;
+};
+
+/* 块设备层接口 (kernel/blkdev.c) */
+int blk_register(struct blk_device *dev);
+struct blk_device *blk_get(const char *name);
+struct blk_device *blk_get_default(void);
+void blk_init_request(struct blk_request *req, uint32_t type, uint64_t sector,
+                      void *buf, uint32_t len);
+uint32_t blk_submit(struct blk_device *dev, struct blk_request **reqs, uint32_t count);
+void blk_complete(struct blk_request *req, uint32_t status);
+void blk_wait(struct blk_device *dev, struct blk_request *req);
+int blk_read(struct blk_device *dev, uint64_t sector, void *buf, uint32_t count);
+int blk_write(struct blk_device *dev, uint64_t sector, const void *buf, uint32_t count);
+void blk_print_stats(void);
+
+#endif /* _SKYOS_BLKDEV_H_ */
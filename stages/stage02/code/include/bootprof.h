@@ -0,0 +1,27 @@
+/*
+ * SkyOS 启动计时与快速启动
+ * 文件: include/bootprof.h
+ *
+ * 启动阶段时间戳来自CNTPCT：reset_handler第一条指令之后记录复位时刻，
+ * 跳转main前再记录一次，之后由boot_mark()标记每个初始化阶段的结束。
+ *
+ * 设备树chosen/bootargs中带 "fastboot" 时，boot_defer()登记的演示和自检
+ * 不在启动路径上执行，而是在主循环开始后由一个内核线程依次执行。
+ */
+
+#ifndef _SKYOS_BOOTPROF_H_
+#define _SKYOS_BOOTPROF_H_
+
+#include <stdint.h>
+
+#define BOOT_MAX_MARKS      64      /* 表满时丢弃并告警 */
+#define BOOT_MAX_DEFERRED   64      /* 表满时就地执行并告警 */
+
+void boot_mark(const char *stage);
+int boot_param(const char *name);
+int boot_fast(void);
+void boot_defer(void (*fn)(void), const char *name);
+void boot_start_deferred(void);
+void boot_print_report(void);
+
+#endif /* _SKYOS_BOOTPROF_H_ */
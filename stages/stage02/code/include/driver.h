@@ -0,0 +1,71 @@
+/*
+ * SkyOS 平台驱动模型
+ * 文件: include/driver.h
+ *
+ * 驱动用PLATFORM_DRIVER()放入链接段 .platform_drivers (见boot/boot.lds)，
+ * 启动时按compatible字符串与设备树节点匹配，生成platform_device并探测。
+ *
+ * 探测顺序：
+ * - depends列出所依赖的提供者驱动名，全部就绪后才会探测
+ * - probe返回 -DRIVER_EPROBE_DEFER 表示运行时资源未就绪，稍后重试
+ * - 同一轮中依赖都已满足的设备彼此独立，可以分派到不同CPU并行探测
+ */
+
+#ifndef _SKYOS_DRIVER_H_
+#define _SKYOS_DRIVER_H_
+
+#include <stdint.h>
+#include "fdt.h"
+
+#define DRIVER_MAX_DEVICES      64
+
+/* probe返回值 (负值) */
+#define DRIVER_EIO              5       /* 设备初始化失败 */
+#define DRIVER_ENODEV           19      /* 节点存在但不是本驱动能处理的设备 */
+#define DRIVER_EPROBE_DEFER     517     /* 依赖未就绪，稍后重试 */
+
+/* 设备状态 */
+#define DEV_STATE_PENDING       0
+#define DEV_STATE_BOUND         1
+#define DEV_STATE_NODEV         2
+#define DEV_STATE_FAILED        3
+
+struct platform_driver;
+
+struct platform_device {
+    const struct fdt_device *node;
+    const struct platform_driver *driver;
+    uint32_t state;             /* DEV_STATE_* */
+    uint32_t defer_count;       /* 被推迟的次数 */
+    uint32_t wave;              /* 在第几轮完成探测 */
+    uint32_t probe_cycles;      /* 探测耗时 (CNTPCT计数) */
+    void *driver_data;
+};
+
+struct platform_driver {
+    const char *name;
+    const char *const *match;       /* NULL结尾的compatible列表 */
+    const char *const *depends;     /* NULL结尾的提供者驱动名，可为NULL */
+    int (*probe)(struct platform_device *pdev);
+};
+
+/*
+ * 注册驱动：放入链接段，无需修改main.c。
+ * 主机测试时段名不带点，链接器生成__start_/__stop_platform_drivers，
+ * 由host/hal_host.c按名字查找并直接探测
+ */
+#ifndef SKYOS_HOST
+#define PLATFORM_DRIVER(var) \
+    static const struct platform_driver var \
+    __attribute__((used, section(".platform_drivers"), aligned(4)))
+#else
+#define PLATFORM_DRIVER(var) \
+    static const struct platform_driver var \
+    __attribute__((used, section("platform_drivers"), aligned(8)))
+#endif
+
+void driver_probe_all(void);
+int driver_provider_ready(const char *name);
+void driver_print_stats(void);
+
+#endif /* _SKYOS_DRIVER_H_ */
@@ -0,0 +1,47 @@
+/*
+ * SkyOS 扁平设备树 (FDT) 解析
+ * 文件: include/fdt.h
+ *
+ * 启动时对QEMU传入的DTB做一次线性扫描，生成紧凑的设备表；
+ * 另建一个按compatible字符串排序的索引，驱动用二分查找获取
+ * 设备的寄存器地址和中断号。字符串直接指向DTB内部，不做拷贝。
+ */
+
+#ifndef _SKYOS_FDT_H_
+#define _SKYOS_FDT_H_
+
+#include <stdint.h>
+
+#define FDT_MAGIC           0xD00DFEED
+
+#define FDT_MAX_DEVICES     96
+#define FDT_MAX_COMPAT      160     /* 索引项总数 (一个节点可有多个compatible) */
+#define FDT_MAX_REG         2
+#define FDT_MAX_IRQS        4
+
+struct fdt_device {
+    const char *name;               /* 节点名，如 "pl011@9000000" */
+    const char *compatible;         /* compatible字符串列表 (以\0分隔) */
+    uint32_t compatible_len;
+    uint32_t reg_base[FDT_MAX_REG];
+    uint32_t reg_size[FDT_MAX_REG];
+    uint32_t nr_reg;
+    uint32_t irqs[FDT_MAX_IRQS];    /* 已换算为GIC中断ID */
+    uint32_t nr_irqs;
+    uint32_t phandle;
+    uint32_t disabled;              /* status = "disabled" */
+};
+
+void fdt_init(void);
+int fdt_available(void);
+const struct fdt_device *fdt_find_compatible(const char *compat);
+uint32_t fdt_find_all_compatible(const char *compat, const struct fdt_device **out, uint32_t max);
+int fdt_device_is_compatible(const struct fdt_device *dev, const char *compat);
+uint32_t fdt_device_count(void);
+const struct fdt_device *fdt_get_device(uint32_t index);
+const char *fdt_bootargs(void);
+int fdt_memory(uint32_t *base, uint32_t *size);
+int fdt_blob_region(uint32_t *addr, uint32_t *size);
+void fdt_print_devices(void);
+
+#endif /* _SKYOS_FDT_H_ */
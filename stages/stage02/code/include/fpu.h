@@ -0,0 +1,43 @@
+/*
+ * SkyOS VFP/NEON惰性上下文切换
+ * 文件: include/fpu.h
+ *
+ * boot/start.S在CPACR中打开cp10/cp11并置位FPEXC.EN。
+ * 每个CPU各自记录FP寄存器的持有者。
+ * 任务切换时不保存FP寄存器，只在切到的任务不是本CPU FP寄存器的持有者时
+ * 清除FPEXC.EN；该任务第一次执行VFP/NEON指令时触发未定义指令异常，
+ * 由fpu_trap()保存上一个持有者的状态、恢复当前任务的状态后重新执行该指令。
+ *
+ * 内核C代码按soft-float编译，不会生成FP指令；memcpy/memset等也只用整数寄存器，
+ * 只有任务自己执行的VFP/NEON指令会让它成为持有者。内核代码需要NEON时
+ * (memcpy_neon等) 放在kernel_neon_begin/kernel_neon_end之间：先保存持有者的
+ * 状态并放弃持有，调用者不会成为持有者。
+ */
+
+#ifndef _SKYOS_FPU_H_
+#define _SKYOS_FPU_H_
+
+#include <stdint.h>
+
+/* 每个任务保存的VFP/NEON状态 */
+struct fpu_state {
+    uint64_t d[32];             /* D0-D31 (VFPv3-D16时只用前16个) */
+    uint32_t fpscr;
+    uint32_t used;              /* 是否用过FP (首次使用时从全零状态开始) */
+    uint32_t traps;             /* 本任务触发的惰性切换次数 */
+};
+
+struct task;
+
+void fpu_init(struct task *owner);
+void fpu_task_switch(struct task *prev, struct task *next);
+void fpu_task_exit(struct task *t);
+void fpu_task_release(struct task *t);
+int fpu_task_owns(const struct task *t);
+int fpu_trap(uint32_t *pc, uint32_t spsr);
+uint32_t kernel_neon_begin(void);
+void kernel_neon_end(uint32_t flags);
+void fpu_print_stats(void);
+void test_fpu(void);
+
+#endif /* _SKYOS_FPU_H_ */
@@ -0,0 +1,26 @@
+/*
+ * SkyOS futex (快速用户态互斥)
+ * 文件: include/futex.h
+ *
+ * 锁和条件变量的状态字放在调用者自己的内存中，无争用时只做原子操作、
+ * 不陷入内核；只有需要睡眠或唤醒时才调用SYS_FUTEX：
+ * - FUTEX_WAIT: *uaddr仍等于val时睡眠直到被唤醒，否则立即返回-EAGAIN
+ * - FUTEX_WAKE: 唤醒在uaddr上等待的最多val个任务，返回唤醒数
+ */
+
+#ifndef _SKYOS_FUTEX_H_
+#define _SKYOS_FUTEX_H_
+
+#include <stdint.h>
+
+#define FUTEX_WAIT      0
+#define FUTEX_WAKE      1
+
+#define FUTEX_EAGAIN    11
+#define FUTEX_EINVAL    22
+
+uint32_t sys_futex(volatile uint32_t *uaddr, uint32_t op, uint32_t val);
+void futex_print_stats(void);
+void test_futex(void);
+
+#endif /* _SKYOS_FUTEX_H_ */
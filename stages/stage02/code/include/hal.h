@@ -0,0 +1,165 @@
+/*
+ * SkyOS 硬件访问层
+ * 文件: include/hal.h
+ *
+ * 驱动和内核代码通过这里的函数访问外设寄存器 (MMIO) 和CP15系统寄存器：
+ * - 目标机上全部是内联的volatile访问和mrc/mcr指令，与直接写汇编相同
+ * - 定义SKYOS_HOST时 (make host-test / host-bench) 变成普通函数，
+ *   由host/hal_host.c用假的寄存器文件实现，同一份内核源码可以在Linux上
+ *   编译、单元测试和做微基准
+ *
+ * 地址一律是32位总线地址，主机上不会被当作指针解引用。
+ */
+
+#ifndef _SKYOS_HAL_H_
+#define _SKYOS_HAL_H_
+
+#include <stdint.h>
+
+#ifndef SKYOS_HOST
+
+/* ===== MMIO ===== */
+
+static inline uint32_t mmio_read32(uint32_t addr) {
+    return *(volatile uint32_t *)addr;
+}
+
+static inline void mmio_write32(uint32_t addr, uint32_t val) {
+    *(volatile uint32_t *)addr = val;
+}
+
+/* ===== ARM Generic Timer ===== */
+
+static inline uint32_t read_cntfrq(void) {
+    uint32_t freq;
+    asm volatile("mrc p15, 0, %0, c14, c0, 0" : "=r"(freq));
+    return freq;
+}
+
+static inline uint64_t read_cntpct(void) {
+    uint64_t val;
+    asm volatile("mrrc p15, 0, %Q0, %R0, c14" : "=r"(val));
+    return val;
+}
+
+/* 虚拟计数器，isb保证不会早于之前的读取执行 (vDSO用户库也使用) */
+static inline uint64_t read_cntvct(void) {
+    uint64_t val;
+    asm volatile("isb\n"
+                 "mrrc p15, 1, %Q0, %R0, c14" : "=r"(val) : : "memory");
+    return val;
+}
+
+static inline uint32_t read_cntp_tval(void) {
+    uint32_t tval;
+    asm volatile("mrc p15, 0, %0, c14, c2, 0" : "=r"(tval));
+    return tval;
+}
+
+static inline void write_cntp_tval(uint32_t tval) {
+    asm volatile("mcr p15, 0, %0, c14, c2, 0" : : "r"(tval));
+}
+
+static inline void write_cntp_cval(uint64_t cval) {
+    asm volatile("mcrr p15, 2, %Q0, %R0, c14" : : "r"(cval));
+}
+
+static inline uint32_t read_cntp_ctl(void) {
+    uint32_t ctl;
+    asm volatile("mrc p15, 0, %0, c14, c2, 1" : "=r"(ctl));
+    return ctl;
+}
+
+static inline void write_cntp_ctl(uint32_t ctl) {
+    asm volatile("mcr p15, 0, %0, c14, c2, 1" : : "r"(ctl));
+}
+
+static inline uint32_t read_cntkctl(void) {
+    uint32_t val;
+    asm volatile("mrc p15, 0, %0, c14, c1, 0" : "=r"(val));
+    return val;
+}
+
+static inline void write_cntkctl(uint32_t val) {
+    asm volatile("mcr p15, 0, %0, c14, c1, 0" : : "r"(val));
+    asm volatile("isb" : : : "memory");
+}
+
+/* ===== 故障状态/地址 ===== */
+
+static inline uint32_t read_dfsr(void) {
+    uint32_t val;
+    asm volatile("mrc p15, 0, %0, c5, c0, 0" : "=r"(val));
+    return val;
+}
+
+static inline uint32_t read_far(void) {
+    uint32_t val;
+    asm volatile("mrc p15, 0, %0, c6, c0, 0" : "=r"(val));
+    return val;
+}
+
+static inline uint32_t read_ifsr(void) {
+    uint32_t val;
+    asm volatile("mrc p15, 0, %0, c5, c0, 1" : "=r"(val));
+    return val;
+}
+
+static inline uint32_t read_ifar(void) {
+    uint32_t val;
+    asm volatile("mrc p15, 0, %0, c6, c0, 2" : "=r"(val));
+    return val;
+}
+
+/* ===== 处理器 ===== */
+
+static inline uint32_t read_mpidr(void) {
+    uint32_t mpidr;
+    asm volatile("mrc p15, 0, %0, c0, c0, 5" : "=r"(mpidr));
+    return mpidr;
+}
+
+static inline void cpu_wfi(void) {
+    asm volatile("wfi" : : : "memory");
+}
+
+/* 先等之前的访存完成再进入wfi (空闲状态用) */
+static inline void cpu_dsb_wfi(void) {
+    asm volatile("dsb\n"
+                 "wfi" : : : "memory");
+}
+
+#else /* SKYOS_HOST */
+
+/* 主机实现 (host/hal_host.c)，寄存器状态由测试直接读写 */
+uint32_t mmio_read32(uint32_t addr);
+void mmio_write32(uint32_t addr, uint32_t val);
+uint32_t read_cntfrq(void);
+uint64_t read_cntpct(void);
+uint64_t read_cntvct(void);
+uint32_t read_cntp_tval(void);
+void write_cntp_tval(uint32_t tval);
+void write_cntp_cval(uint64_t cval);
+uint32_t read_cntp_ctl(void);
+void write_cntp_ctl(uint32_t ctl);
+uint32_t read_cntkctl(void);
+void write_cntkctl(uint32_t val);
+uint32_t read_dfsr(void);
+uint32_t read_far(void);
+uint32_t read_ifsr(void);
+uint32_t read_ifar(void);
+uint32_t read_mpidr(void);
+void cpu_wfi(void);
+void cpu_dsb_wfi(void);
+
+#endif /* SKYOS_HOST */
+
+/* 支持的CPU数，各模块的每CPU数组按此分配 */
+#define NR_CPUS     4
+
+/* 当前CPU号 (MPIDR.Aff0，QEMU virt从0连续编号)，超出NR_CPUS的核取模映射 */
+static inline uint32_t cpu_id(void) {
+    return (read_mpidr() & 0xFF) % NR_CPUS;
+}
+
+#endif /* _SKYOS_HAL_H_ */
@@ -0,0 +1,37 @@
+/*
+ * SkyOS 空闲任务与CPU时间统计
+ * 文件: include/idle.h
+ *
+ * 每个CPU一个空闲任务，就绪队列为空时由调度器切换过去。空闲调速器根据
+ * 下一个定时事件和最近几次空闲时长选择空闲状态：
+ * - 轮询：预计很快有任务就绪，打开中断忙等
+ * - wfi：保留周期滴答
+ * - wfi + 停滴答：预计空闲超过两个滴答，停掉滴答直到下一个定时事件
+ * 用CNTPCT统计忙碌/中断/空闲时间、每个状态的驻留时长分布，
+ * 以及1/5/15分钟平均可运行任务数 (负载均值)。
+ */
+
+#ifndef _SKYOS_IDLE_H_
+#define _SKYOS_IDLE_H_
+
+#include <stdint.h>
+
+/* 负载均值定点格式：2048 = 1个可运行任务 */
+#define LOAD_FSHIFT     11
+#define LOAD_FIXED_1    (1u << LOAD_FSHIFT)
+
+void idle_init(void);
+void idle_irq_enter(void);
+void idle_irq_exit(void);
+void idle_tick(uint32_t ticks);
+void idle_get_loadavg(uint32_t avg[3]);
+void idle_print_load(void);
+void idle_print_stats(void);
+void test_idle(void);
+
+/* 定时器 (kernel/timer.c) 提供给空闲调速器 */
+uint32_t timer_next_event(void);
+void timer_stop_tick(uint32_t ticks);
+void timer_restart_tick(void);
+
+#endif /* _SKYOS_IDLE_H_ */
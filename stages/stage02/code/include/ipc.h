@@ -0,0 +1,91 @@
+/*
+ * SkyOS 同步消息传递 (IPC)
+ * 文件: include/ipc.h
+ *
+ * 任务之间按任务号收发定长消息，发送和接收都阻塞直到对方就绪 (会合式)：
+ * - 短消息：整条消息就是r0-r7八个寄存器，内核把发送方的寄存器帧直接复制到
+ *   接收方的寄存器帧，并从发送方直接切换到接收方 (不经过就绪队列)
+ * - 长消息：标签中带页数，r7为页对齐的源地址，内核按整页复制到接收方
+ *   在ipc_recv时登记的接收窗口，接收方的r7改为窗口地址
+ *
+ * 寄存器约定 (struct ipc_msg的w[0..7]对应r0-r7)：
+ *   发送时 w[0]=目标任务号，接收后 w[0]=发送方任务号，回复后 w[0]=状态 (0或-错误码)
+ *   w[1]=标签 (IPC_TAG)，w[2..7]=数据
+ * ipc_recv的参数：w[0]=只接收该任务的消息 (IPC_ANY不限)，w[1]/w[2]=接收窗口地址/页数
+ */
+
+#ifndef _SKYOS_IPC_H_
+#define _SKYOS_IPC_H_
+
+#include <stdint.h>
+#include "syscall.h"
+
+#define IPC_MSG_WORDS       8
+#define IPC_ANY             0xFFFFFFFFu
+
+/* 标签：低16位由通信双方自定义，16-23位为长消息页数 */
+#define IPC_TAG(label, pages)   (((label) & 0xFFFF) | ((uint32_t)(pages) << 16))
+#define IPC_TAG_LABEL(tag)      ((tag) & 0xFFFF)
+#define IPC_TAG_PAGES(tag)      (((tag) >> 16) & 0xFF)
+
+#define IPC_E2BIG           7
+#define IPC_ESRCH           3
+#define IPC_EINVAL          22
+
+/* 任务的IPC状态 */
+#define IPC_IDLE            0
+#define IPC_SEND_BLOCKED    1   /* 在目标的发送队列上等待接收 */
+#define IPC_RECV_BLOCKED    2   /* 等待消息 */
+#define IPC_REPLY_BLOCKED   3   /* 消息已被接收，等待回复 */
+
+struct task;
+
+struct ipc_state {
+    uint32_t state;             /* IPC_* */
+    uint32_t want_reply;        /* 发送方：ipc_call (接收后转为等待回复) */
+    struct syscall_regs *regs;  /* 阻塞时的系统调用寄存器帧 (消息所在) */
+    struct task *partner;       /* 等待回复时的服务端 */
+    uint32_t from;              /* 接收方：只接收该任务号的消息，IPC_ANY不限 */
+    uint32_t win;               /* 接收方：长消息接收窗口 (页对齐) */
+    uint32_t win_pages;
+    struct task *send_head;     /* 向本任务发送而阻塞的任务 (FIFO) */
+    struct task *send_tail;
+    struct task *send_next;
+};
+
+struct ipc_msg {
+    uint32_t w[IPC_MSG_WORDS];
+};
+
+/* 系统调用处理函数 (SYSCALL_F_REGS，直接读写寄存器帧) */
+void ipc_send(struct syscall_regs *regs);
+void ipc_recv(struct syscall_regs *regs);
+void ipc_call(struct syscall_regs *regs);
+void ipc_reply(struct syscall_regs *regs);
+void ipc_reply_recv(struct syscall_regs *regs);
+
+void ipc_print_stats(void);
+void test_ipc(void);
+
+/* 用r0-r7装入消息后陷入，返回时r0-r7写回消息 */
+#define ipc_syscall(num, m) do {                                        \
+    struct ipc_msg *__m = (m);                                          \
+    register uint32_t __r0 asm("r0") = __m->w[0];                       \
+    register uint32_t __r1 asm("r1") = __m->w[1];                       \
+    register uint32_t __r2 asm("r2") = __m->w[2];                       \
+    register uint32_t __r3 asm("r3") = __m->w[3];                       \
+    register uint32_t __r4 asm("r4") = __m->w[4];                       \
+    register uint32_t __r5 asm("r5") = __m->w[5];                       \
+    register uint32_t __r6 asm("r6") = __m->w[6];                       \
+    register uint32_t __r7 asm("r7") = __m->w[7];                       \
+    asm volatile("svc %[nr]"                                            \
+                 : "+r"(__r0), "+r"(__r1), "+r"(__r2), "+r"(__r3),      \
+                   "+r"(__r4), "+r"(__r5), "+r"(__r6), "+r"(__r7)       \
+                 : [nr] "i"(num)                                        \
+                 : "lr", "memory");                                     \
+    __m->w[0] = __r0; __m->w[1] = __r1; __m->w[2] = __r2;               \
+    __m->w[3] = __r3; __m->w[4] = __r4; __m->w[5] = __r5;               \
+    __m->w[6] = __r6; __m->w[7] = __r7;                                 \
+} while (0)
+
+#endif /* _SKYOS_IPC_H_ */
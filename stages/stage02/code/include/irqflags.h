@@ -0,0 +1,72 @@
+/*
+ * SkyOS 本地中断屏蔽
+ * 文件: include/irqflags.h
+ *
+ * enable_irq/disable_irq (boot/start.S) 无条件改写I位，
+ * 嵌套使用时会过早打开中断。这里保存并恢复原CPSR，
+ * 可在中断上下文和普通上下文中安全使用。
+ */
+
+#ifndef _SKYOS_IRQFLAGS_H_
+#define _SKYOS_IRQFLAGS_H_
+
+#include <stdint.h>
+
+#define CPSR_I_BIT  (1 << 7)
+#define CPSR_F_BIT  (1 << 6)
+
+#ifdef SKYOS_HOST
+
+/* 主机测试：CPSR是host/hal_host.c中的一个变量 */
+extern uint32_t host_cpsr;
+
+static inline uint32_t local_irq_save(void) {
+    uint32_t flags = host_cpsr;
+    host_cpsr |= CPSR_I_BIT;
+    return flags;
+}
+
+static inline void local_irq_restore(uint32_t flags) {
+    host_cpsr = flags;
+}
+
+static inline int irqs_disabled(void) {
+    return (host_cpsr & CPSR_I_BIT) != 0;
+}
+
+/* 主机上没有真实的挂起中断 (假GIC的中断由测试显式分发) */
+static inline void local_irq_window(void) {
+}
+
+#else
+
+/* 保存CPSR并屏蔽IRQ */
+static inline uint32_t local_irq_save(void) {
+    uint32_t flags;
+    asm volatile("mrs %0, cpsr\n"
+                 "cpsid i" : "=r"(flags) : : "memory", "cc");
+    return flags;
+}
+
+/* 恢复之前保存的IRQ状态 */
+static inline void local_irq_restore(uint32_t flags) {
+    asm volatile("msr cpsr_c, %0" : : "r"(flags) : "memory", "cc");
+}
+
+/* 当前IRQ是否被屏蔽 */
+static inline int irqs_disabled(void) {
+    uint32_t cpsr;
+    asm volatile("mrs %0, cpsr" : "=r"(cpsr));
+    return (cpsr & CPSR_I_BIT) != 0;
+}
+
+/* IRQ屏蔽时短暂打开，让挂起的中断处理程序执行 */
+static inline void local_irq_window(void) {
+    asm volatile("cpsie i\n"
+                 "isb\n"
+                 "cpsid i" : : : "memory");
+}
+
+#endif /* SKYOS_HOST */
+
+#endif /* _SKYOS_IRQFLAGS_H_ */
@@ -0,0 +1,69 @@
+/*
+ * SkyOS 内核日志 (kprintf)
+ * 文件: include/kprintf.h
+ *
+ * kprintf按格式串格式化后写入全局日志环，不直接操作串口：
+ * - 格式：%d %i %u %x %X %p %s %c %%，支持 - 0 宽度 .精度 以及 l/ll/h/z
+ *   长度修饰 (ll为64位)
+ * - 级别：格式串开头的KERN_*前缀，无前缀为KERN_INFO。所有级别都进日志环，
+ *   低于控制台级别 (数值小) 的才输出到串口
+ * - 每个CPU先在自己的缓冲区中格式化 (屏蔽IRQ，不加锁)，再按全局序号无锁地
+ *   占用环中一个固定大小的槽，写完后发布序号
+ * - 工作队列中的刷新任务把新记录写到串口 (空闲任务和定时器会触发刷新)；
+ *   异步刷新开启之前、KERN_ERR及更高级别、以及崩溃时同步刷新
+ * - 日志环在.noinit段，热复位后下次启动先打印上次启动的最后几条记录
+ *
+ * 记录中的换行写"\n"，输出到串口时换成"\r\n"。
+ */
+
+#ifndef _SKYOS_KPRINTF_H_
+#define _SKYOS_KPRINTF_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+#define KERN_SOH        "\001"
+#define KERN_EMERG      KERN_SOH "0"    /* 系统不可用 */
+#define KERN_ALERT      KERN_SOH "1"
+#define KERN_CRIT       KERN_SOH "2"
+#define KERN_ERR        KERN_SOH "3"
+#define KERN_WARNING    KERN_SOH "4"
+#define KERN_NOTICE     KERN_SOH "5"
+#define KERN_INFO       KERN_SOH "6"
+#define KERN_DEBUG      KERN_SOH "7"
+
+#define LOGLEVEL_ERR        3
+#define LOGLEVEL_DEBUG      7
+#define LOGLEVEL_DEFAULT    6           /* 无前缀的消息 */
+
+#define LOG_RECORD_SIZE     128
+#define LOG_NR_RECORDS      256         /* 2的幂 */
+#define LOG_TEXT_MAX        (LOG_RECORD_SIZE - 12)
+
+#define pr_err(fmt, ...)    kprintf(KERN_ERR fmt, ##__VA_ARGS__)
+#define pr_warn(fmt, ...)   kprintf(KERN_WARNING fmt, ##__VA_ARGS__)
+#define pr_info(fmt, ...)   kprintf(KERN_INFO fmt, ##__VA_ARGS__)
+#define pr_debug(fmt, ...)  kprintf(KERN_DEBUG fmt, ##__VA_ARGS__)
+
+/*
+ * 编译器按printf检查参数。arm-none-eabi的uint32_t是unsigned long，
+ * 主机上是unsigned int：uint32_t参数显式转换为unsigned int后用%u/%x
+ */
+int kvsnprintf(char *buf, size_t size, const char *fmt, va_list ap)
+    __attribute__((format(printf, 3, 0)));
+int ksnprintf(char *buf, size_t size, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+int kprintf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+void klog_init(void);
+void klog_start_async(void);
+void klog_set_console_level(uint32_t level);
+void klog_flush(void);
+void klog_kick(void);
+void klog_panic(void);
+void klog_dump(uint32_t max);
+void klog_print_stats(void);
+void test_kprintf(void);
+
+#endif /* _SKYOS_KPRINTF_H_ */
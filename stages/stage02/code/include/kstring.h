@@ -0,0 +1,29 @@
+/*
+ * SkyOS 内核字符串/内存函数
+ * 文件: include/kstring.h
+ *
+ * 内核以-nostdlib链接，编译器生成的结构体拷贝等也会调用memcpy/memset，
+ * 因此由内核自己提供这些符号。memcpy/memset/memcmp在kernel/memops.S中实现
+ *
+ * memcpy_neon/memset_neon用NEON寄存器，只能在kernel_neon_begin/end之间调用
+ * (include/fpu.h)；其他内核代码一律使用不触碰FP寄存器的memcpy/memset
+ */
+
+#ifndef _SKYOS_KSTRING_H_
+#define _SKYOS_KSTRING_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+void *memcpy(void *dst, const void *src, size_t n);
+void *memmove(void *dst, const void *src, size_t n);
+void *memset(void *dst, int c, size_t n);
+int memcmp(const void *a, const void *b, size_t n);
+void *memcpy_neon(void *dst, const void *src, size_t n);
+void *memset_neon(void *dst, int c, size_t n);
+size_t strlen(const char *s);
+int strcmp(const char *a, const char *b);
+int strncmp(const char *a, const char *b, size_t n);
+void test_memops(void);
+
+#endif /* _SKYOS_KSTRING_H_ */
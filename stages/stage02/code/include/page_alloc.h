@@ -0,0 +1,33 @@
+/*
+ * SkyOS 物理页分配器
+ * 文件: include/page_alloc.h
+ *
+ * 管理 __kernel_end 之上到RAM末尾的物理页 (位图，一位一页)。
+ * RAM范围取自设备树的memory节点，DTB本身所在的页会被保留。
+ * 没有MMU，物理地址即内核可直接访问的地址。
+ */
+
+#ifndef _SKYOS_PAGE_ALLOC_H_
+#define _SKYOS_PAGE_ALLOC_H_
+
+#include <stdint.h>
+
+#define PAGE_SHIFT      12
+#define PAGE_SIZE       (1u << PAGE_SHIFT)
+#define PAGE_MASK       (~(PAGE_SIZE - 1))
+#define PAGE_ALIGN(x)   (((x) + PAGE_SIZE - 1) & PAGE_MASK)
+
+/* QEMU virt默认RAM布局 (与boot.lds一致)；RAM_SIZE也是位图能管理的上限 */
+#define RAM_BASE        0x40000000
+#define RAM_SIZE        (256 * 1024 * 1024)
+
+void page_alloc_init(void);
+void page_reserve(uint32_t addr, uint32_t size);
+void *alloc_page(void);
+void *alloc_pages(uint32_t count);
+void free_page(void *page);
+void free_pages(void *page, uint32_t count);
+uint32_t page_free_count(void);
+void page_alloc_print_stats(void);
+
+#endif /* _SKYOS_PAGE_ALLOC_H_ */
@@ -0,0 +1,21 @@
+/*
+ * SkyOS 管道
+ * 文件: include/pipe.h
+ *
+ * 匿名管道：SYS_PIPE返回读端和写端两个文件描述符，通过read/write系统调用
+ * 收发数据。缓冲区是内核中的共享环 (struct ring_shared)，环空时读者、
+ * 环满时写者在等待队列上睡眠；写端全部关闭后读到0 (EOF)，
+ * 读端全部关闭后写入返回-EPIPE。
+ */
+
+#ifndef _SKYOS_PIPE_H_
+#define _SKYOS_PIPE_H_
+
+#include <stdint.h>
+
+#define PIPE_PAGES      1           /* 缓冲区页数 (2的幂) */
+
+uint32_t sys_pipe(uint32_t *fds);
+void pipe_print_stats(void);
+
+#endif /* _SKYOS_PIPE_H_ */
@@ -0,0 +1,53 @@
+/*
+ * SkyOS Cortex-A15 性能监控单元 (PMU)
+ * 文件: include/pmu.h
+ *
+ * 通过CP15 c9访问PMUv2：一个周期计数器PMCCNTR和若干事件计数器。
+ * 硬件计数器为32位，溢出中断 (PPI) 把高位累加到软件中，对外提供64位计数。
+ * 计数器全局运行，按任务的计数在上下文切换时取差值累加 (虚拟化)。
+ */
+
+#ifndef _SKYOS_PMU_H_
+#define _SKYOS_PMU_H_
+
+#include <stdint.h>
+
+/* 配置的事件 (依次占用事件计数器0..PMU_NR_EVENTS-1) */
+#define PMU_INSTRUCTIONS    0       /* 0x08 INST_RETIRED */
+#define PMU_L1D_ACCESS      1       /* 0x04 L1D_CACHE */
+#define PMU_L1D_REFILL      2       /* 0x03 L1D_CACHE_REFILL */
+#define PMU_BRANCHES        3       /* 0x12 BR_PRED */
+#define PMU_BRANCH_MISSES   4       /* 0x10 BR_MIS_PRED */
+#define PMU_NR_EVENTS       5
+
+struct pmu_counts {
+    uint64_t cycles;
+    uint64_t events[PMU_NR_EVENTS];
+};
+
+/* 每个任务的虚拟计数器 */
+struct pmu_task_ctx {
+    struct pmu_counts total;    /* 已切出时间段的累计值 */
+    struct pmu_counts start;    /* 最近一次切入时的全局计数 */
+};
+
+void pmu_init(void);
+int pmu_available(void);
+int pmu_event_supported(uint32_t event);
+void pmu_read(struct pmu_counts *out);
+void pmu_sub(struct pmu_counts *out, const struct pmu_counts *end, const struct pmu_counts *start);
+
+/* 上下文切换时调用 (IRQ已屏蔽) */
+void pmu_task_switch(struct pmu_task_ctx *prev, struct pmu_task_ctx *next);
+void pmu_task_read(const struct pmu_task_ctx *ctx, int running, struct pmu_counts *out);
+
+/* 采样计数器：每period个CPU周期在溢出中断中调用一次fn */
+int pmu_sampling_start(uint32_t period, void (*fn)(void));
+void pmu_sampling_stop(void);
+
+/* 输出周期、指令、IPC和缺失率 */
+void pmu_print_counts(const struct pmu_counts *c);
+void pmu_print_stats(void);
+void test_pmu(void);
+
+#endif /* _SKYOS_PMU_H_ */
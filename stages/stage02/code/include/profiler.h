@@ -0,0 +1,34 @@
+/*
+ * SkyOS 采样分析器
+ * 文件: include/profiler.h
+ *
+ * 周期性地记录被中断的PC/LR：优先用PMU周期计数器溢出中断，
+ * 不可用时退化为定时器中断 (100Hz)。样本写入每CPU的无锁环形缓冲区，
+ * profiler_dump()输出PC直方图和原始样本，原始样本由
+ * resources/profile_symbolize.py 符号化并生成火焰图折叠格式。
+ */
+
+#ifndef _SKYOS_PROFILER_H_
+#define _SKYOS_PROFILER_H_
+
+#include <stdint.h>
+#include "hal.h"
+
+#define PROF_MAX_CPUS           NR_CPUS
+#define PROF_RING_SIZE          2048        /* 每CPU样本数 (2的幂) */
+#define PROF_DEFAULT_PERIOD     1000000     /* PMU采样周期 (CPU周期) */
+
+struct prof_sample {
+    uint32_t pc;        /* 被中断的指令地址 */
+    uint32_t lr;        /* 被中断模式的LR (调用者) */
+    uint32_t mode;      /* 被中断时的CPSR模式位 */
+    uint32_t task;      /* 当前任务ID */
+};
+
+void profiler_init(void);
+int profiler_start(uint32_t period);
+void profiler_stop(void);
+void profiler_dump(void);
+void test_profiler(void);
+
+#endif /* _SKYOS_PROFILER_H_ */
@@ -0,0 +1,59 @@
+/*
+ * SkyOS RCU (读-复制-更新)
+ * 文件: include/rcu.h
+ *
+ * 用于读多写少的分发表 (系统调用表、中断处理程序表)：
+ * - 读者只用rcu_read_lock/rcu_read_unlock包住对共享指针的访问，
+ *   不做任何原子操作或写共享内存；读侧临界区内不能让出CPU
+ * - 写者用rcu_assign_pointer发布新对象，旧对象通过call_rcu在
+ *   宽限期 (所有CPU都经过一次静止状态) 结束后释放
+ * - 静止状态：任务切换/task_yield、空闲等待；定时器滴答检查各CPU
+ *   是否经过了静止状态，推进宽限期并执行回调
+ *
+ * 内核不可抢占，所以读侧临界区就是两次静止状态之间的任意一段代码。
+ */
+
+#ifndef _SKYOS_RCU_H_
+#define _SKYOS_RCU_H_
+
+#include <stdint.h>
+#include "atomic.h"
+#include "hal.h"
+
+#define RCU_MAX_CPUS    NR_CPUS
+
+struct rcu_head {
+    struct rcu_head *next;
+    void (*func)(struct rcu_head *head);
+};
+
+/* 读侧：不可抢占内核中只需阻止编译器把访问移出临界区 */
+static inline void rcu_read_lock(void) {
+    asm volatile("" : : : "memory");
+}
+
+static inline void rcu_read_unlock(void) {
+    asm volatile("" : : : "memory");
+}
+
+/* ARM保证地址依赖的加载有序，读指针不需要屏障 */
+#define rcu_dereference(p)          READ_ONCE(p)
+
+/* 发布前保证对象的初始化对其他CPU可见 */
+#define rcu_assign_pointer(p, v)    do { smp_wmb(); WRITE_ONCE(p, v); } while (0)
+
+#define container_of(ptr, type, member) \
+    ((type *)((char *)(ptr) - __builtin_offsetof(type, member)))
+
+void rcu_init(void);
+void rcu_cpu_online(uint32_t cpu);
+void rcu_note_qs(void);
+void rcu_tick(void);
+int rcu_pending(void);
+void call_rcu(struct rcu_head *head, void (*func)(struct rcu_head *head));
+void synchronize_rcu(void);
+void rcu_barrier(void);
+void rcu_print_stats(void);
+void test_rcu(void);
+
+#endif /* _SKYOS_RCU_H_ */
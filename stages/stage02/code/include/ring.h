@@ -0,0 +1,127 @@
+/*
+ * SkyOS 共享内存环形缓冲区
+ * 文件: include/ring.h
+ *
+ * 单生产者/单消费者环：ring_create分配一个控制页和若干数据页，双方直接
+ * 读写这些页 (没有MMU，"映射"就是把地址交给双方)。head/tail是自由增长的
+ * 字节计数，各占一条缓存行：
+ * - 生产者写数据 -> smp_wmb -> 推进head；消费者读数据 -> smp_mb -> 推进tail
+ * - 只有环满/环空时才陷入SYS_RING_WAIT睡眠；等待前先置位*_waiting，
+ *   对方推进索引后看到标志才陷入SYS_RING_WAKE，平时收发数据不进内核
+ * ring_write_begin/ring_read_begin返回环内可直接读写的连续区域 (零拷贝)。
+ */
+
+#ifndef _SKYOS_RING_H_
+#define _SKYOS_RING_H_
+
+#include <stdint.h>
+#include "atomic.h"
+#include "syscall.h"
+
+#define RING_PRODUCER   0
+#define RING_CONSUMER   1
+
+#define RING_MAX_PAGES  16          /* 每个环的数据页上限 */
+
+struct ring_shared {
+    volatile uint32_t head;         /* 生产者：已提交的字节数 */
+    volatile uint32_t prod_waiting; /* 生产者在等待空间 */
+    uint32_t pad0[14];
+    volatile uint32_t tail;         /* 消费者：已取走的字节数 */
+    volatile uint32_t cons_waiting; /* 消费者在等待数据 */
+    uint32_t pad1[14];
+    uint32_t size;                  /* 数据区字节数 (2的幂) */
+    uint32_t data;                  /* 数据区地址 */
+};
+
+/* 系统调用处理函数 (kernel/ring.c) */
+uint32_t sys_ring_create(uint32_t pages);
+uint32_t sys_ring_destroy(struct ring_shared *r);
+uint32_t sys_ring_wait(struct ring_shared *r, uint32_t side, uint32_t seen);
+uint32_t sys_ring_wake(struct ring_shared *r, uint32_t side);
+void ring_print_stats(void);
+void test_ring(void);
+
+static inline uint32_t ring_used(const struct ring_shared *r) {
+    return READ_ONCE(r->head) - READ_ONCE(r->tail);
+}
+
+/* 生产者：返回可连续写入的字节数，*p为写入位置 */
+static inline uint32_t ring_write_begin(struct ring_shared *r, void **p) {
+    uint32_t head = r->head;
+    uint32_t space = r->size - (head - READ_ONCE(r->tail));
+    uint32_t off = head & (r->size - 1);
+    uint32_t contig = r->size - off;
+
+    /* 看到tail之后才能覆盖消费者已读完的数据 */
+    smp_mb();
+    *p = (void *)(r->data + off);
+    return space < contig ? space : contig;
+}
+
+/* 生产者：提交n字节，消费者在等待时唤醒 */
+static inline void ring_write_commit(struct ring_shared *r, uint32_t n) {
+    smp_wmb();
+    WRITE_ONCE(r->head, r->head + n);
+    smp_mb();
+    if (READ_ONCE(r->cons_waiting)) {
+        WRITE_ONCE(r->cons_waiting, 0);
+        syscall2(SYS_RING_WAKE, r, RING_CONSUMER);
+    }
+}
+
+/* 消费者：返回可连续读取的字节数，*p为读取位置 */
+static inline uint32_t ring_read_begin(struct ring_shared *r, void **p) {
+    uint32_t tail = r->tail;
+    uint32_t avail = READ_ONCE(r->head) - tail;
+    uint32_t off = tail & (r->size - 1);
+    uint32_t contig = r->size - off;
+
+    /* 看到head之后才能读它覆盖的数据 */
+    smp_mb();
+    *p = (void *)(r->data + off);
+    return avail < contig ? avail : contig;
+}
+
+/* 消费者：释放n字节，生产者在等待时唤醒 */
+static inline void ring_read_commit(struct ring_shared *r, uint32_t n) {
+    smp_mb();
+    WRITE_ONCE(r->tail, r->tail + n);
+    smp_mb();
+    if (READ_ONCE(r->prod_waiting)) {
+        WRITE_ONCE(r->prod_waiting, 0);
+        syscall2(SYS_RING_WAKE, r, RING_PRODUCER);
+    }
+}
+
+/* 生产者：环满时睡眠直到消费者释放空间 */
+static inline void ring_wait_space(struct ring_shared *r) {
+    while (ring_used(r) == r->size) {
+        uint32_t tail;
+        WRITE_ONCE(r->prod_waiting, 1);
+        smp_mb();
+        tail = READ_ONCE(r->tail);
+        if (r->head - tail != r->size) {
+            WRITE_ONCE(r->prod_waiting, 0);
+            break;
+        }
+        syscall3(SYS_RING_WAIT, r, RING_PRODUCER, tail);
+    }
+}
+
+/* 消费者：环空时睡眠直到生产者提交数据 */
+static inline void ring_wait_data(struct ring_shared *r) {
+    while (ring_used(r) == 0) {
+        uint32_t head;
+        WRITE_ONCE(r->cons_waiting, 1);
+        smp_mb();
+        head = READ_ONCE(r->head);
+        if (head != r->tail) {
+            WRITE_ONCE(r->cons_waiting, 0);
+            break;
+        }
+        syscall3(SYS_RING_WAIT, r, RING_CONSUMER, head);
+    }
+}
+
+#endif /* _SKYOS_RING_H_ */
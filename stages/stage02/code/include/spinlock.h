@@ -0,0 +1,125 @@
+/*
+ * SkyOS 自旋锁与读写锁
+ * 文件: include/spinlock.h
+ *
+ * 票据自旋锁：一个32位字，低16位owner为正在服务的号，高16位next为下一个
+ * 要发放的号。加锁时用ldrex/strex原子地取号 (next+1)，号不等于owner时
+ * wfe等待；解锁只有持有者写owner，写后dsb+sev唤醒等待的CPU。按取号顺序
+ * 获得锁，不会饿死。
+ *
+ * 读写锁：最高位为写者标志，低位为读者数。读者之间不互斥，写者独占。
+ *
+ * *_irqsave变体先保存CPSR并屏蔽IRQ，再加锁 (中断处理程序也会用的锁必须这样获取，
+ * 否则持锁时被同一CPU上的中断打断会死锁)。
+ *
+ * 注意：ARMv7上独占访问要求内存属性支持独占监视器。QEMU中关闭MMU时可用，
+ * 真实硬件需要在打开MMU和缓存之后使用。
+ */
+
+#ifndef _SKYOS_SPINLOCK_H_
+#define _SKYOS_SPINLOCK_H_
+
+#include <stdint.h>
+#include "irqflags.h"
+
+/*
+ * 为1时每个锁记录获取次数、争用次数、等待和持有时间 (每次加锁/解锁多读
+ * 两次CNTPCT)。默认关闭，调试构建 (make DEBUG=1) 打开
+ */
+#ifndef LOCK_STAT
+#define LOCK_STAT   0
+#endif
+
+#define TICKET_SHIFT    16
+#define LOCK_STAT_MAX   32          /* 统计表能登记的锁数 */
+
+struct lock_stat {
+    uint32_t registered;
+    uint32_t acquired;              /* 获取次数 (读写锁为写者) */
+    uint32_t read_acquired;         /* 读写锁的读者获取次数 */
+    uint32_t contended;             /* 需要等待的次数 */
+    uint32_t spins;                 /* 等待中wfe唤醒的次数 */
+    uint32_t wait_ticks;            /* 累计等待时间 (CNTPCT计数) */
+    uint32_t hold_ticks;            /* 累计持有时间 */
+    uint32_t hold_max;
+    uint32_t hold_start;
+};
+
+struct spinlock {
+    union {
+        volatile uint32_t slock;
+        struct {
+            volatile uint16_t owner;
+            volatile uint16_t next;
+        } tickets;
+    };
+    const char *name;
+#if LOCK_STAT
+    struct lock_stat stat;
+#endif
+};
+
+#define RW_WRITER       0x80000000u
+
+struct rwlock {
+    volatile uint32_t lock;
+    const char *name;
+#if LOCK_STAT
+    struct lock_stat stat;
+#endif
+};
+
+#define SPINLOCK_INIT(n)    { .slock = 0, .name = (n) }
+#define RWLOCK_INIT(n)      { .lock = 0, .name = (n) }
+
+void spin_lock_init(struct spinlock *lock, const char *name);
+void spin_lock(struct spinlock *lock);
+int spin_trylock(struct spinlock *lock);
+void spin_unlock(struct spinlock *lock);
+int spin_is_locked(struct spinlock *lock);
+
+void rwlock_init(struct rwlock *rw, const char *name);
+void read_lock(struct rwlock *rw);
+void read_unlock(struct rwlock *rw);
+void write_lock(struct rwlock *rw);
+int write_trylock(struct rwlock *rw);
+void write_unlock(struct rwlock *rw);
+
+/* 保存IRQ状态并加锁，返回值交给对应的unlock_irqrestore */
+static inline uint32_t spin_lock_irqsave(struct spinlock *lock) {
+    uint32_t flags = local_irq_save();
+    spin_lock(lock);
+    return flags;
+}
+
+static inline void spin_unlock_irqrestore(struct spinlock *lock, uint32_t flags) {
+    spin_unlock(lock);
+    local_irq_restore(flags);
+}
+
+static inline uint32_t read_lock_irqsave(struct rwlock *rw) {
+    uint32_t flags = local_irq_save();
+    read_lock(rw);
+    return flags;
+}
+
+static inline void read_unlock_irqrestore(struct rwlock *rw, uint32_t flags) {
+    read_unlock(rw);
+    local_irq_restore(flags);
+}
+
+static inline uint32_t write_lock_irqsave(struct rwlock *rw) {
+    uint32_t flags = local_irq_save();
+    write_lock(rw);
+    return flags;
+}
+
+static inline void write_unlock_irqrestore(struct rwlock *rw, uint32_t flags) {
+    write_unlock(rw);
+    local_irq_restore(flags);
+}
+
+void lock_print_stats(void);
+void test_spinlock(void);
+
+#endif /* _SKYOS_SPINLOCK_H_ */
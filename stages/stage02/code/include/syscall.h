@@ -0,0 +1,108 @@
+/*
+ * SkyOS 系统调用号与调用包装
+ * 文件: include/syscall.h
+ *
+ * 系统调用号放在SVC指令的立即数中 (swi_handler从指令中取出)，
+ * 参数通过r0-r3传递，返回值在r0；IPC系统调用在r0-r7中收发整条消息 (见ipc.h)。
+ * boot/start.S也包含本文件 (系统调用号和SYSCALL_MAX)，C声明放在__ASSEMBLER__之外。
+ */
+
+#ifndef _SKYOS_SYSCALL_H_
+#define _SKYOS_SYSCALL_H_
+
+#ifndef __ASSEMBLER__
+#include <stdint.h>
+#endif
+
+/* 系统调用号定义 */
+#define SYS_INVALID 0
+#define SYS_WRITE   1
+#define SYS_READ    2
+#define SYS_EXIT    3
+#define SYS_GETTIME 4
+#define SYS_PRINT   5
+#define SYS_OPEN    6
+#define SYS_CLOSE   7
+#define SYS_LSEEK   8
+#define SYS_MMAP    9
+#define SYS_MUNMAP  10
+#define SYS_FUTEX   11
+#define SYS_IPC_SEND        12
+#define SYS_IPC_RECV        13
+#define SYS_IPC_CALL        14
+#define SYS_IPC_REPLY       15
+#define SYS_IPC_REPLY_RECV  16
+#define SYS_PIPE            17
+#define SYS_RING_CREATE     18
+#define SYS_RING_DESTROY    19
+#define SYS_RING_WAIT       20
+#define SYS_RING_WAKE       21
+#define SYS_SCHED_SETAFFINITY   22
+#define SYS_SCHED_GETAFFINITY   23
+#define SYS_VDSO_PAGE       24
+
+#define SYSCALL_MAX 32
+
+#ifndef __ASSEMBLER__
+
+/*
+ * swi_handler保存在SVC栈上的寄存器帧，返回时按此恢复。
+ * 只有SYSCALL_F_REGS的系统调用保存完整的帧，其他系统调用只有r0-r3有效
+ */
+struct syscall_regs {
+    uint32_t r0, r1, r2, r3, r4, r5, r6, r7;
+    uint32_t r8, r9, r10, r11, r12;
+    uint32_t lr;
+};
+
+/* 系统调用处理函数 (参数r0-r3，返回值放回r0) */
+typedef uint32_t (*syscall_func_t)(uint32_t, uint32_t, uint32_t, uint32_t);
+
+/* 带SYSCALL_F_REGS的处理函数直接读写寄存器帧 (如IPC在r0-r7中传递消息) */
+typedef void (*syscall_regs_func_t)(struct syscall_regs *regs);
+
+#define SYSCALL_F_REGS      (1u << 0)   /* fn是syscall_regs_func_t */
+#define SYSCALL_F_NOTRACE   (1u << 1)   /* 热路径，不打印调试输出 */
+
+/* 运行时注册/注销 (表项由RCU保护，分发路径无锁) */
+void syscall_init(void);
+int syscall_register(uint32_t nr, syscall_func_t fn, const char *name);
+int syscall_unregister(uint32_t nr);
+uint32_t syscall_total_count(void);
+
+#ifdef SKYOS_HOST
+
+/* 主机测试：构造寄存器帧直接调用handle_swi (host/hal_host.c) */
+uint32_t host_syscall(uint32_t num, uint32_t a1, uint32_t a2, uint32_t a3, uint32_t a4);
+#define syscall4(num, a1, a2, a3, a4)                                   \
+    host_syscall((num), (uint32_t)(uintptr_t)(a1), (uint32_t)(uintptr_t)(a2), \
+                 (uint32_t)(uintptr_t)(a3), (uint32_t)(uintptr_t)(a4))
+
+#else
+
+/*
+ * SVC在SVC模式下执行时会覆盖lr_svc，所以lr必须列为被破坏寄存器；
+ * 其余寄存器由swi_handler保存/恢复。
+ */
+#define syscall4(num, a1, a2, a3, a4) ({                                \
+    register uint32_t __r0 asm("r0") = (uint32_t)(a1);                  \
+    register uint32_t __r1 asm("r1") = (uint32_t)(a2);                  \
+    register uint32_t __r2 asm("r2") = (uint32_t)(a3);                  \
+    register uint32_t __r3 asm("r3") = (uint32_t)(a4);                  \
+    asm volatile("svc %[nr]"                                            \
+                 : "+r"(__r0)                                           \
+                 : [nr] "i"(num), "r"(__r1), "r"(__r2), "r"(__r3)       \
+                 : "lr", "memory");                                     \
+    __r0;                                                               \
+})
+
+#endif /* SKYOS_HOST */
+
+#define syscall3(num, a1, a2, a3)   syscall4(num, a1, a2, a3, 0)
+#define syscall2(num, a1, a2)       syscall4(num, a1, a2, 0, 0)
+#define syscall1(num, a1)           syscall4(num, a1, 0, 0, 0)
+#define syscall0(num)               syscall4(num, 0, 0, 0, 0)
+
+#endif /* __ASSEMBLER__ */
+
+#endif /* _SKYOS_SYSCALL_H_ */
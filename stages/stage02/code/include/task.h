@@ -0,0 +1,95 @@
+/*
+ * SkyOS 内核线程
+ * 文件: include/task.h
+ *
+ * 协作式调度：任务通过task_yield()让出CPU，按FIFO轮转。
+ * main()在task_init()后成为0号任务，使用启动时的SVC栈。
+ *
+ * 每个CPU一个就绪队列 (kernel/task.c)：唤醒时按亲和性和缓存热度选择CPU，
+ * 定时器滴答周期性地、CPU空闲时立即从最忙的CPU拉取任务。
+ */
+
+#ifndef _SKYOS_TASK_H_
+#define _SKYOS_TASK_H_
+
+#include <stdint.h>
+#include "pmu.h"
+#include "fpu.h"
+#include "ipc.h"
+#include "hal.h"
+
+#define TASK_MAX            16
+#define TASK_NAME_MAX       16
+#define TASK_STACK_PAGES    2
+
+#define SCHED_NR_CPUS       NR_CPUS
+#define SCHED_ALL_CPUS      ((1u << SCHED_NR_CPUS) - 1)
+
+/* 亲和性系统调用的错误码 (返回负值) */
+#define SCHED_ESRCH         3
+#define SCHED_EINVAL        22
+
+/* 任务状态 */
+#define TASK_RUNNABLE       0
+#define TASK_BLOCKED        1
+#define TASK_DEAD           2
+
+/* 被调用者保存的寄存器，由kernel/switch.S按此布局保存/恢复 */
+struct task_context {
+    uint32_t r4, r5, r6, r7, r8, r9, r10, r11;
+    uint32_t sp;
+    uint32_t lr;
+};
+
+struct task {
+    struct task_context ctx;    /* 必须是第一个成员 */
+    uint32_t id;
+    uint32_t state;             /* TASK_* */
+    char name[TASK_NAME_MAX];
+    void (*entry)(void *arg);
+    void *arg;
+    void *stack;                /* 栈底 (页分配器分配)，0号任务为NULL */
+    struct task *run_next;      /* 就绪队列链接 */
+    uint32_t cpu;               /* 所在 (或最近运行的) CPU */
+    uint32_t affinity;          /* 允许运行的CPU位图 */
+    volatile uint32_t on_cpu;   /* 正在CPU上运行 (切出完成后清零) */
+    uint32_t on_rq;             /* 在就绪队列中 */
+    uint32_t last_ran;          /* 最近一次被切出的滴答 (缓存热度) */
+    uint32_t migrations;        /* 被迁移到其他CPU的次数 */
+    uint32_t idle;              /* CPU的空闲任务：固定在该CPU，不进入就绪队列 */
+    uint32_t switches;          /* 被切入的次数 */
+    struct pmu_task_ctx pmu;    /* 虚拟化的性能计数器 */
+    struct fpu_state fpu;       /* VFP/NEON寄存器 (惰性保存，见kernel/fpu.c) */
+    uint32_t wake_tick;         /* 定时睡眠的唤醒滴答 */
+    struct task *sleep_next;    /* 定时睡眠链表 (kernel/timer.c) */
+    uint32_t blocks;            /* 阻塞次数 */
+    struct ipc_state ipc;       /* 同步消息传递 (kernel/ipc.c) */
+};
+
+void task_init(void);
+struct task *task_current(void);
+struct task *task_create(const char *name, void (*entry)(void *arg), void *arg);
+struct task *task_find(uint32_t id);
+void task_yield(void);
+void task_schedule(void);
+int task_wake(struct task *t);
+void task_handoff(struct task *next);
+void task_exit(void) __attribute__((noreturn));
+void task_print_stats(void);
+
+/* SMP调度 */
+void task_cpu_online(void);
+void sched_tick(void);
+int task_set_affinity(struct task *t, uint32_t mask);
+uint32_t sys_sched_setaffinity(uint32_t tid, uint32_t mask);
+uint32_t sys_sched_getaffinity(uint32_t tid);
+void sched_print_stats(void);
+void test_sched(void);
+
+/* 空闲任务 (kernel/idle.c) */
+struct task *task_create_idle(void (*entry)(void *arg), void *arg);
+int sched_idle_switch(void);
+int sched_need_resched(void);
+uint32_t sched_nr_running(void);
+
+#endif /* _SKYOS_TASK_H_ */
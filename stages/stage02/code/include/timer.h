@@ -0,0 +1,30 @@
+/*
+ * SkyOS ARM Generic Timer
+ * 文件: include/timer.h
+ */
+
+#ifndef _SKYOS_TIMER_H_
+#define _SKYOS_TIMER_H_
+
+#include <stdint.h>
+#include "pmu.h"
+
+/* 性能测量：墙钟时间 (CNTPCT) + PMU计数 */
+typedef struct {
+    uint64_t start_counter;
+    struct pmu_counts start_pmu;
+    const char *name;
+} timer_benchmark_t;
+
+uint32_t timer_get_frequency(void);
+uint64_t timer_get_counter(void);
+uint32_t get_timer_ticks(void);
+void timer_delay_ms(uint32_t milliseconds);
+void timer_delay_us(uint32_t microseconds);
+uint64_t timer_get_timestamp_us(void);
+uint32_t timer_counter_to_ns(uint32_t delta);
+uint32_t timer_counter_mbps(uint32_t bytes, uint32_t delta);
+timer_benchmark_t timer_benchmark_start(const char *name);
+void timer_benchmark_end(timer_benchmark_t bench);
+
+#endif /* _SKYOS_TIMER_H_ */
@@ -0,0 +1,75 @@
+/*
+ * SkyOS 用户态互斥锁与条件变量
+ * 文件: include/ulock.h
+ *
+ * 建立在SYS_FUTEX上的纯头文件库：
+ * - umutex: 三态锁 (0 空闲, 1 持有无等待者, 2 持有且可能有等待者)，
+ *   加锁/解锁在无争用时各只有一次原子操作，只有状态为2时才陷入内核
+ * - ucond: 序号计数条件变量，等待前记下序号，signal/broadcast递增序号后唤醒，
+ *   等待者在序号改变后返回 (可能虚假唤醒，调用者需在循环中重新检查条件)
+ */
+
+#ifndef _SKYOS_ULOCK_H_
+#define _SKYOS_ULOCK_H_
+
+#include <stdint.h>
+#include "atomic.h"
+#include "syscall.h"
+#include "futex.h"
+
+struct umutex {
+    volatile uint32_t state;
+};
+
+struct ucond {
+    volatile uint32_t seq;
+};
+
+#define UMUTEX_INIT     { 0 }
+#define UCOND_INIT      { 0 }
+
+static inline void umutex_lock(struct umutex *m) {
+    uint32_t c = atomic_cmpxchg(&m->state, 0, 1);
+
+    if (c == 0) {
+        return;
+    }
+    /* 标记有等待者后睡眠，被唤醒时仍以2获取 (不知道是否还有其他等待者) */
+    if (c != 2) {
+        c = atomic_xchg(&m->state, 2);
+    }
+    while (c != 0) {
+        syscall3(SYS_FUTEX, &m->state, FUTEX_WAIT, 2);
+        c = atomic_xchg(&m->state, 2);
+    }
+}
+
+static inline int umutex_trylock(struct umutex *m) {
+    return atomic_cmpxchg(&m->state, 0, 1) == 0;
+}
+
+static inline void umutex_unlock(struct umutex *m) {
+    if (atomic_xchg(&m->state, 0) == 2) {
+        syscall3(SYS_FUTEX, &m->state, FUTEX_WAKE, 1);
+    }
+}
+
+static inline void ucond_wait(struct ucond *cv, struct umutex *m) {
+    uint32_t seq = READ_ONCE(cv->seq);
+
+    umutex_unlock(m);
+    syscall3(SYS_FUTEX, &cv->seq, FUTEX_WAIT, seq);
+    umutex_lock(m);
+}
+
+static inline void ucond_signal(struct ucond *cv) {
+    atomic_add_return(&cv->seq, 1);
+    syscall3(SYS_FUTEX, &cv->seq, FUTEX_WAKE, 1);
+}
+
+static inline void ucond_broadcast(struct ucond *cv) {
+    atomic_add_return(&cv->seq, 1);
+    syscall3(SYS_FUTEX, &cv->seq, FUTEX_WAKE, 0xFFFFFFFFu);
+}
+
+#endif /* _SKYOS_ULOCK_H_ */
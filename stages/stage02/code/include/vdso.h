@@ -0,0 +1,96 @@
+/*
+ * SkyOS 共享时间页 (vDSO风格)
+ * 文件: include/vdso.h
+ *
+ * 内核在每个定时器滴答更新一个只读的时间页，任务直接读取而不陷入内核：
+ * - 页中保存滴答数、最近一次更新时的虚拟计数器值和对应的纳秒数，
+ *   以及把计数器差值换算成纳秒的mult/shift (ns = delta * mult >> shift)
+ * - 更新用序号锁：写者先把seq加为奇数，写完再加为偶数；
+ *   读者看到奇数或前后两次seq不同时重读
+ * - CNTKCTL打开了PL0对CNTVCT的访问，用户态也能读计数器
+ *
+ * 下面的vdso_*是纯头文件的用户库：第一次调用时通过SYS_VDSO_PAGE取得时间页
+ * 地址 (没有MMU，"映射"就是把地址交给任务)，之后读取时间不再进入内核。
+ */
+
+#ifndef _SKYOS_VDSO_H_
+#define _SKYOS_VDSO_H_
+
+#include <stdint.h>
+#include "atomic.h"
+#include "syscall.h"
+#include "hal.h"
+
+#define VDSO_MAX_SHIFT  24
+
+struct vdso_time_page {
+    volatile uint32_t seq;          /* 奇数表示正在更新 */
+    uint32_t ticks;                 /* 定时器滴答数 (同SYS_GETTIME) */
+    uint32_t freq;                  /* 计数器频率 (Hz) */
+    uint32_t mult;
+    uint32_t shift;
+    uint32_t pad;
+    uint64_t cycle_last;            /* 最近一次更新时的CNTVCT */
+    uint64_t ns_last;               /* cycle_last对应的启动以来纳秒数 */
+};
+
+/* 内核侧 (kernel/vdso.c) */
+void vdso_init(uint32_t freq);
+void vdso_update(uint32_t ticks);
+uint32_t sys_vdso_page(void);
+void vdso_print_stats(void);
+void test_vdso(void);
+
+/* 虚拟计数器，isb保证不会早于之前读取的时间页字段被读取 */
+static inline uint64_t vdso_read_cntvct(void) {
+    return read_cntvct();
+}
+
+static inline const struct vdso_time_page *vdso_page(void) {
+    static const struct vdso_time_page *page;
+
+    if (page == 0) {
+        page = (const struct vdso_time_page *)syscall0(SYS_VDSO_PAGE);
+    }
+    return page;
+}
+
+/* 读取序号，正在更新时等待 */
+static inline uint32_t vdso_read_begin(const struct vdso_time_page *p) {
+    uint32_t seq;
+
+    while ((seq = READ_ONCE(p->seq)) & 1) {
+    }
+    smp_rmb();
+    return seq;
+}
+
+static inline int vdso_read_retry(const struct vdso_time_page *p, uint32_t seq) {
+    smp_rmb();
+    return READ_ONCE(p->seq) != seq;
+}
+
+/* 启动以来的定时器滴答数 */
+static inline uint32_t vdso_ticks(void) {
+    return READ_ONCE(vdso_page()->ticks);
+}
+
+/* 启动以来的纳秒数 (计数器分辨率) */
+static inline uint64_t vdso_clock_ns(void) {
+    const struct vdso_time_page *p = vdso_page();
+    uint64_t ns, cycle_last;
+    uint32_t mult, shift, seq;
+
+    do {
+        seq = vdso_read_begin(p);
+        cycle_last = p->cycle_last;
+        ns = p->ns_last;
+        mult = p->mult;
+        shift = p->shift;
+        /* 两次更新之间的差值不超过32位 (约一分钟) */
+        ns += ((uint64_t)(uint32_t)(vdso_read_cntvct() - cycle_last) * mult) >> shift;
+    } while (vdso_read_retry(p, seq));
+    return ns;
+}
+
+#endif /* _SKYOS_VDSO_H_ */
@@ -0,0 +1,174 @@
+/*
+ * SkyOS 虚拟文件系统 (VFS)
+ * 文件: include/vfs.h
+ *
+ * 对象模型 (参考Linux VFS的精简版)：
+ * - super_block: 一个已挂载的文件系统实例
+ * - inode:       文件/目录本身，由具体文件系统填充
+ * - dentry:      路径分量 -> inode 的缓存
+ * - file:        打开的文件 (位置、标志)，由文件描述符引用
+ */
+
+#ifndef _SKYOS_VFS_H_
+#define _SKYOS_VFS_H_
+
+#include <stdint.h>
+#include "blkdev.h"
+
+#define VFS_NAME_MAX        64
+#define VFS_MAX_MOUNTS      4
+#define VFS_MAX_INODES      64
+#define VFS_MAX_DENTRIES    64
+#define VFS_MAX_FILES       32
+#define VFS_MAX_FDS         16
+#define VFS_MAX_MAPPINGS    16
+
+/* inode类型 */
+#define VFS_IFREG       1       /* 普通文件 */
+#define VFS_IFDIR       2       /* 目录 */
+#define VFS_IFCHR       3       /* 字符设备 (控制台) */
+#define VFS_IFIFO       4       /* 管道 */
+
+/* open标志 (与Linux取值一致) */
+#define O_RDONLY        0x0000
+#define O_WRONLY        0x0001
+#define O_RDWR          0x0002
+#define O_ACCMODE       0x0003
+#define O_CREAT         0x0040
+#define O_TRUNC         0x0200
+#define O_APPEND        0x0400
+
+/* lseek */
+#define SEEK_SET        0
+#define SEEK_CUR        1
+#define SEEK_END        2
+
+/* 错误码 (返回负值) */
+#define VFS_ENOENT      2
+#define VFS_EIO         5
+#define VFS_EBADF       9
+#define VFS_ENOMEM      12
+#define VFS_EBUSY       16
+#define VFS_EEXIST      17
+#define VFS_ENOTDIR     20
+#define VFS_EISDIR      21
+#define VFS_EINVAL      22
+#define VFS_ENFILE      23
+#define VFS_EMFILE      24
+#define VFS_ENOSPC      28
+#define VFS_EPIPE       32
+#define VFS_EROFS       30
+#define VFS_ENAMETOOLONG 36
+
+/* 返回地址的接口 (如mmap) 用 [-4095, -1] 表示错误码 */
+#define VFS_IS_ERR(x)   ((uint32_t)(x) >= (uint32_t)-4095)
+
+struct inode;
+struct dentry;
+struct file;
+struct super_block;
+
+struct vfs_dirent {
+    char name[VFS_NAME_MAX];
+    uint32_t type;              /* VFS_IF* */
+    uint32_t size;
+};
+
+struct inode_ops {
+    /* 在目录dir中查找name，返回已引用的inode或NULL */
+    struct inode *(*lookup)(struct inode *dir, const char *name, uint32_t len);
+    /* 在目录dir中创建普通文件 (可为NULL表示不支持) */
+    struct inode *(*create)(struct inode *dir, const char *name, uint32_t len);
+    /* 截断文件到size */
+    int (*truncate)(struct inode *inode, uint32_t size);
+};
+
+struct file_ops {
+    int (*open)(struct inode *inode, struct file *file);
+    int (*read)(struct file *file, void *buf, uint32_t count);
+    int (*write)(struct file *file, const void *buf, uint32_t count);
+    int (*readdir)(struct file *file, struct vfs_dirent *dirent);
+    void (*release)(struct file *file);
+    /* 把文件[offset, offset+len)直接映射给调用者，*addr返回映射地址 */
+    int (*mmap)(struct file *file, uint32_t offset, uint32_t len, void **addr);
+    void (*munmap)(struct file *file, void *addr, uint32_t len);
+};
+
+struct super_ops {
+    /* inode引用计数归零时释放文件系统私有数据 */
+    void (*evict_inode)(struct inode *inode);
+};
+
+struct inode {
+    uint32_t ino;
+    uint32_t mode;              /* VFS_IF* */
+    uint32_t size;
+    uint32_t refcnt;
+    struct super_block *sb;
+    const struct inode_ops *i_op;
+    const struct file_ops *f_op;
+    void *private_data;
+};
+
+struct dentry {
+    char name[VFS_NAME_MAX];
+    uint32_t len;
+    uint32_t refcnt;
+    uint32_t children;          /* 缓存中以本项为父的子项数 */
+    struct dentry *parent;
+    struct inode *inode;
+    struct super_block *sb;
+    struct dentry *hash_next;
+};
+
+struct file {
+    struct inode *inode;
+    struct dentry *dentry;
+    uint32_t pos;
+    uint32_t flags;
+    uint32_t refcnt;
+    const struct file_ops *f_op;
+    void *private_data;
+};
+
+struct super_block {
+    struct file_system_type *type;
+    struct blk_device *dev;
+    struct dentry *root;
+    const struct super_ops *s_op;
+    uint32_t readonly;
+    void *fs_info;
+};
+
+struct file_system_type {
+    const char *name;
+    /* 填充sb (root inode等)，成功返回0 */
+    int (*mount)(struct super_block *sb, struct blk_device *dev);
+    struct file_system_type *next;
+};
+
+/* 文件系统注册与挂载 */
+int vfs_register_filesystem(struct file_system_type *fs);
+int vfs_mount(const char *path, const char *fstype, struct blk_device *dev);
+
+/* inode/dentry 辅助 (供具体文件系统使用) */
+struct inode *vfs_alloc_inode(struct super_block *sb, uint32_t ino, uint32_t mode);
+struct inode *vfs_iget(struct inode *inode);
+void vfs_iput(struct inode *inode);
+struct dentry *vfs_make_root(struct super_block *sb, struct inode *root);
+
+/* 文件描述符接口 (由系统调用使用) */
+void vfs_init(void);
+int vfs_open(const char *path, uint32_t flags);
+int vfs_open_anon(struct inode *inode, uint32_t flags, void *private_data);
+int vfs_close(int fd);
+int vfs_read(int fd, void *buf, uint32_t count);
+int vfs_write(int fd, const void *buf, uint32_t count);
+int vfs_lseek(int fd, int32_t offset, uint32_t whence);
+int vfs_readdir(int fd, struct vfs_dirent *dirent);
+uint32_t vfs_mmap(int fd, uint32_t offset, uint32_t len);
+int vfs_munmap(void *addr, uint32_t len);
+struct file *vfs_get_file(int fd);
+void vfs_print_stats(void);
+
+#endif /* _SKYOS_VFS_H_ */
@@ -0,0 +1,122 @@
+/*
+ * SkyOS virtio-mmio 定义
+ * 文件: include/virtio.h
+ *
+ * virtio 1.x 规范 4.2 节 (MMIO传输) 与 2.6 节 (split virtqueue)
+ * 同时兼容QEMU默认的legacy (version 1) MMIO接口
+ */
+
+#ifndef _SKYOS_VIRTIO_H_
+#define _SKYOS_VIRTIO_H_
+
+#include <stdint.h>
+
+/* virtio-mmio节点的地址和中断号来自设备树 (QEMU virt有32个) */
+#define VIRTIO_MMIO_MAX_NODES   32
+
+/* MMIO寄存器偏移 */
+#define VIRTIO_MMIO_MAGIC               0x000   /* "virt" */
+#define VIRTIO_MMIO_VERSION             0x004   /* 1: legacy, 2: modern */
+#define VIRTIO_MMIO_DEVICE_ID           0x008
+#define VIRTIO_MMIO_VENDOR_ID           0x00C
+#define VIRTIO_MMIO_DEVICE_FEATURES     0x010
+#define VIRTIO_MMIO_DEVICE_FEATURES_SEL 0x014
+#define VIRTIO_MMIO_DRIVER_FEATURES     0x020
+#define VIRTIO_MMIO_DRIVER_FEATURES_SEL 0x024
+#define VIRTIO_MMIO_GUEST_PAGE_SIZE     0x028   /* legacy */
+#define VIRTIO_MMIO_QUEUE_SEL           0x030
+#define VIRTIO_MMIO_QUEUE_NUM_MAX       0x034
+#define VIRTIO_MMIO_QUEUE_NUM           0x038
+#define VIRTIO_MMIO_QUEUE_ALIGN         0x03C   /* legacy */
+#define VIRTIO_MMIO_QUEUE_PFN           0x040   /* legacy */
+#define VIRTIO_MMIO_QUEUE_READY         0x044
+#define VIRTIO_MMIO_QUEUE_NOTIFY        0x050
+#define VIRTIO_MMIO_INTERRUPT_STATUS    0x060
+#define VIRTIO_MMIO_INTERRUPT_ACK       0x064
+#define VIRTIO_MMIO_STATUS              0x070
+#define VIRTIO_MMIO_QUEUE_DESC_LOW      0x080
+#define VIRTIO_MMIO_QUEUE_DESC_HIGH     0x084
+#define VIRTIO_MMIO_QUEUE_DRIVER_LOW    0x090
+#define VIRTIO_MMIO_QUEUE_DRIVER_HIGH   0x094
+#define VIRTIO_MMIO_QUEUE_DEVICE_LOW    0x0A0
+#define VIRTIO_MMIO_QUEUE_DEVICE_HIGH   0x0A4
+#define VIRTIO_MMIO_CONFIG              0x100
+
+#define VIRTIO_MMIO_MAGIC_VALUE         0x74726976
+
+/* 设备ID */
+#define VIRTIO_ID_BLOCK                 2
+
+/* 设备状态位 */
+#define VIRTIO_STATUS_ACKNOWLEDGE       1
+#define VIRTIO_STATUS_DRIVER            2
+#define VIRTIO_STATUS_DRIVER_OK         4
+#define VIRTIO_STATUS_FEATURES_OK       8
+#define VIRTIO_STATUS_FAILED            128
+
+/* 中断状态位 */
+#define VIRTIO_MMIO_INT_VRING           (1 << 0)
+#define VIRTIO_MMIO_INT_CONFIG          (1 << 1)
+
+/* 通用特性位 */
+#define VIRTIO_RING_F_INDIRECT_DESC     28
+#define VIRTIO_RING_F_EVENT_IDX         29
+#define VIRTIO_F_VERSION_1              32
+
+/* split virtqueue 描述符 */
+#define VRING_DESC_F_NEXT       1
+#define VRING_DESC_F_WRITE      2
+#define VRING_DESC_F_INDIRECT   4
+
+struct vring_desc {
+    uint64_t addr;
+    uint32_t len;
+    uint16_t flags;
+    uint16_t next;
+};
+
+#define VRING_AVAIL_F_NO_INTERRUPT  1
+
+struct vring_avail {
+    uint16_t flags;
+    uint16_t idx;
+    uint16_t ring[];            /* 之后紧跟 used_event (EVENT_IDX) */
+};
+
+struct vring_used_elem {
+    uint32_t id;
+    uint32_t len;
+};
+
+#define VRING_USED_F_NO_NOTIFY      1
+
+struct vring_used {
+    uint16_t flags;
+    uint16_t idx;
+    struct vring_used_elem ring[];  /* 之后紧跟 avail_event (EVENT_IDX) */
+};
+
+/* EVENT_IDX: 当new_idx越过event_idx时需要通知 (virtio规范 2.6.7.2) */
+static inline int vring_need_event(uint16_t event_idx, uint16_t new_idx, uint16_t old_idx) {
+    return (uint16_t)(new_idx - event_idx - 1) < (uint16_t)(new_idx - old_idx);
+}
+
+/* virtio-blk */
+#define VIRTIO_BLK_F_SEG_MAX    2
+#define VIRTIO_BLK_F_FLUSH      9
+
+#define VIRTIO_BLK_T_IN         0
+#define VIRTIO_BLK_T_OUT        1
+#define VIRTIO_BLK_T_FLUSH      4
+
+#define VIRTIO_BLK_S_OK         0
+#define VIRTIO_BLK_S_IOERR      1
+#define VIRTIO_BLK_S_UNSUPP     2
+
+struct virtio_blk_req_hdr {
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t sector;
+};
+
+#endif /* _SKYOS_VIRTIO_H_ */
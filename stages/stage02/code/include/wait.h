@@ -0,0 +1,71 @@
+/*
+ * SkyOS 等待队列
+ * 文件: include/wait.h
+ *
+ * 任务在条件不满足时挂到等待队列上阻塞，条件的修改者调用wake_up唤醒。
+ * 等待项放在等待者自己的栈上 (初始化为全零)。用法 (wait_event宏展开后的形式)：
+ *
+ *     for (;;) {
+ *         wait_prepare(wq, &e, key);      入队并设为TASK_BLOCKED
+ *         if (条件成立) break;
+ *         wait_schedule(wq);              期间被唤醒则立即返回
+ *     }
+ *     wait_finish(wq, &e);
+ *
+ * 先入队再检查条件，唤醒者先改条件再唤醒，所以不会丢失唤醒。
+ * key用于共享同一队列的不同等待对象 (如futex哈希桶中的不同地址)。
+ */
+
+#ifndef _SKYOS_WAIT_H_
+#define _SKYOS_WAIT_H_
+
+#include <stdint.h>
+#include "spinlock.h"
+#include "task.h"
+
+struct wait_entry {
+    struct task *task;
+    uint32_t key;
+    uint32_t queued;
+    struct wait_entry *next;
+};
+
+struct wait_queue {
+    struct spinlock lock;
+    struct wait_entry *head;
+    uint32_t waits;             /* 统计：真正阻塞的次数 */
+    uint32_t wakeups;           /* 统计：唤醒的等待者数 */
+};
+
+#define WAIT_QUEUE_INIT(n)      { .lock = SPINLOCK_INIT(n), .head = 0 }
+#define WAKE_ALL                0xFFFFFFFFu
+
+void wait_queue_init(struct wait_queue *wq, const char *name);
+void wait_prepare(struct wait_queue *wq, struct wait_entry *e, uint32_t key);
+void wait_finish(struct wait_queue *wq, struct wait_entry *e);
+void wait_schedule(struct wait_queue *wq);
+uint32_t wake_up_key(struct wait_queue *wq, uint32_t key, uint32_t n);
+
+/* 唤醒最多n个等待者 (不区分key) */
+static inline uint32_t wake_up(struct wait_queue *wq, uint32_t n) {
+    return wake_up_key(wq, 0, n);
+}
+
+static inline uint32_t wake_up_all(struct wait_queue *wq) {
+    return wake_up_key(wq, 0, WAKE_ALL);
+}
+
+/* 阻塞直到cond成立 (cond不能让出CPU) */
+#define wait_event(wq, cond) do {                                       \
+    struct wait_entry __we = { 0 };                                     \
+    for (;;) {                                                          \
+        wait_prepare((wq), &__we, 0);                                   \
+        if (cond) {                                                     \
+            break;                                                      \
+        }                                                               \
+        wait_schedule(wq);                                              \
+    }                                                                   \
+    wait_finish((wq), &__we);                                           \
+} while (0)
+
+#endif /* _SKYOS_WAIT_H_ */
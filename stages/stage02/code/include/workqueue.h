@@ -0,0 +1,51 @@
+/*
+ * SkyOS 工作窃取工作队列
+ * 文件: include/workqueue.h
+ *
+ * 每个CPU一个Chase-Lev双端队列和一个工作线程：
+ * - queue_work在本CPU的队列底部压入 (可在中断中调用)，本CPU的工作线程从底部取
+ * - 空闲的工作线程从其他队列顶部窃取 (CAS)，一个CPU中断里排入的突发工作
+ *   会自动分散到所有工作线程
+ * - 队列满时退回到全局溢出链表
+ *
+ * 工作项由调用者分配，执行前清除PENDING，所以处理函数可以重新排入自己。
+ */
+
+#ifndef _SKYOS_WORKQUEUE_H_
+#define _SKYOS_WORKQUEUE_H_
+
+#include <stdint.h>
+#include "rcu.h"
+
+#define WQ_NR_WORKERS       RCU_MAX_CPUS    /* 每个CPU一个工作线程 */
+#define WQ_DEQUE_SIZE       64              /* 2的幂 */
+
+/* work_struct.state */
+#define WORK_PENDING        (1u << 0)       /* 已排队尚未开始执行 */
+#define WORK_RUNNING        (1u << 1)       /* 正在执行 */
+
+struct work_struct;
+typedef void (*work_func_t)(struct work_struct *work);
+
+struct work_struct {
+    work_func_t func;
+    volatile uint32_t state;    /* WORK_* */
+    struct work_struct *next;   /* 溢出链表 */
+};
+
+#define WORK_INIT(f)        { .func = (f), .state = 0, .next = 0 }
+
+static inline void init_work(struct work_struct *work, work_func_t func) {
+    work->func = func;
+    work->state = 0;
+    work->next = 0;
+}
+
+void workqueue_init(void);
+int queue_work(struct work_struct *work);
+void flush_work(struct work_struct *work);
+void flush_workqueue(void);
+void wq_print_stats(void);
+void test_workqueue(void);
+
+#endif /* _SKYOS_WORKQUEUE_H_ */
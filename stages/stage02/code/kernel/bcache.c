@@ -0,0 +1,651 @@
+/*
+ * SkyOS 块缓冲区缓存
+ * 文件: kernel/bcache.c
+ *
+ * 实现：
+ * 1. 哈希表索引 (设备, 块号) -> 缓冲区
+ * 2. CLOCK淘汰：访问位给缓冲区"第二次机会"，被引用/脏/I/O中的块不淘汰
+ * 3. 写回：脏块挂脏链表，定时器回调排入写回工作 (工作队列启动前直接在中断中写回)，
+ *    把过期脏块排序后合并成多段请求异步写回
+ * 4. 预读：检测顺序访问，窗口从8块倍增到64块，与当前块合并为一批请求提交
+ *
+ * 缓存状态会被定时器回调和I/O完成回调(中断上下文)修改，
+ * 所以普通上下文中的操作都在local_irq_save保护下进行。
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "bcache.h"
+#include "irqflags.h"
+#include "workqueue.h"
+#include "hal.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_hex(uint32_t value);
+extern uint32_t get_timer_ticks(void);
+extern int timer_register_callback(void (*fn)(void *), void *data, uint32_t period_ticks);
+
+#define BCACHE_NBUF             256
+#define BCACHE_HASH_SIZE        64
+#define BCACHE_FLUSH_PERIOD     50      /* 写回检查周期 (滴答, 500ms) */
+#define BCACHE_DIRTY_EXPIRE     100     /* 脏块超过1秒即写回 */
+#define BCACHE_FLUSH_BATCH      64      /* 单次写回的最大块数 */
+#define BCACHE_RA_MIN           8       /* 初始预读窗口 (块) */
+#define BCACHE_RA_MAX           64      /* 最大预读窗口 */
+#define BCACHE_RA_TRIGGER       2       /* 连续顺序访问次数达到后开始预读 */
+
+/* 每个设备一个顺序流检测器 */
+struct bcache_stream {
+    struct blk_device *dev;
+    uint32_t last;              /* 上次访问的块号 */
+    uint32_t seq;               /* 连续顺序访问次数 */
+    uint32_t ra_end;            /* 已预读到的位置 (不含) */
+    uint32_t window;            /* 当前预读窗口 */
+};
+
+static struct buf bcache_bufs[BCACHE_NBUF];
+static uint8_t bcache_data[BCACHE_NBUF][BCACHE_BLOCK_SIZE] __attribute__((aligned(64)));
+static struct buf *bcache_hash[BCACHE_HASH_SIZE];
+static struct buf *bcache_dirty_head = NULL;
+static uint32_t bcache_dirty_count = 0;
+static uint32_t bcache_clock_hand = 0;
+static struct bcache_stream bcache_streams[BLK_MAX_DEVICES];
+
+/* 统计信息 */
+static uint32_t stat_hits = 0;
+static uint32_t stat_misses = 0;
+static uint32_t stat_ra_blocks = 0;
+static uint32_t stat_ra_hits = 0;
+static uint32_t stat_writebacks = 0;
+static uint32_t stat_evictions = 0;
+static uint32_t stat_flush_runs = 0;
+
+static inline uint32_t bcache_hashfn(struct blk_device *dev, uint32_t blockno) {
+    return (((uint32_t)dev >> 6) ^ blockno ^ (blockno >> 6)) & (BCACHE_HASH_SIZE - 1);
+}
+
+static struct buf *bcache_lookup(struct blk_device *dev, uint32_t blockno) {
+    struct buf *b = bcache_hash[bcache_hashfn(dev, blockno)];
+    while (b) {
+        if (b->dev == dev && b->blockno == blockno) {
+            return b;
+        }
+        b = b->hash_next;
+    }
+    return NULL;
+}
+
+static void bcache_hash_insert(struct buf *b, struct blk_device *dev, uint32_t blockno) {
+    uint32_t h = bcache_hashfn(dev, blockno);
+    b->dev = dev;
+    b->blockno = blockno;
+    b->hash_next = bcache_hash[h];
+    bcache_hash[h] = b;
+}
+
+static void bcache_hash_remove(struct buf *b) {
+    struct buf **pp = &bcache_hash[bcache_hashfn(b->dev, b->blockno)];
+    while (*pp) {
+        if (*pp == b) {
+            *pp = b->hash_next;
+            break;
+        }
+        pp = &(*pp)->hash_next;
+    }
+    b->hash_next = NULL;
+    b->dev = NULL;
+}
+
+static void bcache_dirty_add(struct buf *b) {
+    b->dirty_prev = NULL;
+    b->dirty_next = bcache_dirty_head;
+    if (bcache_dirty_head) {
+        bcache_dirty_head->dirty_prev = b;
+    }
+    bcache_dirty_head = b;
+    bcache_dirty_count++;
+}
+
+static void bcache_dirty_del(struct buf *b) {
+    if (b->dirty_prev) {
+        b->dirty_prev->dirty_next = b->dirty_next;
+    } else {
+        bcache_dirty_head = b->dirty_next;
+    }
+    if (b->dirty_next) {
+        b->dirty_next->dirty_prev = b->dirty_prev;
+    }
+    b->dirty_next = b->dirty_prev = NULL;
+    bcache_dirty_count--;
+}
+
+/* CLOCK淘汰：转动指针，清除访问位，找到第一个可回收的缓冲区 */
+static struct buf *bcache_alloc(void) {
+    for (uint32_t n = 0; n < 2 * BCACHE_NBUF; n++) {
+        struct buf *b = &bcache_bufs[bcache_clock_hand];
+        bcache_clock_hand = (bcache_clock_hand + 1) % BCACHE_NBUF;
+
+        if (b->refcnt || (b->flags & (B_BUSY | B_DIRTY))) {
+            continue;
+        }
+        if (b->clock_ref) {
+            b->clock_ref = 0;
+            continue;
+        }
+
+        if (b->dev) {
+            bcache_hash_remove(b);
+            stat_evictions++;
+        }
+        b->flags = 0;
+        b->io_next = NULL;
+        b->io_req = NULL;
+        return b;
+    }
+    return NULL;
+}
+
+/* I/O完成回调 (中断或轮询上下文) */
+static void bcache_end_io(struct blk_request *req) {
+    struct buf *b = req->private_data;
+    int is_write = (req->type == BLK_REQ_WRITE);
+
+    while (b) {
+        struct buf *next = b->io_next;
+        b->io_next = NULL;
+
+        if (req->status == BLK_STATUS_OK) {
+            b->flags &= ~B_ERROR;
+            if (is_write) {
+                stat_writebacks++;
+            } else {
+                b->flags |= B_VALID;
+            }
+        } else {
+            b->flags |= B_ERROR;
+            b->flags &= ~B_READAHEAD;
+            if (is_write && !(b->flags & B_DIRTY)) {
+                /* 写失败：重新挂回脏链表，下次再试 */
+                b->flags |= B_DIRTY;
+                b->dirty_tick = get_timer_ticks();
+                bcache_dirty_add(b);
+            }
+        }
+        b->flags &= ~B_BUSY;
+        b = next;
+    }
+}
+
+/*
+ * 把按块号升序排列的缓冲区合并成请求：连续块放进同一请求的多个数据段，
+ * 然后整批提交 (一次门铃)。调用者已把缓冲区标记为B_BUSY。
+ */
+static void bcache_submit_bufs(struct blk_device *dev, struct buf **list, uint32_t n, uint32_t type) {
+    struct blk_request *reqs[BCACHE_FLUSH_BATCH + 1];
+    uint32_t nreq = 0;
+    uint32_t i = 0;
+
+    while (i < n) {
+        struct buf *owner = list[i];
+        struct blk_request *req = &owner->req;
+        struct buf *tail = owner;
+
+        blk_init_request(req, type, owner->blockno, owner->data, BCACHE_BLOCK_SIZE);
+        req->end_io = bcache_end_io;
+        req->private_data = owner;
+        owner->io_req = req;
+        i++;
+
+        while (i < n && req->nr_segs < dev->max_segs &&
+               list[i]->blockno == tail->blockno + 1) {
+            struct buf *b = list[i++];
+            req->segs[req->nr_segs].buf = b->data;
+            req->segs[req->nr_segs].len = BCACHE_BLOCK_SIZE;
+            req->nr_segs++;
+            b->io_req = req;
+            tail->io_next = b;
+            tail = b;
+        }
+        reqs[nreq++] = req;
+    }
+
+    uint32_t done = 0;
+    while (done < nreq) {
+        uint32_t q = blk_submit(dev, reqs + done, nreq - done);
+        if (q == 0) {
+            /* 环已满：回收完成项以释放描述符 */
+            dev->ops->poll(dev);
+        }
+        done += q;
+    }
+}
+
+/* 等待缓冲区上的I/O结束 */
+static void bcache_wait(struct buf *b) {
+    struct blk_device *dev = b->dev;
+
+    while (b->flags & B_BUSY) {
+        if (dev->polling || irqs_disabled()) {
+            dev->ops->poll(dev);
+        } else {
+            cpu_wfi();
+        }
+    }
+}
+
+/* 为[start, start+count)中未缓存的块分配缓冲区并发起一批读请求 (需屏蔽中断) */
+static void bcache_start_read(struct blk_device *dev, uint32_t start, uint32_t count, uint32_t want) {
+    struct buf *list[BCACHE_RA_MAX + 1];
+    uint32_t n = 0;
+
+    if (count > BCACHE_RA_MAX + 1) {
+        count = BCACHE_RA_MAX + 1;
+    }
+
+    for (uint32_t blk = start; blk < start + count && blk < dev->capacity; blk++) {
+        if (bcache_lookup(dev, blk)) {
+            continue;
+        }
+        struct buf *b = bcache_alloc();
+        if (b == NULL) {
+            break;
+        }
+        bcache_hash_insert(b, dev, blk);
+        b->refcnt = 0;
+        if (blk == want) {
+            b->flags = B_BUSY;
+            b->clock_ref = 1;
+        } else {
+            /* 预读块访问位为0：若一直未被使用会最先被淘汰 */
+            b->flags = B_BUSY | B_READAHEAD;
+            b->clock_ref = 0;
+            stat_ra_blocks++;
+        }
+        list[n++] = b;
+    }
+
+    if (n) {
+        bcache_submit_bufs(dev, list, n, BLK_REQ_READ);
+    }
+}
+
+static struct bcache_stream *bcache_stream_get(struct blk_device *dev) {
+    for (uint32_t i = 0; i < BLK_MAX_DEVICES; i++) {
+        if (bcache_streams[i].dev == dev) {
+            return &bcache_streams[i];
+        }
+    }
+    for (uint32_t i = 0; i < BLK_MAX_DEVICES; i++) {
+        if (bcache_streams[i].dev == NULL) {
+            bcache_streams[i].dev = dev;
+            bcache_streams[i].last = (uint32_t)-2;
+            bcache_streams[i].window = BCACHE_RA_MIN;
+            return &bcache_streams[i];
+        }
+    }
+    return NULL;
+}
+
+/* 顺序访问检测，需要预读时返回预读块数并通过ra_start返回起点 */
+static uint32_t bcache_stream_update(struct blk_device *dev, uint32_t blockno, uint32_t *ra_start) {
+    struct bcache_stream *s = bcache_stream_get(dev);
+
+    if (s == NULL) {
+        return 0;
+    }
+
+    if (blockno == s->last + 1) {
+        s->seq++;
+    } else if (blockno != s->last) {
+        s->seq = 0;
+        s->ra_end = 0;
+        s->window = BCACHE_RA_MIN;
+    }
+    s->last = blockno;
+
+    if (s->seq < BCACHE_RA_TRIGGER) {
+        return 0;
+    }
+    /* 预读进度仍领先半个窗口以上，暂不需要 */
+    if (s->ra_end > blockno + s->window / 2) {
+        return 0;
+    }
+
+    uint32_t start = blockno + 1;
+    if (s->ra_end > start) {
+        start = s->ra_end;
+    }
+    uint32_t count = blockno + 1 + s->window - start;
+    s->ra_end = start + count;
+    if (s->window < BCACHE_RA_MAX) {
+        s->window *= 2;
+    }
+
+    *ra_start = start;
+    return count;
+}
+
+/* 读取一个块，返回已引用的缓冲区 (用完需brelse) */
+struct buf *bread(struct blk_device *dev, uint32_t blockno) {
+    struct buf *b;
+    uint32_t ra_start = 0;
+    uint32_t ra_count;
+    uint32_t flags;
+
+    if (dev == NULL || blockno >= dev->capacity) {
+        return NULL;
+    }
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        flags = local_irq_save();
+        ra_count = bcache_stream_update(dev, blockno, &ra_start);
+
+        b = bcache_lookup(dev, blockno);
+        if (b) {
+            stat_hits++;
+            if (b->flags & B_READAHEAD) {
+                b->flags &= ~B_READAHEAD;
+                stat_ra_hits++;
+            }
+            if (!(b->flags & (B_VALID | B_BUSY))) {
+                /* 之前的读(如预读)失败，重新发起 */
+                b->flags |= B_BUSY;
+                bcache_submit_bufs(dev, &b, 1, BLK_REQ_READ);
+            }
+        } else {
+            if (attempt == 0) {
+                stat_misses++;
+            }
+            /* 当前块和紧随其后的预读块合并成一批 */
+            if (ra_count && ra_start == blockno + 1) {
+                bcache_start_read(dev, blockno, ra_count + 1, blockno);
+                ra_count = 0;
+            } else {
+                bcache_start_read(dev, blockno, 1, blockno);
+            }
+            b = bcache_lookup(dev, blockno);
+        }
+
+        /* 先持有引用，避免随后的预读分配把它淘汰 */
+        if (b) {
+            b->refcnt++;
+            b->clock_ref = 1;
+        }
+        if (ra_count) {
+            bcache_start_read(dev, ra_start, ra_count, (uint32_t)-1);
+        }
+        local_irq_restore(flags);
+
+        if (b) {
+            break;
+        }
+
+        /* 所有缓冲区都脏或被引用：同步写回后重试 */
+        bcache_flush(1);
+    }
+
+    if (b == NULL) {
+        return NULL;
+    }
+
+    bcache_wait(b);
+    if (!(b->flags & B_VALID)) {
+        brelse(b);
+        return NULL;
+    }
+    return b;
+}
+
+/* 获取一个块的缓冲区但不读盘 (调用者将整块覆盖写) */
+struct buf *bget(struct blk_device *dev, uint32_t blockno) {
+    struct buf *b;
+    uint32_t flags;
+
+    if (dev == NULL || blockno >= dev->capacity) {
+        return NULL;
+    }
+
+    flags = local_irq_save();
+    b = bcache_lookup(dev, blockno);
+    if (b == NULL) {
+        b = bcache_alloc();
+        if (b) {
+            bcache_hash_insert(b, dev, blockno);
+            for (uint32_t i = 0; i < BCACHE_BLOCK_SIZE; i++) {
+                b->data[i] = 0;
+            }
+            b->flags = B_VALID;
+        }
+    }
+    if (b) {
+        b->refcnt++;
+        b->clock_ref = 1;
+    }
+    local_irq_restore(flags);
+
+    if (b) {
+        bcache_wait(b);
+    }
+    return b;
+}
+
+/* 标记缓冲区为脏，由定时器回调异步写回 */
+void bdirty(struct buf *b) {
+    uint32_t flags = local_irq_save();
+
+    b->flags |= B_VALID;
+    b->flags &= ~B_READAHEAD;
+    if (!(b->flags & B_DIRTY)) {
+        b->flags |= B_DIRTY;
+        b->dirty_tick = get_timer_ticks();
+        bcache_dirty_add(b);
+    }
+
+    local_irq_restore(flags);
+}
+
+/* 释放对缓冲区的引用 */
+void brelse(struct buf *b) {
+    uint32_t flags = local_irq_save();
+    if (b->refcnt) {
+        b->refcnt--;
+    }
+    local_irq_restore(flags);
+}
+
+/* 同步写回单个缓冲区 */
+int bwrite(struct buf *b) {
+    uint32_t flags;
+
+    bcache_wait(b);
+
+    flags = local_irq_save();
+    if (b->flags & B_DIRTY) {
+        b->flags &= ~B_DIRTY;
+        bcache_dirty_del(b);
+    }
+    b->flags |= B_BUSY;
+    bcache_submit_bufs(b->dev, &b, 1, BLK_REQ_WRITE);
+    local_irq_restore(flags);
+
+    bcache_wait(b);
+    return (b->flags & B_ERROR) ? -1 : 0;
+}
+
+/* 异步预读[blockno, blockno+count) */
+void bcache_readahead(struct blk_device *dev, uint32_t blockno, uint32_t count) {
+    uint32_t flags = local_irq_save();
+    bcache_start_read(dev, blockno, count, (uint32_t)-1);
+    local_irq_restore(flags);
+}
+
+static int bcache_buf_before(struct buf *a, struct buf *b) {
+    if (a->dev != b->dev) {
+        return (uint32_t)a->dev < (uint32_t)b->dev;
+    }
+    return a->blockno < b->blockno;
+}
+
+/*
+ * 收集脏块 (only_expired时只取超过BCACHE_DIRTY_EXPIRE的)，
+ * 按(设备, 块号)排序后合并提交。需屏蔽中断，返回提交的块数。
+ */
+static uint32_t bcache_writeback(int only_expired, struct buf **list) {
+    uint32_t now = get_timer_ticks();
+    uint32_t n = 0;
+    struct buf *b = bcache_dirty_head;
+
+    while (b && n < BCACHE_FLUSH_BATCH) {
+        struct buf *next = b->dirty_next;
+        if (!(b->flags & B_BUSY) &&
+            (!only_expired || now - b->dirty_tick >= BCACHE_DIRTY_EXPIRE)) {
+            bcache_dirty_del(b);
+            b->flags &= ~B_DIRTY;
+            b->flags |= B_BUSY;
+
+            /* 插入排序 */
+            uint32_t j = n++;
+            while (j > 0 && bcache_buf_before(b, list[j - 1])) {
+                list[j] = list[j - 1];
+                j--;
+            }
+            list[j] = b;
+        }
+        b = next;
+    }
+
+    uint32_t i = 0;
+    while (i < n) {
+        uint32_t j = i;
+        while (j < n && list[j]->dev == list[i]->dev) {
+            j++;
+        }
+        bcache_submit_bufs(list[i]->dev, list + i, j - i, BLK_REQ_WRITE);
+        i = j;
+    }
+
+    if (n) {
+        stat_flush_runs++;
+    }
+    return n;
+}
+
+/* 写回脏块；wait非0时写回全部并等待完成 */
+void bcache_flush(int wait) {
+    struct buf *list[BCACHE_FLUSH_BATCH];
+    uint32_t n;
+
+    do {
+        uint32_t flags = local_irq_save();
+        n = bcache_writeback(!wait, list);
+        local_irq_restore(flags);
+
+        if (wait) {
+            for (uint32_t i = 0; i < n; i++) {
+                bcache_wait(list[i]);
+            }
+        }
+    } while (wait && n);
+}
+
+/* 写回工作：在工作线程中异步写回过期脏块 */
+static void bcache_flush_work_fn(struct work_struct *work) {
+    (void)work;
+    bcache_flush(0);
+}
+
+static struct work_struct bcache_flush_work = WORK_INIT(bcache_flush_work_fn);
+
+/* 定时器回调 (中断上下文)：写回交给工作队列，尚未启动时就地写回 */
+static void bcache_timer_flush(void *data) {
+    struct buf *list[BCACHE_FLUSH_BATCH];
+    (void)data;
+
+    if (bcache_dirty_head && queue_work(&bcache_flush_work) < 0) {
+        bcache_writeback(1, list);
+    }
+}
+
+/* 初始化缓冲区缓存 */
+void bcache_init(void) {
+    for (uint32_t i = 0; i < BCACHE_NBUF; i++) {
+        bcache_bufs[i].data = bcache_data[i];
+    }
+    timer_register_callback(bcache_timer_flush, NULL, BCACHE_FLUSH_PERIOD);
+
+    uart_puts("缓冲区缓存: ");
+    uart_put_hex(BCACHE_NBUF);
+    uart_puts(" 块 x ");
+    uart_put_hex(BCACHE_BLOCK_SIZE);
+    uart_puts(" 字节\r\n");
+}
+
+/* 打印缓存统计 */
+void bcache_print_stats(void) {
+    uint32_t total = stat_hits + stat_misses;
+
+    uart_puts("\r\n=== 缓冲区缓存统计 ===\r\n");
+    uart_puts("命中: ");
+    uart_put_hex(stat_hits);
+    uart_puts(", 未命中: ");
+    uart_put_hex(stat_misses);
+    uart_puts(", 命中率: ");
+    uart_put_hex(total ? stat_hits * 100 / total : 0);
+    uart_puts("%\r\n");
+    uart_puts("预读块: ");
+    uart_put_hex(stat_ra_blocks);
+    uart_puts(", 预读命中: ");
+    uart_put_hex(stat_ra_hits);
+    uart_puts("\r\n");
+    uart_puts("写回块: ");
+    uart_put_hex(stat_writebacks);
+    uart_puts(", 写回批次: ");
+    uart_put_hex(stat_flush_runs);
+    uart_puts(", 当前脏块: ");
+    uart_put_hex(bcache_dirty_count);
+    uart_puts("\r\n");
+    uart_puts("淘汰: ");
+    uart_put_hex(stat_evictions);
+    uart_puts("\r\n");
+    uart_puts("======================\r\n");
+}
+
+/* 测试缓存：两遍顺序读 + 一次写回 (写回原数据，不改变镜像内容) */
+void test_bcache(void) {
+    struct blk_device *dev = blk_get_default();
+
+    uart_puts("\r\n=== 测试缓冲区缓存 ===\r\n");
+    if (dev == NULL) {
+        uart_puts("无块设备，跳过\r\n");
+        uart_puts("======================\r\n");
+        return;
+    }
+
+    uint32_t nblocks = dev->capacity < 128 ? (uint32_t)dev->capacity : 128;
+    for (uint32_t pass = 0; pass < 2; pass++) {
+        uint32_t hits = stat_hits;
+        uint32_t misses = stat_misses;
+        for (uint32_t blk = 0; blk < nblocks; blk++) {
+            struct buf *b = bread(dev, blk);
+            if (b) {
+                brelse(b);
+            }
+        }
+        uart_puts("第");
+        uart_put_hex(pass + 1);
+        uart_puts("遍顺序读: 命中 ");
+        uart_put_hex(stat_hits - hits);
+        uart_puts(", 未命中 ");
+        uart_put_hex(stat_misses - misses);
+        uart_puts("\r\n");
+    }
+
+    struct buf *b = bread(dev, 1);
+    if (b) {
+        bdirty(b);
+        brelse(b);
+        uart_puts("块1已标记为脏，等待定时器写回\r\n");
+    }
+    uart_puts("======================\r\n");
+}
@@ -0,0 +1,169 @@
+/*
+ * SkyOS 块设备层
+ * 文件: kernel/blkdev.c
+ *
+ * 管理已注册的块设备，提供批量提交、同步读写和完成等待
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "blkdev.h"
+#include "irqflags.h"
+#include "wait.h"
+#include "hal.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_hex(uint32_t value);
+
+static struct blk_device *blk_devices[BLK_MAX_DEVICES];
+static uint32_t blk_device_count = 0;
+static struct wait_queue blk_done_wq = WAIT_QUEUE_INIT("blk_done");
+
+static int blk_name_equal(const char *a, const char *b) {
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+/* 注册块设备 */
+int blk_register(struct blk_device *dev) {
+    if (blk_device_count >= BLK_MAX_DEVICES) {
+        return -1;
+    }
+    blk_devices[blk_device_count++] = dev;
+
+    uart_puts("块设备注册: ");
+    uart_puts(dev->name);
+    uart_puts(" 容量 ");
+    uart_put_hex((uint32_t)dev->capacity);
+    uart_puts(" 扇区\r\n");
+    return 0;
+}
+
+/* 按名字查找块设备 */
+struct blk_device *blk_get(const char *name) {
+    for (uint32_t i = 0; i < blk_device_count; i++) {
+        if (blk_name_equal(blk_devices[i]->name, name)) {
+            return blk_devices[i];
+        }
+    }
+    return NULL;
+}
+
+/* 第一个注册的块设备 */
+struct blk_device *blk_get_default(void) {
+    return blk_device_count ? blk_devices[0] : NULL;
+}
+
+/* 初始化单段请求 */
+void blk_init_request(struct blk_request *req, uint32_t type, uint64_t sector,
+                      void *buf, uint32_t len) {
+    req->type = type;
+    req->sector = sector;
+    req->nr_segs = (buf && len) ? 1 : 0;
+    req->segs[0].buf = buf;
+    req->segs[0].len = len;
+    req->status = BLK_STATUS_PENDING;
+    req->done = 0;
+    req->end_io = NULL;
+    req->private_data = NULL;
+}
+
+/* 批量提交请求 */
+uint32_t blk_submit(struct blk_device *dev, struct blk_request **reqs, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        reqs[i]->status = BLK_STATUS_PENDING;
+        reqs[i]->done = 0;
+    }
+
+    uint32_t queued = dev->ops->submit(dev, reqs, count);
+
+    dev->stat_batches++;
+    dev->stat_requests += queued;
+    for (uint32_t i = 0; i < queued; i++) {
+        for (uint32_t s = 0; s < reqs[i]->nr_segs; s++) {
+            dev->stat_sectors += reqs[i]->segs[s].len / BLK_SECTOR_SIZE;
+        }
+    }
+    return queued;
+}
+
+/* 由驱动在请求完成时调用 (中断或轮询上下文) */
+void blk_complete(struct blk_request *req, uint32_t status) {
+    req->status = status;
+    req->done = 1;
+    if (req->end_io) {
+        req->end_io(req);
+    }
+    wake_up_all(&blk_done_wq);
+}
+
+/*
+ * 等待请求完成：轮询模式或IRQ被屏蔽时主动轮询；
+ * 有任务上下文时在完成队列上睡眠 (由完成中断唤醒)，否则wfi等待中断
+ */
+void blk_wait(struct blk_device *dev, struct blk_request *req) {
+    if (!dev->polling && !irqs_disabled() && task_current()) {
+        wait_event(&blk_done_wq, req->done);
+        return;
+    }
+    while (!req->done) {
+        if (dev->polling || irqs_disabled()) {
+            dev->ops->poll(dev);
+        } else {
+            cpu_wfi();
+        }
+    }
+}
+
+static int blk_rw_sync(struct blk_device *dev, uint32_t type, uint64_t sector,
+                       void *buf, uint32_t count) {
+    struct blk_request req;
+    struct blk_request *reqp = &req;
+
+    if (dev == NULL || sector + count > dev->capacity) {
+        return -1;
+    }
+
+    blk_init_request(&req, type, sector, buf, count * BLK_SECTOR_SIZE);
+    if (blk_submit(dev, &reqp, 1) != 1) {
+        return -1;
+    }
+    blk_wait(dev, &req);
+    return req.status == BLK_STATUS_OK ? 0 : -1;
+}
+
+/* 同步读取count个扇区 */
+int blk_read(struct blk_device *dev, uint64_t sector, void *buf, uint32_t count) {
+    return blk_rw_sync(dev, BLK_REQ_READ, sector, buf, count);
+}
+
+/* 同步写入count个扇区 */
+int blk_write(struct blk_device *dev, uint64_t sector, const void *buf, uint32_t count) {
+    return blk_rw_sync(dev, BLK_REQ_WRITE, sector, (void *)buf, count);
+}
+
+/* 打印块设备统计 */
+void blk_print_stats(void) {
+    if (blk_device_count == 0) {
+        return;
+    }
+
+    uart_puts("\r\n=== 块设备统计 ===\r\n");
+    for (uint32_t i = 0; i < blk_device_count; i++) {
+        struct blk_device *dev = blk_devices[i];
+        uart_puts(dev->name);
+        uart_puts(": 请求 ");
+        uart_put_hex(dev->stat_requests);
+        uart_puts(", 批次 ");
+        uart_put_hex(dev->stat_batches);
+        uart_puts(", 扇区 ");
+        uart_put_hex(dev->stat_sectors);
+        uart_puts(dev->polling ? " (轮询)" : " (中断)");
+        uart_puts("\r\n");
+    }
+    uart_puts("==================\r\n");
+}
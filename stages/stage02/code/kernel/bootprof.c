@@ -0,0 +1,205 @@
+/*
+ * SkyOS 启动计时与快速启动
+ * 文件: kernel/bootprof.c
+ *
+ * 1. boot/start.S把复位时刻和进入main时刻的CNTPCT写入boot_reset_stamp/boot_main_stamp
+ * 2. boot_mark()记录阶段名和时间戳，报告中按相邻差值列出每个阶段的耗时
+ * 3. 普通启动时boot_defer()立即执行并计时；fastboot时登记下来，
+ *    boot_start_deferred()创建内核线程在主循环运行后执行
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "bootprof.h"
+#include "fdt.h"
+#include "task.h"
+#include "timer.h"
+#include "kstring.h"
+#include "kprintf.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_hex(uint32_t value);
+extern void uart_put_dec(uint32_t value);
+
+/* 由boot/start.S写入 (BSS清零之后) */
+uint64_t boot_reset_stamp __attribute__((aligned(8)));
+uint64_t boot_main_stamp __attribute__((aligned(8)));
+
+struct boot_stage {
+    const char *name;
+    uint64_t stamp;             /* 阶段结束时的CNTPCT */
+};
+
+struct boot_deferred {
+    void (*fn)(void);
+    const char *name;
+    uint32_t ticks;             /* 执行耗时 (CNTPCT计数) */
+};
+
+static struct boot_stage boot_stages[BOOT_MAX_MARKS];
+static uint32_t boot_stage_count = 0;
+static struct boot_deferred boot_deferred[BOOT_MAX_DEFERRED];
+static uint32_t boot_deferred_count = 0;
+static uint32_t boot_deferred_done = 0;
+static uint64_t boot_deferred_start = 0;
+static uint64_t boot_deferred_end = 0;
+static int boot_fast_mode = -1;         /* -1: 尚未解析bootargs */
+
+static inline uint64_t boot_read_cntpct(void) {
+    uint64_t val;
+    asm volatile("isb\n"
+                 "mrrc p15, 0, %Q0, %R0, c14" : "=r"(val));
+    return val;
+}
+
+/* 计数值转微秒，分两步避免64位除法和溢出 */
+static uint32_t boot_ticks_to_us(uint32_t ticks) {
+    uint32_t khz = timer_get_frequency() / 1000;
+
+    if (khz == 0) {
+        return 0;
+    }
+    return (ticks / khz) * 1000 + (ticks % khz) * 1000 / khz;
+}
+
+/* 记录一个启动阶段的结束 */
+void boot_mark(const char *stage) {
+    if (boot_stage_count >= BOOT_MAX_MARKS) {
+        pr_warn("启动阶段表已满 (BOOT_MAX_MARKS=%u)，丢弃: %s\n",
+                (unsigned int)BOOT_MAX_MARKS, stage);
+        return;
+    }
+    boot_stages[boot_stage_count].name = stage;
+    boot_stages[boot_stage_count].stamp = boot_read_cntpct();
+    boot_stage_count++;
+}
+
+/* bootargs中是否有name (以空格分隔的完整单词，或 name=value) */
+int boot_param(const char *name) {
+    const char *p = fdt_bootargs();
+    size_t len = strlen(name);
+
+    if (p == NULL) {
+        return 0;
+    }
+    while (*p) {
+        while (*p == ' ') {
+            p++;
+        }
+        if (strncmp(p, name, len) == 0 && (p[len] == '\0' || p[len] == ' ' || p[len] == '=')) {
+            return 1;
+        }
+        while (*p && *p != ' ') {
+            p++;
+        }
+    }
+    return 0;
+}
+
+int boot_fast(void) {
+    if (boot_fast_mode < 0) {
+        boot_fast_mode = boot_param("fastboot");
+    }
+    return boot_fast_mode;
+}
+
+/* 普通启动立即执行fn并计时；fastboot时推迟到主循环开始之后 */
+void boot_defer(void (*fn)(void), const char *name) {
+    if (boot_fast()) {
+        if (boot_deferred_count < BOOT_MAX_DEFERRED) {
+            boot_deferred[boot_deferred_count].fn = fn;
+            boot_deferred[boot_deferred_count].name = name;
+            boot_deferred_count++;
+            return;
+        }
+        pr_warn("延迟初始化表已满 (BOOT_MAX_DEFERRED=%u)，就地执行: %s\n",
+                (unsigned int)BOOT_MAX_DEFERRED, name);
+    }
+    fn();
+    boot_mark(name);
+}
+
+/* 延迟初始化线程：依次执行登记的演示和自检 */
+static void boot_deferred_task(void *arg) {
+    (void)arg;
+    boot_deferred_start = boot_read_cntpct();
+    for (uint32_t i = 0; i < boot_deferred_count; i++) {
+        uint64_t start = boot_read_cntpct();
+        boot_deferred[i].fn();
+        boot_deferred[i].ticks = (uint32_t)(boot_read_cntpct() - start);
+        boot_deferred_done++;
+    }
+    boot_deferred_end = boot_read_cntpct();
+    boot_print_report();
+}
+
+/* 主循环开始前调用：有推迟的项目时创建线程执行 */
+void boot_start_deferred(void) {
+    if (boot_deferred_count == 0) {
+        return;
+    }
+    if (task_create("deferred-init", boot_deferred_task, NULL) == NULL) {
+        /* 无法创建线程时就地执行 */
+        boot_deferred_task(NULL);
+    }
+}
+
+/* 打印启动各阶段耗时 */
+void boot_print_report(void) {
+    uint64_t prev = boot_main_stamp;
+    uint64_t last = boot_stage_count ? boot_stages[boot_stage_count - 1].stamp : boot_main_stamp;
+    uint32_t total = (uint32_t)(last - boot_reset_stamp);
+
+    uart_puts("\r\n=== 启动计时 ===\r\n");
+    uart_puts("模式: ");
+    uart_puts(boot_fast() ? "fastboot (演示和自检推迟执行)" : "普通");
+    uart_puts("\r\n");
+    uart_puts("复位时CNTPCT: ");
+    uart_put_hex((uint32_t)(boot_reset_stamp >> 32));
+    uart_puts(":");
+    uart_put_hex((uint32_t)boot_reset_stamp);
+    uart_puts("\r\n");
+    uart_puts("  复位 -> main (栈/BSS): ");
+    uart_put_dec(boot_ticks_to_us((uint32_t)(boot_main_stamp - boot_reset_stamp)));
+    uart_puts(" us\r\n");
+    for (uint32_t i = 0; i < boot_stage_count; i++) {
+        uint32_t ticks = (uint32_t)(boot_stages[i].stamp - prev);
+        uart_puts("  ");
+        uart_puts(boot_stages[i].name);
+        uart_puts(": ");
+        uart_put_dec(boot_ticks_to_us(ticks));
+        uart_puts(" us");
+        if (total >= 100) {
+            uart_puts(" (");
+            uart_put_dec(ticks / (total / 100));
+            uart_puts("%)");
+        }
+        uart_puts("\r\n");
+        prev = boot_stages[i].stamp;
+    }
+    uart_puts("复位到主循环: ");
+    uart_put_dec(boot_ticks_to_us(total));
+    uart_puts(" us\r\n");
+
+    if (boot_deferred_count) {
+        uart_puts("推迟执行 (");
+        uart_put_dec(boot_deferred_done);
+        uart_puts("/");
+        uart_put_dec(boot_deferred_count);
+        uart_puts("):\r\n");
+        for (uint32_t i = 0; i < boot_deferred_done; i++) {
+            uart_puts("  ");
+            uart_puts(boot_deferred[i].name);
+            uart_puts(": ");
+            uart_put_dec(boot_ticks_to_us(boot_deferred[i].ticks));
+            uart_puts(" us\r\n");
+        }
+        if (boot_deferred_end) {
+            uart_puts("推迟部分总计: ");
+            uart_put_dec(boot_ticks_to_us((uint32_t)(boot_deferred_end - boot_deferred_start)));
+            uart_puts(" us (与主循环交替运行)\r\n");
+        }
+    }
+    uart_puts("================\r\n");
+}
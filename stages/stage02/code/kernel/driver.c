@@ -0,0 +1,248 @@
+/*
+ * SkyOS 平台驱动模型
+ * 文件: kernel/driver.c
+ *
+ * 1. 遍历链接段中的驱动，按compatible在设备树索引中查找节点 (二分查找)
+ * 2. 按"轮"探测：每轮收集依赖已全部就绪的待探测设备，同轮设备互不依赖
+ * 3. 返回DEFER的设备留到下一轮，直到某一轮没有任何进展为止
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "driver.h"
+#include "kstring.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_hex(uint32_t value);
+extern uint64_t timer_get_counter(void);
+
+/* 链接脚本定义的驱动表边界 */
+extern const struct platform_driver __platform_drivers_start[];
+extern const struct platform_driver __platform_drivers_end[];
+
+#define DRIVER_MAX_WAVES    16
+
+static struct platform_device pdevs[DRIVER_MAX_DEVICES];
+static uint32_t pdev_count = 0;
+static uint32_t driver_waves = 0;
+
+/* 统计 */
+static uint32_t stat_drivers = 0;
+static uint32_t stat_deferrals = 0;
+static uint32_t stat_dropped = 0;
+static uint64_t stat_serial_cycles = 0;      /* 所有probe耗时之和 */
+static uint64_t stat_critical_cycles = 0;    /* 每轮最长probe之和 (并行下限) */
+
+/* 节点是否已被某个驱动认领 */
+static int node_claimed(const struct fdt_device *node) {
+    for (uint32_t i = 0; i < pdev_count; i++) {
+        if (pdevs[i].node == node) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* 为每个驱动查找匹配的设备树节点，先注册的驱动优先 */
+static void driver_match_all(void) {
+    static const struct fdt_device *nodes[FDT_MAX_DEVICES];
+
+    for (const struct platform_driver *drv = __platform_drivers_start;
+         drv < __platform_drivers_end; drv++) {
+        stat_drivers++;
+        for (const char *const *compat = drv->match; *compat; compat++) {
+            uint32_t n = fdt_find_all_compatible(*compat, nodes, FDT_MAX_DEVICES);
+
+            for (uint32_t i = 0; i < n; i++) {
+                if (node_claimed(nodes[i])) {
+                    continue;
+                }
+                if (pdev_count >= DRIVER_MAX_DEVICES) {
+                    stat_dropped++;
+                    continue;
+                }
+                struct platform_device *pdev = &pdevs[pdev_count++];
+                memset(pdev, 0, sizeof(*pdev));
+                pdev->node = nodes[i];
+                pdev->driver = drv;
+            }
+        }
+    }
+}
+
+/* 提供者就绪：该驱动至少绑定了一个设备，且没有仍在等待的设备 */
+int driver_provider_ready(const char *name) {
+    uint32_t bound = 0;
+
+    for (uint32_t i = 0; i < pdev_count; i++) {
+        if (strcmp(pdevs[i].driver->name, name) != 0) {
+            continue;
+        }
+        if (pdevs[i].state == DEV_STATE_PENDING) {
+            return 0;
+        }
+        if (pdevs[i].state == DEV_STATE_BOUND) {
+            bound++;
+        }
+    }
+    return bound > 0;
+}
+
+static int driver_deps_ready(const struct platform_driver *drv) {
+    if (drv->depends == NULL) {
+        return 1;
+    }
+    for (const char *const *dep = drv->depends; *dep; dep++) {
+        if (!driver_provider_ready(*dep)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* 探测一个设备，返回状态是否发生变化 */
+static int driver_probe_one(struct platform_device *pdev, uint32_t wave) {
+    uint64_t start = timer_get_counter();
+    int ret = pdev->driver->probe(pdev);
+    uint32_t cycles = (uint32_t)(timer_get_counter() - start);
+
+    pdev->probe_cycles += cycles;
+    stat_serial_cycles += cycles;
+
+    if (ret == -DRIVER_EPROBE_DEFER) {
+        pdev->defer_count++;
+        stat_deferrals++;
+        return 0;
+    }
+    pdev->wave = wave;
+    if (ret == 0) {
+        pdev->state = DEV_STATE_BOUND;
+    } else if (ret == -DRIVER_ENODEV) {
+        pdev->state = DEV_STATE_NODEV;
+    } else {
+        pdev->state = DEV_STATE_FAILED;
+    }
+    return 1;
+}
+
+/*
+ * 执行一轮探测。本轮设备的依赖在轮次开始时就已满足，彼此之间没有顺序约束，
+ * 多核时可以按CPU分派；单核上顺序执行，并记录最长的一个作为并行时的耗时。
+ */
+static int driver_run_wave(struct platform_device **ready, uint32_t n, uint32_t wave) {
+    uint32_t progress = 0;
+    uint32_t longest = 0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t before = ready[i]->probe_cycles;
+
+        progress += driver_probe_one(ready[i], wave);
+        if (ready[i]->probe_cycles - before > longest) {
+            longest = ready[i]->probe_cycles - before;
+        }
+    }
+    stat_critical_cycles += longest;
+    return progress > 0;
+}
+
+/* 匹配并探测所有平台设备 */
+void driver_probe_all(void) {
+    static struct platform_device *ready[DRIVER_MAX_DEVICES];
+
+    driver_match_all();
+
+    for (uint32_t wave = 1; wave <= DRIVER_MAX_WAVES; wave++) {
+        uint32_t n = 0;
+
+        for (uint32_t i = 0; i < pdev_count; i++) {
+            if (pdevs[i].state == DEV_STATE_PENDING && driver_deps_ready(pdevs[i].driver)) {
+                ready[n++] = &pdevs[i];
+            }
+        }
+        if (n == 0) {
+            break;
+        }
+        driver_waves = wave;
+        if (!driver_run_wave(ready, n, wave)) {
+            break;  /* 全部推迟且没有任何进展 */
+        }
+    }
+
+    for (uint32_t i = 0; i < pdev_count; i++) {
+        if (pdevs[i].state == DEV_STATE_PENDING) {
+            uart_puts("驱动 ");
+            uart_puts(pdevs[i].driver->name);
+            uart_puts(": ");
+            uart_puts(pdevs[i].node->name);
+            uart_puts(" 依赖未满足，放弃探测\r\n");
+        }
+    }
+}
+
+/* 打印驱动绑定情况 */
+void driver_print_stats(void) {
+    uint32_t bound = 0, nodev = 0, failed = 0, pending = 0;
+
+    uart_puts("\r\n=== 平台驱动 ===\r\n");
+    for (uint32_t i = 0; i < pdev_count; i++) {
+        struct platform_device *pdev = &pdevs[i];
+
+        switch (pdev->state) {
+        case DEV_STATE_BOUND:
+            bound++;
+            uart_puts("  ");
+            uart_puts(pdev->driver->name);
+            uart_puts(" <- ");
+            uart_puts(pdev->node->name);
+            uart_puts(", 轮次 ");
+            uart_put_hex(pdev->wave);
+            uart_puts(", 推迟 ");
+            uart_put_hex(pdev->defer_count);
+            uart_puts(", 耗时 ");
+            uart_put_hex(pdev->probe_cycles);
+            uart_puts("\r\n");
+            break;
+        case DEV_STATE_NODEV:
+            nodev++;
+            break;
+        case DEV_STATE_FAILED:
+            failed++;
+            uart_puts("  ");
+            uart_puts(pdev->driver->name);
+            uart_puts(" <- ");
+            uart_puts(pdev->node->name);
+            uart_puts(" 探测失败\r\n");
+            break;
+        default:
+            pending++;
+            break;
+        }
+    }
+    uart_puts("驱动: ");
+    uart_put_hex(stat_drivers);
+    uart_puts(", 匹配节点: ");
+    uart_put_hex(pdev_count);
+    uart_puts(", 绑定: ");
+    uart_put_hex(bound);
+    uart_puts(", 无设备: ");
+    uart_put_hex(nodev);
+    uart_puts(", 失败: ");
+    uart_put_hex(failed);
+    uart_puts(", 未满足: ");
+    uart_put_hex(pending);
+    uart_puts("\r\n");
+    uart_puts("探测轮数: ");
+    uart_put_hex(driver_waves);
+    uart_puts(", 推迟次数: ");
+    uart_put_hex(stat_deferrals);
+    uart_puts(", 超出设备表: ");
+    uart_put_hex(stat_dropped);
+    uart_puts("\r\n");
+    uart_puts("探测耗时 串行: ");
+    uart_put_hex((uint32_t)stat_serial_cycles);
+    uart_puts(", 按轮并行: ");
+    uart_put_hex((uint32_t)stat_critical_cycles);
+    uart_puts(" 计数器周期\r\n");
+    uart_puts("================\r\n");
+}
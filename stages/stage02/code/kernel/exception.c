@@ -6,10 +6,20 @@
  */
 
 #include <stdint.h>
+#include <stddef.h>
+#include "fpu.h"
+#include "syscall.h"
+#include "irqflags.h"
+#include "kprintf.h"
+#include "hal.h"
 
 /* 外部函数声明 */
 extern void uart_puts(const char *str);
 extern void uart_put_hex(uint32_t value);
+extern void uart_put_dec(uint32_t value);
+extern int gic_request_irq(uint32_t irq_id, void (*handler)(uint32_t, void *), void *data);
+extern void gic_free_irq(uint32_t irq_id);
+extern void gic_send_sgi(uint32_t sgi_id, uint32_t target_cpu_mask);
 
 /* 异常信息结构 */
 struct exception_frame {
@@ -18,6 +28,13 @@ struct exception_frame {
     uint32_t lr;
 };
 
+/* 读取当前异常模式的SPSR (被打断代码的CPSR) */
+static inline uint32_t read_spsr(void) {
+    uint32_t val;
+    asm volatile("mrs %0, spsr" : "=r"(val));
+    return val;
+}
+
 /* 异常统计计数器 */
 static uint32_t undef_count = 0;
 static uint32_t swi_count = 0;
@@ -26,57 +43,50 @@ static uint32_t data_abort_count = 0;
 static uint32_t irq_count = 0;
 static uint32_t fiq_count = 0;
 
-/* 读取ARM协处理器寄存器的函数 */
-static inline uint32_t read_dfsr(void) {
-    uint32_t val;
-    asm volatile("mrc p15, 0, %0, c5, c0, 0" : "=r"(val));
-    return val;
-}
-
-static inline uint32_t read_far(void) {
-    uint32_t val;
-    asm volatile("mrc p15, 0, %0, c6, c0, 0" : "=r"(val));
-    return val;
-}
-
-static inline uint32_t read_ifsr(void) {
-    uint32_t val;
-    asm volatile("mrc p15, 0, %0, c5, c0, 1" : "=r"(val));
-    return val;
-}
-
-static inline uint32_t read_ifar(void) {
-    uint32_t val;
-    asm volatile("mrc p15, 0, %0, c6, c0, 2" : "=r"(val));
-    return val;
-}
-
 /* 未定义指令异常处理 */
 void handle_undefined_instruction(struct exception_frame *frame) {
+    /* FPEXC.EN关闭时的VFP/NEON指令：惰性切换FP状态后返回重新执行 */
+    if (fpu_trap(&frame->lr, read_spsr())) {
+        return;
+    }
     undef_count++;
     
-    uart_puts("\r\n*** UNDEFINED INSTRUCTION EXCEPTION ***\r\n");
-    uart_puts("Exception count: ");
-    uart_put_hex(undef_count);
-    uart_puts("\r\n");
+    /* 先输出日志环中尚未输出的记录，之后的kprintf都同步输出 */
+    klog_panic();
+    kprintf(KERN_EMERG "\n*** UNDEFINED INSTRUCTION EXCEPTION ***\n");
+    kprintf(KERN_EMERG "Exception count: 0x%08X\n", (unsigned int)undef_count);
     
-    uart_puts("Registers at exception:\r\n");
-    uart_puts("  R0 = "); uart_put_hex(frame->r0); uart_puts("\r\n");
-    uart_puts("  R1 = "); uart_put_hex(frame->r1); uart_puts("\r\n");
-    uart_puts("  R2 = "); uart_put_hex(frame->r2); uart_puts("\r\n");
-    uart_puts("  R3 = "); uart_put_hex(frame->r3); uart_puts("\r\n");
-    uart_puts("  PC = "); uart_put_hex(frame->lr); uart_puts("\r\n");
+    kprintf(KERN_EMERG "Registers at exception:\n");
+    kprintf(KERN_EMERG "  R0 = 0x%08X\n", (unsigned int)frame->r0);
+    kprintf(KERN_EMERG "  R1 = 0x%08X\n", (unsigned int)frame->r1);
+    kprintf(KERN_EMERG "  R2 = 0x%08X\n", (unsigned int)frame->r2);
+    kprintf(KERN_EMERG "  R3 = 0x%08X\n", (unsigned int)frame->r3);
+    kprintf(KERN_EMERG "  PC = 0x%08X\n", (unsigned int)frame->lr);
     
     /* 读取指令故障状态寄存器 */
-    uint32_t ifsr = read_ifsr();
-    uart_puts("  IFSR = "); uart_put_hex(ifsr); uart_puts("\r\n");
+    kprintf(KERN_EMERG "  IFSR = 0x%08X\n", (unsigned int)read_ifsr());
     
-    uart_puts("System halted due to undefined instruction.\r\n");
-    uart_puts("******************************************\r\n");
+    kprintf(KERN_EMERG "System halted due to undefined instruction.\n");
+    kprintf(KERN_EMERG "******************************************\n");
     
     /* 停止系统 */
     while(1) {
-        asm volatile("wfi");
+        cpu_wfi();
+    }
+}
+
+/* DFSR[3:0]对应的故障类型 */
+static const char *data_fault_name(uint32_t fault_status) {
+    switch (fault_status) {
+        case 0x1: return "Alignment fault";
+        case 0x3: return "Access flag fault";
+        case 0x5: return "Translation fault (section)";
+        case 0x7: return "Translation fault (page)";
+        case 0x9: return "Domain fault (section)";
+        case 0xB: return "Domain fault (page)";
+        case 0xD: return "Permission fault (section)";
+        case 0xF: return "Permission fault (page)";
+        default:  return NULL;
     }
 }
 
@@ -88,63 +98,35 @@ void handle_data_abort(struct exception_frame *frame) {
     uint32_t far = read_far();    /* Fault Address Register */
     uint32_t dfsr = read_dfsr();   /* Data Fault Status Register */
     
-    uart_puts("\r\n*** DATA ABORT EXCEPTION ***\r\n");
-    uart_puts("Exception count: ");
-    uart_put_hex(data_abort_count);
-    uart_puts("\r\n");
+    klog_panic();
+    kprintf(KERN_EMERG "\n*** DATA ABORT EXCEPTION ***\n");
+    kprintf(KERN_EMERG "Exception count: 0x%08X\n", (unsigned int)data_abort_count);
     
-    uart_puts("Fault information:\r\n");
-    uart_puts("  Fault Address (FAR): "); uart_put_hex(far); uart_puts("\r\n");
-    uart_puts("  Data Fault Status (DFSR): "); uart_put_hex(dfsr); uart_puts("\r\n");
-    uart_puts("  PC at fault: "); uart_put_hex(frame->lr); uart_puts("\r\n");
+    kprintf(KERN_EMERG "Fault information:\n");
+    kprintf(KERN_EMERG "  Fault Address (FAR): 0x%08X\n", (unsigned int)far);
+    kprintf(KERN_EMERG "  Data Fault Status (DFSR): 0x%08X\n", (unsigned int)dfsr);
+    kprintf(KERN_EMERG "  PC at fault: 0x%08X\n", (unsigned int)frame->lr);
     
     /* 解析故障状态 */
     uint32_t fault_status = dfsr & 0xF;
-    uart_puts("  Fault type: ");
-    switch (fault_status) {
-        case 0x1:
-            uart_puts("Alignment fault");
-            break;
-        case 0x3:
-            uart_puts("Access flag fault");
-            break;
-        case 0x5:
-            uart_puts("Translation fault (section)");
-            break;
-        case 0x7:
-            uart_puts("Translation fault (page)");
-            break;
-        case 0x9:
-            uart_puts("Domain fault (section)");
-            break;
-        case 0xB:
-            uart_puts("Domain fault (page)");
-            break;
-        case 0xD:
-            uart_puts("Permission fault (section)");
-            break;
-        case 0xF:
-            uart_puts("Permission fault (page)");
-            break;
-        default:
-            uart_puts("Unknown fault (");
-            uart_put_hex(fault_status);
-            uart_puts(")");
-            break;
+    const char *fault_name = data_fault_name(fault_status);
+    if (fault_name) {
+        kprintf(KERN_EMERG "  Fault type: %s\n", fault_name);
+    } else {
+        kprintf(KERN_EMERG "  Fault type: Unknown fault (0x%08X)\n", (unsigned int)fault_status);
     }
-    uart_puts("\r\n");
     
-    uart_puts("Registers at exception:\r\n");
-    uart_puts("  R0 = "); uart_put_hex(frame->r0); uart_puts("\r\n");
-    uart_puts("  R1 = "); uart_put_hex(frame->r1); uart_puts("\r\n");
-    uart_puts("  R2 = "); uart_put_hex(frame->r2); uart_puts("\r\n");
+    kprintf(KERN_EMERG "Registers at exception:\n");
+    kprintf(KERN_EMERG "  R0 = 0x%08X\n", (unsigned int)frame->r0);
+    kprintf(KERN_EMERG "  R1 = 0x%08X\n", (unsigned int)frame->r1);
+    kprintf(KERN_EMERG "  R2 = 0x%08X\n", (unsigned int)frame->r2);
     
-    uart_puts("System halted due to data abort.\r\n");
-    uart_puts("********************************\r\n");
+    kprintf(KERN_EMERG "System halted due to data abort.\n");
+    kprintf(KERN_EMERG "********************************\n");
     
     /* 停止系统 */
     while(1) {
-        asm volatile("wfi");
+        cpu_wfi();
     }
 }
 
@@ -156,22 +138,21 @@ void handle_prefetch_abort(struct exception_frame *frame) {
     uint32_t ifsr = read_ifsr();   /* Instruction Fault Status Register */
     uint32_t ifar = read_ifar();   /* Instruction Fault Address Register */
     
-    uart_puts("\r\n*** PREFETCH ABORT EXCEPTION ***\r\n");
-    uart_puts("Exception count: ");
-    uart_put_hex(prefetch_abort_count);
-    uart_puts("\r\n");
+    klog_panic();
+    kprintf(KERN_EMERG "\n*** PREFETCH ABORT EXCEPTION ***\n");
+    kprintf(KERN_EMERG "Exception count: 0x%08X\n", (unsigned int)prefetch_abort_count);
     
-    uart_puts("Fault information:\r\n");
-    uart_puts("  Instruction Fault Address (IFAR): "); uart_put_hex(ifar); uart_puts("\r\n");
-    uart_puts("  Instruction Fault Status (IFSR): "); uart_put_hex(ifsr); uart_puts("\r\n");
-    uart_puts("  PC at fault: "); uart_put_hex(frame->lr); uart_puts("\r\n");
+    kprintf(KERN_EMERG "Fault information:\n");
+    kprintf(KERN_EMERG "  Instruction Fault Address (IFAR): 0x%08X\n", (unsigned int)ifar);
+    kprintf(KERN_EMERG "  Instruction Fault Status (IFSR): 0x%08X\n", (unsigned int)ifsr);
+    kprintf(KERN_EMERG "  PC at fault: 0x%08X\n", (unsigned int)frame->lr);
     
-    uart_puts("System halted due to prefetch abort.\r\n");
-    uart_puts("************************************\r\n");
+    kprintf(KERN_EMERG "System halted due to prefetch abort.\n");
+    kprintf(KERN_EMERG "************************************\n");
     
     /* 停止系统 */
     while(1) {
-        asm volatile("wfi");
+        cpu_wfi();
     }
 }
 
@@ -179,9 +160,7 @@ void handle_prefetch_abort(struct exception_frame *frame) {
 void handle_fiq(void) {
     fiq_count++;
     
-    uart_puts("FIQ #");
-    uart_put_hex(fiq_count);
-    uart_puts(" received\r\n");
+    kprintf("FIQ #0x%08X received\n", (unsigned int)fiq_count);
     
     /* FIQ通常用于高优先级、低延迟的中断处理 */
     /* 这里暂时只做简单的计数和打印 */
@@ -219,4 +198,95 @@ void test_exceptions(void) {
     uart_puts("Exception tests are commented out to prevent system halt.\r\n");
     uart_puts("Uncomment in exception.c to test actual exceptions.\r\n");
     uart_puts("===================================\r\n");
-} 
\ No newline at end of file
+}
+
+/*
+ * 向量表延迟对比：分别在当前向量表和旧式向量表 (_vectors_legacy，文字池跳转 +
+ * 完整保存r0-r12) 下测量空系统调用和自发SGI的往返周期数 (PMCCNTR)
+ */
+#define VEC_BENCH_SGI       4
+#define VEC_BENCH_LOOPS     256
+
+extern char _vectors[];
+extern char _vectors_legacy[];
+
+static volatile uint32_t vec_sgi_seen = 0;
+
+static inline void write_vbar(const void *base) {
+    asm volatile("mcr p15, 0, %0, c12, c0, 0\n"
+                 "isb" : : "r"(base) : "memory");
+}
+
+static inline uint32_t read_cycles(void) {
+    uint32_t val;
+    asm volatile("isb\n"
+                 "mrc p15, 0, %0, c9, c13, 0" : "=r"(val) : : "memory");
+    return val;
+}
+
+static void vec_sgi_handler(uint32_t irq_id, void *data) {
+    (void)irq_id;
+    (void)data;
+    vec_sgi_seen = 1;
+}
+
+/* 在base向量表下测量，返回平均周期数 */
+static void vec_measure(const void *base, uint32_t *svc_cycles, uint32_t *irq_cycles) {
+    uint32_t start, svc = 0, irq = 0;
+
+    write_vbar(base);
+    for (uint32_t i = 0; i < VEC_BENCH_LOOPS; i++) {
+        start = read_cycles();
+        syscall0(SYS_GETTIME);
+        svc += read_cycles() - start;
+    }
+    for (uint32_t i = 0; i < VEC_BENCH_LOOPS; i++) {
+        vec_sgi_seen = 0;
+        start = read_cycles();
+        gic_send_sgi(VEC_BENCH_SGI, 1u << cpu_id());
+        while (!vec_sgi_seen) {
+        }
+        irq += read_cycles() - start;
+    }
+    write_vbar(_vectors);
+    *svc_cycles = svc / VEC_BENCH_LOOPS;
+    *irq_cycles = irq / VEC_BENCH_LOOPS;
+}
+
+static void vec_print_result(const char *what, uint32_t old, uint32_t new) {
+    uart_puts(what);
+    uart_put_dec(old);
+    uart_puts(" -> ");
+    uart_put_dec(new);
+    uart_puts(" 周期");
+    if (new < old) {
+        uart_puts(", 减少 ");
+        uart_put_dec((old - new) * 100 / old);
+        uart_puts("%");
+    }
+    uart_puts("\r\n");
+}
+
+void test_vectors(void) {
+    uint32_t svc_old, irq_old, svc_new, irq_new;
+
+    uart_puts("\r\n=== 异常向量延迟对比 ===\r\n");
+    uart_puts("向量表: ");
+    uart_put_hex((uint32_t)_vectors);
+    uart_puts(((uint32_t)_vectors & 63) ? " (未按缓存行对齐)" : " (64字节对齐)");
+    uart_puts("\r\n");
+    if (irqs_disabled() || gic_request_irq(VEC_BENCH_SGI, vec_sgi_handler, NULL) != 0) {
+        uart_puts("IRQ未打开或SGI已占用，跳过\r\n");
+        return;
+    }
+    /* 先各跑一遍预热缓存 */
+    vec_measure(_vectors_legacy, &svc_old, &irq_old);
+    vec_measure(_vectors, &svc_new, &irq_new);
+    vec_measure(_vectors_legacy, &svc_old, &irq_old);
+    vec_measure(_vectors, &svc_new, &irq_new);
+    gic_free_irq(VEC_BENCH_SGI);
+
+    vec_print_result("空系统调用往返: ", svc_old, svc_new);
+    vec_print_result("SGI中断往返:    ", irq_old, irq_new);
+    uart_puts("========================\r\n");
+}
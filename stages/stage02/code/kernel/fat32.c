@@ -0,0 +1,686 @@
+/*
+ * SkyOS FAT32文件系统 (只读)
+ * 文件: kernel/fat32.c
+ *
+ * 功能：
+ * - 识别MBR分区 (类型0x0B/0x0C) 或无分区表的整盘FAT32
+ * - 簇链缓存：打开文件时一次遍历FAT，把簇链压缩成extent列表，
+ *   之后的偏移->扇区映射是对extent的二分查找，不再逐簇读FAT
+ * - 连续读：对齐的整扇区部分按extent合并成大块请求直接读入用户缓冲区，
+ *   一批提交；不对齐的头尾扇区以及目录/FAT经由缓冲区缓存
+ * - 长文件名 (LFN) 与8.3短名，查找不区分大小写
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "vfs.h"
+#include "bcache.h"
+#include "blkdev.h"
+#include "kstring.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_hex(uint32_t value);
+
+#define FAT_MAX_EXTENTS     32      /* 每个inode缓存的extent数 */
+#define FAT_MAX_REQ_SECTORS 128     /* 单个直读请求的最大扇区数 (64KB) */
+#define FAT_MAX_BATCH       8       /* 一批提交的直读请求数 */
+
+#define FAT_EOC             0x0FFFFFF8
+#define FAT_CLUSTER_MASK    0x0FFFFFFF
+
+#define FAT_ATTR_READ_ONLY  0x01
+#define FAT_ATTR_HIDDEN     0x02
+#define FAT_ATTR_SYSTEM     0x04
+#define FAT_ATTR_VOLUME_ID  0x08
+#define FAT_ATTR_DIRECTORY  0x10
+#define FAT_ATTR_LFN        0x0F
+
+#define FAT_DIRENT_SIZE     32
+#define FAT_LFN_MAX         255
+
+struct fat_fs {
+    struct blk_device *dev;
+    uint32_t part_lba;
+    uint32_t sec_per_clus;
+    uint32_t clus_shift;            /* log2(sec_per_clus) */
+    uint32_t fat_start;             /* FAT起始LBA (绝对) */
+    uint32_t data_start;            /* 数据区起始LBA (绝对) */
+    uint32_t total_clusters;
+    uint32_t root_clus;
+
+    /* 统计 */
+    uint32_t stat_fat_reads;        /* 读取FAT表项次数 */
+    uint32_t stat_extent_builds;
+    uint32_t stat_slow_walks;       /* extent不足时的慢速遍历 */
+    uint32_t stat_direct_reqs;      /* 直读大块请求数 */
+    uint32_t stat_direct_sectors;
+    uint32_t stat_cached_sectors;   /* 经缓冲区缓存读取的扇区数 */
+};
+
+/* 一段物理连续的簇 */
+struct fat_extent {
+    uint32_t fclus;                 /* 文件内簇号 */
+    uint32_t dclus;                 /* 磁盘簇号 */
+    uint32_t count;
+};
+
+struct fat_inode {
+    uint32_t used;
+    uint32_t first_clus;
+    uint32_t nr_extents;
+    uint32_t complete;              /* 整条簇链都在extent中 */
+    struct fat_extent ext[FAT_MAX_EXTENTS];
+};
+
+/* 目录项解析结果 */
+struct fat_entry {
+    char name[VFS_NAME_MAX];
+    uint32_t attr;
+    uint32_t cluster;
+    uint32_t size;
+};
+
+static struct fat_fs fat_fs_pool[VFS_MAX_MOUNTS];
+static uint32_t fat_fs_count = 0;
+static struct fat_inode fat_inodes[VFS_MAX_INODES];
+static uint8_t fat_sector[BLK_SECTOR_SIZE] __attribute__((aligned(4)));
+
+static const struct inode_ops fat_dir_iops;
+static const struct file_ops fat_dir_fops;
+static const struct file_ops fat_file_fops;
+
+static inline uint16_t fat_le16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t fat_le32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint32_t fat_clus_to_lba(struct fat_fs *fs, uint32_t clus) {
+    return fs->data_start + ((clus - 2) << fs->clus_shift);
+}
+
+static inline int fat_valid_cluster(struct fat_fs *fs, uint32_t clus) {
+    return clus >= 2 && clus < fs->total_clusters + 2;
+}
+
+/* 读取一个FAT表项 (经由缓冲区缓存) */
+static uint32_t fat_next_cluster(struct fat_fs *fs, uint32_t clus) {
+    uint32_t offset = clus * 4;
+    struct buf *b = bread(fs->dev, fs->fat_start + offset / BLK_SECTOR_SIZE);
+    uint32_t next;
+
+    fs->stat_fat_reads++;
+    if (b == NULL) {
+        return FAT_EOC;
+    }
+    next = fat_le32(b->data + offset % BLK_SECTOR_SIZE) & FAT_CLUSTER_MASK;
+    brelse(b);
+    return next;
+}
+
+/* ---------------- 簇链 -> extent ---------------- */
+
+static struct fat_inode *fat_inode_alloc(uint32_t first_clus) {
+    for (uint32_t i = 0; i < VFS_MAX_INODES; i++) {
+        if (!fat_inodes[i].used) {
+            struct fat_inode *fi = &fat_inodes[i];
+            fi->used = 1;
+            fi->first_clus = first_clus;
+            fi->nr_extents = 0;
+            fi->complete = 0;
+            return fi;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * 遍历整条簇链，把连续簇合并成extent。
+ * 链长超过卷上的簇数说明FAT损坏 (链成环)，返回-VFS_EIO
+ */
+static int fat_build_extents(struct fat_fs *fs, struct fat_inode *fi) {
+    uint32_t clus = fi->first_clus;
+    uint32_t fclus = 0;
+
+    fi->nr_extents = 0;
+    fi->complete = 0;
+    fs->stat_extent_builds++;
+
+    while (fat_valid_cluster(fs, clus)) {
+        struct fat_extent *e = fi->nr_extents ? &fi->ext[fi->nr_extents - 1] : NULL;
+
+        if (fclus >= fs->total_clusters) {
+            fi->nr_extents = 0;
+            return -VFS_EIO;
+        }
+        if (e && e->dclus + e->count == clus) {
+            e->count++;
+        } else {
+            if (fi->nr_extents == FAT_MAX_EXTENTS) {
+                return 0;       /* 链太碎，剩余部分走慢速路径 */
+            }
+            e = &fi->ext[fi->nr_extents++];
+            e->fclus = fclus;
+            e->dclus = clus;
+            e->count = 1;
+        }
+        fclus++;
+        clus = fat_next_cluster(fs, clus);
+    }
+    fi->complete = 1;
+    return 0;
+}
+
+/*
+ * 把文件内簇号映射到磁盘簇号，*run返回从该簇起物理连续的簇数。
+ * 失败返回0。
+ */
+static uint32_t fat_bmap(struct fat_fs *fs, struct fat_inode *fi, uint32_t fclus, uint32_t *run) {
+    uint32_t lo = 0, hi = fi->nr_extents;
+
+    /* 二分查找包含fclus的extent */
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        struct fat_extent *e = &fi->ext[mid];
+        if (fclus < e->fclus) {
+            hi = mid;
+        } else if (fclus >= e->fclus + e->count) {
+            lo = mid + 1;
+        } else {
+            *run = e->count - (fclus - e->fclus);
+            return e->dclus + (fclus - e->fclus);
+        }
+    }
+    if (fi->complete || fi->nr_extents == 0 || fclus >= fs->total_clusters) {
+        return 0;       /* 超过卷上簇数的位置只可能来自成环的链 */
+    }
+
+    /* 慢速路径：从最后一个extent末尾继续沿FAT走 */
+    struct fat_extent *last = &fi->ext[fi->nr_extents - 1];
+    uint32_t cur = last->fclus + last->count - 1;
+    uint32_t clus = last->dclus + last->count - 1;
+
+    fs->stat_slow_walks++;
+    while (cur < fclus) {
+        clus = fat_next_cluster(fs, clus);
+        if (!fat_valid_cluster(fs, clus)) {
+            return 0;
+        }
+        cur++;
+    }
+    *run = 1;
+    return clus;
+}
+
+/* 把文件内扇区号映射到LBA，*run返回从该扇区起连续的扇区数 */
+static uint32_t fat_sector_map(struct fat_fs *fs, struct fat_inode *fi, uint32_t fsec, uint32_t *run) {
+    uint32_t crun;
+    uint32_t off = fsec & (fs->sec_per_clus - 1);
+    uint32_t dclus = fat_bmap(fs, fi, fsec >> fs->clus_shift, &crun);
+
+    if (dclus == 0) {
+        return 0;
+    }
+    *run = (crun << fs->clus_shift) - off;
+    return fat_clus_to_lba(fs, dclus) + off;
+}
+
+/* ---------------- 目录 ---------------- */
+
+static uint8_t fat_lfn_checksum(const uint8_t *short_name) {
+    uint8_t sum = 0;
+    for (int i = 0; i < 11; i++) {
+        sum = ((sum & 1) << 7) + (sum >> 1) + short_name[i];
+    }
+    return sum;
+}
+
+/* 8.3短名转为 "NAME.EXT"，按NT保留字节中的标志转小写 */
+static void fat_short_name(const uint8_t *de, char *out) {
+    uint8_t case_flags = de[12];
+    int n = 0;
+
+    for (int i = 0; i < 8 && de[i] != ' '; i++) {
+        char c = (i == 0 && de[0] == 0x05) ? (char)0xE5 : (char)de[i];
+        if ((case_flags & 0x08) && c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        out[n++] = c;
+    }
+    if (de[8] != ' ') {
+        out[n++] = '.';
+        for (int i = 8; i < 11 && de[i] != ' '; i++) {
+            char c = de[i];
+            if ((case_flags & 0x10) && c >= 'A' && c <= 'Z') c += 'a' - 'A';
+            out[n++] = c;
+        }
+    }
+    out[n] = '\0';
+}
+
+/* 从LFN项中取出13个UCS-2字符 (只保留ASCII，其余替换为'?') */
+static void fat_lfn_collect(const uint8_t *de, char *lfn) {
+    static const uint8_t offs[13] = { 1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30 };
+    uint32_t base = ((de[0] & 0x1F) - 1) * 13;
+
+    for (int i = 0; i < 13; i++) {
+        uint16_t ch = fat_le16(de + offs[i]);
+        if (base + i >= FAT_LFN_MAX) {
+            break;
+        }
+        if (ch == 0x0000 || ch == 0xFFFF) {
+            lfn[base + i] = '\0';
+            break;
+        }
+        lfn[base + i] = ch < 0x80 ? (char)ch : '?';
+    }
+}
+
+/*
+ * 读取目录中从*index开始的下一个有效项 (跳过已删除、卷标、"."和"..")。
+ * 返回1表示找到，0表示目录结束，负值表示错误。*index更新为下一项。
+ */
+static int fat_dir_next(struct fat_fs *fs, struct fat_inode *dir, uint32_t *index,
+                        struct fat_entry *ent) {
+    char lfn[FAT_LFN_MAX + 1];
+    int lfn_valid = 0;
+    uint8_t lfn_sum = 0;
+    const uint32_t per_sector = BLK_SECTOR_SIZE / FAT_DIRENT_SIZE;
+
+    for (;;) {
+        uint32_t run;
+        uint32_t lba = fat_sector_map(fs, dir, *index / per_sector, &run);
+        if (lba == 0) {
+            return 0;
+        }
+
+        struct buf *b = bread(fs->dev, lba);
+        if (b == NULL) {
+            return -VFS_EIO;
+        }
+        fs->stat_cached_sectors++;
+
+        for (uint32_t i = *index % per_sector; i < per_sector; i++) {
+            const uint8_t *de = b->data + i * FAT_DIRENT_SIZE;
+            uint8_t attr = de[11];
+
+            (*index)++;
+            if (de[0] == 0x00) {
+                brelse(b);
+                (*index)--;         /* 保持在结束位置 */
+                return 0;
+            }
+            if (de[0] == 0xE5) {
+                lfn_valid = 0;
+                continue;
+            }
+            if ((attr & 0x3F) == FAT_ATTR_LFN) {
+                if (de[0] & 0x40) {
+                    memset(lfn, 0, sizeof(lfn));
+                    lfn_valid = 1;
+                    lfn_sum = de[13];
+                } else if (de[13] != lfn_sum) {
+                    lfn_valid = 0;
+                }
+                if (lfn_valid) {
+                    fat_lfn_collect(de, lfn);
+                }
+                continue;
+            }
+            if (attr & FAT_ATTR_VOLUME_ID) {
+                lfn_valid = 0;
+                continue;
+            }
+            if (de[0] == '.' && (de[1] == ' ' || (de[1] == '.' && de[2] == ' '))) {
+                lfn_valid = 0;
+                continue;
+            }
+
+            if (lfn_valid && lfn_sum == fat_lfn_checksum(de) && lfn[0]) {
+                uint32_t n = 0;
+                while (lfn[n] && n < VFS_NAME_MAX - 1) {
+                    ent->name[n] = lfn[n];
+                    n++;
+                }
+                ent->name[n] = '\0';
+            } else {
+                fat_short_name(de, ent->name);
+            }
+            ent->attr = attr;
+            ent->cluster = ((uint32_t)fat_le16(de + 20) << 16) | fat_le16(de + 26);
+            ent->size = fat_le32(de + 28);
+            brelse(b);
+            return 1;
+        }
+        brelse(b);
+    }
+}
+
+static int fat_name_match(const char *a, const char *b, uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) {
+        char x = a[i], y = b[i];
+        if (x >= 'a' && x <= 'z') x -= 'a' - 'A';
+        if (y >= 'a' && y <= 'z') y -= 'a' - 'A';
+        if (x != y || y == '\0') {
+            return 0;
+        }
+    }
+    return b[len] == '\0';
+}
+
+/* 为目录项建立inode，并预先构建extent列表 */
+static struct inode *fat_make_inode(struct super_block *sb, uint32_t cluster,
+                                    uint32_t attr, uint32_t size) {
+    struct fat_fs *fs = sb->fs_info;
+    int is_dir = (attr & FAT_ATTR_DIRECTORY) != 0;
+    struct fat_inode *fi = fat_inode_alloc(cluster);
+    if (fi == NULL) {
+        return NULL;
+    }
+
+    struct inode *inode = vfs_alloc_inode(sb, cluster, is_dir ? VFS_IFDIR : VFS_IFREG);
+    if (inode == NULL) {
+        fi->used = 0;
+        return NULL;
+    }
+    inode->size = is_dir ? 0 : size;
+    inode->i_op = is_dir ? &fat_dir_iops : NULL;
+    inode->f_op = is_dir ? &fat_dir_fops : &fat_file_fops;
+    inode->private_data = fi;
+
+    if (fat_valid_cluster(fs, cluster)) {
+        if (fat_build_extents(fs, fi) < 0) {
+            vfs_iput(inode);    /* evict_inode释放fi */
+            return NULL;
+        }
+    } else {
+        fi->complete = 1;       /* 空文件 */
+    }
+    return inode;
+}
+
+static struct inode *fat_lookup(struct inode *dir, const char *name, uint32_t len) {
+    struct fat_fs *fs = dir->sb->fs_info;
+    struct fat_inode *fi = dir->private_data;
+    struct fat_entry ent;
+    uint32_t index = 0;
+
+    while (fat_dir_next(fs, fi, &index, &ent) > 0) {
+        if (fat_name_match(name, ent.name, len)) {
+            return fat_make_inode(dir->sb, ent.cluster, ent.attr, ent.size);
+        }
+    }
+    return NULL;
+}
+
+static int fat_readdir(struct file *file, struct vfs_dirent *dirent) {
+    struct fat_fs *fs = file->inode->sb->fs_info;
+    struct fat_entry ent;
+    int ret = fat_dir_next(fs, file->inode->private_data, &file->pos, &ent);
+
+    if (ret <= 0) {
+        return ret;
+    }
+    memcpy(dirent->name, ent.name, VFS_NAME_MAX);
+    dirent->type = (ent.attr & FAT_ATTR_DIRECTORY) ? VFS_IFDIR : VFS_IFREG;
+    dirent->size = ent.size;
+    return 1;
+}
+
+/* ---------------- 文件读取 ---------------- */
+
+/* 经缓冲区缓存读取一个扇区中的部分数据 */
+static int fat_read_partial(struct fat_fs *fs, uint32_t lba, uint32_t off, uint8_t *dst, uint32_t len) {
+    struct buf *b = bread(fs->dev, lba);
+    if (b == NULL) {
+        return -VFS_EIO;
+    }
+    memcpy(dst, b->data + off, len);
+    brelse(b);
+    fs->stat_cached_sectors++;
+    return 0;
+}
+
+/* 一批提交直读请求并等待完成 */
+static int fat_submit_batch(struct fat_fs *fs, struct blk_request *reqs, uint32_t count) {
+    struct blk_request *batch[FAT_MAX_BATCH];
+    uint32_t done = 0;
+    int ret = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        batch[i] = &reqs[i];
+    }
+    /* 队列满时submit可能只接收一部分，等待已提交的请求腾出描述符后再提交 */
+    while (done < count) {
+        uint32_t queued = blk_submit(fs->dev, batch + done, count - done);
+        if (queued == 0) {
+            if (done == 0 || batch[done - 1]->done) {
+                ret = -VFS_EIO;
+                break;
+            }
+            blk_wait(fs->dev, batch[done - 1]);
+        }
+        done += queued;
+    }
+    for (uint32_t i = 0; i < done; i++) {
+        blk_wait(fs->dev, batch[i]);
+        if (batch[i]->status != BLK_STATUS_OK) {
+            ret = -VFS_EIO;
+        }
+    }
+    fs->stat_direct_reqs += done;
+    return ret;
+}
+
+static int fat_file_read(struct file *file, void *buf, uint32_t count) {
+    struct inode *inode = file->inode;
+    struct fat_fs *fs = inode->sb->fs_info;
+    struct fat_inode *fi = inode->private_data;
+    struct blk_request reqs[FAT_MAX_BATCH];
+    uint32_t nreq = 0;
+    uint8_t *dst = buf;
+    uint32_t total;
+    int ret = 0;
+
+    if (file->pos >= inode->size) {
+        return 0;
+    }
+    if (count > inode->size - file->pos) {
+        count = inode->size - file->pos;
+    }
+    total = count;
+
+    while (count > 0) {
+        uint32_t fsec = file->pos / BLK_SECTOR_SIZE;
+        uint32_t off = file->pos % BLK_SECTOR_SIZE;
+        uint32_t run;
+        uint32_t lba = fat_sector_map(fs, fi, fsec, &run);
+        uint32_t len;
+
+        if (lba == 0) {
+            ret = -VFS_EIO;
+            break;
+        }
+
+        if (off != 0 || count < BLK_SECTOR_SIZE) {
+            /* 不对齐的头/尾：经由缓存 */
+            len = BLK_SECTOR_SIZE - off;
+            if (len > count) len = count;
+            ret = fat_read_partial(fs, lba, off, dst, len);
+            if (ret < 0) break;
+        } else {
+            /* 对齐的整扇区：按extent合并成一个大请求直接读入目标缓冲区 */
+            uint32_t nsec = count / BLK_SECTOR_SIZE;
+            if (nsec > run) nsec = run;
+            if (nsec > FAT_MAX_REQ_SECTORS) nsec = FAT_MAX_REQ_SECTORS;
+            len = nsec * BLK_SECTOR_SIZE;
+
+            blk_init_request(&reqs[nreq++], BLK_REQ_READ, lba, dst, len);
+            fs->stat_direct_sectors += nsec;
+            if (nreq == FAT_MAX_BATCH) {
+                ret = fat_submit_batch(fs, reqs, nreq);
+                nreq = 0;
+                if (ret < 0) break;
+            }
+        }
+
+        dst += len;
+        file->pos += len;
+        count -= len;
+    }
+
+    if (nreq) {
+        int r = fat_submit_batch(fs, reqs, nreq);
+        if (ret == 0) ret = r;
+    }
+    if (ret < 0) {
+        return ret;
+    }
+    return (int)total;
+}
+
+static void fat_evict_inode(struct inode *inode) {
+    struct fat_inode *fi = inode->private_data;
+    if (fi) {
+        fi->used = 0;
+        inode->private_data = NULL;
+    }
+}
+
+static const struct inode_ops fat_dir_iops = {
+    .lookup = fat_lookup,
+};
+
+static const struct file_ops fat_dir_fops = {
+    .readdir = fat_readdir,
+};
+
+static const struct file_ops fat_file_fops = {
+    .read = fat_file_read,
+};
+
+static const struct super_ops fat_sops = {
+    .evict_inode = fat_evict_inode,
+};
+
+/* ---------------- 挂载 ---------------- */
+
+static int fat_is_fat32_bpb(const uint8_t *s) {
+    return s[510] == 0x55 && s[511] == 0xAA &&
+           fat_le16(s + 11) == BLK_SECTOR_SIZE &&
+           fat_le16(s + 17) == 0 &&                 /* FAT32根目录项数为0 */
+           memcmp(s + 82, "FAT32   ", 8) == 0;
+}
+
+static int fat_mount(struct super_block *sb, struct blk_device *dev) {
+    struct fat_fs *fs;
+    uint32_t part_lba = 0;
+
+    if (dev == NULL) {
+        return -VFS_ENOENT;
+    }
+    if (fat_fs_count >= VFS_MAX_MOUNTS) {
+        return -VFS_ENOMEM;
+    }
+    if (blk_read(dev, 0, fat_sector, 1) < 0) {
+        return -VFS_EIO;
+    }
+
+    /* 没有直接的BPB时查找MBR中的FAT32分区 */
+    if (!fat_is_fat32_bpb(fat_sector)) {
+        if (fat_sector[510] != 0x55 || fat_sector[511] != 0xAA) {
+            return -VFS_EINVAL;
+        }
+        for (int i = 0; i < 4; i++) {
+            const uint8_t *pe = fat_sector + 446 + i * 16;
+            if (pe[4] == 0x0B || pe[4] == 0x0C) {
+                part_lba = fat_le32(pe + 8);
+                break;
+            }
+        }
+        if (part_lba == 0 || blk_read(dev, part_lba, fat_sector, 1) < 0 ||
+            !fat_is_fat32_bpb(fat_sector)) {
+            return -VFS_EINVAL;
+        }
+    }
+
+    uint32_t sec_per_clus = fat_sector[13];
+    uint32_t reserved = fat_le16(fat_sector + 14);
+    uint32_t nfats = fat_sector[16];
+    uint32_t total_sec = fat_le32(fat_sector + 32);
+    uint32_t fat_sz = fat_le32(fat_sector + 36);
+    uint32_t root_clus = fat_le32(fat_sector + 44);
+
+    if (sec_per_clus == 0 || (sec_per_clus & (sec_per_clus - 1)) || fat_sz == 0) {
+        return -VFS_EINVAL;
+    }
+
+    fs = &fat_fs_pool[fat_fs_count++];
+    memset(fs, 0, sizeof(*fs));
+    fs->dev = dev;
+    fs->part_lba = part_lba;
+    fs->sec_per_clus = sec_per_clus;
+    while ((1u << fs->clus_shift) < sec_per_clus) {
+        fs->clus_shift++;
+    }
+    fs->fat_start = part_lba + reserved;
+    fs->data_start = fs->fat_start + nfats * fat_sz;
+    fs->total_clusters = (total_sec - (reserved + nfats * fat_sz)) >> fs->clus_shift;
+    fs->root_clus = root_clus;
+
+    sb->fs_info = fs;
+    sb->s_op = &fat_sops;
+    sb->readonly = 1;
+
+    struct inode *root = fat_make_inode(sb, root_clus, FAT_ATTR_DIRECTORY, 0);
+    if (root == NULL) {
+        return -VFS_ENOMEM;
+    }
+    sb->root = vfs_make_root(sb, root);
+    if (sb->root == NULL) {
+        vfs_iput(root);
+        return -VFS_ENOMEM;
+    }
+
+    uart_puts("FAT32: 分区LBA ");
+    uart_put_hex(part_lba);
+    uart_puts(", 每簇扇区 ");
+    uart_put_hex(sec_per_clus);
+    uart_puts(", 簇数 ");
+    uart_put_hex(fs->total_clusters);
+    uart_puts("\r\n");
+    return 0;
+}
+
+static struct file_system_type fat32_fs_type = {
+    .name = "fat32",
+    .mount = fat_mount,
+};
+
+void fat32_init(void) {
+    vfs_register_filesystem(&fat32_fs_type);
+}
+
+void fat32_print_stats(void) {
+    for (uint32_t i = 0; i < fat_fs_count; i++) {
+        struct fat_fs *fs = &fat_fs_pool[i];
+
+        uart_puts("\r\n=== FAT32统计 ===\r\n");
+        uart_puts("FAT表项读取: ");
+        uart_put_hex(fs->stat_fat_reads);
+        uart_puts(", extent构建: ");
+        uart_put_hex(fs->stat_extent_builds);
+        uart_puts(", 慢速遍历: ");
+        uart_put_hex(fs->stat_slow_walks);
+        uart_puts("\r\n");
+        uart_puts("直读请求: ");
+        uart_put_hex(fs->stat_direct_reqs);
+        uart_puts(" (");
+        uart_put_hex(fs->stat_direct_sectors);
+        uart_puts(" 扇区), 缓存读扇区: ");
+        uart_put_hex(fs->stat_cached_sectors);
+        uart_puts("\r\n");
+        uart_puts("=================\r\n");
+    }
+}
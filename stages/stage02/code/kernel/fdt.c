@@ -0,0 +1,494 @@
+/*
+ * SkyOS 扁平设备树 (FDT) 解析
+ * 文件: kernel/fdt.c
+ *
+ * - reset_handler把r2中的DTB地址保存到boot_dtb_addr
+ * - 对结构块做一次线性扫描：每个带compatible的节点生成一个设备项，
+ *   reg按父节点的#address-cells/#size-cells解码，interrupts按GIC三元组
+ *   (类型, 编号, 标志) 换算成中断ID
+ * - 扫描完成后建立按compatible排序的索引，查找为O(log n)
+ * - 找不到DTB时使用QEMU virt的默认设备表，驱动代码无需区分
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "fdt.h"
+#include "page_alloc.h"
+#include "kstring.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_hex(uint32_t value);
+
+/* 链接脚本符号 */
+extern char __kernel_end[];
+
+/* 由start.S在清空BSS后写入 (进入内核时r2的值) */
+uint32_t boot_dtb_addr;
+
+/* FDT结构块标记 */
+#define FDT_BEGIN_NODE      1
+#define FDT_END_NODE        2
+#define FDT_PROP            3
+#define FDT_NOP             4
+#define FDT_END             9
+
+#define FDT_MAX_DEPTH       16
+#define FDT_MAX_SIZE        (1024 * 1024)
+#define FDT_SCAN_LIMIT      (16 * 1024 * 1024)  /* r2无效时在内核之后搜索的范围 */
+
+/* GIC中断说明符的类型字段 */
+#define FDT_IRQ_TYPE_SPI    0
+#define FDT_IRQ_TYPE_PPI    1
+
+struct fdt_header {
+    uint32_t magic;
+    uint32_t totalsize;
+    uint32_t off_dt_struct;
+    uint32_t off_dt_strings;
+    uint32_t off_mem_rsvmap;
+    uint32_t version;
+    uint32_t last_comp_version;
+    uint32_t boot_cpuid_phys;
+    uint32_t size_dt_strings;
+    uint32_t size_dt_struct;
+};
+
+/* 每层节点的解析状态 */
+struct fdt_level {
+    uint32_t addr_cells;            /* 本节点为子节点声明的#address-cells */
+    uint32_t size_cells;
+    int is_memory;
+    int is_chosen;
+    struct fdt_device dev;
+};
+
+/* 按compatible排序的索引项 */
+struct fdt_compat_entry {
+    const char *compat;
+    uint16_t dev;
+};
+
+static const uint8_t *fdt_blob = NULL;
+static uint32_t fdt_size = 0;
+
+static struct fdt_device fdt_devices[FDT_MAX_DEVICES];
+static uint32_t fdt_ndev = 0;
+static struct fdt_compat_entry fdt_index[FDT_MAX_COMPAT];
+static uint32_t fdt_nindex = 0;
+static struct fdt_level fdt_levels[FDT_MAX_DEPTH];
+
+static const char *fdt_chosen_bootargs = NULL;
+static uint32_t fdt_mem_base = 0;
+static uint32_t fdt_mem_size = 0;
+
+/* 统计 */
+static uint32_t stat_nodes = 0;
+static uint32_t stat_props = 0;
+static uint32_t stat_parse_ticks = 0;
+
+static inline uint32_t fdt32(const void *p) {
+    const uint8_t *b = p;
+    return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | b[3];
+}
+
+static inline uint32_t fdt_align4(uint32_t x) {
+    return (x + 3) & ~3u;
+}
+
+static inline uint64_t fdt_read_cntpct(void) {
+    uint32_t lo, hi;
+    asm volatile("mrrc p15, 0, %0, %1, c14" : "=r"(lo), "=r"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/* 读取cells个32位单元组成的数 (只保留低32位) */
+static uint32_t fdt_read_cells(const uint8_t *p, uint32_t cells) {
+    return cells ? fdt32(p + (cells - 1) * 4) : 0;
+}
+
+static int fdt_header_valid(uint32_t addr) {
+    const struct fdt_header *h = (const struct fdt_header *)addr;
+
+    if (addr == 0 || (addr & 3)) {
+        return 0;
+    }
+    if (fdt32(&h->magic) != FDT_MAGIC) {
+        return 0;
+    }
+    uint32_t size = fdt32(&h->totalsize);
+    return size >= sizeof(*h) && size <= FDT_MAX_SIZE &&
+           fdt32(&h->version) >= 16 &&
+           fdt32(&h->off_dt_struct) < size && fdt32(&h->off_dt_strings) < size;
+}
+
+/* 优先使用r2；裸机ELF启动时QEMU不一定设置r2，再在内核镜像之后按页搜索 */
+static uint32_t fdt_locate(void) {
+    if (fdt_header_valid(boot_dtb_addr)) {
+        return boot_dtb_addr;
+    }
+    uint32_t start = PAGE_ALIGN((uint32_t)__kernel_end);
+    for (uint32_t addr = start; addr < start + FDT_SCAN_LIMIT; addr += PAGE_SIZE) {
+        if (addr >= RAM_BASE + RAM_SIZE) {
+            break;
+        }
+        if (fdt_header_valid(addr)) {
+            return addr;
+        }
+    }
+    return 0;
+}
+
+static int fdt_streq(const char *a, const char *b) {
+    return strcmp(a, b) == 0;
+}
+
+/* 节点名 "memory@40000000" 与 "memory" 都算内存节点 */
+static int fdt_name_is(const char *name, const char *base) {
+    uint32_t n = strlen(base);
+    return strncmp(name, base, n) == 0 && (name[n] == '\0' || name[n] == '@');
+}
+
+static void fdt_parse_prop(struct fdt_level *lv, struct fdt_level *parent,
+                           const char *pname, const uint8_t *val, uint32_t len) {
+    struct fdt_device *dev = &lv->dev;
+
+    stat_props++;
+    if (fdt_streq(pname, "compatible")) {
+        dev->compatible = (const char *)val;
+        dev->compatible_len = len;
+    } else if (fdt_streq(pname, "#address-cells")) {
+        lv->addr_cells = fdt32(val);
+    } else if (fdt_streq(pname, "#size-cells")) {
+        lv->size_cells = fdt32(val);
+    } else if (fdt_streq(pname, "reg") && parent) {
+        uint32_t ac = parent->addr_cells, sc = parent->size_cells;
+        uint32_t stride = (ac + sc) * 4;
+        for (uint32_t off = 0; stride && off + stride <= len && dev->nr_reg < FDT_MAX_REG; off += stride) {
+            dev->reg_base[dev->nr_reg] = fdt_read_cells(val + off, ac);
+            dev->reg_size[dev->nr_reg] = fdt_read_cells(val + off + ac * 4, sc);
+            dev->nr_reg++;
+        }
+    } else if (fdt_streq(pname, "interrupts")) {
+        /* GIC三元组：<类型 编号 标志> */
+        for (uint32_t off = 0; off + 12 <= len && dev->nr_irqs < FDT_MAX_IRQS; off += 12) {
+            uint32_t type = fdt32(val + off);
+            uint32_t num = fdt32(val + off + 4);
+            dev->irqs[dev->nr_irqs++] = (type == FDT_IRQ_TYPE_PPI) ? 16 + num : 32 + num;
+        }
+    } else if (fdt_streq(pname, "phandle") || fdt_streq(pname, "linux,phandle")) {
+        dev->phandle = fdt32(val);
+    } else if (fdt_streq(pname, "status")) {
+        dev->disabled = !(fdt_streq((const char *)val, "okay") || fdt_streq((const char *)val, "ok"));
+    } else if (lv->is_chosen && fdt_streq(pname, "bootargs")) {
+        fdt_chosen_bootargs = (const char *)val;
+    }
+}
+
+/* 节点结束：内存节点记录RAM范围，带compatible的节点加入设备表 */
+static void fdt_end_node(struct fdt_level *lv) {
+    if (lv->is_memory && lv->dev.nr_reg && fdt_mem_size == 0) {
+        fdt_mem_base = lv->dev.reg_base[0];
+        fdt_mem_size = lv->dev.reg_size[0];
+    }
+    if (lv->dev.compatible && fdt_ndev < FDT_MAX_DEVICES) {
+        fdt_devices[fdt_ndev++] = lv->dev;
+    }
+}
+
+/* 一次线性扫描结构块 */
+static int fdt_parse(const uint8_t *blob) {
+    const struct fdt_header *h = (const struct fdt_header *)blob;
+    const uint8_t *p = blob + fdt32(&h->off_dt_struct);
+    const uint8_t *end = blob + fdt32(&h->totalsize);
+    const char *strings = (const char *)blob + fdt32(&h->off_dt_strings);
+    int depth = -1;
+
+    while (p + 4 <= end) {
+        uint32_t token = fdt32(p);
+        p += 4;
+
+        switch (token) {
+        case FDT_BEGIN_NODE: {
+            const char *name = (const char *)p;
+            uint32_t nlen = strlen(name);
+            p += fdt_align4(nlen + 1);
+
+            if (++depth >= FDT_MAX_DEPTH) {
+                return -1;
+            }
+            struct fdt_level *lv = &fdt_levels[depth];
+            memset(lv, 0, sizeof(*lv));
+            lv->addr_cells = 2;         /* 规范默认值 */
+            lv->size_cells = 1;
+            lv->dev.name = name;
+            lv->is_memory = (depth == 1 && fdt_name_is(name, "memory"));
+            lv->is_chosen = (depth == 1 && fdt_name_is(name, "chosen"));
+            stat_nodes++;
+            break;
+        }
+        case FDT_END_NODE:
+            if (depth < 0) {
+                return -1;
+            }
+            fdt_end_node(&fdt_levels[depth]);
+            depth--;
+            break;
+        case FDT_PROP: {
+            uint32_t len = fdt32(p);
+            uint32_t nameoff = fdt32(p + 4);
+            const uint8_t *val = p + 8;
+            p = val + fdt_align4(len);
+            if (depth < 0) {
+                return -1;
+            }
+            fdt_parse_prop(&fdt_levels[depth], depth > 0 ? &fdt_levels[depth - 1] : NULL,
+                           strings + nameoff, val, len);
+            break;
+        }
+        case FDT_NOP:
+            break;
+        case FDT_END:
+            return 0;
+        default:
+            return -1;
+        }
+    }
+    return -1;
+}
+
+/* ---------------- compatible索引 ---------------- */
+
+static void fdt_index_insert(const char *compat, uint16_t dev) {
+    uint32_t i = fdt_nindex;
+
+    if (fdt_nindex >= FDT_MAX_COMPAT) {
+        return;
+    }
+    /* 插入排序；同名项保持设备树中的顺序 */
+    while (i > 0 && strcmp(fdt_index[i - 1].compat, compat) > 0) {
+        fdt_index[i] = fdt_index[i - 1];
+        i--;
+    }
+    fdt_index[i].compat = compat;
+    fdt_index[i].dev = dev;
+    fdt_nindex++;
+}
+
+static void fdt_build_index(void) {
+    fdt_nindex = 0;
+    for (uint32_t d = 0; d < fdt_ndev; d++) {
+        const char *s = fdt_devices[d].compatible;
+        const char *end = s + fdt_devices[d].compatible_len;
+        while (s < end && *s) {
+            fdt_index_insert(s, d);
+            s += strlen(s) + 1;
+        }
+    }
+}
+
+/* 返回第一个compat >= key的索引位置 */
+static uint32_t fdt_lower_bound(const char *key) {
+    uint32_t lo = 0, hi = fdt_nindex;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (strcmp(fdt_index[mid].compat, key) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+const struct fdt_device *fdt_find_compatible(const char *compat) {
+    const struct fdt_device *dev = NULL;
+    fdt_find_all_compatible(compat, &dev, 1);
+    return dev;
+}
+
+/* 查找所有匹配且未禁用的设备，按设备树顺序返回 */
+uint32_t fdt_find_all_compatible(const char *compat, const struct fdt_device **out, uint32_t max) {
+    uint32_t n = 0;
+
+    for (uint32_t i = fdt_lower_bound(compat);
+         i < fdt_nindex && n < max && strcmp(fdt_index[i].compat, compat) == 0; i++) {
+        const struct fdt_device *dev = &fdt_devices[fdt_index[i].dev];
+        if (!dev->disabled) {
+            out[n++] = dev;
+        }
+    }
+    return n;
+}
+
+int fdt_device_is_compatible(const struct fdt_device *dev, const char *compat) {
+    const char *s = dev->compatible;
+    const char *end = s + dev->compatible_len;
+
+    while (s < end && *s) {
+        if (strcmp(s, compat) == 0) {
+            return 1;
+        }
+        s += strlen(s) + 1;
+    }
+    return 0;
+}
+
+uint32_t fdt_device_count(void) {
+    return fdt_ndev;
+}
+
+const struct fdt_device *fdt_get_device(uint32_t index) {
+    return index < fdt_ndev ? &fdt_devices[index] : NULL;
+}
+
+const char *fdt_bootargs(void) {
+    return fdt_chosen_bootargs;
+}
+
+int fdt_memory(uint32_t *base, uint32_t *size) {
+    if (fdt_mem_size == 0) {
+        return -1;
+    }
+    *base = fdt_mem_base;
+    *size = fdt_mem_size;
+    return 0;
+}
+
+int fdt_available(void) {
+    return fdt_blob != NULL;
+}
+
+/* DTB本身占用的内存，页分配器需要保留 */
+int fdt_blob_region(uint32_t *addr, uint32_t *size) {
+    if (fdt_blob == NULL) {
+        return -1;
+    }
+    *addr = (uint32_t)fdt_blob;
+    *size = fdt_size;
+    return 0;
+}
+
+/* ---------------- 默认设备表 (QEMU virt) ---------------- */
+
+static void fdt_add_default(const char *name, const char *compat, uint32_t compat_len,
+                            uint32_t base0, uint32_t size0, uint32_t base1, uint32_t size1,
+                            const uint32_t *irqs, uint32_t nr_irqs) {
+    struct fdt_device *dev = &fdt_devices[fdt_ndev++];
+
+    memset(dev, 0, sizeof(*dev));
+    dev->name = name;
+    dev->compatible = compat;
+    dev->compatible_len = compat_len;
+    dev->reg_base[0] = base0;
+    dev->reg_size[0] = size0;
+    dev->reg_base[1] = base1;
+    dev->reg_size[1] = size1;
+    dev->nr_reg = size1 ? 2 : 1;
+    for (uint32_t i = 0; i < nr_irqs && i < FDT_MAX_IRQS; i++) {
+        dev->irqs[i] = irqs[i];
+    }
+    dev->nr_irqs = nr_irqs;
+}
+
+static void fdt_load_defaults(void) {
+    static const char gic_compat[] = "arm,cortex-a15-gic";
+    static const char timer_compat[] = "arm,armv7-timer";
+    static const char uart_compat[] = "arm,pl011\0arm,primecell";
+    static const char virtio_compat[] = "virtio,mmio";
+    static const uint32_t timer_irqs[] = { 29, 30, 27, 26 };   /* 安全/非安全物理、虚拟、Hyp */
+    static const uint32_t uart_irq = 33;
+    static uint32_t virtio_irqs[32];
+
+    fdt_ndev = 0;
+    fdt_add_default("intc@8000000", gic_compat, sizeof(gic_compat),
+                    0x08000000, 0x10000, 0x08010000, 0x10000, NULL, 0);
+    fdt_add_default("timer", timer_compat, sizeof(timer_compat), 0, 0, 0, 0, timer_irqs, 4);
+    fdt_devices[fdt_ndev - 1].nr_reg = 0;
+    fdt_add_default("pl011@9000000", uart_compat, sizeof(uart_compat),
+                    0x09000000, 0x1000, 0, 0, &uart_irq, 1);
+    for (uint32_t i = 0; i < 32; i++) {
+        virtio_irqs[i] = 48 + i;
+        fdt_add_default("virtio_mmio", virtio_compat, sizeof(virtio_compat),
+                        0x0A000000 + i * 0x200, 0x200, 0, 0, &virtio_irqs[i], 1);
+    }
+    fdt_mem_base = RAM_BASE;
+    fdt_mem_size = RAM_SIZE;
+}
+
+/* 定位并解析DTB，必须在驱动初始化之前调用 */
+void fdt_init(void) {
+    uint64_t start = fdt_read_cntpct();
+    uint32_t addr = fdt_locate();
+
+    if (addr && fdt_parse((const uint8_t *)addr) == 0) {
+        fdt_blob = (const uint8_t *)addr;
+        fdt_size = fdt32(&((const struct fdt_header *)addr)->totalsize);
+    } else {
+        fdt_blob = NULL;
+        fdt_ndev = 0;
+        fdt_chosen_bootargs = NULL;
+        fdt_mem_size = 0;
+        fdt_load_defaults();
+    }
+    fdt_build_index();
+    stat_parse_ticks = (uint32_t)(fdt_read_cntpct() - start);
+}
+
+void fdt_print_devices(void) {
+    uart_puts("\r\n=== 设备树 ===\r\n");
+    if (fdt_blob) {
+        uart_puts("DTB地址: ");
+        uart_put_hex((uint32_t)fdt_blob);
+        uart_puts(", 大小: ");
+        uart_put_hex(fdt_size);
+        uart_puts(", 节点: ");
+        uart_put_hex(stat_nodes);
+        uart_puts(", 属性: ");
+        uart_put_hex(stat_props);
+        uart_puts("\r\n");
+    } else {
+        uart_puts("未找到DTB，使用QEMU virt默认设备表\r\n");
+    }
+    uart_puts("设备: ");
+    uart_put_hex(fdt_ndev);
+    uart_puts(", 索引项: ");
+    uart_put_hex(fdt_nindex);
+    uart_puts(", 解析耗时: ");
+    uart_put_hex(stat_parse_ticks);
+    uart_puts(" 计数器周期\r\n");
+    if (fdt_mem_size) {
+        uart_puts("内存: ");
+        uart_put_hex(fdt_mem_base);
+        uart_puts(" + ");
+        uart_put_hex(fdt_mem_size);
+        uart_puts("\r\n");
+    }
+    if (fdt_chosen_bootargs) {
+        uart_puts("bootargs: ");
+        uart_puts(fdt_chosen_bootargs);
+        uart_puts("\r\n");
+    }
+
+    for (uint32_t i = 0; i < fdt_ndev; i++) {
+        const struct fdt_device *dev = &fdt_devices[i];
+        /* virtio-mmio节点很多，只列出第一个 */
+        if (i > 0 && fdt_streq(dev->compatible, "virtio,mmio") &&
+            fdt_streq(fdt_devices[i - 1].compatible, "virtio,mmio")) {
+            continue;
+        }
+        uart_puts("  ");
+        uart_puts(dev->compatible);
+        uart_puts(" @ ");
+        uart_put_hex(dev->nr_reg ? dev->reg_base[0] : 0);
+        if (dev->nr_irqs) {
+            uart_puts(" irq ");
+            uart_put_hex(dev->irqs[0]);
+        }
+        if (dev->disabled) {
+            uart_puts(" (disabled)");
+        }
+        uart_puts("\r\n");
+    }
+    uart_puts("==============\r\n");
+}
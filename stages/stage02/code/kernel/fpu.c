@@ -0,0 +1,394 @@
+/*
+ * SkyOS VFP/NEON惰性上下文切换
+ * 文件: kernel/fpu.c
+ *
+ * 1. fpu_owner[cpu]记录该CPU的FP寄存器中是哪个任务的状态 (每个CPU一组寄存器)
+ * 2. 切换到持有者时打开FPEXC.EN，切换到其他任务时关闭 (不保存/恢复)
+ * 3. FPEXC.EN关闭时执行VFP/NEON指令进入未定义指令异常，
+ *    fpu_trap()识别出FP指令后完成真正的保存/恢复，并让异常返回到该指令重新执行
+ *
+ * C代码按soft-float编译，FP指令写在内联汇编里 (用.fpu neon让汇编器接受)。
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "fpu.h"
+#include "task.h"
+#include "irqflags.h"
+#include "kstring.h"
+#include "atomic.h"
+#include "hal.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_hex(uint32_t value);
+extern void uart_put_dec(uint32_t value);
+
+#define FPEXC_EN            (1u << 30)
+#define MVFR0_SIMD_REGS     0xf             /* 2: 32个D寄存器, 1: 16个 */
+#define PSR_T_BIT           (1u << 5)
+
+static struct task *fpu_owner[NR_CPUS];
+static int fpu_d32 = 0;
+
+/* 统计 */
+static uint32_t stat_traps = 0;
+static uint32_t stat_saves = 0;
+static uint32_t stat_restores = 0;
+static uint32_t stat_lazy_switches = 0;     /* 切走时没有保存FP状态的次数 */
+static uint32_t stat_non_fp_undef = 0;
+static uint32_t stat_kernel_neon = 0;       /* kernel_neon_begin的次数 */
+static uint32_t stat_migrate_saves = 0;     /* 持有者迁移前保存的次数 */
+
+static inline uint32_t fpu_read_fpexc(void) {
+    uint32_t val;
+    asm volatile(".fpu neon\n"
+                 "vmrs %0, fpexc" : "=r"(val));
+    return val;
+}
+
+static inline void fpu_write_fpexc(uint32_t val) {
+    asm volatile(".fpu neon\n"
+                 "vmsr fpexc, %0\n"
+                 "isb" : : "r"(val) : "memory");
+}
+
+static inline uint32_t fpu_read_mvfr0(void) {
+    uint32_t val;
+    asm volatile(".fpu neon\n"
+                 "vmrs %0, mvfr0" : "=r"(val));
+    return val;
+}
+
+/* 调用前FPEXC.EN必须已打开 */
+static void fpu_save(struct fpu_state *s) {
+    uint64_t *p = s->d;
+    uint32_t fpscr;
+
+    asm volatile(".fpu neon\n"
+                 "vstmia %0!, {d0-d15}" : "+r"(p) : : "memory");
+    if (fpu_d32) {
+        asm volatile(".fpu neon\n"
+                     "vstmia %0, {d16-d31}" : : "r"(p) : "memory");
+    }
+    asm volatile(".fpu neon\n"
+                 "vmrs %0, fpscr" : "=r"(fpscr));
+    s->fpscr = fpscr;
+    stat_saves++;
+}
+
+static void fpu_restore(const struct fpu_state *s) {
+    const uint64_t *p = s->d;
+
+    asm volatile(".fpu neon\n"
+                 "vldmia %0!, {d0-d15}" : "+r"(p) : : "memory");
+    if (fpu_d32) {
+        asm volatile(".fpu neon\n"
+                     "vldmia %0, {d16-d31}" : : "r"(p) : "memory");
+    }
+    asm volatile(".fpu neon\n"
+                 "vmsr fpscr, %0" : : "r"(s->fpscr));
+    stat_restores++;
+}
+
+/*
+ * 判断是否为VFP/NEON指令 (ARMv7编码)
+ * ARM:   cp10/cp11协处理器指令、1111001x (SIMD数据处理)、11110100xxx0 (SIMD加载存储)
+ * Thumb: 同样的cp10/cp11编码，111x1111 (SIMD数据处理)、11111001xxx0 (SIMD加载存储)
+ */
+static int fpu_is_fp_insn(uint32_t insn, int thumb) {
+    uint32_t cp = (insn >> 8) & 0xf;
+
+    if (thumb) {
+        if ((insn & 0xef000000) == 0xef000000) {
+            return 1;
+        }
+        if ((insn & 0xff100000) == 0xf9000000) {
+            return 1;
+        }
+        return (insn & 0xec000000) == 0xec000000 && (cp == 10 || cp == 11);
+    }
+    if ((insn & 0xfe000000) == 0xf2000000) {
+        return 1;
+    }
+    if ((insn & 0xff100000) == 0xf4000000) {
+        return 1;
+    }
+    return ((insn >> 26) & 3) == 3 && ((insn >> 24) & 0xf) != 0xf &&
+           (cp == 10 || cp == 11) && (insn >> 28) != 0xf;
+}
+
+/* task_init()之后调用：启动时FP已打开，归0号任务所有 */
+void fpu_init(struct task *owner) {
+    fpu_d32 = (fpu_read_mvfr0() & MVFR0_SIMD_REGS) == 2;
+    fpu_write_fpexc(FPEXC_EN);
+    fpu_owner[cpu_id()] = owner;
+    owner->fpu.used = 1;
+}
+
+/*
+ * 在t正在运行的CPU上调用 (IRQ已屏蔽)：t是本CPU的持有者时保存它的状态并放弃持有，
+ * 之后t可以迁移到其他CPU，在那里首次使用FP时从t->fpu恢复
+ */
+void fpu_task_release(struct task *t) {
+    uint32_t cpu = cpu_id();
+
+    if (fpu_owner[cpu] != t) {
+        return;
+    }
+    fpu_write_fpexc(FPEXC_EN);
+    fpu_save(&t->fpu);
+    fpu_write_fpexc(0);     /* t切走前若再用FP会陷入并恢复 */
+    fpu_owner[cpu] = NULL;
+    stat_migrate_saves++;
+}
+
+/*
+ * 任务切换时调用 (IRQ已屏蔽)：只切换FPEXC.EN，不搬运寄存器。
+ * 亲和性已不允许本CPU的持有者切出后会被迁走，此时先保存它的状态
+ */
+void fpu_task_switch(struct task *prev, struct task *next) {
+    struct task *owner;
+
+    if (!(prev->affinity & (1u << cpu_id()))) {
+        fpu_task_release(prev);
+    }
+    owner = fpu_owner[cpu_id()];
+    if (next == owner) {
+        fpu_write_fpexc(FPEXC_EN);
+        return;
+    }
+    if (prev == owner) {
+        stat_lazy_switches++;
+    }
+    fpu_write_fpexc(0);
+}
+
+/* 持有者退出后FP寄存器中的内容不再需要保存 */
+void fpu_task_exit(struct task *t) {
+    for (uint32_t cpu = 0; cpu < NR_CPUS; cpu++) {
+        if (fpu_owner[cpu] == t) {
+            fpu_owner[cpu] = NULL;
+        }
+    }
+}
+
+/* 某个CPU的FP寄存器中是否是t的状态 (迁移到其他CPU前必须先保存，调度器不迁移这样的任务) */
+int fpu_task_owns(const struct task *t) {
+    for (uint32_t cpu = 0; cpu < NR_CPUS; cpu++) {
+        if (READ_ONCE(fpu_owner[cpu]) == t) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * 内核代码显式使用NEON (memcpy_neon等)：屏蔽IRQ，保存持有者的状态后放弃持有。
+ * 持有者下次执行FP指令时照常陷入并恢复自己的状态；当前任务不会因此成为持有者。
+ */
+uint32_t kernel_neon_begin(void) {
+    uint32_t flags = local_irq_save();
+    struct task **owner = &fpu_owner[cpu_id()];
+
+    fpu_write_fpexc(FPEXC_EN);
+    if (*owner) {
+        fpu_save(&(*owner)->fpu);
+        *owner = NULL;
+    }
+    stat_kernel_neon++;
+    return flags;
+}
+
+/* FP寄存器中只剩内核用过的临时值，关闭FPEXC.EN，下一个使用者陷入后恢复 */
+void kernel_neon_end(uint32_t flags) {
+    fpu_write_fpexc(0);
+    local_irq_restore(flags);
+}
+
+/*
+ * 由handle_undefined_instruction调用，pc指向异常帧中的返回地址。
+ * 是FPEXC.EN关闭导致的FP指令异常时完成惰性切换，把返回地址改回该指令，返回1。
+ */
+int fpu_trap(uint32_t *pc, uint32_t spsr) {
+    int thumb = (spsr & PSR_T_BIT) != 0;
+    uint32_t addr = *pc - (thumb ? 2 : 4);
+    uint32_t insn;
+    struct task *cur = task_current();
+    struct task **owner = &fpu_owner[cpu_id()];
+
+    if (cur == NULL || (fpu_read_fpexc() & FPEXC_EN)) {
+        stat_non_fp_undef++;
+        return 0;
+    }
+    if (thumb) {
+        const uint16_t *hw = (const uint16_t *)addr;
+        insn = ((uint32_t)hw[0] << 16) | hw[1];
+    } else {
+        insn = *(const uint32_t *)addr;
+    }
+    if (!fpu_is_fp_insn(insn, thumb)) {
+        stat_non_fp_undef++;
+        return 0;
+    }
+
+    fpu_write_fpexc(FPEXC_EN);
+    if (*owner && *owner != cur) {
+        fpu_save(&(*owner)->fpu);
+    }
+    /* 首次使用时struct task已被清零，恢复即得到全零寄存器和默认FPSCR */
+    fpu_restore(&cur->fpu);
+    cur->fpu.used = 1;
+    *owner = cur;
+    cur->fpu.traps++;
+    stat_traps++;
+    *pc = addr;
+    return 1;
+}
+
+void fpu_print_stats(void) {
+    struct task *owner = fpu_owner[cpu_id()];
+
+    uart_puts("\r\n=== VFP/NEON 惰性切换 ===\r\n");
+    uart_puts("寄存器: ");
+    uart_put_dec(fpu_d32 ? 32 : 16);
+    uart_puts(" x D, FPEXC: ");
+    uart_put_hex(fpu_read_fpexc());
+    uart_puts("\r\n");
+    uart_puts("本CPU持有者: ");
+    uart_puts(owner ? owner->name : "(无)");
+    uart_puts("\r\n");
+    uart_puts("FP陷入: ");
+    uart_put_dec(stat_traps);
+    uart_puts(", 保存: ");
+    uart_put_dec(stat_saves);
+    uart_puts(", 恢复: ");
+    uart_put_dec(stat_restores);
+    uart_puts("\r\n");
+    uart_puts("未搬运FP状态的切换: ");
+    uart_put_dec(stat_lazy_switches);
+    uart_puts(", 非FP未定义指令: ");
+    uart_put_dec(stat_non_fp_undef);
+    uart_puts("\r\n");
+    uart_puts("内核NEON区: ");
+    uart_put_dec(stat_kernel_neon);
+    uart_puts(", 迁移前保存: ");
+    uart_put_dec(stat_migrate_saves);
+    uart_puts("\r\n");
+    uart_puts("=========================\r\n");
+}
+
+/*
+ * 自检：两个任务在d0和d31 (只有D16时为d15) 中放入各自的值，
+ * 交替让出CPU多次后检查值没有被对方覆盖；第三个任务同时做内核拷贝，
+ * 检查它不会成为持有者，也不破坏持有者的寄存器
+ */
+#define FPU_TEST_ROUNDS     8
+
+struct fpu_test_arg {
+    uint32_t pattern;
+    uint32_t errors;
+    struct task *task;
+};
+
+static void fpu_test_set(uint32_t v) {
+    asm volatile(".fpu neon\n"
+                 "vmov d0, %0, %0" : : "r"(v));
+    if (fpu_d32) {
+        asm volatile(".fpu neon\n"
+                     "vmov d31, %0, %0" : : "r"(~v));
+    } else {
+        asm volatile(".fpu neon\n"
+                     "vmov d15, %0, %0" : : "r"(~v));
+    }
+}
+
+static int fpu_test_check(uint32_t v) {
+    uint32_t lo, hi, lo2, hi2;
+
+    asm volatile(".fpu neon\n"
+                 "vmov %0, %1, d0" : "=r"(lo), "=r"(hi));
+    if (fpu_d32) {
+        asm volatile(".fpu neon\n"
+                     "vmov %0, %1, d31" : "=r"(lo2), "=r"(hi2));
+    } else {
+        asm volatile(".fpu neon\n"
+                     "vmov %0, %1, d15" : "=r"(lo2), "=r"(hi2));
+    }
+    return lo == v && hi == v && lo2 == ~v && hi2 == ~v;
+}
+
+static void fpu_test_task(void *arg) {
+    struct fpu_test_arg *a = arg;
+
+    fpu_test_set(a->pattern);
+    for (uint32_t i = 0; i < FPU_TEST_ROUNDS; i++) {
+        task_yield();
+        if (!fpu_test_check(a->pattern)) {
+            a->errors++;
+        }
+    }
+}
+
+/* 普通memcpy/memset不触发FP陷入；kernel_neon_begin/end之间的NEON拷贝不改变持有者 */
+static void fpu_test_memcpy_task(void *arg) {
+    static uint8_t src[512], dst[512];
+    struct fpu_test_arg *a = arg;
+    struct task *cur = task_current();
+    struct task *owner;
+    uint32_t flags;
+
+    for (uint32_t i = 0; i < FPU_TEST_ROUNDS; i++) {
+        owner = fpu_owner[cpu_id()];
+        memset(src, (int)(a->pattern + i), sizeof(src));
+        memcpy(dst, src, sizeof(dst));
+        if (fpu_owner[cpu_id()] != owner || cur->fpu.traps != 0) {
+            a->errors++;
+        }
+        flags = kernel_neon_begin();
+        memcpy_neon(dst, src, sizeof(dst));
+        kernel_neon_end(flags);
+        if (fpu_task_owns(cur) || cur->fpu.traps != 0 || memcmp(dst, src, sizeof(dst)) != 0) {
+            a->errors++;
+        }
+        task_yield();
+    }
+}
+
+void test_fpu(void) {
+    struct fpu_test_arg args[2] = {
+        { 0x11223344, 0, NULL },
+        { 0xa5a5c3c3, 0, NULL },
+    };
+    struct fpu_test_arg copy = { 0x5a, 0, NULL };
+    uint32_t traps = stat_traps;
+    uint32_t saves = stat_saves;
+
+    uart_puts("\r\n=== VFP/NEON 惰性切换自检 ===\r\n");
+    for (uint32_t i = 0; i < 2; i++) {
+        args[i].task = task_create("fpu-test", fpu_test_task, &args[i]);
+        if (args[i].task == NULL) {
+            uart_puts("无法创建测试任务\r\n");
+            return;
+        }
+    }
+    copy.task = task_create("fpu-copy", fpu_test_memcpy_task, &copy);
+    if (copy.task == NULL) {
+        uart_puts("无法创建测试任务\r\n");
+        return;
+    }
+    while (args[0].task->state != TASK_DEAD || args[1].task->state != TASK_DEAD ||
+           copy.task->state != TASK_DEAD) {
+        task_yield();
+    }
+    uart_puts("寄存器保持: ");
+    uart_puts(args[0].errors + args[1].errors ? "失败" : "通过");
+    uart_puts(", 内核拷贝不改变持有者: ");
+    uart_puts(copy.errors ? "失败" : "通过");
+    uart_puts(", 本次FP陷入: ");
+    uart_put_dec(stat_traps - traps);
+    uart_puts(", 保存: ");
+    uart_put_dec(stat_saves - saves);
+    uart_puts("\r\n");
+    uart_puts("=============================\r\n");
+}
@@ -0,0 +1,200 @@
+/*
+ * SkyOS futex
+ * 文件: kernel/futex.c
+ *
+ * 等待者按地址哈希到FUTEX_HASH_SIZE个等待队列，队列中以地址为key区分。
+ * FUTEX_WAIT先入队再比较*uaddr，FUTEX_WAKE的调用者先改值再唤醒，
+ * 所以比较和睡眠之间发生的唤醒不会丢失。
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "futex.h"
+#include "wait.h"
+#include "task.h"
+#include "timer.h"
+#include "ulock.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_dec(uint32_t value);
+
+#define FUTEX_HASH_BITS     5
+#define FUTEX_HASH_SIZE     (1u << FUTEX_HASH_BITS)
+
+static struct wait_queue futex_queues[FUTEX_HASH_SIZE] = {
+    [0 ... FUTEX_HASH_SIZE - 1] = WAIT_QUEUE_INIT("futex"),
+};
+
+/* 统计 */
+static uint32_t stat_wait_calls = 0;
+static uint32_t stat_wait_eagain = 0;
+static uint32_t stat_wake_calls = 0;
+static uint32_t stat_woken = 0;
+
+static struct wait_queue *futex_queue(uint32_t addr) {
+    return &futex_queues[((addr >> 2) * 0x9E3779B1u) >> (32 - FUTEX_HASH_BITS)];
+}
+
+static uint32_t futex_wait(volatile uint32_t *uaddr, uint32_t val) {
+    struct wait_queue *wq = futex_queue((uint32_t)uaddr);
+    struct wait_entry e = { 0 };
+
+    stat_wait_calls++;
+    wait_prepare(wq, &e, (uint32_t)uaddr);
+    if (*uaddr != val) {
+        wait_finish(wq, &e);
+        stat_wait_eagain++;
+        return (uint32_t)-FUTEX_EAGAIN;
+    }
+    wait_schedule(wq);
+    wait_finish(wq, &e);
+    return 0;
+}
+
+static uint32_t futex_wake(volatile uint32_t *uaddr, uint32_t n) {
+    uint32_t woken = wake_up_key(futex_queue((uint32_t)uaddr), (uint32_t)uaddr, n);
+
+    stat_wake_calls++;
+    stat_woken += woken;
+    return woken;
+}
+
+/* 系统调用：futex(uaddr, op, val) */
+uint32_t sys_futex(volatile uint32_t *uaddr, uint32_t op, uint32_t val) {
+    if (uaddr == NULL || ((uint32_t)uaddr & 3) || task_current() == NULL) {
+        return (uint32_t)-FUTEX_EINVAL;
+    }
+    switch (op) {
+    case FUTEX_WAIT:
+        return futex_wait(uaddr, val);
+    case FUTEX_WAKE:
+        return futex_wake(uaddr, val);
+    default:
+        return (uint32_t)-FUTEX_EINVAL;
+    }
+}
+
+void futex_print_stats(void) {
+    uint32_t waits = 0;
+
+    for (uint32_t i = 0; i < FUTEX_HASH_SIZE; i++) {
+        waits += futex_queues[i].waits;
+    }
+    uart_puts("\r\n=== futex统计 ===\r\n");
+    uart_puts("WAIT调用: ");
+    uart_put_dec(stat_wait_calls);
+    uart_puts(", 实际睡眠: ");
+    uart_put_dec(waits);
+    uart_puts(", 值已改变: ");
+    uart_put_dec(stat_wait_eagain);
+    uart_puts("\r\n");
+    uart_puts("WAKE调用: ");
+    uart_put_dec(stat_wake_calls);
+    uart_puts(", 唤醒任务: ");
+    uart_put_dec(stat_woken);
+    uart_puts("\r\n");
+    uart_puts("=================\r\n");
+}
+
+/* 自检：生产者/消费者通过umutex+ucond传递FUTEX_TEST_ITEMS个数据 */
+#define FUTEX_TEST_ITEMS        64
+#define FUTEX_TEST_SLOTS        4
+#define FUTEX_TEST_LOCK_ROUNDS  1000
+
+static struct umutex test_mutex = UMUTEX_INIT;
+static struct ucond test_not_empty = UCOND_INIT;
+static struct ucond test_not_full = UCOND_INIT;
+static uint32_t test_buf[FUTEX_TEST_SLOTS];
+static uint32_t test_head, test_tail, test_count;
+static uint32_t test_sum;
+static volatile uint32_t test_done;
+
+static void futex_test_producer(void *arg) {
+    (void)arg;
+    for (uint32_t i = 1; i <= FUTEX_TEST_ITEMS; i++) {
+        umutex_lock(&test_mutex);
+        while (test_count == FUTEX_TEST_SLOTS) {
+            ucond_wait(&test_not_full, &test_mutex);
+        }
+        test_buf[test_tail] = i;
+        test_tail = (test_tail + 1) % FUTEX_TEST_SLOTS;
+        test_count++;
+        ucond_signal(&test_not_empty);
+        umutex_unlock(&test_mutex);
+    }
+}
+
+static void futex_test_consumer(void *arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < FUTEX_TEST_ITEMS; i++) {
+        umutex_lock(&test_mutex);
+        while (test_count == 0) {
+            ucond_wait(&test_not_empty, &test_mutex);
+        }
+        test_sum += test_buf[test_head];
+        test_head = (test_head + 1) % FUTEX_TEST_SLOTS;
+        test_count--;
+        ucond_signal(&test_not_full);
+        umutex_unlock(&test_mutex);
+    }
+    test_done = 1;
+}
+
+void test_futex(void) {
+    uint32_t calls_before = stat_wait_calls + stat_wake_calls;
+    uint32_t ticks_before, waited, blocks;
+    int ok = 1;
+
+    uart_puts("\r\n=== futex自检 ===\r\n");
+
+    /* 无争用：加锁/解锁不陷入内核 */
+    for (uint32_t i = 0; i < FUTEX_TEST_LOCK_ROUNDS; i++) {
+        umutex_lock(&test_mutex);
+        umutex_unlock(&test_mutex);
+    }
+    uart_puts("无争用加锁/解锁 ");
+    uart_put_dec(FUTEX_TEST_LOCK_ROUNDS);
+    uart_puts(" 次，系统调用 ");
+    uart_put_dec(stat_wait_calls + stat_wake_calls - calls_before);
+    uart_puts(" 次\r\n");
+    ok &= stat_wait_calls + stat_wake_calls == calls_before;
+
+    /* 值已改变时WAIT立即返回 */
+    ok &= sys_futex(&test_mutex.state, FUTEX_WAIT, 1) == (uint32_t)-FUTEX_EAGAIN;
+
+    /* 生产者/消费者：消费者先启动并在空缓冲上睡眠 */
+    test_head = test_tail = test_count = test_sum = test_done = 0;
+    task_create("futex-cons", futex_test_consumer, NULL);
+    task_create("futex-prod", futex_test_producer, NULL);
+    ticks_before = get_timer_ticks();
+    while (!test_done) {
+        timer_delay_ms(10);
+    }
+    waited = get_timer_ticks() - ticks_before;
+    uart_puts("生产者/消费者: 和 ");
+    uart_put_dec(test_sum);
+    uart_puts(" (期望 ");
+    uart_put_dec(FUTEX_TEST_ITEMS * (FUTEX_TEST_ITEMS + 1) / 2);
+    uart_puts(")，等待 ");
+    uart_put_dec(waited);
+    uart_puts(" 个滴答\r\n");
+    ok &= test_sum == FUTEX_TEST_ITEMS * (FUTEX_TEST_ITEMS + 1) / 2;
+
+    /* 睡眠期间不轮询：100ms内本任务只阻塞一次，到期由定时器中断唤醒 */
+    blocks = task_current()->blocks;
+    ticks_before = get_timer_ticks();
+    timer_delay_ms(100);
+    waited = get_timer_ticks() - ticks_before;
+    blocks = task_current()->blocks - blocks;
+    uart_puts("timer_delay_ms(100): 经过 ");
+    uart_put_dec(waited);
+    uart_puts(" 个滴答，阻塞 ");
+    uart_put_dec(blocks);
+    uart_puts(" 次\r\n");
+    ok &= waited >= 10 && blocks == 1;
+
+    uart_puts("结果: ");
+    uart_puts(ok ? "通过" : "失败");
+    uart_puts("\r\n=================\r\n");
+}
@@ -6,15 +6,23 @@
  */
 
 #include <stdint.h>
+#include <stddef.h>
+#include "driver.h"
+#include "atomic.h"
+#include "spinlock.h"
+#include "rcu.h"
+#include "idle.h"
+#include "kprintf.h"
+#include "hal.h"
 
 /* 外部函数声明 */
 extern void uart_puts(const char *str);
 extern void uart_put_hex(uint32_t value);
 extern void timer_handle_interrupt(void);
 
-/* QEMU virt machine GIC地址定义 */
-#define GIC_DIST_BASE   0x08000000  /* 分发器基址 */
-#define GIC_CPU_BASE    0x08010000  /* CPU接口基址 */
+/* QEMU virt machine GIC默认地址 (GIC驱动探测前使用) */
+#define GIC_DIST_DEFAULT_BASE   0x08000000  /* 分发器基址 */
+#define GIC_CPU_DEFAULT_BASE    0x08010000  /* CPU接口基址 */
 
 /* GIC分发器寄存器偏移 */
 #define GICD_CTLR       0x000  /* 分发器控制寄存器 */
@@ -43,17 +51,14 @@ extern void timer_handle_interrupt(void);
 #define GICC_ABPR       0x01C  /* 别名二进制点寄存器 */
 #define GICC_IIDR       0x0FC  /* CPU接口标识寄存器 */
 
-/* 寄存器访问宏 */
-#define GIC_DIST_REG(offset) (*(volatile uint32_t*)(GIC_DIST_BASE + (offset)))
-#define GIC_CPU_REG(offset)  (*(volatile uint32_t*)(GIC_CPU_BASE + (offset)))
 
 /* 中断ID定义 */
 #define SGI_BASE        0   /* 软件生成中断 0-15 */
 #define PPI_BASE        16  /* 私有外设中断 16-31 */
 #define SPI_BASE        32  /* 共享外设中断 32+ */
 
-/* ARM Generic Timer Physical Timer中断 */
-#define TIMER_IRQ_ID    30  /* ARM Generic Timer Physical Timer */
+/* ARM Generic Timer 非安全物理定时器中断 (PPI 14) 默认值，定时器驱动探测后更新 */
+#define TIMER_IRQ_DEFAULT   30
 
 /* GIC控制位定义 */
 #define GICD_CTLR_ENABLE    (1 << 0)   /* 分发器使能 */
@@ -64,15 +69,56 @@ extern void timer_handle_interrupt(void);
 #define IRQ_PRIORITY_NORMAL 0x80
 #define IRQ_PRIORITY_LOW    0xC0
 
+/*
+ * 动态注册的中断处理程序 (SPI等运行时才确定中断号的设备)
+ * 表项指向irq_action，handle_irq在RCU读侧读取 (无锁)；
+ * 释放或替换后旧的irq_action在宽限期后经call_rcu放回池中
+ */
+#define IRQ_HANDLER_MAX     256
+#define IRQ_ACTION_POOL     32
+
+typedef void (*irq_handler_t)(uint32_t irq_id, void *data);
+
+struct irq_action {
+    irq_handler_t handler;
+    void *data;
+    struct rcu_head rcu;
+    uint32_t in_use;
+};
+
 /* 全局变量 */
+static uint32_t gic_dist_base = GIC_DIST_DEFAULT_BASE;
+static uint32_t gic_cpu_base = GIC_CPU_DEFAULT_BASE;
+static uint32_t timer_irq_id = TIMER_IRQ_DEFAULT;
+static struct irq_action *irq_actions[IRQ_HANDLER_MAX];
+static struct irq_action irq_action_pool[IRQ_ACTION_POOL];
+static struct spinlock irq_action_lock = SPINLOCK_INIT("irq_actions");
 static uint32_t gic_num_irqs = 0;
 static uint32_t gic_cpu_count = 0;
 static volatile uint32_t irq_counts[1024] = {0}; /* 中断计数统计 */
 static volatile uint32_t total_irqs = 0;
+static uint32_t *irq_regs[NR_CPUS];    /* 每个CPU当前IRQ的寄存器帧 (boot/start.S中irq_handler保存) */
+
+/* 寄存器访问 (经hal.h，主机测试时落到假的寄存器文件) */
+static inline uint32_t gicd_read(uint32_t offset) {
+    return mmio_read32(gic_dist_base + offset);
+}
+
+static inline void gicd_write(uint32_t offset, uint32_t val) {
+    mmio_write32(gic_dist_base + offset, val);
+}
+
+static inline uint32_t gicc_read(uint32_t offset) {
+    return mmio_read32(gic_cpu_base + offset);
+}
+
+static inline void gicc_write(uint32_t offset, uint32_t val) {
+    mmio_write32(gic_cpu_base + offset, val);
+}
 
 /* 读取GIC分发器类型信息 */
 static void gic_read_distributor_info(void) {
-    uint32_t typer = GIC_DIST_REG(GICD_TYPER);
+    uint32_t typer = gicd_read(GICD_TYPER);
     
     /* 计算支持的中断数量 */
     gic_num_irqs = ((typer & 0x1F) + 1) * 32;
@@ -98,14 +144,14 @@ static void gic_disable_all_interrupts(void) {
     
     /* 禁用所有SPI中断 */
     for (i = SPI_BASE; i < gic_num_irqs; i += 32) {
-        GIC_DIST_REG(GICD_ICENABLER + (i / 32) * 4) = 0xFFFFFFFF;
+        gicd_write(GICD_ICENABLER + (i / 32) * 4, 0xFFFFFFFF);
     }
     
     /* 禁用所有PPI中断 */
-    GIC_DIST_REG(GICD_ICENABLER + 0) = 0xFFFF0000;
+    gicd_write(GICD_ICENABLER + 0, 0xFFFF0000);
     
     /* 禁用所有SGI中断 */
-    GIC_DIST_REG(GICD_ICENABLER + 0) |= 0x0000FFFF;
+    gicd_write(GICD_ICENABLER + 0, gicd_read(GICD_ICENABLER + 0) | 0x0000FFFF);
 }
 
 /* 清除所有挂起中断 */
@@ -113,7 +159,7 @@ static void gic_clear_all_pending(void) {
     uint32_t i;
     
     for (i = 0; i < gic_num_irqs; i += 32) {
-        GIC_DIST_REG(GICD_ICPENDR + (i / 32) * 4) = 0xFFFFFFFF;
+        gicd_write(GICD_ICPENDR + (i / 32) * 4, 0xFFFFFFFF);
     }
 }
 
@@ -121,24 +167,24 @@ static void gic_clear_all_pending(void) {
 static void gic_set_priority(uint32_t irq_id, uint8_t priority) {
     uint32_t reg_offset = GICD_IPRIORITYR + (irq_id / 4) * 4;
     uint32_t bit_offset = (irq_id % 4) * 8;
-    uint32_t reg_val = GIC_DIST_REG(reg_offset);
+    uint32_t reg_val = gicd_read(reg_offset);
     
     /* 清除旧优先级并设置新优先级 */
     reg_val &= ~(0xFF << bit_offset);
     reg_val |= (priority << bit_offset);
-    GIC_DIST_REG(reg_offset) = reg_val;
+    gicd_write(reg_offset, reg_val);
 }
 
 /* 设置中断目标CPU */
 static void gic_set_target(uint32_t irq_id, uint8_t cpu_mask) {
     uint32_t reg_offset = GICD_ITARGETSR + (irq_id / 4) * 4;
     uint32_t bit_offset = (irq_id % 4) * 8;
-    uint32_t reg_val = GIC_DIST_REG(reg_offset);
+    uint32_t reg_val = gicd_read(reg_offset);
     
     /* 清除旧目标并设置新目标 */
     reg_val &= ~(0xFF << bit_offset);
     reg_val |= (cpu_mask << bit_offset);
-    GIC_DIST_REG(reg_offset) = reg_val;
+    gicd_write(reg_offset, reg_val);
 }
 
 /* 使能指定中断 */
@@ -146,7 +192,7 @@ void gic_enable_interrupt(uint32_t irq_id) {
     uint32_t reg_offset = GICD_ISENABLER + (irq_id / 32) * 4;
     uint32_t bit_offset = irq_id % 32;
     
-    GIC_DIST_REG(reg_offset) = (1 << bit_offset);
+    gicd_write(reg_offset, 1 << bit_offset);
 }
 
 /* 禁用指定中断 */
@@ -154,7 +200,7 @@ void gic_disable_interrupt(uint32_t irq_id) {
     uint32_t reg_offset = GICD_ICENABLER + (irq_id / 32) * 4;
     uint32_t bit_offset = irq_id % 32;
     
-    GIC_DIST_REG(reg_offset) = (1 << bit_offset);
+    gicd_write(reg_offset, 1 << bit_offset);
 }
 
 /* 检查中断是否使能 */
@@ -162,22 +208,122 @@ uint32_t gic_is_interrupt_enabled(uint32_t irq_id) {
     uint32_t reg_offset = GICD_ISENABLER + (irq_id / 32) * 4;
     uint32_t bit_offset = irq_id % 32;
     
-    return (GIC_DIST_REG(reg_offset) >> bit_offset) & 1;
+    return (gicd_read(reg_offset) >> bit_offset) & 1;
 }
 
 /* 触发软件生成中断 */
 void gic_send_sgi(uint32_t sgi_id, uint32_t target_cpu_mask) {
     uint32_t sgir_val = (target_cpu_mask << 16) | sgi_id;
-    GIC_DIST_REG(GICD_SGIR) = sgir_val;
+    gicd_write(GICD_SGIR, sgir_val);
+}
+
+/* 宽限期结束后回收irq_action */
+static void irq_action_free(struct rcu_head *head) {
+    struct irq_action *action = container_of(head, struct irq_action, rcu);
+    uint32_t flags = spin_lock_irqsave(&irq_action_lock);
+    action->in_use = 0;
+    spin_unlock_irqrestore(&irq_action_lock, flags);
+}
+
+/* 持有irq_action_lock时替换表项 */
+static void irq_action_replace(uint32_t irq_id, struct irq_action *action) {
+    struct irq_action *old = irq_actions[irq_id];
+
+    rcu_assign_pointer(irq_actions[irq_id], action);
+    if (old) {
+        call_rcu(&old->rcu, irq_action_free);
+    }
+}
+
+/* 注册中断处理程序并在分发器中使能该中断 (已注册时替换) */
+int gic_request_irq(uint32_t irq_id, irq_handler_t handler, void *data) {
+    struct irq_action *action = NULL;
+    uint32_t flags;
+
+    if (irq_id >= IRQ_HANDLER_MAX || handler == 0) {
+        return -1;
+    }
+
+    flags = spin_lock_irqsave(&irq_action_lock);
+    for (uint32_t i = 0; i < IRQ_ACTION_POOL; i++) {
+        if (!irq_action_pool[i].in_use) {
+            action = &irq_action_pool[i];
+            action->in_use = 1;
+            break;
+        }
+    }
+    if (action) {
+        action->handler = handler;
+        action->data = data;
+        irq_action_replace(irq_id, action);
+    }
+    spin_unlock_irqrestore(&irq_action_lock, flags);
+    if (action == NULL) {
+        return -1;
+    }
+
+    gic_set_priority(irq_id, IRQ_PRIORITY_NORMAL);
+    if (irq_id >= SPI_BASE) {
+        gic_set_target(irq_id, 0x01);
+    }
+    gic_enable_interrupt(irq_id);
+    return 0;
 }
 
-/* 初始化GIC */
-void gic_init(void) {
+/* 禁用中断并注销处理程序 (正在其他CPU上执行的处理程序不受影响) */
+void gic_free_irq(uint32_t irq_id) {
+    uint32_t flags;
+
+    if (irq_id >= IRQ_HANDLER_MAX) {
+        return;
+    }
+    gic_disable_interrupt(irq_id);
+    flags = spin_lock_irqsave(&irq_action_lock);
+    irq_action_replace(irq_id, NULL);
+    spin_unlock_irqrestore(&irq_action_lock, flags);
+}
+
+/* 定时器中断号 (供其他模块查询) */
+uint32_t gic_timer_irq(void) {
+    return timer_irq_id;
+}
+
+/* 配置定时器中断 (由定时器驱动探测时调用，中断号来自设备树) */
+void gic_setup_timer_irq(uint32_t irq_id) {
+    timer_irq_id = irq_id;
+    
+    uart_puts("配置定时器中断 (IRQ ");
+    uart_put_hex(timer_irq_id);
+    uart_puts(")...\r\n");
+    
+    /* 设置定时器中断优先级 */
+    gic_set_priority(timer_irq_id, IRQ_PRIORITY_NORMAL);
+    
+    /* 设置定时器中断目标CPU (CPU 0) */
+    gic_set_target(timer_irq_id, 0x01);
+    
+    /* 启用定时器中断 */
+    gic_enable_interrupt(timer_irq_id);
+}
+
+/* 初始化GIC (平台驱动probe，reg[0]为分发器，reg[1]为CPU接口) */
+static int gic_probe(struct platform_device *pdev) {
     uart_puts("初始化ARM GIC v2中断控制器...\r\n");
     
+    if (pdev->node->nr_reg < 2) {
+        return -DRIVER_ENODEV;
+    }
+    gic_dist_base = pdev->node->reg_base[0];
+    gic_cpu_base = pdev->node->reg_base[1];
+    uart_puts("  分发器: ");
+    uart_put_hex(gic_dist_base);
+    uart_puts(", CPU接口: ");
+    uart_put_hex(gic_cpu_base);
+    uart_puts("\r\n");
+    
     /* 禁用分发器和CPU接口 */
-    GIC_DIST_REG(GICD_CTLR) = 0;
-    GIC_CPU_REG(GICC_CTLR) = 0;
+    gicd_write(GICD_CTLR, 0);
+    gicc_write(GICC_CTLR, 0);
     
     /* 读取GIC信息 */
     gic_read_distributor_info();
@@ -188,85 +334,88 @@ void gic_init(void) {
     /* 清除所有挂起中断 */
     gic_clear_all_pending();
     
-    /* 配置定时器中断 */
-    uart_puts("配置定时器中断 (IRQ ");
-    uart_put_hex(TIMER_IRQ_ID);
-    uart_puts(")...\r\n");
-    
-    /* 设置定时器中断优先级 */
-    gic_set_priority(TIMER_IRQ_ID, IRQ_PRIORITY_NORMAL);
-    
-    /* 设置定时器中断目标CPU (CPU 0) */
-    gic_set_target(TIMER_IRQ_ID, 0x01);
-    
-    /* 启用定时器中断 */
-    gic_enable_interrupt(TIMER_IRQ_ID);
-    
     /* 设置CPU接口优先级屏蔽 (允许所有优先级) */
-    GIC_CPU_REG(GICC_PMR) = 0xFF;
+    gicc_write(GICC_PMR, 0xFF);
     
     /* 设置二进制点 (所有位用于优先级) */
-    GIC_CPU_REG(GICC_BPR) = 0;
+    gicc_write(GICC_BPR, 0);
     
     /* 启用CPU接口 */
-    GIC_CPU_REG(GICC_CTLR) = GICC_CTLR_ENABLE;
+    gicc_write(GICC_CTLR, GICC_CTLR_ENABLE);
     
     /* 启用分发器 */
-    GIC_DIST_REG(GICD_CTLR) = GICD_CTLR_ENABLE;
+    gicd_write(GICD_CTLR, GICD_CTLR_ENABLE);
     
     uart_puts("GIC初始化完成\r\n");
+    return 0;
 }
 
-/* IRQ中断处理程序 */
-void handle_irq(void) {
+static const char *const gic_match[] = { "arm,cortex-a15-gic", "arm,gic-400", NULL };
+
+PLATFORM_DRIVER(gic_driver) = {
+    .name = "gic",
+    .match = gic_match,
+    .depends = NULL,
+    .probe = gic_probe,
+};
+
+/* 本CPU当前IRQ的寄存器帧：r0-r3、r12，[5]为被中断的PC；不在IRQ中时为NULL */
+uint32_t *irq_get_regs(void) {
+    return irq_regs[cpu_id()];
+}
+
+/* IRQ中断处理程序 (frame指向irq_handler保存的r0-r3、r12和返回地址，基准对照入口为NULL) */
+void handle_irq(uint32_t *frame) {
     /* 读取中断确认寄存器，获取中断ID */
-    uint32_t iar = GIC_CPU_REG(GICC_IAR);
+    uint32_t iar = gicc_read(GICC_IAR);
     uint32_t irq_id = iar & 0x3FF;
+    struct irq_action *action;
+    
+    idle_irq_enter();
+    irq_regs[cpu_id()] = frame;
+    
+    /* 中断处理程序整体是RCU读侧临界区 (中断中不会让出CPU) */
+    rcu_read_lock();
     
     /* 增加总中断计数 */
-    total_irqs++;
+    atomic_inc(&total_irqs);
     
     /* 增加特定中断计数 */
     if (irq_id < 1024) {
-        irq_counts[irq_id]++;
+        atomic_inc(&irq_counts[irq_id]);
     }
     
-    /* 根据中断ID分发处理 */
-    switch (irq_id) {
-        case TIMER_IRQ_ID:
-            /* 处理定时器中断 */
-            timer_handle_interrupt();
-            break;
-            
-        case 1022:
-            /* 无效中断 */
-            uart_puts("无效IRQ中断\r\n");
-            break;
-            
-        case 1023:
-            /* 伪中断 */
-            uart_puts("伪IRQ中断\r\n");
-            break;
-            
-        default:
-            /* 未知中断 */
-            uart_puts("未知IRQ: ");
-            uart_put_hex(irq_id);
-            uart_puts("\r\n");
-            break;
+    /* 根据中断ID分发处理 (定时器中断号来自设备树，不能作为case常量) */
+    if (irq_id == timer_irq_id) {
+        /* 处理定时器中断 */
+        timer_handle_interrupt();
+    } else if (irq_id == 1022) {
+        /* 无效中断 */
+        pr_warn("无效IRQ中断\n");
+    } else if (irq_id == 1023) {
+        /* 伪中断 */
+        pr_warn("伪IRQ中断\n");
+    } else if (irq_id < IRQ_HANDLER_MAX && (action = rcu_dereference(irq_actions[irq_id]))) {
+        action->handler(irq_id, action->data);
+    } else {
+        /* 未知中断 */
+        pr_err("未知IRQ: 0x%08X\n", (unsigned int)irq_id);
     }
     
     /* 发送中断结束信号 */
-    GIC_CPU_REG(GICC_EOIR) = iar;
+    gicc_write(GICC_EOIR, iar);
+    rcu_read_unlock();
+    irq_regs[cpu_id()] = NULL;
+    idle_irq_exit();
 }
 
 /* 获取GIC状态信息 */
 void gic_print_status(void) {
-    uint32_t dist_ctlr = GIC_DIST_REG(GICD_CTLR);
-    uint32_t cpu_ctlr = GIC_CPU_REG(GICC_CTLR);
-    uint32_t pmr = GIC_CPU_REG(GICC_PMR);
-    uint32_t rpr = GIC_CPU_REG(GICC_RPR);
-    uint32_t hppir = GIC_CPU_REG(GICC_HPPIR);
+    uint32_t dist_ctlr = gicd_read(GICD_CTLR);
+    uint32_t cpu_ctlr = gicc_read(GICC_CTLR);
+    uint32_t pmr = gicc_read(GICC_PMR);
+    uint32_t rpr = gicc_read(GICC_RPR);
+    uint32_t hppir = gicc_read(GICC_HPPIR);
     
     uart_puts("\r\n=== GIC状态信息 ===\r\n");
     uart_puts("分发器控制: ");
@@ -294,7 +443,7 @@ void gic_print_status(void) {
     uart_puts("\r\n");
     
     uart_puts("定时器中断状态: ");
-    uart_puts(gic_is_interrupt_enabled(TIMER_IRQ_ID) ? "启用" : "禁用");
+    uart_puts(gic_is_interrupt_enabled(timer_irq_id) ? "启用" : "禁用");
     uart_puts("\r\n");
     
     uart_puts("总中断数: ");
@@ -302,7 +451,7 @@ void gic_print_status(void) {
     uart_puts("\r\n");
     
     uart_puts("定时器中断数: ");
-    uart_put_hex(irq_counts[TIMER_IRQ_ID]);
+    uart_put_hex(irq_counts[timer_irq_id]);
     uart_puts("\r\n");
     
     uart_puts("==================\r\n");
@@ -323,7 +472,7 @@ void gic_print_interrupt_stats(void) {
             uart_puts(": ");
             uart_put_hex(irq_counts[i]);
             uart_puts(" 次");
-            if (i == TIMER_IRQ_ID) {
+            if (i == timer_irq_id) {
                 uart_puts(" (定时器)");
             }
             uart_puts("\r\n");
@@ -348,8 +497,8 @@ void gic_test_sgi(void) {
 
 /* 获取GIC版本信息 */
 void gic_print_version_info(void) {
-    uint32_t dist_iidr = GIC_DIST_REG(GICD_IIDR);
-    uint32_t cpu_iidr = GIC_CPU_REG(GICC_IIDR);
+    uint32_t dist_iidr = gicd_read(GICD_IIDR);
+    uint32_t cpu_iidr = gicc_read(GICC_IIDR);
     
     uart_puts("\r\n=== GIC版本信息 ===\r\n");
     uart_puts("分发器ID: ");
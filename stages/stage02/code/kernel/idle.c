@@ -0,0 +1,452 @@
+/*
+ * SkyOS 空闲任务、空闲调速器与CPU时间统计
+ * 文件: kernel/idle.c
+ *
+ * 1. 每个CPU一个空闲任务 (task_create_idle)，就绪队列为空时调度器切换过来；
+ *    它在屏蔽IRQ的情况下先检查/拉取任务，没有任务时才进入空闲状态
+ * 2. 调速器：预测本次空闲时长 = 最近几次空闲期的指数平均减去已经空闲的时间，
+ *    再与下一个定时事件取小，选目标驻留时间不超过它的最深状态。
+ *    RCU宽限期未完成时不停滴答 (宽限期靠滴答推进)
+ * 3. 时间统计 (CNTPCT周期)：空闲 = 各空闲状态的驻留时间减去其中处理中断的时间，
+ *    中断 = handle_irq首尾的idle_irq_enter/idle_irq_exit之间，其余为忙碌
+ * 4. 负载均值：每5秒按 load = load*e + n*(1-e) 更新1/5/15分钟平均，
+ *    n为所有CPU可运行 (排队或正在运行) 的任务数，定点数格式与Linux相同
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "idle.h"
+#include "task.h"
+#include "timer.h"
+#include "rcu.h"
+#include "atomic.h"
+#include "irqflags.h"
+#include "kprintf.h"
+#include "hal.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_hex(uint32_t value);
+extern void uart_put_dec(uint32_t value);
+extern void enable_irq(void);
+extern void disable_irq(void);
+
+#define IDLE_NR_CPUS        SCHED_NR_CPUS
+#define IDLE_TICK_US        10000       /* 10ms一个滴答 */
+#define IDLE_POLL_MAX_US    20          /* 轮询最长时间 */
+#define IDLE_HIST_BUCKETS   6
+
+/* 负载均值：每LOAD_FREQ个滴答更新一次，EXP_n = FIXED_1 / e^(5秒/n分钟) */
+#define LOAD_FREQ           500
+#define LOAD_EXP_1          1884
+#define LOAD_EXP_5          2014
+#define LOAD_EXP_15         2037
+
+enum idle_state {
+    IDLE_POLL,              /* 打开中断忙等就绪任务 */
+    IDLE_WFI,               /* wfi，保留周期滴答 */
+    IDLE_WFI_NOTICK,        /* 停掉滴答再wfi，直到下一个定时事件 */
+    IDLE_NR_STATES
+};
+
+struct idle_state_desc {
+    const char *name;
+    uint32_t target_us;     /* 驻留短于它时进入该状态不划算 */
+};
+
+static const struct idle_state_desc idle_states[IDLE_NR_STATES] = {
+    [IDLE_POLL]       = { "轮询",       0 },
+    [IDLE_WFI]        = { "wfi",        IDLE_POLL_MAX_US },
+    [IDLE_WFI_NOTICK] = { "wfi停滴答",  2 * IDLE_TICK_US },
+};
+
+/* 驻留时间分布的上界 (微秒)，最后一档不设上限 */
+static const uint32_t idle_hist_limit[IDLE_HIST_BUCKETS - 1] = {
+    10, 100, 1000, 10000, 100000
+};
+static const char *const idle_hist_name[IDLE_HIST_BUCKETS] = {
+    "<10us", "<100us", "<1ms", "<10ms", "<100ms", ">=100ms"
+};
+
+/* 每CPU状态，只由本CPU写，按缓存行对齐 */
+struct idle_cpu {
+    struct task *task;
+    uint32_t cpu;
+    uint32_t predicted_us;          /* 空闲期时长的指数平均 */
+    uint64_t start_cycles;          /* 统计起点 */
+    uint64_t idle_cycles;
+    uint64_t irq_cycles;
+    uint64_t irq_stamp;             /* 当前中断的进入时间 */
+    uint64_t period_start;          /* 本次空闲期开始 (0表示不在空闲期) */
+    uint64_t last_exit;             /* 最近一次离开空闲状态 */
+    uint64_t snap_total;            /* 上次打印时的快照 */
+    uint64_t snap_idle;
+    uint64_t snap_irq;
+    uint32_t periods;
+    uint32_t entries[IDLE_NR_STATES];
+    uint32_t misses[IDLE_NR_STATES];
+    uint32_t hist[IDLE_HIST_BUCKETS];
+} __attribute__((aligned(64)));
+
+static struct idle_cpu idle_cpus[IDLE_NR_CPUS];
+static uint32_t idle_freq_mhz = 0;
+
+/* 负载均值 (只在0号CPU的定时器中断中更新) */
+static uint32_t load_avg[3];
+static uint32_t load_ticks = 0;
+static const uint32_t load_exp[3] = { LOAD_EXP_1, LOAD_EXP_5, LOAD_EXP_15 };
+
+/* 计数器周期换算成微秒 (只用32位除法) */
+static uint32_t idle_cycles_to_us(uint64_t cycles) {
+    if (idle_freq_mhz == 0) {
+        return 0;
+    }
+    if (cycles >> 32) {
+        return 0xFFFFFFFF / idle_freq_mhz;
+    }
+    return (uint32_t)cycles / idle_freq_mhz;
+}
+
+/* part/whole的百分比，先把两者右移到25位以内避免64位除法 */
+static uint32_t idle_percent(uint64_t part, uint64_t whole) {
+    while (whole >> 25) {
+        part >>= 1;
+        whole >>= 1;
+    }
+    return whole ? (uint32_t)part * 100 / (uint32_t)whole : 0;
+}
+
+/* ===== 中断时间 ===== */
+
+void idle_irq_enter(void) {
+    idle_cpus[cpu_id()].irq_stamp = timer_get_counter();
+}
+
+void idle_irq_exit(void) {
+    struct idle_cpu *ic = &idle_cpus[cpu_id()];
+
+    ic->irq_cycles += timer_get_counter() - ic->irq_stamp;
+}
+
+/* ===== 调速器 ===== */
+
+/* 选择空闲状态，*ticks返回停滴答时到下一个定时事件的滴答数 */
+static enum idle_state idle_select(struct idle_cpu *ic, uint64_t now, uint32_t *ticks) {
+    uint32_t elapsed = idle_cycles_to_us(now - ic->period_start);
+    uint32_t next_us, expected;
+
+    *ticks = timer_next_event();
+    next_us = *ticks * IDLE_TICK_US;
+
+    /* 已经比预测空闲得久，说明预测偏短，退回用下一个定时事件 */
+    expected = ic->predicted_us > elapsed ? ic->predicted_us - elapsed : next_us;
+    if (expected > next_us) {
+        expected = next_us;
+    }
+
+    if (expected >= idle_states[IDLE_WFI_NOTICK].target_us && *ticks >= 2 && !rcu_pending()) {
+        return IDLE_WFI_NOTICK;
+    }
+    if (expected >= idle_states[IDLE_WFI].target_us) {
+        return IDLE_WFI;
+    }
+    return IDLE_POLL;
+}
+
+/* 轮询时打开中断，唤醒任务的中断处理 (或IPI) 能立即被看到 */
+static int idle_poll(uint64_t start) {
+    uint64_t limit = (uint64_t)IDLE_POLL_MAX_US * idle_freq_mhz;
+    int found = 0;
+
+    enable_irq();
+    while (timer_get_counter() - start < limit) {
+        if (sched_need_resched()) {
+            found = 1;
+            break;
+        }
+    }
+    disable_irq();
+    return found;
+}
+
+/* 在IRQ屏蔽的情况下进入一个空闲状态；wfi被挂起的中断唤醒，中断在返回后才处理 */
+static void idle_enter_state(struct idle_cpu *ic) {
+    uint64_t t0, t1, irq0;
+    uint32_t ticks, us, b;
+    enum idle_state state;
+    int miss;
+
+    t0 = timer_get_counter();
+    if (ic->period_start == 0) {
+        ic->period_start = t0;
+        ic->periods++;
+    }
+    state = idle_select(ic, t0, &ticks);
+    irq0 = ic->irq_cycles;
+
+    /* 等待期间本CPU不在RCU读侧 */
+    rcu_note_qs();
+    switch (state) {
+    case IDLE_POLL:
+        miss = !idle_poll(t0);      /* 轮询到上限仍没有任务：应该更深 */
+        break;
+    case IDLE_WFI_NOTICK:
+        timer_stop_tick(ticks);
+        cpu_dsb_wfi();
+        timer_restart_tick();
+        miss = -1;
+        break;
+    default:
+        cpu_dsb_wfi();
+        miss = -1;
+        break;
+    }
+    t1 = timer_get_counter();
+
+    ic->idle_cycles += (t1 - t0) - (ic->irq_cycles - irq0);
+    ic->last_exit = t1;
+    ic->entries[state]++;
+
+    us = idle_cycles_to_us(t1 - t0);
+    if (miss < 0) {
+        miss = us < idle_states[state].target_us;   /* 醒得太早：应该更浅 */
+    }
+    if (miss) {
+        ic->misses[state]++;
+    }
+    for (b = 0; b < IDLE_HIST_BUCKETS - 1 && us >= idle_hist_limit[b]; b++) {
+    }
+    ic->hist[b]++;
+}
+
+/* 空闲期结束 (切换到其他任务)：用整个空闲期的时长更新预测 */
+static void idle_period_end(struct idle_cpu *ic) {
+    uint32_t us;
+
+    if (ic->period_start == 0) {
+        return;
+    }
+    if (ic->last_exit > ic->period_start) {
+        us = idle_cycles_to_us(ic->last_exit - ic->period_start);
+        /* predicted = predicted * 7/8 + us/8 */
+        ic->predicted_us = ic->predicted_us - (ic->predicted_us >> 3) + (us >> 3);
+    }
+    ic->period_start = 0;
+}
+
+static void idle_task_fn(void *arg) {
+    struct idle_cpu *ic = arg;
+    uint32_t flags;
+
+    for (;;) {
+        flags = local_irq_save();
+        /* 空闲时输出积压的日志：排入的刷新工作使下面的切换找到任务 */
+        klog_kick();
+        if (sched_idle_switch()) {
+            /* 运行过其他任务后切回 */
+            idle_period_end(ic);
+        } else {
+            idle_enter_state(ic);
+        }
+        local_irq_restore(flags);
+    }
+}
+
+/* 在每个CPU上调用一次 (task_init或task_cpu_online之后) */
+void idle_init(void) {
+    uint32_t cpu = cpu_id();
+    struct idle_cpu *ic = &idle_cpus[cpu];
+
+    if (ic->task) {
+        return;
+    }
+    if (idle_freq_mhz == 0) {
+        idle_freq_mhz = timer_get_frequency() / 1000000;
+    }
+    ic->cpu = cpu;
+    ic->predicted_us = IDLE_TICK_US;
+    ic->start_cycles = timer_get_counter();
+    ic->task = task_create_idle(idle_task_fn, ic);
+    if (ic->task == NULL) {
+        uart_puts("空闲任务创建失败\r\n");
+        return;
+    }
+    uart_puts("空闲任务: CPU ");
+    uart_put_dec(cpu);
+    uart_puts(", 计数器 ");
+    uart_put_dec(idle_freq_mhz);
+    uart_puts(" MHz\r\n");
+}
+
+/* ===== 负载均值 ===== */
+
+static uint32_t calc_load(uint32_t load, uint32_t exp, uint32_t active) {
+    uint32_t newload = load * exp + active * (LOAD_FIXED_1 - exp);
+
+    if (active >= load) {
+        newload += LOAD_FIXED_1 - 1;    /* 上升时向上取整，否则永远到不了整数 */
+    }
+    return newload >> LOAD_FSHIFT;
+}
+
+/* 定时器中断中调用，ticks为本次补上的滴答数 */
+void idle_tick(uint32_t ticks) {
+    uint32_t active;
+
+    if (cpu_id() != 0) {
+        return;
+    }
+    load_ticks += ticks;
+    if (load_ticks < LOAD_FREQ) {
+        return;
+    }
+    active = sched_nr_running() * LOAD_FIXED_1;
+    /* 停滴答可能一次跨过多个周期，每个周期都按当前任务数衰减 */
+    while (load_ticks >= LOAD_FREQ) {
+        load_ticks -= LOAD_FREQ;
+        for (uint32_t i = 0; i < 3; i++) {
+            load_avg[i] = calc_load(load_avg[i], load_exp[i], active);
+        }
+    }
+}
+
+void idle_get_loadavg(uint32_t avg[3]) {
+    for (uint32_t i = 0; i < 3; i++) {
+        avg[i] = READ_ONCE(load_avg[i]);
+    }
+}
+
+/* 定点负载按 x.yy 打印 */
+static void idle_put_load(uint32_t load) {
+    uint32_t frac = ((load & (LOAD_FIXED_1 - 1)) * 100) >> LOAD_FSHIFT;
+
+    uart_put_dec(load >> LOAD_FSHIFT);
+    uart_puts(frac < 10 ? ".0" : ".");
+    uart_put_dec(frac);
+}
+
+/* 打印忙碌/中断/空闲的占比 */
+static void idle_put_usage(uint64_t total, uint64_t idle, uint64_t irq) {
+    uint64_t busy = total > idle + irq ? total - idle - irq : 0;
+
+    uart_puts("忙碌 ");
+    uart_put_dec(idle_percent(busy, total));
+    uart_puts("%, 中断 ");
+    uart_put_dec(idle_percent(irq, total));
+    uart_puts("%, 空闲 ");
+    uart_put_dec(idle_percent(idle, total));
+    uart_puts("%");
+}
+
+/* timer_print_status调用：负载均值和本CPU启动以来的时间占比 */
+void idle_print_load(void) {
+    struct idle_cpu *ic = &idle_cpus[cpu_id()];
+    uint32_t avg[3];
+
+    idle_get_loadavg(avg);
+    uart_puts("负载均值: ");
+    for (uint32_t i = 0; i < 3; i++) {
+        idle_put_load(avg[i]);
+        uart_puts(i < 2 ? " " : "\r\n");
+    }
+    if (ic->task) {
+        uart_puts("CPU时间: ");
+        idle_put_usage(timer_get_counter() - ic->start_cycles, ic->idle_cycles, ic->irq_cycles);
+        uart_puts("\r\n");
+    }
+}
+
+void idle_print_stats(void) {
+    uint64_t now = timer_get_counter();
+
+    uart_puts("\r\n=== 空闲统计 ===\r\n");
+    for (uint32_t cpu = 0; cpu < IDLE_NR_CPUS; cpu++) {
+        struct idle_cpu *ic = &idle_cpus[cpu];
+        uint64_t total, idle, irq;
+
+        if (ic->task == NULL) {
+            continue;
+        }
+        total = now - ic->start_cycles;
+        idle = ic->idle_cycles;
+        irq = ic->irq_cycles;
+
+        uart_puts("CPU ");
+        uart_put_dec(cpu);
+        uart_puts(": 空闲期 ");
+        uart_put_dec(ic->periods);
+        uart_puts(", 预测 ");
+        uart_put_dec(ic->predicted_us);
+        uart_puts(" us\r\n  启动以来: ");
+        idle_put_usage(total, idle, irq);
+        uart_puts("\r\n  最近区间: ");
+        idle_put_usage(total - ic->snap_total, idle - ic->snap_idle, irq - ic->snap_irq);
+        uart_puts("\r\n");
+        ic->snap_total = total;
+        ic->snap_idle = idle;
+        ic->snap_irq = irq;
+
+        for (uint32_t s = 0; s < IDLE_NR_STATES; s++) {
+            uart_puts("  ");
+            uart_puts(idle_states[s].name);
+            uart_puts(": 进入 ");
+            uart_put_dec(ic->entries[s]);
+            uart_puts(", 误判 ");
+            uart_put_dec(ic->misses[s]);
+            uart_puts("\r\n");
+        }
+        uart_puts("  驻留分布:");
+        for (uint32_t b = 0; b < IDLE_HIST_BUCKETS; b++) {
+            uart_puts(" ");
+            uart_puts(idle_hist_name[b]);
+            uart_puts("=");
+            uart_put_dec(ic->hist[b]);
+        }
+        uart_puts("\r\n");
+    }
+    idle_print_load();
+    uart_puts("================\r\n");
+}
+
+/* 自检：睡眠期间本CPU应处于空闲任务中，空闲时间增长、滴答按时补齐 */
+void test_idle(void) {
+    struct idle_cpu *ic = &idle_cpus[cpu_id()];
+    uint64_t idle0, t0;
+    uint32_t ticks0, ticks, pct, entries0 = 0, entries = 0;
+    int ok;
+
+    uart_puts("\r\n=== 空闲统计自检 ===\r\n");
+    if (ic->task == NULL || idle_freq_mhz == 0) {
+        uart_puts("空闲任务未创建\r\n");
+        return;
+    }
+    for (uint32_t s = 0; s < IDLE_NR_STATES; s++) {
+        entries0 += ic->entries[s];
+    }
+    idle0 = ic->idle_cycles;
+    ticks0 = get_timer_ticks();
+    t0 = timer_get_counter();
+
+    timer_delay_ms(500);
+
+    ticks = get_timer_ticks() - ticks0;
+    pct = idle_percent(ic->idle_cycles - idle0, timer_get_counter() - t0);
+    for (uint32_t s = 0; s < IDLE_NR_STATES; s++) {
+        entries += ic->entries[s];
+    }
+
+    uart_puts("500ms内: 滴答 ");
+    uart_put_dec(ticks);
+    uart_puts(", 空闲 ");
+    uart_put_dec(pct);
+    uart_puts("%, 进入空闲状态 ");
+    uart_put_dec(entries - entries0);
+    uart_puts(" 次\r\n");
+
+    /* 推迟的自检可能与其他内核线程并行，只要求空闲时间有增长 */
+    ok = ticks >= 45 && ticks <= 55 && entries != entries0 && ic->idle_cycles != idle0;
+    uart_puts("结果: ");
+    uart_puts(ok ? "通过" : "失败");
+    uart_puts("\r\n");
+    uart_puts("====================\r\n");
+}
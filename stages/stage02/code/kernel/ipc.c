@@ -0,0 +1,414 @@
+/*
+ * SkyOS 同步消息传递 (IPC)
+ * 文件: kernel/ipc.c
+ *
+ * 会合式IPC：
+ * 1. 发送时接收方已在ipc_recv中阻塞：把发送方寄存器帧中的r0-r7复制到接收方的帧，
+ *    用task_handoff直接切换到接收方 (不经过就绪队列、不打印、不转换参数)
+ * 2. 接收方未就绪：发送方挂到接收方的发送队列上阻塞，接收方下次ipc_recv时取走
+ * 3. ipc_call在消息被接收后转为等待回复；ipc_reply_recv回复后立即等待下一条消息，
+ *    没有其他发送方时直接切换回客户端，一次往返只有两次陷入和两次切换
+ * 长消息按整页复制到接收方登记的窗口 (没有MMU，不能改映射)。
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ipc.h"
+#include "task.h"
+#include "spinlock.h"
+#include "page_alloc.h"
+#include "kstring.h"
+#include "pmu.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_hex(uint32_t value);
+extern void uart_put_dec(uint32_t value);
+
+static struct spinlock ipc_lock = SPINLOCK_INIT("ipc");
+
+/* 统计 */
+static uint32_t stat_msgs = 0;
+static uint32_t stat_direct = 0;        /* 接收方已在等待，直接切换 */
+static uint32_t stat_queued = 0;        /* 发送方排队等待接收 */
+static uint32_t stat_replies = 0;
+static uint32_t stat_pages = 0;
+static uint32_t stat_errors = 0;
+
+/* 持有ipc_lock时把发送方帧s中的消息交给接收方dst，返回0或-错误码 */
+static int ipc_transfer(struct task *src, const struct syscall_regs *s, struct task *dst) {
+    struct syscall_regs *d = dst->ipc.regs;
+    uint32_t pages = IPC_TAG_PAGES(s->r1);
+
+    if (pages) {
+        if ((s->r7 & ~PAGE_MASK) || dst->ipc.win == 0 || pages > dst->ipc.win_pages) {
+            stat_errors++;
+            return -IPC_E2BIG;
+        }
+        memcpy((void *)dst->ipc.win, (const void *)s->r7, pages * PAGE_SIZE);
+        stat_pages += pages;
+    }
+    d->r0 = src->id;
+    d->r1 = s->r1;
+    d->r2 = s->r2;
+    d->r3 = s->r3;
+    d->r4 = s->r4;
+    d->r5 = s->r5;
+    d->r6 = s->r6;
+    d->r7 = pages ? dst->ipc.win : s->r7;
+    stat_msgs++;
+    return 0;
+}
+
+/*
+ * 持有ipc_lock时从当前任务的发送队列取一条匹配的消息到regs，返回是否取到。
+ * 发送方若是ipc_call则转为等待回复，否则唤醒；传递失败的发送方带错误码唤醒。
+ */
+static int ipc_take_sender(struct task *cur, struct syscall_regs *regs) {
+    struct task *s, *prev;
+
+    cur->ipc.regs = regs;
+    for (;;) {
+        prev = NULL;
+        s = cur->ipc.send_head;
+        while (s && cur->ipc.from != IPC_ANY && s->id != cur->ipc.from) {
+            prev = s;
+            s = s->ipc.send_next;
+        }
+        if (s == NULL) {
+            return 0;
+        }
+        if (prev) {
+            prev->ipc.send_next = s->ipc.send_next;
+        } else {
+            cur->ipc.send_head = s->ipc.send_next;
+        }
+        if (cur->ipc.send_tail == s) {
+            cur->ipc.send_tail = prev;
+        }
+        s->ipc.send_next = NULL;
+
+        int err = ipc_transfer(s, s->ipc.regs, cur);
+        if (err == 0 && s->ipc.want_reply) {
+            s->ipc.state = IPC_REPLY_BLOCKED;
+            s->ipc.partner = cur;
+            return 1;
+        }
+        s->ipc.state = IPC_IDLE;
+        s->ipc.regs->r0 = (uint32_t)err;
+        task_wake(s);
+        if (err == 0) {
+            return 1;
+        }
+    }
+}
+
+/* 持有ipc_lock时把当前任务设为等待消息 (调用者随后task_schedule/task_handoff) */
+static void ipc_block_recv(struct task *cur) {
+    cur->ipc.state = IPC_RECV_BLOCKED;
+    cur->state = TASK_BLOCKED;
+}
+
+static void ipc_do_send(struct syscall_regs *regs, uint32_t want_reply) {
+    struct task *cur = task_current();
+    uint32_t flags = spin_lock_irqsave(&ipc_lock);
+    struct task *dst = task_find(regs->r0);
+
+    if (dst == NULL || dst == cur) {
+        stat_errors++;
+        regs->r0 = (uint32_t)-IPC_ESRCH;
+        spin_unlock_irqrestore(&ipc_lock, flags);
+        return;
+    }
+    cur->ipc.regs = regs;
+    cur->ipc.want_reply = want_reply;
+
+    if (dst->ipc.state == IPC_RECV_BLOCKED &&
+        (dst->ipc.from == IPC_ANY || dst->ipc.from == cur->id)) {
+        int err = ipc_transfer(cur, regs, dst);
+        if (err) {
+            regs->r0 = (uint32_t)err;
+            spin_unlock_irqrestore(&ipc_lock, flags);
+            return;
+        }
+        dst->ipc.state = IPC_IDLE;
+        if (want_reply) {
+            cur->ipc.state = IPC_REPLY_BLOCKED;
+            cur->ipc.partner = dst;
+            cur->state = TASK_BLOCKED;
+        } else {
+            regs->r0 = 0;
+        }
+        stat_direct++;
+        spin_unlock(&ipc_lock);
+        task_handoff(dst);
+        local_irq_restore(flags);
+        return;
+    }
+
+    /* 接收方未就绪：排队，由接收方取走消息后唤醒或转为等待回复 */
+    cur->ipc.state = IPC_SEND_BLOCKED;
+    cur->ipc.send_next = NULL;
+    if (dst->ipc.send_tail) {
+        dst->ipc.send_tail->ipc.send_next = cur;
+    } else {
+        dst->ipc.send_head = cur;
+    }
+    dst->ipc.send_tail = cur;
+    cur->state = TASK_BLOCKED;
+    stat_queued++;
+    spin_unlock(&ipc_lock);
+    task_schedule();
+    local_irq_restore(flags);
+}
+
+/* 持有ipc_lock时把regs中的回复交给等待当前任务回复的调用方，返回该任务 */
+static struct task *ipc_do_reply(struct task *cur, struct syscall_regs *regs) {
+    struct task *c = task_find(regs->r0);
+    struct syscall_regs *d;
+
+    if (c == NULL || c->ipc.state != IPC_REPLY_BLOCKED || c->ipc.partner != cur ||
+        IPC_TAG_PAGES(regs->r1)) {
+        stat_errors++;
+        return NULL;
+    }
+    d = c->ipc.regs;
+    d->r0 = 0;
+    d->r1 = regs->r1;
+    d->r2 = regs->r2;
+    d->r3 = regs->r3;
+    d->r4 = regs->r4;
+    d->r5 = regs->r5;
+    d->r6 = regs->r6;
+    d->r7 = regs->r7;
+    c->ipc.state = IPC_IDLE;
+    c->ipc.partner = NULL;
+    stat_replies++;
+    return c;
+}
+
+/* 系统调用：发送消息，等到被接收后返回 (r0为0或-错误码) */
+void ipc_send(struct syscall_regs *regs) {
+    ipc_do_send(regs, 0);
+}
+
+/* 系统调用：发送消息并等待回复，回复消息写回r0-r7 */
+void ipc_call(struct syscall_regs *regs) {
+    ipc_do_send(regs, 1);
+}
+
+/* 系统调用：接收消息 (r0=发送方过滤，r1/r2=长消息窗口地址/页数) */
+void ipc_recv(struct syscall_regs *regs) {
+    struct task *cur = task_current();
+    uint32_t flags = spin_lock_irqsave(&ipc_lock);
+
+    cur->ipc.from = regs->r0;
+    if ((regs->r1 & ~PAGE_MASK) == 0) {
+        cur->ipc.win = regs->r1;
+        cur->ipc.win_pages = regs->r2;
+    } else {
+        cur->ipc.win = 0;
+        cur->ipc.win_pages = 0;
+    }
+    if (!ipc_take_sender(cur, regs)) {
+        ipc_block_recv(cur);
+        spin_unlock(&ipc_lock);
+        task_schedule();
+        local_irq_restore(flags);
+        return;
+    }
+    spin_unlock_irqrestore(&ipc_lock, flags);
+}
+
+/* 系统调用：回复r0指定的调用方 (只能是短消息)，不阻塞 */
+void ipc_reply(struct syscall_regs *regs) {
+    struct task *cur = task_current();
+    uint32_t flags = spin_lock_irqsave(&ipc_lock);
+    struct task *c = ipc_do_reply(cur, regs);
+
+    regs->r0 = c ? 0 : (uint32_t)-IPC_EINVAL;
+    spin_unlock_irqrestore(&ipc_lock, flags);
+    if (c) {
+        task_wake(c);
+    }
+}
+
+/*
+ * 系统调用：回复r0指定的调用方，然后接收下一条消息 (窗口沿用上次ipc_recv的)。
+ * 服务端的主循环只用这一个调用；没有排队的发送方时直接切换回调用方。
+ */
+void ipc_reply_recv(struct syscall_regs *regs) {
+    struct task *cur = task_current();
+    uint32_t flags = spin_lock_irqsave(&ipc_lock);
+    struct task *c = ipc_do_reply(cur, regs);
+
+    if (c == NULL) {
+        regs->r0 = (uint32_t)-IPC_EINVAL;
+        spin_unlock_irqrestore(&ipc_lock, flags);
+        return;
+    }
+    cur->ipc.from = IPC_ANY;
+    if (ipc_take_sender(cur, regs)) {
+        spin_unlock(&ipc_lock);
+        task_wake(c);
+        local_irq_restore(flags);
+        return;
+    }
+    ipc_block_recv(cur);
+    stat_direct++;
+    spin_unlock(&ipc_lock);
+    task_handoff(c);
+    local_irq_restore(flags);
+}
+
+void ipc_print_stats(void) {
+    uart_puts("\r\n=== IPC统计 ===\r\n");
+    uart_puts("消息: ");
+    uart_put_dec(stat_msgs);
+    uart_puts(", 直接切换: ");
+    uart_put_dec(stat_direct);
+    uart_puts(", 排队: ");
+    uart_put_dec(stat_queued);
+    uart_puts(", 回复: ");
+    uart_put_dec(stat_replies);
+    uart_puts("\r\n");
+    uart_puts("长消息页: ");
+    uart_put_dec(stat_pages);
+    uart_puts(", 错误: ");
+    uart_put_dec(stat_errors);
+    uart_puts("\r\n");
+    uart_puts("===============\r\n");
+}
+
+/* 自检：回显服务端 + 乒乓往返基准 */
+#define IPC_TEST_ROUNDS     1000
+#define IPC_TEST_WIN_PAGES  2
+#define IPC_TEST_ECHO       1
+#define IPC_TEST_SUM        2
+#define IPC_TEST_QUIT       3
+
+static void *ipc_test_win;
+
+/* 回显服务端：ECHO把数据字各加一，SUM返回长消息窗口中各字之和 */
+static void ipc_test_server(void *arg) {
+    struct ipc_msg m = { { 0 } };
+
+    (void)arg;
+    m.w[0] = IPC_ANY;
+    m.w[1] = (uint32_t)ipc_test_win;
+    m.w[2] = IPC_TEST_WIN_PAGES;
+    ipc_syscall(SYS_IPC_RECV, &m);
+    for (;;) {
+        uint32_t label = IPC_TAG_LABEL(m.w[1]);
+        uint32_t pages = IPC_TAG_PAGES(m.w[1]);
+
+        if (label == IPC_TEST_SUM) {
+            const uint32_t *p = (const uint32_t *)m.w[7];
+            uint32_t sum = 0;
+            for (uint32_t i = 0; i < pages * PAGE_SIZE / 4; i++) {
+                sum += p[i];
+            }
+            m.w[2] = sum;
+        } else {
+            for (uint32_t i = 2; i < IPC_MSG_WORDS; i++) {
+                m.w[i]++;
+            }
+        }
+        m.w[1] = IPC_TAG(label, 0);
+        if (label == IPC_TEST_QUIT) {
+            ipc_syscall(SYS_IPC_REPLY, &m);
+            return;
+        }
+        ipc_syscall(SYS_IPC_REPLY_RECV, &m);
+    }
+}
+
+static uint32_t ipc_test_cycles(const struct pmu_counts *start) {
+    struct pmu_counts end;
+
+    pmu_read(&end);
+    return (uint32_t)(end.cycles - start->cycles);
+}
+
+void test_ipc(void) {
+    struct task *srv;
+    struct ipc_msg m = { { 0 } };
+    struct pmu_counts start;
+    uint32_t *page, expect, cycles;
+    int ok = 1;
+
+    uart_puts("\r\n=== IPC自检 ===\r\n");
+    ipc_test_win = alloc_pages(IPC_TEST_WIN_PAGES);
+    page = alloc_page();
+    srv = ipc_test_win && page ? task_create("ipc-srv", ipc_test_server, NULL) : NULL;
+    if (srv == NULL) {
+        uart_puts("无法创建服务端\r\n===============\r\n");
+        return;
+    }
+
+    /* 短消息：数据字逐个加一 */
+    m.w[0] = srv->id;
+    m.w[1] = IPC_TAG(IPC_TEST_ECHO, 0);
+    for (uint32_t i = 2; i < IPC_MSG_WORDS; i++) {
+        m.w[i] = i * 100;
+    }
+    ipc_syscall(SYS_IPC_CALL, &m);
+    ok &= m.w[0] == 0;
+    for (uint32_t i = 2; i < IPC_MSG_WORDS; i++) {
+        ok &= m.w[i] == i * 100 + 1;
+    }
+
+    /* 错误：目标不存在、长消息超过窗口 */
+    m.w[0] = 0xDEAD;
+    ipc_syscall(SYS_IPC_CALL, &m);
+    ok &= m.w[0] == (uint32_t)-IPC_ESRCH;
+    m.w[0] = srv->id;
+    m.w[1] = IPC_TAG(IPC_TEST_SUM, IPC_TEST_WIN_PAGES + 1);
+    m.w[7] = (uint32_t)page;
+    ipc_syscall(SYS_IPC_CALL, &m);
+    ok &= m.w[0] == (uint32_t)-IPC_E2BIG;
+    uart_puts("语义检查: ");
+    uart_puts(ok ? "通过" : "失败");
+    uart_puts("\r\n");
+
+    /* 乒乓：短消息往返 */
+    pmu_read(&start);
+    for (uint32_t n = 0; n < IPC_TEST_ROUNDS; n++) {
+        m.w[0] = srv->id;
+        m.w[1] = IPC_TAG(IPC_TEST_ECHO, 0);
+        ipc_syscall(SYS_IPC_CALL, &m);
+    }
+    cycles = ipc_test_cycles(&start);
+    uart_puts("短消息往返 (r0-r7): ");
+    uart_put_dec(cycles / IPC_TEST_ROUNDS);
+    uart_puts(" 周期\r\n");
+
+    /* 长消息：每次复制一页到服务端窗口 */
+    expect = 0;
+    for (uint32_t i = 0; i < PAGE_SIZE / 4; i++) {
+        page[i] = i;
+        expect += i;
+    }
+    pmu_read(&start);
+    for (uint32_t n = 0; n < IPC_TEST_ROUNDS / 10; n++) {
+        m.w[0] = srv->id;
+        m.w[1] = IPC_TAG(IPC_TEST_SUM, 1);
+        m.w[7] = (uint32_t)page;
+        ipc_syscall(SYS_IPC_CALL, &m);
+        ok &= m.w[0] == 0 && m.w[2] == expect;
+    }
+    cycles = ipc_test_cycles(&start);
+    uart_puts("长消息往返 (1页): ");
+    uart_put_dec(cycles / (IPC_TEST_ROUNDS / 10));
+    uart_puts(" 周期\r\n");
+
+    m.w[0] = srv->id;
+    m.w[1] = IPC_TAG(IPC_TEST_QUIT, 0);
+    ipc_syscall(SYS_IPC_CALL, &m);
+
+    free_page(page);
+    free_pages(ipc_test_win, IPC_TEST_WIN_PAGES);
+    uart_puts("结果: ");
+    uart_puts(ok ? "通过" : "失败");
+    uart_puts("\r\n===============\r\n");
+}
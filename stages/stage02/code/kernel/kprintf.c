@@ -0,0 +1,650 @@
+/*
+ * SkyOS 内核日志 (kprintf)
+ * 文件: kernel/kprintf.c
+ *
+ * 1. 格式化只用32位除法：64位十进制按16位分段做长除法 (内核不链接libgcc)
+ * 2. 写者：屏蔽IRQ后在本CPU缓冲区格式化，atomic_add_return取全局序号，
+ *    序号对环大小取模得到槽位；槽的state先写"序号<<1" (写入中)，
+ *    填完内容后写"序号<<1 | 1" (已发布)。写者之间不加锁
+ * 3. 读者 (控制台刷新，持console_lock)：按序号依次读取，state不是期望的已发布
+ *    序号时，序号更大说明已被覆盖 (计入丢弃)，否则写者尚未发布，下次再读；
+ *    拷贝后再检查一次state，拷贝期间被覆盖的同样丢弃
+ * 4. 记录开头的级别、CPU号和滴答时间戳只在klog_dump中显示，控制台只输出正文，
+ *    和原来uart_puts的输出格式一致
+ * 5. klog_ring在.noinit段 (启动时不清零)，魔数有效就说明是热复位，
+ *    先打印上次启动的最后几条记录再重新初始化；调试器也可以按符号读取
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include "kprintf.h"
+#include "kstring.h"
+#include "atomic.h"
+#include "irqflags.h"
+#include "spinlock.h"
+#include "workqueue.h"
+#include "timer.h"
+#include "hal.h"
+
+/* 外部函数声明 */
+extern void uart_putc(char c);
+extern void uart_puts(const char *str);
+extern void uart_put_hex(uint32_t value);
+extern int timer_register_callback(void (*fn)(void *data), void *data, uint32_t period_ticks);
+
+#define LOG_MAGIC           0x4B4C4F47      /* "KLOG" */
+#define LOG_NR_CPUS         NR_CPUS
+#define LOG_FLUSH_PERIOD    20              /* 定时器兜底刷新周期 (滴答, 200ms) */
+#define LOG_PREV_DUMP       16              /* 热复位后打印上次启动的记录数 */
+#define LOG_BENCH_LOOPS     64
+
+#define LOG_STATE(seq, done)    (((seq) << 1) | (done))
+
+struct log_record {
+    volatile uint32_t state;    /* 序号<<1 | 已发布 */
+    uint32_t ts;                /* 写入时的滴答数 */
+    uint8_t level;
+    uint8_t cpu;
+    uint16_t len;
+    char text[LOG_TEXT_MAX];    /* 不以'\0'结尾 */
+};
+
+struct log_ring {
+    uint32_t magic;
+    uint32_t record_size;
+    uint32_t nr_records;
+    volatile uint32_t next_seq; /* 下一个要分配的序号 */
+    uint32_t reserved[12];
+    struct log_record records[LOG_NR_RECORDS];
+};
+
+/* 每CPU格式化缓冲区，屏蔽IRQ时使用 (多留一个字节，截断时能看到被截掉的第一个字节) */
+struct klog_cpu {
+    char buf[LOG_TEXT_MAX + 2];
+    uint32_t records;
+    uint32_t truncated;
+} __attribute__((aligned(64)));
+
+struct log_ring klog_ring __attribute__((section(".noinit"), aligned(64)));
+
+static struct klog_cpu klog_cpus[LOG_NR_CPUS];
+static struct spinlock console_lock = SPINLOCK_INIT("console");
+static uint32_t console_seq = 0;            /* 下一条要输出到控制台的记录 */
+static uint32_t console_level = LOGLEVEL_DEBUG;
+static char console_last = '\n';
+static volatile uint32_t klog_ready = 0;
+static volatile uint32_t klog_async = 0;
+static volatile uint32_t klog_oops = 0;
+
+static void klog_flush_work_fn(struct work_struct *work);
+static struct work_struct klog_flush_work = WORK_INIT(klog_flush_work_fn);
+
+/* 统计 */
+static uint32_t stat_printed = 0;
+static uint32_t stat_dropped = 0;
+static uint32_t stat_sync_flushes = 0;
+static uint32_t stat_async_flushes = 0;
+static uint32_t stat_flush_busy = 0;        /* 刷新时控制台正被其他上下文占用 */
+static uint32_t stat_prev_records = 0;      /* 上次启动留下的记录数 */
+
+/* ===== 格式化 ===== */
+
+struct kfmt_out {
+    char *buf;
+    size_t size;
+    size_t pos;
+};
+
+#define KFMT_LEFT       (1 << 0)
+#define KFMT_ZERO       (1 << 1)
+#define KFMT_ALT        (1 << 2)
+#define KFMT_UPPER      (1 << 3)
+
+static void kfmt_putc(struct kfmt_out *o, char c) {
+    if (o->pos + 1 < o->size) {
+        o->buf[o->pos] = c;
+    }
+    o->pos++;
+}
+
+static void kfmt_pad(struct kfmt_out *o, char c, int n) {
+    while (n-- > 0) {
+        kfmt_putc(o, c);
+    }
+}
+
+/* *v /= 10，返回余数：按16位分段，每段的被除数都不超过32位 */
+static uint32_t kfmt_divmod10(uint64_t *v) {
+    uint32_t hi = (uint32_t)(*v >> 32), lo = (uint32_t)*v;
+    uint32_t part, q3, q2, q1, q0, r;
+
+    part = hi >> 16;            q3 = part / 10; r = part % 10;
+    part = (r << 16) | (hi & 0xFFFF); q2 = part / 10; r = part % 10;
+    part = (r << 16) | (lo >> 16);    q1 = part / 10; r = part % 10;
+    part = (r << 16) | (lo & 0xFFFF); q0 = part / 10; r = part % 10;
+    *v = ((uint64_t)((q3 << 16) | q2) << 32) | ((q1 << 16) | q0);
+    return r;
+}
+
+static void kfmt_number(struct kfmt_out *o, uint64_t value, uint32_t base, int neg,
+                        uint32_t flags, int width) {
+    const char *digits = (flags & KFMT_UPPER) ? "0123456789ABCDEF" : "0123456789abcdef";
+    char tmp[24];
+    int n = 0, len;
+
+    do {
+        if (base == 16) {
+            tmp[n++] = digits[value & 0xF];
+            value >>= 4;
+        } else if ((value >> 32) == 0) {
+            tmp[n++] = digits[(uint32_t)value % 10];
+            value = (uint32_t)value / 10;
+        } else {
+            tmp[n++] = digits[kfmt_divmod10(&value)];
+        }
+    } while (value);
+
+    len = n + (neg ? 1 : 0) + ((flags & KFMT_ALT) ? 2 : 0);
+    if (!(flags & (KFMT_LEFT | KFMT_ZERO))) {
+        kfmt_pad(o, ' ', width - len);
+    }
+    if (neg) {
+        kfmt_putc(o, '-');
+    }
+    if (flags & KFMT_ALT) {
+        kfmt_putc(o, '0');
+        kfmt_putc(o, 'x');
+    }
+    if ((flags & (KFMT_LEFT | KFMT_ZERO)) == KFMT_ZERO) {
+        kfmt_pad(o, '0', width - len);
+    }
+    while (n > 0) {
+        kfmt_putc(o, tmp[--n]);
+    }
+    if (flags & KFMT_LEFT) {
+        kfmt_pad(o, ' ', width - len);
+    }
+}
+
+static void kfmt_string(struct kfmt_out *o, const char *s, uint32_t flags, int width, int prec) {
+    int len = 0;
+
+    if (s == NULL) {
+        s = "(null)";
+    }
+    while (s[len] && (prec < 0 || len < prec)) {
+        len++;
+    }
+    if (!(flags & KFMT_LEFT)) {
+        kfmt_pad(o, ' ', width - len);
+    }
+    for (int i = 0; i < len; i++) {
+        kfmt_putc(o, s[i]);
+    }
+    if (flags & KFMT_LEFT) {
+        kfmt_pad(o, ' ', width - len);
+    }
+}
+
+/* 返回完整输出的长度 (不含'\0')，超过size-1的部分被截断，与vsnprintf相同 */
+int kvsnprintf(char *buf, size_t size, const char *fmt, va_list ap) {
+    struct kfmt_out o = { buf, size, 0 };
+
+    for (; *fmt; fmt++) {
+        uint32_t flags = 0;
+        int width = 0, prec = -1, lng = 0;
+        uint64_t uval;
+        int64_t sval;
+
+        if (*fmt != '%') {
+            kfmt_putc(&o, *fmt);
+            continue;
+        }
+        /* 标志 */
+        for (fmt++; ; fmt++) {
+            if (*fmt == '-') {
+                flags |= KFMT_LEFT;
+            } else if (*fmt == '0') {
+                flags |= KFMT_ZERO;
+            } else if (*fmt == '#') {
+                flags |= KFMT_ALT;
+            } else {
+                break;
+            }
+        }
+        /* 宽度和精度 */
+        if (*fmt == '*') {
+            width = va_arg(ap, int);
+            if (width < 0) {
+                flags |= KFMT_LEFT;
+                width = -width;
+            }
+            fmt++;
+        } else {
+            while (*fmt >= '0' && *fmt <= '9') {
+                width = width * 10 + (*fmt++ - '0');
+            }
+        }
+        if (*fmt == '.') {
+            prec = 0;
+            if (*++fmt == '*') {
+                prec = va_arg(ap, int);
+                fmt++;
+            } else {
+                while (*fmt >= '0' && *fmt <= '9') {
+                    prec = prec * 10 + (*fmt++ - '0');
+                }
+            }
+        }
+        /* 长度修饰：只有ll是64位 */
+        while (*fmt == 'l' || *fmt == 'h' || *fmt == 'z') {
+            if (*fmt == 'l') {
+                lng++;
+            }
+            fmt++;
+        }
+
+        switch (*fmt) {
+        case 'd':
+        case 'i':
+            sval = lng >= 2 ? va_arg(ap, int64_t) : va_arg(ap, int32_t);
+            uval = sval < 0 ? 0 - (uint64_t)sval : (uint64_t)sval;
+            kfmt_number(&o, uval, 10, sval < 0, flags & ~KFMT_ALT, width);
+            break;
+        case 'u':
+            uval = lng >= 2 ? va_arg(ap, uint64_t) : va_arg(ap, uint32_t);
+            kfmt_number(&o, uval, 10, 0, flags & ~KFMT_ALT, width);
+            break;
+        case 'X':
+            flags |= KFMT_UPPER;
+            /* fall through */
+        case 'x':
+            uval = lng >= 2 ? va_arg(ap, uint64_t) : va_arg(ap, uint32_t);
+            kfmt_number(&o, uval, 16, 0, flags, width);
+            break;
+        case 'p':
+            /* 与uart_put_hex相同：0x加8位大写十六进制 */
+            uval = (uint32_t)va_arg(ap, void *);
+            kfmt_number(&o, uval, 16, 0, KFMT_ALT | KFMT_ZERO | KFMT_UPPER, 10);
+            break;
+        case 's':
+            kfmt_string(&o, va_arg(ap, const char *), flags, width, prec);
+            break;
+        case 'c':
+            kfmt_putc(&o, (char)va_arg(ap, int));
+            break;
+        case '%':
+            kfmt_putc(&o, '%');
+            break;
+        case '\0':
+            fmt--;      /* 格式串以单个%结尾 */
+            break;
+        default:
+            kfmt_putc(&o, '%');
+            kfmt_putc(&o, *fmt);
+            break;
+        }
+    }
+    if (size) {
+        buf[o.pos < size ? o.pos : size - 1] = '\0';
+    }
+    return (int)o.pos;
+}
+
+int ksnprintf(char *buf, size_t size, const char *fmt, ...) {
+    va_list ap;
+    int len;
+
+    va_start(ap, fmt);
+    len = kvsnprintf(buf, size, fmt, ap);
+    va_end(ap);
+    return len;
+}
+
+/* ===== 日志环 ===== */
+
+/* 把'\n'换成"\r\n"输出到串口 */
+static void klog_console_write(const char *text, uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) {
+        if (text[i] == '\n' && console_last != '\r') {
+            uart_putc('\r');
+        }
+        uart_putc(text[i]);
+        console_last = text[i];
+    }
+}
+
+/* 记录能容纳的长度，不截断在UTF-8多字节字符中间 */
+static uint32_t klog_text_len(const struct klog_cpu *kc, uint32_t len) {
+    if (len > LOG_TEXT_MAX) {
+        len = LOG_TEXT_MAX;
+        while (len > 0 && ((uint8_t)kc->buf[len] & 0xC0) == 0x80) {
+            len--;
+        }
+    }
+    return len;
+}
+
+/* 写入一条记录 (已屏蔽IRQ)，返回序号 */
+static uint32_t klog_store(struct klog_cpu *kc, uint32_t cpu, uint32_t level, uint32_t len) {
+    struct log_record *r;
+    uint32_t seq;
+
+    if (len > LOG_TEXT_MAX) {
+        len = klog_text_len(kc, len);
+        kc->truncated++;
+    }
+    seq = atomic_add_return(&klog_ring.next_seq, 1) - 1;
+    r = &klog_ring.records[seq & (LOG_NR_RECORDS - 1)];
+    WRITE_ONCE(r->state, LOG_STATE(seq, 0));
+    smp_wmb();
+    r->ts = get_timer_ticks();
+    r->level = (uint8_t)level;
+    r->cpu = (uint8_t)cpu;
+    r->len = (uint16_t)len;
+    memcpy(r->text, kc->buf, len);
+    smp_wmb();
+    WRITE_ONCE(r->state, LOG_STATE(seq, 1));
+    kc->records++;
+    return seq;
+}
+
+int kprintf(const char *fmt, ...) {
+    uint32_t level = LOGLEVEL_DEFAULT;
+    uint32_t flags, cpu;
+    struct klog_cpu *kc;
+    va_list ap;
+    int len;
+
+    if (fmt[0] == KERN_SOH[0] && fmt[1] >= '0' && fmt[1] <= '7') {
+        level = fmt[1] - '0';
+        fmt += 2;
+    }
+
+    flags = local_irq_save();
+    cpu = cpu_id();
+    kc = &klog_cpus[cpu];
+    va_start(ap, fmt);
+    len = kvsnprintf(kc->buf, sizeof(kc->buf), fmt, ap);
+    va_end(ap);
+
+    if (!klog_ready) {
+        /* klog_init之前直接输出 */
+        if (level < console_level) {
+            klog_console_write(kc->buf, klog_text_len(kc, (uint32_t)len));
+        }
+        local_irq_restore(flags);
+        return len;
+    }
+    klog_store(kc, cpu, level, (uint32_t)len);
+    local_irq_restore(flags);
+
+    if (!klog_async || level <= LOGLEVEL_ERR || klog_oops) {
+        stat_sync_flushes++;
+        klog_flush();
+    }
+    return len;
+}
+
+/* 把尚未输出的记录写到串口 (调用者持有console_lock或系统已崩溃) */
+static void klog_flush_locked(void) {
+    char text[LOG_TEXT_MAX];
+    struct log_record *r;
+    uint32_t head, seq, state, level, len;
+
+    for (;;) {
+        head = READ_ONCE(klog_ring.next_seq);
+        seq = console_seq;
+        if (seq == head) {
+            break;
+        }
+        if (head - seq > LOG_NR_RECORDS) {
+            /* 读者落后超过一圈 */
+            stat_dropped += head - seq - LOG_NR_RECORDS;
+            seq = head - LOG_NR_RECORDS;
+        }
+        r = &klog_ring.records[seq & (LOG_NR_RECORDS - 1)];
+        state = READ_ONCE(r->state);
+        smp_rmb();
+        if (state != LOG_STATE(seq, 1)) {
+            if ((int32_t)(state - LOG_STATE(seq, 0)) >= 2) {
+                stat_dropped++;     /* 槽已被更新的记录占用 */
+                console_seq = seq + 1;
+                continue;
+            }
+            console_seq = seq;
+            break;                  /* 写者尚未发布 */
+        }
+        level = r->level;
+        len = r->len < LOG_TEXT_MAX ? r->len : LOG_TEXT_MAX;
+        memcpy(text, r->text, len);
+        smp_rmb();
+        console_seq = seq + 1;
+        if (READ_ONCE(r->state) != state) {
+            stat_dropped++;         /* 拷贝期间被覆盖 */
+            continue;
+        }
+        if (level < console_level) {
+            klog_console_write(text, len);
+            stat_printed++;
+        }
+    }
+}
+
+/* 把日志环中的新记录输出到串口；其他上下文正在输出时由它负责输出 */
+void klog_flush(void) {
+    /* 只用trylock，中断中调用也不会与被打断的持锁者死锁，输出时不必屏蔽IRQ */
+    if (!spin_trylock(&console_lock)) {
+        stat_flush_busy++;
+        return;
+    }
+    klog_flush_locked();
+    spin_unlock(&console_lock);
+}
+
+static int klog_pending(void) {
+    return READ_ONCE(klog_ring.next_seq) != console_seq;
+}
+
+static void klog_flush_work_fn(struct work_struct *work) {
+    (void)work;
+    stat_async_flushes++;
+    klog_flush();
+}
+
+/* 空闲任务和定时器调用：有未输出的记录时排入刷新工作 */
+void klog_kick(void) {
+    if (klog_async && klog_pending() && !(READ_ONCE(klog_flush_work.state) & WORK_PENDING)) {
+        queue_work(&klog_flush_work);
+    }
+}
+
+static void klog_timer_flush(void *data) {
+    (void)data;
+    if (klog_pending() && queue_work(&klog_flush_work) < 0) {
+        klog_flush();
+    }
+}
+
+/* 崩溃时调用：之后所有kprintf同步输出，持锁者可能就是崩溃的上下文，不再等锁 */
+void klog_panic(void) {
+    uint32_t locked;
+
+    klog_oops = 1;
+    if (!klog_ready) {
+        return;
+    }
+    locked = spin_trylock(&console_lock);
+    klog_flush_locked();
+    if (locked) {
+        spin_unlock(&console_lock);
+    }
+}
+
+/* 无锁地打印日志环中最近max条已发布的记录 (带时间戳、级别和CPU号) */
+void klog_dump(uint32_t max) {
+    char line[32];
+    uint32_t head = READ_ONCE(klog_ring.next_seq);
+    uint32_t n = head < max ? head : max;
+
+    if (n > LOG_NR_RECORDS) {
+        n = LOG_NR_RECORDS;
+    }
+    for (uint32_t seq = head - n; seq != head; seq++) {
+        struct log_record *r = &klog_ring.records[seq & (LOG_NR_RECORDS - 1)];
+        uint32_t len = r->len < LOG_TEXT_MAX ? r->len : LOG_TEXT_MAX;
+
+        if (r->state != LOG_STATE(seq, 1)) {
+            continue;
+        }
+        ksnprintf(line, sizeof(line), "[%5u.%02u] <%u> cpu%u ",
+                  (unsigned int)(r->ts / 100), (unsigned int)(r->ts % 100), r->level & 7, r->cpu);
+        klog_console_write(line, strlen(line));
+        klog_console_write(r->text, len);
+        if (len == 0 || r->text[len - 1] != '\n') {
+            klog_console_write("\n", 1);
+        }
+    }
+}
+
+/* 串口可用后尽早调用 */
+void klog_init(void) {
+    struct log_ring *ring = &klog_ring;
+
+    if (ring->magic == LOG_MAGIC && ring->record_size == LOG_RECORD_SIZE &&
+        ring->nr_records == LOG_NR_RECORDS && ring->next_seq != 0) {
+        stat_prev_records = ring->next_seq;
+        uart_puts("上次启动的最后日志:\r\n");
+        klog_dump(LOG_PREV_DUMP);
+        uart_puts("--------------------------------------------\r\n");
+    }
+    memset(ring, 0, sizeof(*ring));
+    ring->magic = LOG_MAGIC;
+    ring->record_size = LOG_RECORD_SIZE;
+    ring->nr_records = LOG_NR_RECORDS;
+    console_seq = 0;
+    smp_wmb();
+    klog_ready = 1;
+}
+
+/* 工作队列和定时器就绪后调用，此后普通级别的日志由刷新工作输出 */
+void klog_start_async(void) {
+    timer_register_callback(klog_timer_flush, NULL, LOG_FLUSH_PERIOD);
+    klog_async = 1;
+    kprintf("内核日志: %u 条 x %u 字节, 异步输出到控制台\n",
+            LOG_NR_RECORDS, LOG_RECORD_SIZE);
+}
+
+/* 级别数值小于level的记录输出到控制台 */
+void klog_set_console_level(uint32_t level) {
+    console_level = level;
+}
+
+void klog_print_stats(void) {
+    uint32_t truncated = 0;
+
+    for (uint32_t cpu = 0; cpu < LOG_NR_CPUS; cpu++) {
+        truncated += klog_cpus[cpu].truncated;
+    }
+    uart_puts("\r\n=== 内核日志统计 ===\r\n");
+    kprintf(KERN_NOTICE "记录: %u, 已输出: %u, 未输出: %u, 丢弃: %u, 截断: %u\n",
+            (unsigned int)klog_ring.next_seq, (unsigned int)stat_printed,
+            (unsigned int)(klog_ring.next_seq - console_seq), (unsigned int)stat_dropped,
+            (unsigned int)truncated);
+    kprintf(KERN_NOTICE "同步刷新: %u, 异步刷新: %u, 控制台忙: %u, 上次启动: %u 条\n",
+            (unsigned int)stat_sync_flushes, (unsigned int)stat_async_flushes,
+            (unsigned int)stat_flush_busy, (unsigned int)stat_prev_records);
+    for (uint32_t cpu = 0; cpu < LOG_NR_CPUS; cpu++) {
+        if (klog_cpus[cpu].records) {
+            kprintf(KERN_NOTICE "  CPU %u: %u 条\n", (unsigned int)cpu,
+                    (unsigned int)klog_cpus[cpu].records);
+        }
+    }
+    klog_flush();
+    uart_puts("====================\r\n");
+}
+
+/* ===== 自检 ===== */
+
+static int kfmt_check(const char *got, int len, const char *expect) {
+    if (strcmp(got, expect) == 0 && len == (int)strlen(expect)) {
+        return 1;
+    }
+    uart_puts("  格式化不符: \"");
+    uart_puts(got);
+    uart_puts("\" != \"");
+    uart_puts(expect);
+    uart_puts("\"\r\n");
+    return 0;
+}
+
+/* 自检：格式化结果、截断、日志环记录，以及写入日志与直接写串口的开销 */
+void test_kprintf(void) {
+    char buf[64], small[8];
+    uint64_t start;
+    uint32_t seq0, t_log, t_uart, mhz, ok = 1, len;
+    struct log_record *r;
+
+    uart_puts("\r\n=== kprintf自检 ===\r\n");
+
+    len = ksnprintf(buf, sizeof(buf), "%d|%5d|%-5d|%05d|%d", -42, 42, 42, 42, (int)0x80000000);
+    ok &= kfmt_check(buf, len, "-42|   42|42   |00042|-2147483648");
+    len = ksnprintf(buf, sizeof(buf), "%u %x %X %08X %#x", 4000000000u, 0xbeefu, 0xbeefu, 0x1234u, 255u);
+    ok &= kfmt_check(buf, len, "4000000000 beef BEEF 00001234 0xff");
+    len = ksnprintf(buf, sizeof(buf), "%llu %llx %lld", 18446744073709551615ull,
+                    0x123456789abcdefull, -9000000000ll);
+    ok &= kfmt_check(buf, len, "18446744073709551615 123456789abcdef -9000000000");
+    len = ksnprintf(buf, sizeof(buf), "%s|%.3s|%-4s|%c%%|%p", "abc", "abcdef", "xy", 'z', (void *)0x1000);
+    ok &= kfmt_check(buf, len, "abc|abc|xy  |z%|0x00001000");
+    len = ksnprintf(small, sizeof(small), "%s", "0123456789");
+    ok &= len == 10 && strcmp(small, "0123456") == 0;
+    uart_puts("格式化: ");
+    uart_puts(ok ? "通过" : "失败");
+    uart_puts("\r\n");
+
+    if (!klog_ready) {
+        uart_puts("日志环未初始化\r\n");
+        return;
+    }
+
+    /* 调试级别只进日志环，不输出到控制台 */
+    mhz = timer_get_frequency() / 1000000;
+    seq0 = READ_ONCE(klog_ring.next_seq);
+    start = timer_get_counter();
+    for (uint32_t i = 0; i < LOG_BENCH_LOOPS; i++) {
+        kprintf(KERN_DEBUG "kprintf自检 %u: ticks=%u\n", (unsigned int)i,
+                (unsigned int)get_timer_ticks());
+    }
+    t_log = (uint32_t)(timer_get_counter() - start);
+
+    /* 其他CPU/中断可能同时写日志，只检查数量下限和本CPU写的最后一条 */
+    len = READ_ONCE(klog_ring.next_seq) - seq0;
+    ok &= len >= LOG_BENCH_LOOPS;
+    for (uint32_t seq = seq0 + len; seq != seq0; seq--) {
+        r = &klog_ring.records[(seq - 1) & (LOG_NR_RECORDS - 1)];
+        if (r->level == LOGLEVEL_DEBUG && r->len > 0 && r->text[0] == 'k') {
+            ksnprintf(buf, sizeof(buf), "kprintf自检 %u:", LOG_BENCH_LOOPS - 1);
+            ok &= r->state == LOG_STATE(seq - 1, 1) && memcmp(r->text, buf, strlen(buf)) == 0;
+            break;
+        }
+    }
+
+    /* 同样内容直接写串口 (原来的方式) */
+    start = timer_get_counter();
+    uart_puts("kprintf自检: 直接输出 ticks=");
+    uart_put_hex(get_timer_ticks());
+    uart_puts("\r\n");
+    t_uart = (uint32_t)(timer_get_counter() - start);
+
+    if (mhz) {
+        kprintf("写日志环: 每条 %u ns, 直接写串口: 每条 %u ns\n",
+                (unsigned int)(t_log / LOG_BENCH_LOOPS * 1000 / mhz),
+                (unsigned int)(t_uart * 1000 / mhz));
+    }
+    klog_flush();
+    uart_puts("结果: ");
+    uart_puts(ok ? "通过" : "失败");
+    uart_puts("\r\n");
+    uart_puts("====================\r\n");
+}
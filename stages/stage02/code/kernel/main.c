@@ -7,32 +7,56 @@
  * 1. 初始化UART串口
  * 2. 演示异常处理机制
  * 3. 测试系统调用功能
- * 4. 初始化定时器和GIC
- * 5. 基础的内核主循环
+ * 4. 通过平台驱动模型探测GIC、定时器和块设备
+ * 5. 记录启动各阶段耗时；fastboot时把演示和自检推迟到主循环开始之后
+ * 6. 基础的内核主循环
  */
 
 #include <stdint.h>
+#include <stddef.h>
+#include "vfs.h"
+#include "syscall.h"
+#include "fdt.h"
+#include "driver.h"
+#include "pmu.h"
+#include "task.h"
+#include "profiler.h"
+#include "bootprof.h"
+#include "kstring.h"
+#include "fpu.h"
+#include "spinlock.h"
+#include "rcu.h"
+#include "futex.h"
+#include "ipc.h"
+#include "pipe.h"
+#include "ring.h"
+#include "workqueue.h"
+#include "vdso.h"
+#include "idle.h"
+#include "kprintf.h"
+#include "hal.h"
 
-/* QEMU virt machine UART0 基址 */
-#define UART0_BASE      0x09000000
-#define UART_DR         (UART0_BASE + 0x00)    /* 数据寄存器 */
-#define UART_FR         (UART0_BASE + 0x18)    /* 标志寄存器 */
+/* QEMU virt machine UART0 默认基址 (解析设备树之前使用) */
+#define UART0_DEFAULT_BASE  0x09000000
+#define UART_DR         (uart_base + 0x00)     /* 数据寄存器 */
+#define UART_FR         (uart_base + 0x18)     /* 标志寄存器 */
 #define UART_FR_TXFF    (1 << 5)               /* 发送FIFO满 */
 
-/* 简单的寄存器读写宏 */
-#define REG(addr) (*(volatile uint32_t*)(addr))
+/* 构建配置 (Makefile的PROFILE) */
+#ifndef SKYOS_BUILD_PROFILE
+#define SKYOS_BUILD_PROFILE "default"
+#endif
 
 /* 外部函数声明 */
 extern void test_syscalls(void);
 extern void test_exceptions(void);
+extern void test_vectors(void);
 extern void print_exception_stats(void);
 extern void print_syscall_stats(void);
 extern void enable_irq(void);
 extern void disable_irq(void);
 
 /* 定时器和GIC函数声明 */
-extern void timer_init(void);
-extern void gic_init(void);
 extern void timer_print_status(void);
 extern void gic_print_status(void);
 extern void gic_print_interrupt_stats(void);
@@ -40,15 +64,42 @@ extern void gic_print_version_info(void);
 extern void timer_delay_ms(uint32_t milliseconds);
 extern uint32_t timer_get_interrupt_count(void);
 
+/* 块设备函数声明 */
+extern void test_virtio_blk(void);
+extern void blk_print_stats(void);
+extern void bcache_init(void);
+extern void test_bcache(void);
+extern void bcache_print_stats(void);
+
+/* 文件系统函数声明 */
+extern void fat32_init(void);
+extern void fat32_print_stats(void);
+extern void test_vfs(void);
+extern void tmpfs_init(void);
+extern void tmpfs_print_stats(void);
+extern void test_tmpfs(void);
+extern void page_alloc_init(void);
+extern void page_alloc_print_stats(void);
+
+static uint32_t uart_base = UART0_DEFAULT_BASE;
+
+/* 从设备树获取UART地址 */
+static void uart_init(void) {
+    const struct fdt_device *uart = fdt_find_compatible("arm,pl011");
+    if (uart && uart->nr_reg) {
+        uart_base = uart->reg_base[0];
+    }
+}
+
 /* UART输出字符函数 */
 void uart_putc(char c) {
     /* 等待发送FIFO不满 */
-    while (REG(UART_FR) & UART_FR_TXFF) {
+    while (mmio_read32(UART_FR) & UART_FR_TXFF) {
         /* 空等待 */
     }
     
     /* 发送字符 */
-    REG(UART_DR) = c;
+    mmio_write32(UART_DR, c);
 }
 
 /* UART输出字符串函数 */
@@ -68,6 +119,19 @@ void uart_put_hex(uint32_t value) {
     }
 }
 
+/* 输出十进制数字 */
+void uart_put_dec(uint32_t value) {
+    char buf[11];
+    int i = 10;
+    
+    buf[i] = '\0';
+    do {
+        buf[--i] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    uart_puts(&buf[i]);
+}
+
 /* 获取ARM处理器ID */
 uint32_t get_processor_id(void) {
     uint32_t id;
@@ -171,11 +235,12 @@ void test_timer_interrupt(void) {
     uart_puts("\r\n=== 测试定时器中断 ===\r\n");
     
     uint32_t start_interrupts = timer_get_interrupt_count();
+    uint32_t start_ticks = get_timer_ticks();
     uart_puts("开始时中断数: ");
     uart_put_hex(start_interrupts);
     uart_puts("\r\n");
     
-    uart_puts("等待2秒 (200个10ms定时器中断)...\r\n");
+    uart_puts("等待2秒 (200个10ms滴答)...\r\n");
     timer_delay_ms(2000);
     
     uint32_t end_interrupts = timer_get_interrupt_count();
@@ -183,12 +248,16 @@ void test_timer_interrupt(void) {
     uart_put_hex(end_interrupts);
     uart_puts("\r\n");
     
+    /* 空闲时会停掉周期滴答，中断数可以少于滴答数，滴答数按计数器补齐 */
     uint32_t interrupt_diff = end_interrupts - start_interrupts;
+    uint32_t tick_diff = get_timer_ticks() - start_ticks;
     uart_puts("期间接收中断: ");
     uart_put_hex(interrupt_diff);
+    uart_puts(" 个, 滴答: ");
+    uart_put_hex(tick_diff);
     uart_puts(" 个\r\n");
     
-    if (interrupt_diff >= 180 && interrupt_diff <= 220) {
+    if (tick_diff >= 180 && tick_diff <= 220 && interrupt_diff <= tick_diff + 20) {
         uart_puts("✅ 定时器中断工作正常!\r\n");
     } else {
         uart_puts("❌ 定时器中断异常!\r\n");
@@ -197,8 +266,21 @@ void test_timer_interrupt(void) {
     uart_puts("====================\r\n");
 }
 
+/* 显示驱动、定时器和GIC的初始状态 */
+static void print_initial_status(void) {
+    driver_print_stats();
+    timer_print_status();
+    gic_print_status();
+}
+
 /* 主函数 - 内核入口点 */
 int main(void) {
+    /* 解析设备树，之后各驱动从设备表获取地址和中断号 */
+    fdt_init();
+    uart_init();
+    klog_init();
+    boot_mark("设备树/串口");
+    
     /* 输出启动信息 */
     uart_puts("\r\n");
     uart_puts("============================================\r\n");
@@ -208,23 +290,52 @@ int main(void) {
     uart_puts("架构: ARM Cortex-A15 (ARMv7-A)\r\n");
     uart_puts("平台: QEMU virt machine\r\n");
     uart_puts("编译时间: " __DATE__ " " __TIME__ "\r\n");
+    uart_puts("构建配置: " SKYOS_BUILD_PROFILE "\r\n");
+    if (boot_fast()) {
+        uart_puts("启动模式: fastboot (演示和自检在主循环开始后执行)\r\n");
+    }
     uart_puts("--------------------------------------------\r\n");
+    boot_mark("启动信息");
     
-    /* 显示处理器模式信息 */
-    demo_processor_modes();
+    /* 演示项目：fastboot时推迟到主循环开始之后 */
+    boot_defer(fdt_print_devices, "设备树列表");
+    boot_defer(demo_processor_modes, "处理器模式演示");
+    boot_defer(demo_interrupt_control, "中断控制演示");
     
-    /* 演示中断控制 */
-    demo_interrupt_control();
+    /* 初始化物理页分配器 */
+    page_alloc_init();
+    boot_mark("页分配器");
     
-    /* 初始化GIC中断控制器 */
-    uart_puts("🔧 初始化中断子系统...\r\n");
-    gic_init();
+    /* RCU和系统调用表 (中断/系统调用分发表由RCU保护) */
+    rcu_init();
+    syscall_init();
     
-    /* 初始化ARM Generic Timer */
-    timer_init();
+    /* 探测平台设备：GIC、定时器、virtio块设备 (按依赖顺序，由驱动表决定) */
+    uart_puts("🔧 初始化中断子系统...\r\n");
+    driver_probe_all();
+    boot_mark("驱动探测");
+    bcache_init();
+    
+    /* 性能计数器 (溢出中断需要GIC)，之后main成为0号任务 */
+    pmu_init();
+    task_init();
+    fpu_init(task_current());
+    workqueue_init();
+    klog_start_async();
+    idle_init();
+    profiler_init();
+    boot_mark("缓存/PMU/任务");
+    
+    /* 初始化VFS并挂载根文件系统 */
+    vfs_init();
+    fat32_init();
+    vfs_mount("/", "fat32", blk_get_default());
+    tmpfs_init();
+    vfs_mount("/tmp", "tmpfs", NULL);
+    boot_mark("文件系统挂载");
     
     /* 显示GIC版本信息 */
-    gic_print_version_info();
+    boot_defer(gic_print_version_info, "GIC版本信息");
     
     /* 启用IRQ中断 */
     uart_puts("🔓 启用IRQ中断...\r\n");
@@ -232,25 +343,44 @@ int main(void) {
     
     uart_puts("✅ 中断子系统初始化完成!\r\n");
     uart_puts("--------------------------------------------\r\n");
-    
-    /* 测试异常处理机制 */
-    uart_puts("🧪 测试异常处理机制:\r\n");
-    test_exceptions();
-    
-    /* 测试系统调用 */
-    uart_puts("🧪 测试系统调用机制:\r\n");
-    test_syscalls();
-    
-    /* 测试定时器中断 */
-    test_timer_interrupt();
-    
-    uart_puts("--------------------------------------------\r\n");
-    uart_puts("🎉 阶段2核心功能演示完成！\r\n");
-    uart_puts("============================================\r\n");
+    boot_mark("启用中断");
+    
+    /* 自检：异常、系统调用、块设备、文件系统、PMU、采样分析、定时器中断 */
+    boot_defer(test_exceptions, "异常处理自检");
+    boot_defer(test_syscalls, "系统调用自检");
+    boot_defer(test_virtio_blk, "virtio-blk自检");
+    boot_defer(test_bcache, "块缓存自检");
+    boot_defer(test_vfs, "VFS自检");
+    boot_defer(test_tmpfs, "tmpfs自检");
+    boot_defer(test_pmu, "PMU自检");
+    boot_defer(test_profiler, "采样分析自检");
+    boot_defer(test_memops, "内存操作基准");
+    boot_defer(test_fpu, "VFP/NEON切换自检");
+    boot_defer(test_spinlock, "锁自检");
+    boot_defer(test_rcu, "RCU自检");
+    boot_defer(test_futex, "futex自检");
+    boot_defer(test_ipc, "IPC自检");
+    boot_defer(test_ring, "管道/共享环基准");
+    boot_defer(test_workqueue, "工作队列自检");
+    boot_defer(test_sched, "SMP调度自检");
+    boot_defer(test_vdso, "vDSO时间页自检");
+    boot_defer(test_idle, "空闲统计自检");
+    boot_defer(test_kprintf, "kprintf自检");
+    boot_defer(test_vectors, "异常向量延迟对比");
+    boot_defer(test_timer_interrupt, "定时器中断自检");
+    
+    if (!boot_fast()) {
+        uart_puts("--------------------------------------------\r\n");
+        uart_puts("🎉 阶段2核心功能演示完成！\r\n");
+        uart_puts("============================================\r\n");
+    }
     
     /* 显示初始状态 */
-    timer_print_status();
-    gic_print_status();
+    boot_defer(print_initial_status, "状态输出");
+    
+    /* 启动计时报告；fastboot时推迟的项目由内核线程在主循环期间执行 */
+    boot_print_report();
+    boot_start_deferred();
     
     /* 主循环 */
     uart_puts("\r\n🚀 开始主程序循环 (按Ctrl+A X退出QEMU):\r\n");
@@ -272,6 +402,26 @@ int main(void) {
             print_exception_stats();
             print_syscall_stats();
             gic_print_interrupt_stats();
+            blk_print_stats();
+            bcache_print_stats();
+            vfs_print_stats();
+            fat32_print_stats();
+            tmpfs_print_stats();
+            page_alloc_print_stats();
+            pmu_print_stats();
+            task_print_stats();
+            fpu_print_stats();
+            lock_print_stats();
+            rcu_print_stats();
+            futex_print_stats();
+            ipc_print_stats();
+            pipe_print_stats();
+            ring_print_stats();
+            wq_print_stats();
+            sched_print_stats();
+            vdso_print_stats();
+            idle_print_stats();
+            klog_print_stats();
             timer_print_status();
         } else {
             /* 简单状态显示 */
@@ -289,17 +439,8 @@ int main(void) {
         if (counter % 10 == 0) {
             uart_puts("\r\n--- 定期系统调用测试 ---\r\n");
             
-            /* 测试获取时间系统调用 */
-            uint32_t result;
-            asm volatile(
-                "mov r0, #4\n"      /* SYS_GETTIME */
-                "mov r1, #0\n"
-                "svc #0\n"
-                "mov %0, r0\n"
-                : "=r"(result)
-                :
-                : "r0", "r1"
-            );
+            /* 读取共享时间页，不陷入内核 */
+            uint32_t result = vdso_ticks();
             
             uart_puts("当前系统时间: ");
             uart_put_hex(result);
@@ -0,0 +1,222 @@
+/*
+ * SkyOS 物理页分配器
+ * 文件: kernel/page_alloc.c
+ *
+ * 位图分配器：
+ * - 单页分配从上次位置继续按字扫描 (跳过全满的字)，摊还O(1)
+ * - 连续多页分配使用首次适配，供需要物理连续内存的场合 (如mmap)
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "page_alloc.h"
+#include "spinlock.h"
+#include "fdt.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_hex(uint32_t value);
+
+/* 链接脚本符号 */
+extern char __kernel_end[];
+
+#define PAGE_MAX        (RAM_SIZE / PAGE_SIZE)
+#define BITMAP_WORDS    (PAGE_MAX / 32)
+
+static uint32_t page_bitmap[BITMAP_WORDS];     /* 1 = 已使用 */
+static uint32_t page_base;                      /* 第一个可分配页的地址 */
+static uint32_t page_count;                     /* 可分配页数 */
+static uint32_t page_free;
+static uint32_t page_hint;                      /* 下次扫描的起始字 */
+static struct spinlock page_lock = SPINLOCK_INIT("page_alloc");
+
+/* 统计 */
+static uint32_t stat_allocs = 0;
+static uint32_t stat_frees = 0;
+static uint32_t stat_failures = 0;
+static uint32_t stat_min_free = 0;
+
+static inline void page_set(uint32_t pfn) {
+    page_bitmap[pfn / 32] |= 1u << (pfn % 32);
+}
+
+static inline void page_clear(uint32_t pfn) {
+    page_bitmap[pfn / 32] &= ~(1u << (pfn % 32));
+}
+
+static inline int page_test(uint32_t pfn) {
+    return (page_bitmap[pfn / 32] >> (pfn % 32)) & 1;
+}
+
+static inline void *pfn_to_addr(uint32_t pfn) {
+    return (void *)(page_base + (pfn << PAGE_SHIFT));
+}
+
+void page_alloc_init(void) {
+    uint32_t ram_base = RAM_BASE, ram_size = RAM_SIZE;
+    uint32_t dtb_addr, dtb_size;
+
+    /* RAM大小以设备树为准 (内核按RAM_BASE链接)，超出位图容量的部分不管理 */
+    if (fdt_memory(&ram_base, &ram_size) < 0 || ram_base != RAM_BASE || ram_size == 0) {
+        ram_base = RAM_BASE;
+        ram_size = RAM_SIZE;
+    }
+    if (ram_size > RAM_SIZE) {
+        ram_size = RAM_SIZE;
+    }
+
+    page_base = PAGE_ALIGN((uint32_t)__kernel_end);
+    page_count = (RAM_BASE + ram_size - page_base) >> PAGE_SHIFT;
+    page_free = page_count;
+    page_hint = 0;
+
+    for (uint32_t i = 0; i < BITMAP_WORDS; i++) {
+        page_bitmap[i] = 0;
+    }
+    /* 超出范围的位标记为已使用，扫描时无需再检查边界 */
+    for (uint32_t pfn = page_count; pfn < BITMAP_WORDS * 32; pfn++) {
+        page_set(pfn);
+    }
+
+    /* DTB在驱动运行期间一直被引用 (字符串直接指向DTB) */
+    if (fdt_blob_region(&dtb_addr, &dtb_size) == 0) {
+        page_reserve(dtb_addr, dtb_size);
+    }
+    stat_min_free = page_free;
+
+    uart_puts("页分配器: 起始 ");
+    uart_put_hex(page_base);
+    uart_puts(", 页数 ");
+    uart_put_hex(page_count);
+    uart_puts("\r\n");
+}
+
+/* 把一段物理内存标记为已使用 (如引导程序放置的数据) */
+void page_reserve(uint32_t addr, uint32_t size) {
+    uint32_t start = addr & PAGE_MASK;
+    uint32_t end = PAGE_ALIGN(addr + size);
+
+    for (uint32_t a = start; a < end; a += PAGE_SIZE) {
+        if (a < page_base) {
+            continue;
+        }
+        uint32_t pfn = (a - page_base) >> PAGE_SHIFT;
+        if (pfn >= page_count) {
+            break;
+        }
+        if (!page_test(pfn)) {
+            page_set(pfn);
+            page_free--;
+        }
+    }
+}
+
+void *alloc_page(void) {
+    uint32_t flags = spin_lock_irqsave(&page_lock);
+
+    for (uint32_t n = 0; n < BITMAP_WORDS; n++) {
+        uint32_t w = (page_hint + n) % BITMAP_WORDS;
+        uint32_t bits = page_bitmap[w];
+        if (bits != 0xFFFFFFFF) {
+            uint32_t pfn = w * 32 + __builtin_ctz(~bits);
+            page_set(pfn);
+            page_free--;
+            page_hint = w;
+            stat_allocs++;
+            if (page_free < stat_min_free) stat_min_free = page_free;
+            spin_unlock_irqrestore(&page_lock, flags);
+            return pfn_to_addr(pfn);
+        }
+    }
+
+    stat_failures++;
+    spin_unlock_irqrestore(&page_lock, flags);
+    return NULL;
+}
+
+/* 分配count个物理连续的页 */
+void *alloc_pages(uint32_t count) {
+    uint32_t flags = spin_lock_irqsave(&page_lock);
+    uint32_t run = 0;
+
+    if (count == 1) {
+        spin_unlock_irqrestore(&page_lock, flags);
+        return alloc_page();
+    }
+
+    for (uint32_t pfn = 0; pfn < page_count; pfn++) {
+        if (page_test(pfn)) {
+            run = 0;
+            /* 整字已满时直接跳到下一个字 */
+            if (page_bitmap[pfn / 32] == 0xFFFFFFFF) {
+                pfn |= 31;
+            }
+            continue;
+        }
+        if (++run == count) {
+            uint32_t first = pfn + 1 - count;
+            for (uint32_t i = first; i <= pfn; i++) {
+                page_set(i);
+            }
+            page_free -= count;
+            stat_allocs += count;
+            if (page_free < stat_min_free) stat_min_free = page_free;
+            spin_unlock_irqrestore(&page_lock, flags);
+            return pfn_to_addr(first);
+        }
+    }
+
+    stat_failures++;
+    spin_unlock_irqrestore(&page_lock, flags);
+    return NULL;
+}
+
+void free_pages(void *page, uint32_t count) {
+    uint32_t addr = (uint32_t)page;
+    uint32_t flags;
+
+    if (page == NULL || addr < page_base || (addr & (PAGE_SIZE - 1))) {
+        return;
+    }
+
+    flags = spin_lock_irqsave(&page_lock);
+    uint32_t pfn = (addr - page_base) >> PAGE_SHIFT;
+    for (uint32_t i = 0; i < count && pfn + i < page_count; i++) {
+        if (page_test(pfn + i)) {
+            page_clear(pfn + i);
+            page_free++;
+            stat_frees++;
+        }
+    }
+    if (pfn / 32 < page_hint) {
+        page_hint = pfn / 32;
+    }
+    spin_unlock_irqrestore(&page_lock, flags);
+}
+
+void free_page(void *page) {
+    free_pages(page, 1);
+}
+
+uint32_t page_free_count(void) {
+    return page_free;
+}
+
+void page_alloc_print_stats(void) {
+    uart_puts("\r\n=== 页分配器统计 ===\r\n");
+    uart_puts("总页数: ");
+    uart_put_hex(page_count);
+    uart_puts(", 空闲: ");
+    uart_put_hex(page_free);
+    uart_puts(", 最低空闲: ");
+    uart_put_hex(stat_min_free);
+    uart_puts("\r\n");
+    uart_puts("分配: ");
+    uart_put_hex(stat_allocs);
+    uart_puts(", 释放: ");
+    uart_put_hex(stat_frees);
+    uart_puts(", 失败: ");
+    uart_put_hex(stat_failures);
+    uart_puts("\r\n");
+    uart_puts("====================\r\n");
+}
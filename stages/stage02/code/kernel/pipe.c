@@ -0,0 +1,201 @@
+/*
+ * SkyOS 管道
+ * 文件: kernel/pipe.c
+ *
+ * 内核中的单生产者/单消费者环加两个等待队列。读写双方都在内核里，
+ * 直接用wait_event睡眠、wake_up_all唤醒，不需要共享环的等待标志。
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "pipe.h"
+#include "ring.h"
+#include "vfs.h"
+#include "wait.h"
+#include "page_alloc.h"
+#include "kstring.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_dec(uint32_t value);
+
+#define PIPE_MAX        8
+
+struct pipe {
+    struct inode inode;             /* 匿名inode，f_op为pipe_fops */
+    struct ring_shared *ring;
+    struct wait_queue rd_wq;        /* 等待数据 */
+    struct wait_queue wr_wq;        /* 等待空间 */
+    uint32_t readers;
+    uint32_t writers;
+    uint32_t used;
+};
+
+static struct pipe pipes[PIPE_MAX];
+static struct spinlock pipe_lock = SPINLOCK_INIT("pipe");
+
+/* 统计 */
+static uint32_t stat_pipes = 0;
+static uint32_t stat_read_bytes = 0;
+static uint32_t stat_write_bytes = 0;
+
+static int pipe_read(struct file *file, void *buf, uint32_t count) {
+    struct pipe *p = file->private_data;
+    struct ring_shared *r = p->ring;
+    uint8_t *dst = buf;
+    uint32_t done = 0;
+
+    wait_event(&p->rd_wq, ring_used(r) != 0 || READ_ONCE(p->writers) == 0);
+    /* 有多少读多少 (最多跨一次环尾)，不等待凑满count */
+    while (done < count && ring_used(r)) {
+        uint32_t tail = r->tail;
+        uint32_t off = tail & (r->size - 1);
+        uint32_t n = r->head - tail;
+
+        if (n > r->size - off) {
+            n = r->size - off;
+        }
+        if (n > count - done) {
+            n = count - done;
+        }
+        smp_mb();
+        memcpy(dst + done, (const void *)(r->data + off), n);
+        smp_mb();
+        WRITE_ONCE(r->tail, tail + n);
+        done += n;
+    }
+    if (done) {
+        stat_read_bytes += done;
+        wake_up_all(&p->wr_wq);
+    }
+    return (int)done;
+}
+
+static int pipe_write(struct file *file, const void *buf, uint32_t count) {
+    struct pipe *p = file->private_data;
+    struct ring_shared *r = p->ring;
+    const uint8_t *src = buf;
+    uint32_t done = 0;
+
+    /* 阻塞写：全部写入才返回，中途读端关闭则返回-EPIPE */
+    while (done < count) {
+        wait_event(&p->wr_wq, ring_used(r) != r->size || READ_ONCE(p->readers) == 0);
+        if (READ_ONCE(p->readers) == 0) {
+            return done ? (int)done : -VFS_EPIPE;
+        }
+        while (done < count && ring_used(r) != r->size) {
+            uint32_t head = r->head;
+            uint32_t off = head & (r->size - 1);
+            uint32_t n = r->size - (head - r->tail);
+
+            if (n > r->size - off) {
+                n = r->size - off;
+            }
+            if (n > count - done) {
+                n = count - done;
+            }
+            smp_mb();
+            memcpy((void *)(r->data + off), src + done, n);
+            smp_wmb();
+            WRITE_ONCE(r->head, head + n);
+            done += n;
+        }
+        wake_up_all(&p->rd_wq);
+    }
+    stat_write_bytes += done;
+    return (int)done;
+}
+
+/* 最后一个读端/写端关闭时唤醒对方，两端都关闭后释放管道 */
+static void pipe_release(struct file *file) {
+    struct pipe *p = file->private_data;
+    uint32_t flags = spin_lock_irqsave(&pipe_lock);
+    int free_it;
+
+    if ((file->flags & O_ACCMODE) == O_RDONLY) {
+        p->readers--;
+    } else {
+        p->writers--;
+    }
+    free_it = p->readers == 0 && p->writers == 0;
+    spin_unlock_irqrestore(&pipe_lock, flags);
+
+    wake_up_all(&p->rd_wq);
+    wake_up_all(&p->wr_wq);
+    if (free_it) {
+        free_pages(p->ring, PIPE_PAGES + 1);
+        p->ring = NULL;
+        p->used = 0;
+    }
+}
+
+static const struct file_ops pipe_fops = {
+    .read = pipe_read,
+    .write = pipe_write,
+    .release = pipe_release,
+};
+
+/* 系统调用：创建管道，fds[0]为读端，fds[1]为写端 */
+uint32_t sys_pipe(uint32_t *fds) {
+    struct pipe *p = NULL;
+    uint32_t flags = spin_lock_irqsave(&pipe_lock);
+    int rfd, wfd;
+
+    for (uint32_t i = 0; i < PIPE_MAX; i++) {
+        if (!pipes[i].used) {
+            p = &pipes[i];
+            p->used = 1;
+            break;
+        }
+    }
+    spin_unlock_irqrestore(&pipe_lock, flags);
+    if (p == NULL) {
+        return (uint32_t)-VFS_ENFILE;
+    }
+
+    p->ring = alloc_pages(PIPE_PAGES + 1);
+    if (p->ring == NULL) {
+        p->used = 0;
+        return (uint32_t)-VFS_ENOMEM;
+    }
+    memset(p->ring, 0, sizeof(*p->ring));
+    p->ring->size = PIPE_PAGES * PAGE_SIZE;
+    p->ring->data = (uint32_t)p->ring + PAGE_SIZE;
+    memset(&p->inode, 0, sizeof(p->inode));
+    p->inode.mode = VFS_IFIFO;
+    p->inode.refcnt = 1;
+    p->inode.f_op = &pipe_fops;
+    wait_queue_init(&p->rd_wq, "pipe_rd");
+    wait_queue_init(&p->wr_wq, "pipe_wr");
+    p->readers = 1;
+    p->writers = 1;
+
+    rfd = vfs_open_anon(&p->inode, O_RDONLY, p);
+    if (rfd < 0) {
+        free_pages(p->ring, PIPE_PAGES + 1);
+        p->used = 0;
+        return (uint32_t)rfd;
+    }
+    wfd = vfs_open_anon(&p->inode, O_WRONLY, p);
+    if (wfd < 0) {
+        p->writers = 0;
+        vfs_close(rfd);
+        return (uint32_t)wfd;
+    }
+    fds[0] = (uint32_t)rfd;
+    fds[1] = (uint32_t)wfd;
+    stat_pipes++;
+    return 0;
+}
+
+void pipe_print_stats(void) {
+    uart_puts("\r\n=== 管道统计 ===\r\n");
+    uart_puts("创建: ");
+    uart_put_dec(stat_pipes);
+    uart_puts(", 写入字节: ");
+    uart_put_dec(stat_write_bytes);
+    uart_puts(", 读出字节: ");
+    uart_put_dec(stat_read_bytes);
+    uart_puts("\r\n");
+    uart_puts("================\r\n");
+}
@@ -0,0 +1,492 @@
+/*
+ * SkyOS Cortex-A15 性能监控单元 (PMU)
+ * 文件: kernel/pmu.c
+ *
+ * 1. ID_DFR0确认PMUv1/v2存在，PMCR.N给出事件计数器个数
+ * 2. 事件计数器0..4分别计数指令、L1D访问、L1D缺失、分支、分支预测失败
+ * 3. 所有计数器打开溢出中断，中断里把2^32累加到软件高位
+ * 4. PMCEID0标出实现了哪些事件 (QEMU只实现其中一部分)，未实现的不参与比率计算
+ * 5. 紧随其后的一个事件计数器留作采样：计数CPU周期，预置为 -period，溢出即采样
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "pmu.h"
+#include "task.h"
+#include "fdt.h"
+#include "irqflags.h"
+#include "timer.h"
+#include "hal.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_hex(uint32_t value);
+extern void uart_put_dec(uint32_t value);
+extern int gic_request_irq(uint32_t irq_id, void (*handler)(uint32_t, void *), void *data);
+
+/* QEMU virt把PMU中断接到PPI 7 */
+#define PMU_IRQ_DEFAULT     23
+
+/* PMCR位 */
+#define PMCR_E              (1 << 0)    /* 使能所有计数器 */
+#define PMCR_P              (1 << 1)    /* 复位事件计数器 */
+#define PMCR_C              (1 << 2)    /* 复位周期计数器 */
+#define PMCR_N_SHIFT        11
+#define PMCR_N_MASK         0x1F
+
+#define PMU_CYCLE_BIT       (1u << 31)  /* 周期计数器在使能/溢出寄存器中的位置 */
+#define PMU_EV_CPU_CYCLES   0x11        /* 采样计数器使用的事件 */
+
+/* ARMv7架构事件号 */
+static const uint32_t pmu_event_ids[PMU_NR_EVENTS] = {
+    0x08,   /* INST_RETIRED */
+    0x04,   /* L1D_CACHE */
+    0x03,   /* L1D_CACHE_REFILL */
+    0x12,   /* BR_PRED */
+    0x10,   /* BR_MIS_PRED */
+};
+
+static const char *const pmu_event_names[PMU_NR_EVENTS] = {
+    "指令", "L1D访问", "L1D缺失", "分支", "分支预测失败",
+};
+
+/* CP15 c9 访问 */
+static inline uint32_t read_pmcr(void) {
+    uint32_t v;
+    asm volatile("mrc p15, 0, %0, c9, c12, 0" : "=r"(v));
+    return v;
+}
+
+static inline void write_pmcr(uint32_t v) {
+    asm volatile("mcr p15, 0, %0, c9, c12, 0" : : "r"(v));
+}
+
+static inline void write_pmcntenset(uint32_t v) {
+    asm volatile("mcr p15, 0, %0, c9, c12, 1" : : "r"(v));
+}
+
+static inline void write_pmcntenclr(uint32_t v) {
+    asm volatile("mcr p15, 0, %0, c9, c12, 2" : : "r"(v));
+}
+
+static inline uint32_t read_pmovsr(void) {
+    uint32_t v;
+    asm volatile("mrc p15, 0, %0, c9, c12, 3" : "=r"(v));
+    return v;
+}
+
+static inline void write_pmovsr(uint32_t v) {
+    asm volatile("mcr p15, 0, %0, c9, c12, 3" : : "r"(v));
+}
+
+static inline void write_pmselr(uint32_t v) {
+    asm volatile("mcr p15, 0, %0, c9, c12, 5" : : "r"(v));
+    asm volatile("isb");
+}
+
+static inline uint32_t read_pmceid0(void) {
+    uint32_t v;
+    asm volatile("mrc p15, 0, %0, c9, c12, 6" : "=r"(v));
+    return v;
+}
+
+static inline uint32_t read_pmccntr(void) {
+    uint32_t v;
+    asm volatile("mrc p15, 0, %0, c9, c13, 0" : "=r"(v));
+    return v;
+}
+
+static inline void write_pmxevtyper(uint32_t v) {
+    asm volatile("mcr p15, 0, %0, c9, c13, 1" : : "r"(v));
+}
+
+static inline void write_pmxevcntr(uint32_t v) {
+    asm volatile("mcr p15, 0, %0, c9, c13, 2" : : "r"(v));
+}
+
+static inline uint32_t read_pmxevcntr(void) {
+    uint32_t v;
+    asm volatile("mrc p15, 0, %0, c9, c13, 2" : "=r"(v));
+    return v;
+}
+
+static inline void write_pmintenset(uint32_t v) {
+    asm volatile("mcr p15, 0, %0, c9, c14, 1" : : "r"(v));
+}
+
+static inline void write_pmintenclr(uint32_t v) {
+    asm volatile("mcr p15, 0, %0, c9, c14, 2" : : "r"(v));
+}
+
+static inline uint32_t read_id_dfr0(void) {
+    uint32_t v;
+    asm volatile("mrc p15, 0, %0, c0, c1, 2" : "=r"(v));
+    return v;
+}
+
+/* 全局状态 */
+static uint32_t pmu_version = 0;        /* ID_DFR0.PerfMon: 1=PMUv1, 2=PMUv2 */
+static uint32_t pmu_num_counters = 0;   /* PMCR.N */
+static uint32_t pmu_active = 0;         /* 实际使用的事件计数器个数 */
+static uint32_t pmu_supported = 0;      /* 按PMU_*索引的已实现事件位图 */
+static uint32_t pmu_irq = PMU_IRQ_DEFAULT;
+/* 软件维护的高位 (溢出次数 << 32)：计数器是每个CPU私有的，高位也按CPU分开 */
+static uint64_t pmu_cycles_hi[NR_CPUS];
+static uint64_t pmu_events_hi[NR_CPUS][PMU_NR_EVENTS];
+static uint32_t stat_overflows = 0;
+static uint32_t pmu_ceid = 0;
+
+/* 采样计数器 */
+static void (*pmu_sample_fn)(void) = NULL;
+static uint32_t pmu_sample_period = 0;
+
+int pmu_available(void) {
+    return pmu_active != 0;
+}
+
+int pmu_event_supported(uint32_t event) {
+    return event < PMU_NR_EVENTS && (pmu_supported & (1u << event));
+}
+
+/* 溢出中断：把溢出的计数器高位加1并清除标志 */
+static void pmu_irq_handler(uint32_t irq_id, void *data) {
+    uint32_t ovs = read_pmovsr();
+    uint32_t cpu = cpu_id();
+
+    (void)irq_id;
+    (void)data;
+    write_pmovsr(ovs);
+    if (pmu_sample_fn && (ovs & (1u << PMU_NR_EVENTS))) {
+        /* 重新预置采样计数器，再记录被中断的位置 */
+        write_pmselr(PMU_NR_EVENTS);
+        write_pmxevcntr(0u - pmu_sample_period);
+        pmu_sample_fn();
+    }
+    if (ovs & PMU_CYCLE_BIT) {
+        pmu_cycles_hi[cpu] += 1ULL << 32;
+        stat_overflows++;
+    }
+    for (uint32_t i = 0; i < pmu_active; i++) {
+        if (ovs & (1u << i)) {
+            pmu_events_hi[cpu][i] += 1ULL << 32;
+            stat_overflows++;
+        }
+    }
+}
+
+/* 初始化PMU并开始计数 (需要GIC已就绪) */
+void pmu_init(void) {
+    const struct fdt_device *node;
+    uint32_t ceid;
+
+    pmu_version = (read_id_dfr0() >> 24) & 0xF;
+    if (pmu_version == 0 || pmu_version == 0xF) {
+        uart_puts("PMU: 未实现\r\n");
+        return;
+    }
+    pmu_num_counters = (read_pmcr() >> PMCR_N_SHIFT) & PMCR_N_MASK;
+    pmu_active = pmu_num_counters < PMU_NR_EVENTS ? pmu_num_counters : PMU_NR_EVENTS;
+
+    /* 设备树中有PMU节点时使用其中断号 */
+    node = fdt_find_compatible("arm,cortex-a15-pmu");
+    if (node == NULL) {
+        node = fdt_find_compatible("arm,armv7-pmuv2");
+    }
+    if (node && node->nr_irqs) {
+        pmu_irq = node->irqs[0];
+    }
+
+    /* 停止并清零所有计数器 */
+    write_pmcntenclr(0xFFFFFFFF);
+    write_pmintenclr(0xFFFFFFFF);
+    write_pmovsr(0xFFFFFFFF);
+    write_pmcr(PMCR_P | PMCR_C);
+
+    ceid = pmu_version >= 2 ? read_pmceid0() : 0xFFFFFFFF;
+    pmu_ceid = ceid;
+    for (uint32_t i = 0; i < pmu_active; i++) {
+        write_pmselr(i);
+        write_pmxevtyper(pmu_event_ids[i]);
+        if (ceid & (1u << pmu_event_ids[i])) {
+            pmu_supported |= 1u << i;
+        }
+    }
+
+    gic_request_irq(pmu_irq, pmu_irq_handler, NULL);
+    write_pmintenset(PMU_CYCLE_BIT | ((1u << pmu_active) - 1));
+    write_pmcntenset(PMU_CYCLE_BIT | ((1u << pmu_active) - 1));
+    write_pmcr(PMCR_E);
+
+    uart_puts("PMU: v");
+    uart_put_dec(pmu_version);
+    uart_puts(", 事件计数器 ");
+    uart_put_dec(pmu_num_counters);
+    uart_puts(", 溢出中断 IRQ ");
+    uart_put_dec(pmu_irq);
+    uart_puts(", 已实现事件:");
+    for (uint32_t i = 0; i < pmu_active; i++) {
+        if (pmu_supported & (1u << i)) {
+            uart_puts(" ");
+            uart_puts(pmu_event_names[i]);
+        }
+    }
+    uart_puts("\r\n");
+}
+
+/*
+ * 读取一个计数器的64位值。溢出标志已置位但中断尚未处理时，
+ * 重新读取低位 (保证是溢出后的值) 并补上这一次的2^32。
+ */
+static uint64_t pmu_read_counter(uint64_t hi, uint32_t ovs_bit, int event) {
+    uint32_t lo = event >= 0 ? read_pmxevcntr() : read_pmccntr();
+
+    if (read_pmovsr() & ovs_bit) {
+        lo = event >= 0 ? read_pmxevcntr() : read_pmccntr();
+        hi += 1ULL << 32;
+    }
+    return hi | lo;
+}
+
+/* 读取所有计数器的当前64位值 */
+void pmu_read(struct pmu_counts *out) {
+    uint32_t flags, cpu;
+
+    if (!pmu_active) {
+        out->cycles = 0;
+        for (uint32_t i = 0; i < PMU_NR_EVENTS; i++) {
+            out->events[i] = 0;
+        }
+        return;
+    }
+    flags = local_irq_save();
+    cpu = cpu_id();
+    out->cycles = pmu_read_counter(pmu_cycles_hi[cpu], PMU_CYCLE_BIT, -1);
+    for (uint32_t i = 0; i < PMU_NR_EVENTS; i++) {
+        if (i < pmu_active) {
+            write_pmselr(i);
+            out->events[i] = pmu_read_counter(pmu_events_hi[cpu][i], 1u << i, (int)i);
+        } else {
+            out->events[i] = 0;
+        }
+    }
+    local_irq_restore(flags);
+}
+
+void pmu_sub(struct pmu_counts *out, const struct pmu_counts *end, const struct pmu_counts *start) {
+    out->cycles = end->cycles - start->cycles;
+    for (uint32_t i = 0; i < PMU_NR_EVENTS; i++) {
+        out->events[i] = end->events[i] - start->events[i];
+    }
+}
+
+static void pmu_add(struct pmu_counts *acc, const struct pmu_counts *end, const struct pmu_counts *start) {
+    acc->cycles += end->cycles - start->cycles;
+    for (uint32_t i = 0; i < PMU_NR_EVENTS; i++) {
+        acc->events[i] += end->events[i] - start->events[i];
+    }
+}
+
+/* 上下文切换：把prev本次运行的增量累加到它的total，记录next的起点 */
+void pmu_task_switch(struct pmu_task_ctx *prev, struct pmu_task_ctx *next) {
+    struct pmu_counts now;
+
+    if (!pmu_active) {
+        return;
+    }
+    pmu_read(&now);
+    pmu_add(&prev->total, &now, &prev->start);
+    next->start = now;
+}
+
+/* 读取任务的虚拟计数，正在运行的任务要加上本次运行的部分 */
+void pmu_task_read(const struct pmu_task_ctx *ctx, int running, struct pmu_counts *out) {
+    *out = ctx->total;
+    if (running && pmu_active) {
+        struct pmu_counts now;
+        pmu_read(&now);
+        pmu_add(out, &now, &ctx->start);
+    }
+}
+
+/*
+ * 用紧随计数事件之后的计数器做周期采样：每period个CPU周期溢出一次，
+ * 在溢出中断中调用fn。PMU没有多余计数器或未实现CPU_CYCLES事件时返回-1。
+ */
+int pmu_sampling_start(uint32_t period, void (*fn)(void)) {
+    uint32_t bit = 1u << PMU_NR_EVENTS;
+
+    if (pmu_active < PMU_NR_EVENTS || pmu_num_counters <= PMU_NR_EVENTS ||
+        !(pmu_ceid & (1u << PMU_EV_CPU_CYCLES)) || period == 0) {
+        return -1;
+    }
+    write_pmcntenclr(bit);
+    pmu_sample_period = period;
+    pmu_sample_fn = fn;
+    write_pmselr(PMU_NR_EVENTS);
+    write_pmxevtyper(PMU_EV_CPU_CYCLES);
+    write_pmxevcntr(0u - period);
+    write_pmovsr(bit);
+    write_pmintenset(bit);
+    write_pmcntenset(bit);
+    return 0;
+}
+
+void pmu_sampling_stop(void) {
+    uint32_t bit = 1u << PMU_NR_EVENTS;
+
+    write_pmcntenclr(bit);
+    write_pmintenclr(bit);
+    write_pmovsr(bit);
+    pmu_sample_fn = NULL;
+}
+
+/* num/den*scale，两者同时右移到32位内以避免64位除法 */
+static uint32_t pmu_ratio(uint64_t num, uint64_t den, uint32_t scale) {
+    while ((den >> 32) || (num >> 32) || (uint32_t)num > 0xFFFFFFFFu / scale) {
+        num >>= 1;
+        den >>= 1;
+    }
+    if ((uint32_t)den == 0) {
+        return 0;
+    }
+    return (uint32_t)num * scale / (uint32_t)den;
+}
+
+/* 输出定点数 x/100，例如 123 -> "1.23" */
+static void pmu_put_fixed2(uint32_t x100) {
+    uart_put_dec(x100 / 100);
+    uart_puts(".");
+    if (x100 % 100 < 10) {
+        uart_puts("0");
+    }
+    uart_put_dec(x100 % 100);
+}
+
+void pmu_print_counts(const struct pmu_counts *c) {
+    uart_puts("周期 ");
+    uart_put_dec((uint32_t)c->cycles);
+    if (!pmu_active) {
+        uart_puts(" (无PMU)\r\n");
+        return;
+    }
+    if (pmu_event_supported(PMU_INSTRUCTIONS)) {
+        uart_puts(", 指令 ");
+        uart_put_dec((uint32_t)c->events[PMU_INSTRUCTIONS]);
+        uart_puts(", IPC ");
+        pmu_put_fixed2(pmu_ratio(c->events[PMU_INSTRUCTIONS], c->cycles, 100));
+    }
+    if (pmu_event_supported(PMU_L1D_ACCESS) && pmu_event_supported(PMU_L1D_REFILL)) {
+        uart_puts(", L1D缺失率 ");
+        pmu_put_fixed2(pmu_ratio(c->events[PMU_L1D_REFILL], c->events[PMU_L1D_ACCESS], 10000));
+        uart_puts("%");
+    }
+    if (pmu_event_supported(PMU_BRANCHES) && pmu_event_supported(PMU_BRANCH_MISSES)) {
+        uart_puts(", 分支预测失败率 ");
+        pmu_put_fixed2(pmu_ratio(c->events[PMU_BRANCH_MISSES], c->events[PMU_BRANCHES], 10000));
+        uart_puts("%");
+    }
+    uart_puts("\r\n");
+}
+
+void pmu_print_stats(void) {
+    struct pmu_counts c;
+
+    uart_puts("\r\n=== PMU统计 ===\r\n");
+    if (!pmu_active) {
+        uart_puts("PMU不可用\r\n");
+        uart_puts("===============\r\n");
+        return;
+    }
+    pmu_read(&c);
+    uart_puts("周期计数: ");
+    uart_put_hex((uint32_t)(c.cycles >> 32));
+    uart_puts(":");
+    uart_put_hex((uint32_t)c.cycles);
+    uart_puts("\r\n");
+    for (uint32_t i = 0; i < pmu_active; i++) {
+        uart_puts(pmu_event_names[i]);
+        uart_puts(": ");
+        if (pmu_supported & (1u << i)) {
+            uart_put_hex((uint32_t)(c.events[i] >> 32));
+            uart_puts(":");
+            uart_put_hex((uint32_t)c.events[i]);
+        } else {
+            uart_puts("未实现");
+        }
+        uart_puts("\r\n");
+    }
+    uart_puts("溢出中断: ");
+    uart_put_dec(stat_overflows);
+    uart_puts("\r\n");
+    uart_puts("===============\r\n");
+}
+
+/* ---------------- 测试 ---------------- */
+
+#define PMU_TEST_BUF    (64 * 1024)
+#define PMU_TEST_ROUNDS 4
+
+static uint8_t pmu_test_buf[PMU_TEST_BUF];
+
+/* 按缓存行跨步访问，制造L1D缺失 */
+static uint32_t pmu_work_stream(void) {
+    uint32_t sum = 0;
+    for (uint32_t off = 0; off < PMU_TEST_BUF; off += 64) {
+        sum += *(volatile uint8_t *)&pmu_test_buf[off];
+    }
+    return sum;
+}
+
+/* 数据相关的分支，制造分支预测失败 */
+static uint32_t pmu_work_branchy(void) {
+    uint32_t x = 12345, n = 0;
+    for (uint32_t i = 0; i < 4096; i++) {
+        x = x * 1103515245 + 12345;
+        if (x & 0x10000) {
+            n++;
+        } else {
+            n += 3;
+        }
+    }
+    return n;
+}
+
+static void pmu_task_stream(void *arg) {
+    volatile uint32_t *sink = arg;
+    for (uint32_t r = 0; r < PMU_TEST_ROUNDS; r++) {
+        *sink += pmu_work_stream();
+        task_yield();
+    }
+}
+
+static void pmu_task_branchy(void *arg) {
+    volatile uint32_t *sink = arg;
+    for (uint32_t r = 0; r < PMU_TEST_ROUNDS; r++) {
+        *sink += pmu_work_branchy();
+        task_yield();
+    }
+}
+
+/* 测试PMU：基准测量 + 两个任务交替运行时的按任务计数 */
+void test_pmu(void) {
+    static volatile uint32_t sink;
+    timer_benchmark_t bench;
+
+    uart_puts("\r\n=== 测试PMU ===\r\n");
+
+    bench = timer_benchmark_start("跨步访问64KB");
+    sink += pmu_work_stream();
+    timer_benchmark_end(bench);
+
+    bench = timer_benchmark_start("随机分支4096次");
+    sink += pmu_work_branchy();
+    timer_benchmark_end(bench);
+
+    struct task *a = task_create("stream", pmu_task_stream, (void *)&sink);
+    struct task *b = task_create("branchy", pmu_task_branchy, (void *)&sink);
+    while ((a && a->state != TASK_DEAD) || (b && b->state != TASK_DEAD)) {
+        task_yield();
+    }
+    task_print_stats();
+    uart_puts("===============\r\n");
+}
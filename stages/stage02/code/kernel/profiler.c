@@ -0,0 +1,297 @@
+/*
+ * SkyOS 采样分析器
+ * 文件: kernel/profiler.c
+ *
+ * 1. 采样源：PMU周期计数器溢出 (可调周期)，否则定时器回调 (每滴答一次)
+ * 2. 样本来自irq_handler保存的寄存器帧：[13]为被中断的PC，
+ *    LR从SPSR指明的被中断模式的分组寄存器读取
+ * 3. 每CPU一个单生产者/单消费者环：中断只写head，dump只写tail，无需加锁
+ * 4. dump时按64字节桶统计PC直方图，并输出原始样本供主机端符号化
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "profiler.h"
+#include "pmu.h"
+#include "task.h"
+#include "timer.h"
+#include "kstring.h"
+#include "hal.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_hex(uint32_t value);
+extern void uart_put_dec(uint32_t value);
+extern uint32_t *irq_get_regs(void);
+extern int timer_register_callback(void (*fn)(void *data), void *data, uint32_t period_ticks);
+
+#define PROF_FRAME_PC       5       /* 寄存器帧 (r0-r3, r12, pc) 中返回地址的下标 */
+#define PROF_BUCKET_SHIFT   6       /* 直方图桶大小 64字节 */
+#define PROF_HIST_SIZE      256     /* 直方图哈希表大小 (2的幂) */
+#define PROF_HIST_TOP       10
+
+#define PROF_SRC_NONE       0
+#define PROF_SRC_PMU        1
+#define PROF_SRC_TIMER      2
+
+struct prof_ring {
+    volatile uint32_t head;     /* 下一个写入位置，只由本CPU的中断修改 */
+    volatile uint32_t tail;     /* 下一个读取位置，只由profiler_dump修改 */
+    uint32_t dropped;           /* 环满丢弃的样本 */
+    uint32_t total;
+    struct prof_sample samples[PROF_RING_SIZE];
+} __attribute__((aligned(64)));
+
+struct prof_bucket {
+    uint32_t addr;
+    uint32_t count;
+};
+
+static struct prof_ring prof_rings[PROF_MAX_CPUS];
+static struct prof_bucket prof_hist[PROF_HIST_SIZE];
+static volatile uint32_t prof_running = 0;
+static uint32_t prof_source = PROF_SRC_NONE;
+static uint32_t prof_period = 0;
+
+static inline void prof_dmb(void) {
+    asm volatile("dmb" : : : "memory");
+}
+
+static inline uint32_t prof_read_spsr(void) {
+    uint32_t spsr;
+    asm volatile("mrs %0, spsr" : "=r"(spsr));
+    return spsr;
+}
+
+/* 读取被中断模式的LR (虚拟化扩展的分组寄存器访问) */
+static uint32_t prof_banked_lr(uint32_t mode) {
+    uint32_t lr = 0;
+
+    switch (mode) {
+    case 0x13:
+        asm volatile("mrs %0, lr_svc" : "=r"(lr));
+        break;
+    case 0x10:
+    case 0x1F:
+        asm volatile("mrs %0, lr_usr" : "=r"(lr));
+        break;
+    case 0x17:
+        asm volatile("mrs %0, lr_abt" : "=r"(lr));
+        break;
+    case 0x1B:
+        asm volatile("mrs %0, lr_und" : "=r"(lr));
+        break;
+    default:
+        break;
+    }
+    return lr;
+}
+
+/* 记录一个样本 (IRQ上下文，IRQ已屏蔽) */
+static void prof_record(void) {
+    uint32_t *frame = irq_get_regs();
+    struct prof_ring *ring;
+    struct prof_sample *s;
+    struct task *t;
+    uint32_t head, mode;
+
+    if (!prof_running || frame == NULL) {
+        return;
+    }
+    ring = &prof_rings[cpu_id()];
+    head = ring->head;
+    ring->total++;
+    if (head - ring->tail >= PROF_RING_SIZE) {
+        ring->dropped++;
+        return;
+    }
+    mode = prof_read_spsr() & 0x1F;
+    t = task_current();
+    s = &ring->samples[head & (PROF_RING_SIZE - 1)];
+    s->pc = frame[PROF_FRAME_PC];
+    s->lr = prof_banked_lr(mode);
+    s->mode = mode;
+    s->task = t ? t->id : 0;
+    /* 样本内容先于head可见 */
+    prof_dmb();
+    ring->head = head + 1;
+}
+
+/* 定时器回退路径：每个滴答采样一次 */
+static void prof_timer_tick(void *data) {
+    (void)data;
+    if (prof_source == PROF_SRC_TIMER) {
+        prof_record();
+    }
+}
+
+void profiler_init(void) {
+    timer_register_callback(prof_timer_tick, NULL, 1);
+}
+
+/* 开始采样，period为PMU采样周期 (CPU周期，0取默认值) */
+int profiler_start(uint32_t period) {
+    if (prof_running) {
+        return -1;
+    }
+    prof_period = period ? period : PROF_DEFAULT_PERIOD;
+    if (pmu_sampling_start(prof_period, prof_record) == 0) {
+        prof_source = PROF_SRC_PMU;
+    } else {
+        prof_source = PROF_SRC_TIMER;
+    }
+    prof_dmb();
+    prof_running = 1;
+    return 0;
+}
+
+void profiler_stop(void) {
+    prof_running = 0;
+    if (prof_source == PROF_SRC_PMU) {
+        pmu_sampling_stop();
+    }
+    prof_dmb();
+}
+
+/* 把PC计入直方图 (开放寻址) */
+static void prof_hist_add(uint32_t pc) {
+    uint32_t addr = pc >> PROF_BUCKET_SHIFT;
+    uint32_t idx = (addr * 2654435761u) >> 24;
+
+    for (uint32_t probe = 0; probe < PROF_HIST_SIZE; probe++) {
+        struct prof_bucket *b = &prof_hist[(idx + probe) & (PROF_HIST_SIZE - 1)];
+        if (b->count == 0) {
+            b->addr = addr;
+            b->count = 1;
+            return;
+        }
+        if (b->addr == addr) {
+            b->count++;
+            return;
+        }
+    }
+}
+
+static void prof_print_histogram(uint32_t samples) {
+    uart_puts("PC直方图 (64字节桶, 前");
+    uart_put_dec(PROF_HIST_TOP);
+    uart_puts("):\r\n");
+    for (uint32_t n = 0; n < PROF_HIST_TOP; n++) {
+        struct prof_bucket *best = NULL;
+        for (uint32_t i = 0; i < PROF_HIST_SIZE; i++) {
+            if (prof_hist[i].count && (best == NULL || prof_hist[i].count > best->count)) {
+                best = &prof_hist[i];
+            }
+        }
+        if (best == NULL) {
+            break;
+        }
+        uart_puts("  ");
+        uart_put_hex(best->addr << PROF_BUCKET_SHIFT);
+        uart_puts(": ");
+        uart_put_dec(best->count);
+        uart_puts(" (");
+        uart_put_dec(best->count * 100 / samples);
+        uart_puts("%)\r\n");
+        best->count = 0;
+    }
+}
+
+/*
+ * 取出所有CPU环中的样本，输出直方图和原始样本。
+ * 原始样本格式 (供resources/profile_symbolize.py解析):
+ *   PROF-BEGIN
+ *   S <cpu> <task> <mode> <pc> <lr>
+ *   PROF-END
+ */
+void profiler_dump(void) {
+    uint32_t samples = 0, dropped = 0;
+
+    uart_puts("\r\n=== 采样分析 ===\r\n");
+    uart_puts("采样源: ");
+    uart_puts(prof_source == PROF_SRC_PMU ? "PMU周期溢出" :
+              prof_source == PROF_SRC_TIMER ? "定时器中断" : "未启动");
+    if (prof_source == PROF_SRC_PMU) {
+        uart_puts(", 周期 ");
+        uart_put_dec(prof_period);
+    }
+    uart_puts("\r\n");
+
+    memset(prof_hist, 0, sizeof(prof_hist));
+    uart_puts("PROF-BEGIN\r\n");
+    for (uint32_t cpu = 0; cpu < PROF_MAX_CPUS; cpu++) {
+        struct prof_ring *ring = &prof_rings[cpu];
+        uint32_t head = ring->head;
+
+        /* 读取head之后再读样本内容 */
+        prof_dmb();
+        for (uint32_t t = ring->tail; t != head; t++) {
+            struct prof_sample *s = &ring->samples[t & (PROF_RING_SIZE - 1)];
+            uart_puts("S ");
+            uart_put_dec(cpu);
+            uart_puts(" ");
+            uart_put_dec(s->task);
+            uart_puts(" ");
+            uart_put_hex(s->mode);
+            uart_puts(" ");
+            uart_put_hex(s->pc);
+            uart_puts(" ");
+            uart_put_hex(s->lr);
+            uart_puts("\r\n");
+            prof_hist_add(s->pc);
+            samples++;
+        }
+        /* 样本读完之后才释放槽位 */
+        prof_dmb();
+        ring->tail = head;
+        dropped += ring->dropped;
+    }
+    uart_puts("PROF-END\r\n");
+
+    uart_puts("样本: ");
+    uart_put_dec(samples);
+    uart_puts(", 丢弃: ");
+    uart_put_dec(dropped);
+    uart_puts("\r\n");
+    if (samples) {
+        prof_print_histogram(samples);
+    }
+    uart_puts("================\r\n");
+}
+
+/* ---------------- 测试 ---------------- */
+
+#define PROF_TEST_TICKS     30      /* 采样300ms */
+
+static uint8_t prof_src_buf[16384];
+static uint8_t prof_dst_buf[16384];
+
+static uint32_t prof_work_hash(uint32_t seed) {
+    for (uint32_t i = 0; i < 2000; i++) {
+        seed = (seed ^ (seed >> 13)) * 0x5bd1e995;
+    }
+    return seed;
+}
+
+static void prof_work_copy(void) {
+    memcpy(prof_dst_buf, prof_src_buf, sizeof(prof_dst_buf));
+    memset(prof_src_buf, (int)prof_dst_buf[1], sizeof(prof_src_buf));
+}
+
+/* 测试采样分析器：对哈希计算和内存拷贝两种负载采样300ms */
+void test_profiler(void) {
+    static volatile uint32_t sink;
+    uint32_t start;
+
+    uart_puts("\r\n=== 测试采样分析器 ===\r\n");
+    profiler_start(0);
+    start = get_timer_ticks();
+    while (get_timer_ticks() - start < PROF_TEST_TICKS) {
+        sink += prof_work_hash(sink);
+        prof_work_copy();
+    }
+    profiler_stop();
+    profiler_dump();
+    uart_puts("主机端: make profile-report PROF_LOG=<串口日志>\r\n");
+    uart_puts("======================\r\n");
+}
@@ -0,0 +1,335 @@
+/*
+ * SkyOS RCU (读-复制-更新)
+ * 文件: kernel/rcu.c
+ *
+ * 基于静止状态的经典RCU：
+ * 1. 宽限期编号gp_cur在开始新宽限期时加一，qs_mask为还没报告静止状态的CPU
+ * 2. rcu_note_qs()只把当前gp_cur记到本CPU的qs_seq (普通写，无原子操作)
+ * 3. rcu_tick()在定时器中断中执行：本CPU的qs_seq等于gp_cur说明宽限期开始后
+ *    经过了静止状态，清除qs_mask中本CPU的位；qs_mask清空时宽限期结束
+ * 4. 回调分三段：next (等待新宽限期) -> wait (等待当前宽限期) -> 执行
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "rcu.h"
+#include "spinlock.h"
+#include "task.h"
+#include "syscall.h"
+#include "hal.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_hex(uint32_t value);
+extern void uart_put_dec(uint32_t value);
+extern uint32_t get_timer_ticks(void);
+
+struct rcu_cpu {
+    volatile uint32_t qs_seq;       /* 最近一次静止状态时的gp_cur */
+    uint32_t qs_reported;           /* 统计：报告的静止状态数 */
+} __attribute__((aligned(64)));
+
+static struct rcu_cpu rcu_cpus[RCU_MAX_CPUS];
+static struct spinlock rcu_lock = SPINLOCK_INIT("rcu");
+static volatile uint32_t gp_cur = 0;        /* 最近开始的宽限期编号 */
+static uint32_t gp_active = 0;
+static uint32_t qs_mask = 0;                /* 当前宽限期还需要报告的CPU */
+static uint32_t online_mask = 1;            /* 启动CPU */
+static uint32_t gp_start_tick = 0;
+
+static struct rcu_head *cb_next = NULL;     /* 等待下一个宽限期 */
+static struct rcu_head **cb_next_tail = &cb_next;
+static struct rcu_head *cb_wait = NULL;     /* 等待当前宽限期结束 */
+static struct rcu_head **cb_wait_tail = &cb_wait;
+
+/* 统计 */
+static uint32_t stat_gp_completed = 0;
+static uint32_t stat_gp_ticks = 0;          /* 宽限期累计持续滴答数 */
+static uint32_t stat_gp_max_ticks = 0;
+static volatile uint32_t stat_cb_queued = 0;
+static volatile uint32_t stat_cb_invoked = 0;
+static uint32_t stat_sync_fast = 0;         /* 单CPU时synchronize_rcu直接返回 */
+
+void rcu_init(void) {
+    for (uint32_t i = 0; i < RCU_MAX_CPUS; i++) {
+        rcu_cpus[i].qs_seq = 0;
+        rcu_cpus[i].qs_reported = 0;
+    }
+    online_mask = 1u << cpu_id();
+}
+
+/* 从核上线后参与宽限期 (从下一个宽限期开始) */
+void rcu_cpu_online(uint32_t cpu) {
+    uint32_t flags = spin_lock_irqsave(&rcu_lock);
+    online_mask |= 1u << (cpu % RCU_MAX_CPUS);
+    spin_unlock_irqrestore(&rcu_lock, flags);
+}
+
+/* 本CPU经过了静止状态 (调用者不在读侧临界区内) */
+void rcu_note_qs(void) {
+    struct rcu_cpu *rc = &rcu_cpus[cpu_id()];
+    uint32_t seq = READ_ONCE(gp_cur);
+
+    if (rc->qs_seq != seq) {
+        rc->qs_seq = seq;
+    }
+}
+
+/* 开始新宽限期：next中的回调移到wait (持有rcu_lock) */
+static void rcu_start_gp(void) {
+    if (gp_active || cb_next == NULL) {
+        return;
+    }
+    cb_wait = cb_next;
+    cb_wait_tail = cb_next_tail;
+    cb_next = NULL;
+    cb_next_tail = &cb_next;
+    qs_mask = online_mask;
+    gp_active = 1;
+    gp_start_tick = get_timer_ticks();
+    smp_mb();
+    WRITE_ONCE(gp_cur, gp_cur + 1);
+}
+
+/* 结束宽限期，返回可以执行的回调链表 (持有rcu_lock) */
+static struct rcu_head *rcu_end_gp(void) {
+    struct rcu_head *done = cb_wait;
+    uint32_t ticks = get_timer_ticks() - gp_start_tick;
+
+    cb_wait = NULL;
+    cb_wait_tail = &cb_wait;
+    gp_active = 0;
+    stat_gp_completed++;
+    stat_gp_ticks += ticks;
+    if (ticks > stat_gp_max_ticks) {
+        stat_gp_max_ticks = ticks;
+    }
+    return done;
+}
+
+/* 有宽限期在进行或有待处理的回调：还需要滴答推进，空闲时不能停掉周期滴答 */
+int rcu_pending(void) {
+    return READ_ONCE(gp_active) || READ_ONCE(cb_next) != NULL;
+}
+
+/* 定时器滴答 (中断上下文)：报告静止状态、推进宽限期、执行回调 */
+void rcu_tick(void) {
+    uint32_t cpu = cpu_id();
+    struct rcu_cpu *rc = &rcu_cpus[cpu];
+    struct rcu_head *done = NULL;
+    uint32_t flags;
+
+    /* 快速路径：没有宽限期在进行，也没有待处理的回调 */
+    if (!READ_ONCE(gp_active) && READ_ONCE(cb_next) == NULL) {
+        return;
+    }
+
+    flags = spin_lock_irqsave(&rcu_lock);
+    if (gp_active && (qs_mask & (1u << cpu)) && rc->qs_seq == gp_cur) {
+        qs_mask &= ~(1u << cpu);
+        rc->qs_reported++;
+        if (qs_mask == 0) {
+            done = rcu_end_gp();
+        }
+    }
+    rcu_start_gp();
+    spin_unlock_irqrestore(&rcu_lock, flags);
+
+    /* 回调在锁外执行，可以再次调用call_rcu */
+    while (done) {
+        struct rcu_head *next = done->next;
+        done->func(done);
+        atomic_inc(&stat_cb_invoked);
+        done = next;
+    }
+}
+
+/* 登记回调：当前所有读者结束后 (一个完整的宽限期之后) 调用func */
+void call_rcu(struct rcu_head *head, void (*func)(struct rcu_head *head)) {
+    uint32_t flags;
+
+    head->func = func;
+    head->next = NULL;
+    flags = spin_lock_irqsave(&rcu_lock);
+    *cb_next_tail = head;
+    cb_next_tail = &head->next;
+    stat_cb_queued++;
+    spin_unlock_irqrestore(&rcu_lock, flags);
+}
+
+/* 等待条件成立，期间让出CPU并在空闲时报告静止状态 */
+static void rcu_wait_until(volatile uint32_t *done, uint32_t target) {
+    if (irqs_disabled()) {
+        uart_puts("RCU: 屏蔽IRQ时不能等待宽限期\r\n");
+        return;
+    }
+    while ((int32_t)(*done - target) < 0) {
+        rcu_note_qs();
+        task_yield();
+        cpu_wfi();
+    }
+}
+
+struct rcu_sync {
+    struct rcu_head head;
+    volatile uint32_t done;
+};
+
+static void rcu_sync_done(struct rcu_head *head) {
+    struct rcu_sync *s = container_of(head, struct rcu_sync, head);
+    s->done = 1;
+}
+
+/* 等待一个完整的宽限期 (不能在读侧临界区或中断中调用) */
+void synchronize_rcu(void) {
+    struct rcu_sync s;
+
+    /*
+     * 只有一个CPU在线时，调用者本身就处于静止状态，
+     * 被它打断过的中断处理程序也都已经返回，宽限期立即结束
+     */
+    if ((online_mask & (online_mask - 1)) == 0) {
+        smp_mb();
+        stat_sync_fast++;
+        return;
+    }
+    s.done = 0;
+    call_rcu(&s.head, rcu_sync_done);
+    rcu_wait_until(&s.done, 1);
+}
+
+/* 等待此前登记的所有回调执行完 */
+void rcu_barrier(void) {
+    rcu_wait_until(&stat_cb_invoked, READ_ONCE(stat_cb_queued));
+}
+
+void rcu_print_stats(void) {
+    uart_puts("\r\n=== RCU统计 ===\r\n");
+    uart_puts("宽限期: 当前 #");
+    uart_put_dec(gp_cur);
+    uart_puts(gp_active ? " (进行中, 待报告CPU掩码 " : " (空闲");
+    if (gp_active) {
+        uart_put_hex(qs_mask);
+    }
+    uart_puts(")\r\n");
+    uart_puts("完成宽限期: ");
+    uart_put_dec(stat_gp_completed);
+    if (stat_gp_completed) {
+        uart_puts(", 平均 ");
+        uart_put_dec(stat_gp_ticks * 10 / stat_gp_completed);
+        uart_puts(" ms, 最长 ");
+        uart_put_dec(stat_gp_max_ticks * 10);
+        uart_puts(" ms");
+    }
+    uart_puts("\r\n");
+    uart_puts("回调: 登记 ");
+    uart_put_dec(stat_cb_queued);
+    uart_puts(", 已执行 ");
+    uart_put_dec(stat_cb_invoked);
+    uart_puts(", synchronize_rcu快速返回 ");
+    uart_put_dec(stat_sync_fast);
+    uart_puts("\r\n");
+    for (uint32_t i = 0; i < RCU_MAX_CPUS; i++) {
+        if (online_mask & (1u << i)) {
+            uart_puts("  CPU");
+            uart_put_dec(i);
+            uart_puts(": 报告静止状态 ");
+            uart_put_dec(rcu_cpus[i].qs_reported);
+            uart_puts("\r\n");
+        }
+    }
+    uart_puts("===============\r\n");
+}
+
+/*
+ * 自检：
+ * 1. 回调要等宽限期结束才执行，rcu_barrier等到全部执行
+ * 2. 运行时注册、替换、注销系统调用，分发路径立即看到新表项
+ * 3. 为SGI注册中断处理程序，释放后旧表项经call_rcu回收
+ */
+#define RCU_TEST_CBS        4
+#define RCU_TEST_SYSCALL    (SYSCALL_MAX - 1)
+#define RCU_TEST_SGI        1
+
+static volatile uint32_t rcu_test_hits;
+static volatile uint32_t rcu_test_sgi_hits;
+
+static void rcu_test_cb(struct rcu_head *head) {
+    (void)head;
+    rcu_test_hits++;
+}
+
+static uint32_t rcu_test_sys_a(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    (void)b; (void)c; (void)d;
+    return a + 1;
+}
+
+static uint32_t rcu_test_sys_b(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    (void)b; (void)c; (void)d;
+    return a + 2;
+}
+
+static void rcu_test_sgi(uint32_t irq_id, void *data) {
+    (void)irq_id;
+    (void)data;
+    rcu_test_sgi_hits++;
+}
+
+extern int gic_request_irq(uint32_t irq_id, void (*handler)(uint32_t, void *), void *data);
+extern void gic_free_irq(uint32_t irq_id);
+extern void gic_send_sgi(uint32_t sgi_id, uint32_t target_cpu_mask);
+
+void test_rcu(void) {
+    static struct rcu_head heads[RCU_TEST_CBS];
+    uint32_t gp_before = stat_gp_completed;
+    uint32_t early, ok = 1;
+
+    uart_puts("\r\n=== RCU自检 ===\r\n");
+
+    rcu_test_hits = 0;
+    for (uint32_t i = 0; i < RCU_TEST_CBS; i++) {
+        call_rcu(&heads[i], rcu_test_cb);
+    }
+    early = rcu_test_hits;
+    rcu_barrier();
+    uart_puts("call_rcu: 登记后立即执行 ");
+    uart_put_dec(early);
+    uart_puts(", rcu_barrier后执行 ");
+    uart_put_dec(rcu_test_hits);
+    uart_puts("/");
+    uart_put_dec(RCU_TEST_CBS);
+    uart_puts(", 经过宽限期 ");
+    uart_put_dec(stat_gp_completed - gp_before);
+    uart_puts("\r\n");
+    ok &= early == 0 && rcu_test_hits == RCU_TEST_CBS;
+
+    /* 系统调用表：注册 -> 替换 -> 注销 */
+    syscall_register(RCU_TEST_SYSCALL, rcu_test_sys_a, "rcu-test");
+    ok &= syscall1(RCU_TEST_SYSCALL, 10) == 11;
+    syscall_register(RCU_TEST_SYSCALL, rcu_test_sys_b, "rcu-test2");
+    ok &= syscall1(RCU_TEST_SYSCALL, 10) == 12;
+    syscall_unregister(RCU_TEST_SYSCALL);
+    ok &= syscall1(RCU_TEST_SYSCALL, 10) == (uint32_t)-1;
+    uart_puts("系统调用表更新: ");
+    uart_puts(ok ? "通过" : "失败");
+    uart_puts("\r\n");
+
+    /* 中断处理程序表：SGI注册、触发、释放 */
+    rcu_test_sgi_hits = 0;
+    if (gic_request_irq(RCU_TEST_SGI, rcu_test_sgi, NULL) == 0) {
+        gic_send_sgi(RCU_TEST_SGI, 1u << cpu_id());
+        for (uint32_t i = 0; i < 100000 && rcu_test_sgi_hits == 0; i++) {
+            asm volatile("nop");
+        }
+        gic_free_irq(RCU_TEST_SGI);
+        rcu_barrier();
+        uart_puts("SGI处理程序: 收到 ");
+        uart_put_dec(rcu_test_sgi_hits);
+        uart_puts(" 次，已释放\r\n");
+        ok &= rcu_test_sgi_hits == 1;
+    }
+
+    uart_puts("结果: ");
+    uart_puts(ok ? "通过" : "失败");
+    uart_puts("\r\n===============\r\n");
+}
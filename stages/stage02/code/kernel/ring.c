@@ -0,0 +1,328 @@
+/*
+ * SkyOS 共享内存环形缓冲区
+ * 文件: kernel/ring.c
+ *
+ * 内核只负责分配环的页和在环满/环空时让一方睡眠：
+ * SYS_RING_WAIT先挂到等待队列，再比较调用者看到的对方索引，
+ * 索引已经变化 (对方在调用者检查之后推进过) 就立即返回，不会丢失唤醒。
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ring.h"
+#include "pipe.h"
+#include "wait.h"
+#include "task.h"
+#include "page_alloc.h"
+#include "kstring.h"
+#include "timer.h"
+#include "vfs.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_dec(uint32_t value);
+
+#define RING_MAX        8
+#define RING_EINVAL     22
+#define RING_ENOMEM     12
+#define RING_EAGAIN     11
+
+struct ring {
+    struct ring_shared *shared;     /* 控制页，数据页紧随其后 */
+    uint32_t pages;                 /* 数据页数 */
+    struct wait_queue wq[2];        /* RING_PRODUCER / RING_CONSUMER */
+};
+
+static struct ring rings[RING_MAX];
+static struct spinlock ring_lock = SPINLOCK_INIT("ring");
+
+/* 统计 */
+static uint32_t stat_creates = 0;
+static uint32_t stat_wait_calls = 0;
+static uint32_t stat_wait_eagain = 0;
+static uint32_t stat_wake_calls = 0;
+
+static struct ring *ring_lookup(struct ring_shared *r) {
+    for (uint32_t i = 0; i < RING_MAX; i++) {
+        if (rings[i].shared && rings[i].shared == r) {
+            return &rings[i];
+        }
+    }
+    return NULL;
+}
+
+/* 系统调用：创建数据区为pages页的环，返回控制页地址 (错误时为-错误码) */
+uint32_t sys_ring_create(uint32_t pages) {
+    struct ring *ring = NULL;
+    struct ring_shared *r;
+    uint32_t flags;
+
+    /* 数据区大小必须是2的幂，索引才能用掩码取模 */
+    if (pages == 0 || pages > RING_MAX_PAGES || (pages & (pages - 1))) {
+        return (uint32_t)-RING_EINVAL;
+    }
+    r = alloc_pages(pages + 1);
+    if (r == NULL) {
+        return (uint32_t)-RING_ENOMEM;
+    }
+    flags = spin_lock_irqsave(&ring_lock);
+    for (uint32_t i = 0; i < RING_MAX; i++) {
+        if (rings[i].shared == NULL) {
+            ring = &rings[i];
+            ring->shared = r;
+            break;
+        }
+    }
+    spin_unlock_irqrestore(&ring_lock, flags);
+    if (ring == NULL) {
+        free_pages(r, pages + 1);
+        return (uint32_t)-RING_ENOMEM;
+    }
+
+    memset(r, 0, sizeof(*r));
+    r->size = pages * PAGE_SIZE;
+    r->data = (uint32_t)r + PAGE_SIZE;
+    ring->pages = pages;
+    wait_queue_init(&ring->wq[RING_PRODUCER], "ring_prod");
+    wait_queue_init(&ring->wq[RING_CONSUMER], "ring_cons");
+    stat_creates++;
+    return (uint32_t)r;
+}
+
+/* 系统调用：释放环 (调用者保证双方都已停止使用) */
+uint32_t sys_ring_destroy(struct ring_shared *r) {
+    struct ring *ring;
+    uint32_t flags = spin_lock_irqsave(&ring_lock);
+
+    ring = ring_lookup(r);
+    if (ring) {
+        ring->shared = NULL;
+    }
+    spin_unlock_irqrestore(&ring_lock, flags);
+    if (ring == NULL) {
+        return (uint32_t)-RING_EINVAL;
+    }
+    free_pages(r, ring->pages + 1);
+    return 0;
+}
+
+/* 系统调用：对方索引仍等于seen时睡眠 (生产者看tail，消费者看head) */
+uint32_t sys_ring_wait(struct ring_shared *r, uint32_t side, uint32_t seen) {
+    struct ring *ring = ring_lookup(r);
+    struct wait_entry e = { 0 };
+    struct wait_queue *wq;
+    uint32_t now;
+
+    if (ring == NULL || side > RING_CONSUMER) {
+        return (uint32_t)-RING_EINVAL;
+    }
+    wq = &ring->wq[side];
+    stat_wait_calls++;
+    wait_prepare(wq, &e, 0);
+    now = side == RING_PRODUCER ? READ_ONCE(r->tail) : READ_ONCE(r->head);
+    if (now != seen) {
+        wait_finish(wq, &e);
+        stat_wait_eagain++;
+        return (uint32_t)-RING_EAGAIN;
+    }
+    wait_schedule(wq);
+    wait_finish(wq, &e);
+    return 0;
+}
+
+/* 系统调用：唤醒在side一侧睡眠的任务 */
+uint32_t sys_ring_wake(struct ring_shared *r, uint32_t side) {
+    struct ring *ring = ring_lookup(r);
+
+    if (ring == NULL || side > RING_CONSUMER) {
+        return (uint32_t)-RING_EINVAL;
+    }
+    stat_wake_calls++;
+    return wake_up_all(&ring->wq[side]);
+}
+
+void ring_print_stats(void) {
+    uint32_t active = 0, sleeps = 0;
+
+    for (uint32_t i = 0; i < RING_MAX; i++) {
+        if (rings[i].shared) {
+            active++;
+        }
+        sleeps += rings[i].wq[RING_PRODUCER].waits + rings[i].wq[RING_CONSUMER].waits;
+    }
+    uart_puts("\r\n=== 共享环统计 ===\r\n");
+    uart_puts("创建: ");
+    uart_put_dec(stat_creates);
+    uart_puts(", 使用中: ");
+    uart_put_dec(active);
+    uart_puts("\r\n");
+    uart_puts("WAIT陷入: ");
+    uart_put_dec(stat_wait_calls);
+    uart_puts(" (睡眠 ");
+    uart_put_dec(sleeps);
+    uart_puts(", 已变化 ");
+    uart_put_dec(stat_wait_eagain);
+    uart_puts("), WAKE陷入: ");
+    uart_put_dec(stat_wake_calls);
+    uart_puts("\r\n");
+    uart_puts("==================\r\n");
+}
+
+/*
+ * 吞吐量基准：同样传送RING_TEST_BYTES字节
+ * - memcpy：单任务内复制，内存带宽上限
+ * - 管道：每块数据一次write和一次read陷入，数据复制两次
+ * - 共享环：生产者直接在环内填充，消费者直接在环内读取，只在满/空时陷入
+ */
+#define RING_TEST_BYTES     (1024 * 1024)
+#define RING_TEST_CHUNK     1024
+#define RING_TEST_PAGES     4
+
+static volatile uint32_t ring_test_done;
+
+static uint32_t ring_test_mbps(uint64_t start) {
+    return timer_counter_mbps(RING_TEST_BYTES, (uint32_t)(timer_get_counter() - start));
+}
+
+/* 生产者产生的数据：第i个字为i */
+static void ring_test_fill(uint32_t *p, uint32_t word, uint32_t words) {
+    for (uint32_t i = 0; i < words; i++) {
+        p[i] = word + i;
+    }
+}
+
+static uint32_t ring_test_sum(const uint32_t *p, uint32_t words) {
+    uint32_t sum = 0;
+
+    for (uint32_t i = 0; i < words; i++) {
+        sum += p[i];
+    }
+    return sum;
+}
+
+static void ring_test_pipe_writer(void *arg) {
+    static uint32_t buf[RING_TEST_CHUNK / 4];
+    int fd = (int)arg;
+
+    for (uint32_t off = 0; off < RING_TEST_BYTES; off += RING_TEST_CHUNK) {
+        ring_test_fill(buf, off / 4, RING_TEST_CHUNK / 4);
+        syscall3(SYS_WRITE, fd, buf, RING_TEST_CHUNK);
+    }
+    syscall1(SYS_CLOSE, fd);
+    ring_test_done = 1;
+}
+
+static void ring_test_producer(void *arg) {
+    struct ring_shared *r = arg;
+    uint32_t off = 0;
+
+    while (off < RING_TEST_BYTES) {
+        void *p;
+        uint32_t n;
+
+        ring_wait_space(r);
+        n = ring_write_begin(r, &p);
+        if (n > RING_TEST_BYTES - off) {
+            n = RING_TEST_BYTES - off;
+        }
+        ring_test_fill(p, off / 4, n / 4);
+        ring_write_commit(r, n);
+        off += n;
+    }
+    ring_test_done = 1;
+}
+
+void test_ring(void) {
+    static uint32_t buf[RING_TEST_CHUNK / 4];
+    uint32_t expect = 0, sum, traps;
+    uint32_t fds[2];
+    uint64_t start;
+    struct ring_shared *r;
+    int ok = 1;
+
+    uart_puts("\r\n=== 管道/共享环自检 ===\r\n");
+    for (uint32_t i = 0; i < RING_TEST_BYTES / 4; i++) {
+        expect += i;
+    }
+
+    /* 基线：单任务内生成+复制 */
+    start = timer_get_counter();
+    sum = 0;
+    for (uint32_t off = 0; off < RING_TEST_BYTES; off += RING_TEST_CHUNK) {
+        static uint32_t src[RING_TEST_CHUNK / 4];
+        ring_test_fill(src, off / 4, RING_TEST_CHUNK / 4);
+        memcpy(buf, src, RING_TEST_CHUNK);
+        sum += ring_test_sum(buf, RING_TEST_CHUNK / 4);
+    }
+    uart_puts("memcpy基线: ");
+    uart_put_dec(ring_test_mbps(start));
+    uart_puts(" MB/s\r\n");
+    ok &= sum == expect;
+
+    /* 管道 */
+    if (syscall1(SYS_PIPE, fds) == 0) {
+        uint32_t got = 0;
+        int n;
+
+        ring_test_done = 0;
+        traps = syscall_total_count();
+        task_create("pipe-writer", ring_test_pipe_writer, (void *)fds[1]);
+        start = timer_get_counter();
+        sum = 0;
+        while ((n = (int)syscall3(SYS_READ, fds[0], buf, RING_TEST_CHUNK)) > 0) {
+            sum += ring_test_sum(buf, (uint32_t)n / 4);
+            got += (uint32_t)n;
+        }
+        uart_puts("管道: ");
+        uart_put_dec(ring_test_mbps(start));
+        uart_puts(" MB/s, 陷入 ");
+        uart_put_dec(syscall_total_count() - traps);
+        uart_puts("\r\n");
+        ok &= got == RING_TEST_BYTES && sum == expect;
+        /* 写端关闭后读端即读到EOF，写线程可能还没来得及置位 */
+        while (!ring_test_done) {
+            task_yield();
+        }
+        syscall1(SYS_CLOSE, fds[0]);
+    } else {
+        ok = 0;
+    }
+
+    /* 共享环 (零拷贝) */
+    r = (struct ring_shared *)syscall1(SYS_RING_CREATE, RING_TEST_PAGES);
+    if (!VFS_IS_ERR(r)) {
+        uint32_t got = 0;
+
+        ring_test_done = 0;
+        traps = syscall_total_count();
+        task_create("ring-producer", ring_test_producer, r);
+        start = timer_get_counter();
+        sum = 0;
+        while (got < RING_TEST_BYTES) {
+            void *p;
+            uint32_t n;
+
+            ring_wait_data(r);
+            n = ring_read_begin(r, &p);
+            sum += ring_test_sum(p, n / 4);
+            ring_read_commit(r, n);
+            got += n;
+        }
+        uart_puts("共享环: ");
+        uart_put_dec(ring_test_mbps(start));
+        uart_puts(" MB/s, 陷入 ");
+        uart_put_dec(syscall_total_count() - traps);
+        uart_puts("\r\n");
+        ok &= sum == expect;
+        while (!ring_test_done) {
+            task_yield();
+        }
+        syscall1(SYS_RING_DESTROY, r);
+    } else {
+        ok = 0;
+    }
+
+    uart_puts("结果: ");
+    uart_puts(ok ? "通过" : "失败");
+    uart_puts("\r\n======================\r\n");
+}
@@ -0,0 +1,446 @@
+/*
+ * SkyOS 自旋锁与读写锁
+ * 文件: kernel/spinlock.c
+ *
+ * 1. 票据锁：ldrex/strex取号，wfe等待owner追上，解锁时dsb+sev唤醒
+ * 2. 读写锁：写者置最高位，读者原子加一，被写者占用时wfe等待
+ * 3. LOCK_STAT打开时，锁第一次被获取时登记到统计表；
+ *    统计字段由持锁者更新 (读者用原子加)，本身不需要额外的锁
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "spinlock.h"
+#include "atomic.h"
+#include "timer.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_hex(uint32_t value);
+extern void uart_put_dec(uint32_t value);
+
+/* rwlock尝试的结果 */
+#define RW_OK       0
+#define RW_RETRY    1       /* strex失败，立即重试 */
+#define RW_BUSY     2       /* 被占用，wfe等待 */
+
+#if LOCK_STAT
+struct lock_stat_entry {
+    const char *name;
+    struct lock_stat *stat;
+    int rw;
+};
+
+static struct lock_stat_entry lock_stat_table[LOCK_STAT_MAX];
+static volatile uint32_t lock_stat_count = 0;
+static volatile uint32_t lock_stat_dropped = 0;
+
+/* CNTPCT低32位，用于等待和持有时间 (差值在2^32个计数内有效) */
+static inline uint32_t lock_clock(void) {
+    uint64_t val;
+    asm volatile("isb\n"
+                 "mrrc p15, 0, %Q0, %R0, c14" : "=r"(val));
+    return (uint32_t)val;
+}
+
+static void lock_stat_register(struct lock_stat *st, const char *name, int rw) {
+    uint32_t idx;
+
+    if (atomic_cmpxchg(&st->registered, 0, 1) != 0) {
+        return;
+    }
+    idx = atomic_add_return(&lock_stat_count, 1) - 1;
+    if (idx >= LOCK_STAT_MAX) {
+        atomic_inc(&lock_stat_dropped);
+        return;
+    }
+    lock_stat_table[idx].name = name ? name : "(未命名)";
+    lock_stat_table[idx].rw = rw;
+    lock_stat_table[idx].stat = st;
+}
+
+/* 获得锁之后由持有者调用 (读者另见read_lock) */
+static void lock_stat_acquired(struct lock_stat *st, const char *name, int rw,
+                               int contended, uint32_t wait_start, uint32_t spins) {
+    uint32_t now = lock_clock();
+
+    if (!st->registered) {
+        lock_stat_register(st, name, rw);
+    }
+    st->acquired++;
+    if (contended) {
+        st->contended++;
+        st->spins += spins;
+        st->wait_ticks += now - wait_start;
+    }
+    st->hold_start = now;
+}
+
+static void lock_stat_release(struct lock_stat *st) {
+    uint32_t hold = lock_clock() - st->hold_start;
+
+    st->hold_ticks += hold;
+    if (hold > st->hold_max) {
+        st->hold_max = hold;
+    }
+}
+#endif
+
+void spin_lock_init(struct spinlock *lock, const char *name) {
+    lock->slock = 0;
+    lock->name = name;
+#if LOCK_STAT
+    lock->stat = (struct lock_stat){ 0 };
+#endif
+}
+
+void spin_lock(struct spinlock *lock) {
+    uint32_t old, newval, tmp;
+    uint16_t ticket;
+    int contended = 0;
+    uint32_t wait_start = 0, spins = 0;
+
+    /* 原子地取号：next加一，旧值中的next就是自己的号 */
+    asm volatile("1: ldrex %0, [%3]\n"
+                 "   add %1, %0, %4\n"
+                 "   strex %2, %1, [%3]\n"
+                 "   teq %2, #0\n"
+                 "   bne 1b"
+                 : "=&r"(old), "=&r"(newval), "=&r"(tmp)
+                 : "r"(&lock->slock), "I"(1 << TICKET_SHIFT)
+                 : "cc");
+
+    ticket = (uint16_t)(old >> TICKET_SHIFT);
+    if ((uint16_t)old != ticket) {
+        contended = 1;
+#if LOCK_STAT
+        wait_start = lock_clock();
+#endif
+        while (READ_ONCE(lock->tickets.owner) != ticket) {
+            wfe();
+            spins++;
+        }
+    }
+    smp_mb();
+#if LOCK_STAT
+    lock_stat_acquired(&lock->stat, lock->name, 0, contended, wait_start, spins);
+#else
+    (void)contended;
+    (void)wait_start;
+    (void)spins;
+#endif
+}
+
+/* 锁空闲 (owner == next) 时取号成功返回1，否则不等待直接返回0 */
+int spin_trylock(struct spinlock *lock) {
+    uint32_t val, res;
+
+    asm volatile("1: ldrex %0, [%2]\n"
+                 "   subs %1, %0, %0, ror #16\n"
+                 "   bne 2f\n"
+                 "   add %0, %0, %3\n"
+                 "   strex %1, %0, [%2]\n"
+                 "   teq %1, #0\n"
+                 "   bne 1b\n"
+                 "2: clrex"
+                 : "=&r"(val), "=&r"(res)
+                 : "r"(&lock->slock), "I"(1 << TICKET_SHIFT)
+                 : "cc");
+
+    if (res != 0) {
+        return 0;
+    }
+    smp_mb();
+#if LOCK_STAT
+    lock_stat_acquired(&lock->stat, lock->name, 0, 0, 0, 0);
+#endif
+    return 1;
+}
+
+void spin_unlock(struct spinlock *lock) {
+#if LOCK_STAT
+    lock_stat_release(&lock->stat);
+#endif
+    smp_mb();
+    /* 只有持有者会写owner，半字写入不需要独占访问 */
+    lock->tickets.owner++;
+    dsb_sev();
+}
+
+int spin_is_locked(struct spinlock *lock) {
+    uint32_t v = READ_ONCE(lock->slock);
+    return (uint16_t)v != (uint16_t)(v >> TICKET_SHIFT);
+}
+
+void rwlock_init(struct rwlock *rw, const char *name) {
+    rw->lock = 0;
+    rw->name = name;
+#if LOCK_STAT
+    rw->stat = (struct lock_stat){ 0 };
+#endif
+}
+
+/* 锁字为0时写入写者标志 */
+static inline uint32_t rw_write_attempt(volatile uint32_t *p) {
+    uint32_t val, res;
+    asm volatile("ldrex %0, [%2]\n"
+                 "teq %0, #0\n"
+                 "movne %1, %4\n"
+                 "strexeq %1, %3, [%2]"
+                 : "=&r"(val), "=&r"(res)
+                 : "r"(p), "r"(RW_WRITER), "I"(RW_BUSY)
+                 : "memory", "cc");
+    return res;
+}
+
+/* 没有写者时读者数加一 */
+static inline uint32_t rw_read_attempt(volatile uint32_t *p) {
+    uint32_t val, res;
+    asm volatile("ldrex %0, [%2]\n"
+                 "adds %0, %0, #1\n"
+                 "strexpl %1, %0, [%2]\n"
+                 "movmi %1, %3"
+                 : "=&r"(val), "=&r"(res)
+                 : "r"(p), "I"(RW_BUSY)
+                 : "memory", "cc");
+    return res;
+}
+
+void read_lock(struct rwlock *rw) {
+    uint32_t res;
+    int contended = 0;
+
+    while ((res = rw_read_attempt(&rw->lock)) != RW_OK) {
+        if (res == RW_BUSY) {
+            contended = 1;
+            wfe();
+        }
+    }
+    smp_mb();
+#if LOCK_STAT
+    if (!rw->stat.registered) {
+        lock_stat_register(&rw->stat, rw->name, 1);
+    }
+    atomic_inc(&rw->stat.read_acquired);
+    if (contended) {
+        atomic_inc(&rw->stat.contended);
+    }
+#else
+    (void)contended;
+#endif
+}
+
+void read_unlock(struct rwlock *rw) {
+    uint32_t val, tmp;
+
+    smp_mb();
+    asm volatile("1: ldrex %0, [%2]\n"
+                 "   sub %0, %0, #1\n"
+                 "   strex %1, %0, [%2]\n"
+                 "   teq %1, #0\n"
+                 "   bne 1b"
+                 : "=&r"(val), "=&r"(tmp)
+                 : "r"(&rw->lock)
+                 : "memory", "cc");
+    /* 最后一个读者离开时唤醒等待的写者 */
+    if (val == 0) {
+        dsb_sev();
+    }
+}
+
+void write_lock(struct rwlock *rw) {
+    uint32_t res;
+    int contended = 0;
+    uint32_t wait_start = 0, spins = 0;
+
+    while ((res = rw_write_attempt(&rw->lock)) != RW_OK) {
+        if (res == RW_BUSY) {
+#if LOCK_STAT
+            if (!contended) {
+                wait_start = lock_clock();
+            }
+#endif
+            contended = 1;
+            spins++;
+            wfe();
+        }
+    }
+    smp_mb();
+#if LOCK_STAT
+    lock_stat_acquired(&rw->stat, rw->name, 1, contended, wait_start, spins);
+#else
+    (void)contended;
+    (void)wait_start;
+    (void)spins;
+#endif
+}
+
+int write_trylock(struct rwlock *rw) {
+    uint32_t res;
+
+    while ((res = rw_write_attempt(&rw->lock)) == RW_RETRY) {
+    }
+    if (res != RW_OK) {
+        asm volatile("clrex" : : : "memory");
+        return 0;
+    }
+    smp_mb();
+#if LOCK_STAT
+    lock_stat_acquired(&rw->stat, rw->name, 1, 0, 0, 0);
+#endif
+    return 1;
+}
+
+void write_unlock(struct rwlock *rw) {
+#if LOCK_STAT
+    lock_stat_release(&rw->stat);
+#endif
+    smp_mb();
+    WRITE_ONCE(rw->lock, 0);
+    dsb_sev();
+}
+
+void lock_print_stats(void) {
+    uart_puts("\r\n=== 锁统计 ===\r\n");
+#if LOCK_STAT
+    uint32_t n = lock_stat_count < LOCK_STAT_MAX ? lock_stat_count : LOCK_STAT_MAX;
+
+    for (uint32_t i = 0; i < n; i++) {
+        struct lock_stat *st = lock_stat_table[i].stat;
+        if (st == NULL) {
+            continue;
+        }
+        uart_puts("  ");
+        uart_puts(lock_stat_table[i].name);
+        uart_puts(lock_stat_table[i].rw ? " (读写锁)" : "");
+        uart_puts(": 获取 ");
+        uart_put_dec(st->acquired);
+        if (lock_stat_table[i].rw) {
+            uart_puts(", 读 ");
+            uart_put_dec(st->read_acquired);
+        }
+        uart_puts(", 争用 ");
+        uart_put_dec(st->contended);
+        uart_puts(", 等待 ");
+        uart_put_dec(timer_counter_to_ns(st->wait_ticks) / 1000);
+        uart_puts(" us");
+        if (st->acquired) {
+            uart_puts(", 平均持有 ");
+            uart_put_dec(timer_counter_to_ns(st->hold_ticks / st->acquired));
+            uart_puts(" ns, 最长 ");
+            uart_put_dec(timer_counter_to_ns(st->hold_max));
+            uart_puts(" ns");
+        }
+        uart_puts("\r\n");
+    }
+    if (lock_stat_dropped) {
+        uart_puts("  (另有 ");
+        uart_put_dec(lock_stat_dropped);
+        uart_puts(" 个锁超出统计表)\r\n");
+    }
+#else
+    uart_puts("LOCK_STAT未打开\r\n");
+#endif
+    uart_puts("==============\r\n");
+}
+
+/* 自检：单核上验证加锁语义，并测量无争用时各种原语的开销 */
+#define LOCK_BENCH_ROUNDS   1000
+
+static struct spinlock test_lock = SPINLOCK_INIT("test-spin");
+static struct rwlock test_rwlock = RWLOCK_INIT("test-rw");
+
+static void lock_bench_print(const char *name, uint64_t start) {
+    uint32_t ticks = (uint32_t)(timer_get_counter() - start);
+
+    uart_puts("  ");
+    uart_puts(name);
+    uart_puts(": ");
+    uart_put_dec(timer_counter_to_ns(ticks) / LOCK_BENCH_ROUNDS);
+    uart_puts(" ns/次\r\n");
+}
+
+void test_spinlock(void) {
+    int ok = 1;
+    uint32_t flags;
+    uint64_t start;
+    static volatile uint32_t counter;
+
+    uart_puts("\r\n=== 锁自检 ===\r\n");
+
+    /* 票据锁：trylock在持有时失败，解锁后owner追上next */
+    spin_lock(&test_lock);
+    ok &= spin_is_locked(&test_lock);
+    ok &= !spin_trylock(&test_lock);
+    spin_unlock(&test_lock);
+    ok &= spin_trylock(&test_lock);
+    spin_unlock(&test_lock);
+    ok &= !spin_is_locked(&test_lock);
+    ok &= test_lock.tickets.owner == test_lock.tickets.next;
+
+    /* irqsave：持锁期间IRQ被屏蔽，解锁后恢复原状态 */
+    flags = spin_lock_irqsave(&test_lock);
+    ok &= irqs_disabled();
+    spin_unlock_irqrestore(&test_lock, flags);
+    ok &= ((flags & CPSR_I_BIT) != 0) == irqs_disabled();
+
+    /* 读写锁：读者可以嵌套，有读者时写者trylock失败 */
+    read_lock(&test_rwlock);
+    read_lock(&test_rwlock);
+    ok &= test_rwlock.lock == 2;
+    ok &= !write_trylock(&test_rwlock);
+    read_unlock(&test_rwlock);
+    read_unlock(&test_rwlock);
+    ok &= write_trylock(&test_rwlock);
+    ok &= test_rwlock.lock == RW_WRITER;
+    write_unlock(&test_rwlock);
+    ok &= test_rwlock.lock == 0;
+
+    uart_puts("语义检查: ");
+    uart_puts(ok ? "通过" : "失败");
+    uart_puts("\r\n无争用开销:\r\n");
+
+    start = timer_get_counter();
+    for (uint32_t i = 0; i < LOCK_BENCH_ROUNDS; i++) {
+        counter++;
+    }
+    lock_bench_print("普通自增", start);
+
+    start = timer_get_counter();
+    for (uint32_t i = 0; i < LOCK_BENCH_ROUNDS; i++) {
+        atomic_inc(&counter);
+    }
+    lock_bench_print("atomic_inc", start);
+
+    start = timer_get_counter();
+    for (uint32_t i = 0; i < LOCK_BENCH_ROUNDS; i++) {
+        flags = local_irq_save();
+        counter++;
+        local_irq_restore(flags);
+    }
+    lock_bench_print("local_irq_save/restore", start);
+
+    start = timer_get_counter();
+    for (uint32_t i = 0; i < LOCK_BENCH_ROUNDS; i++) {
+        spin_lock(&test_lock);
+        counter++;
+        spin_unlock(&test_lock);
+    }
+    lock_bench_print("spin_lock/unlock", start);
+
+    start = timer_get_counter();
+    for (uint32_t i = 0; i < LOCK_BENCH_ROUNDS; i++) {
+        flags = spin_lock_irqsave(&test_lock);
+        counter++;
+        spin_unlock_irqrestore(&test_lock, flags);
+    }
+    lock_bench_print("spin_lock_irqsave", start);
+
+    start = timer_get_counter();
+    for (uint32_t i = 0; i < LOCK_BENCH_ROUNDS; i++) {
+        read_lock(&test_rwlock);
+        read_unlock(&test_rwlock);
+    }
+    lock_bench_print("read_lock/unlock", start);
+    uart_puts("==============\r\n");
+}
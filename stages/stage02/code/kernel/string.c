@@ -0,0 +1,281 @@
+/*
+ * SkyOS 内核字符串/内存函数
+ * 文件: kernel/string.c
+ *
+ * memcpy/memset/memcmp在kernel/memops.S中 (ldm/stm优化，另有显式使用的NEON版本)，
+ * 这里保留逐字节的参考实现用于test_memops()的正确性校验和性能对比
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "kstring.h"
+#include "page_alloc.h"
+#include "timer.h"
+#include "fpu.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_dec(uint32_t value);
+
+/* 不重叠时交给memops.S的memcpy，重叠时逐字节按方向拷贝 */
+void *memmove(void *dst, const void *src, size_t n) {
+    uint8_t *d = dst;
+    const uint8_t *s = src;
+    if (d + n <= s || s + n <= d) {
+        return memcpy(dst, src, n);
+    }
+    if (d < s) {
+        while (n--) {
+            *d++ = *s++;
+        }
+    } else {
+        d += n;
+        s += n;
+        while (n--) {
+            *--d = *--s;
+        }
+    }
+    return dst;
+}
+
+size_t strlen(const char *s) {
+    size_t len = 0;
+    while (s[len]) {
+        len++;
+    }
+    return len;
+}
+
+int strcmp(const char *a, const char *b) {
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return (uint8_t)*a - (uint8_t)*b;
+}
+
+int strncmp(const char *a, const char *b, size_t n) {
+    while (n && *a && *a == *b) {
+        a++;
+        b++;
+        n--;
+    }
+    return n ? (uint8_t)*a - (uint8_t)*b : 0;
+}
+
+/*
+ * 逐字节参考实现 (原C版本)
+ * 禁止GCC把循环识别成memcpy/memset调用，否则测到的是优化版本本身
+ */
+#define MEMOPS_BYTE_LOOP __attribute__((noinline, optimize("no-tree-loop-distribute-patterns")))
+
+static MEMOPS_BYTE_LOOP void *byte_memcpy(void *dst, const void *src, size_t n) {
+    uint8_t *d = dst;
+    const uint8_t *s = src;
+    while (n--) {
+        *d++ = *s++;
+    }
+    return dst;
+}
+
+static MEMOPS_BYTE_LOOP void *byte_memset(void *dst, int c, size_t n) {
+    uint8_t *d = dst;
+    while (n--) {
+        *d++ = (uint8_t)c;
+    }
+    return dst;
+}
+
+static MEMOPS_BYTE_LOOP int byte_memcmp(const void *a, const void *b, size_t n) {
+    const uint8_t *p = a;
+    const uint8_t *q = b;
+    for (size_t i = 0; i < n; i++) {
+        if (p[i] != q[i]) {
+            return p[i] - q[i];
+        }
+    }
+    return 0;
+}
+
+#define MEMOPS_BENCH_PAGES  4
+#define MEMOPS_BENCH_BYTES  (MEMOPS_BENCH_PAGES * PAGE_SIZE)
+#define MEMOPS_BENCH_ROUNDS 16
+
+enum { OP_MEMCPY, OP_MEMSET, OP_MEMCMP };
+enum { IMPL_BYTE, IMPL_WORD, IMPL_NEON };
+
+static uint32_t memops_run(int op, int impl, uint8_t *dst, const uint8_t *src, size_t n) {
+    uint64_t start = timer_get_counter();
+    volatile int sink = 0;
+    uint32_t flags = 0;
+
+    if (impl == IMPL_NEON) {
+        flags = kernel_neon_begin();
+    }
+    for (uint32_t i = 0; i < MEMOPS_BENCH_ROUNDS; i++) {
+        switch (op) {
+        case OP_MEMCPY:
+            if (impl == IMPL_NEON) {
+                memcpy_neon(dst, src, n);
+            } else if (impl == IMPL_WORD) {
+                memcpy(dst, src, n);
+            } else {
+                byte_memcpy(dst, src, n);
+            }
+            break;
+        case OP_MEMSET:
+            if (impl == IMPL_NEON) {
+                memset_neon(dst, (int)i, n);
+            } else if (impl == IMPL_WORD) {
+                memset(dst, (int)i, n);
+            } else {
+                byte_memset(dst, (int)i, n);
+            }
+            break;
+        default:
+            sink += impl != IMPL_BYTE ? memcmp(dst, src, n) : byte_memcmp(dst, src, n);
+            break;
+        }
+    }
+    if (impl == IMPL_NEON) {
+        kernel_neon_end(flags);
+    }
+    (void)sink;
+    return (uint32_t)(timer_get_counter() - start);
+}
+
+static void memops_bench(const char *name, int op, uint8_t *dst, const uint8_t *src, size_t n) {
+    uint32_t bytes = n * MEMOPS_BENCH_ROUNDS;
+    uint32_t slow = memops_run(op, IMPL_BYTE, dst, src, n);
+    uint32_t fast = memops_run(op, IMPL_WORD, dst, src, n);
+
+    uart_puts("  ");
+    uart_puts(name);
+    uart_puts(": 逐字节 ");
+    uart_put_dec(timer_counter_mbps(bytes, slow));
+    uart_puts(" MB/s, 优化 ");
+    uart_put_dec(timer_counter_mbps(bytes, fast));
+    uart_puts(" MB/s");
+    if (fast) {
+        uart_puts(", 加速 ");
+        uart_put_dec(slow / fast);
+        uart_puts(".");
+        uart_put_dec((slow % fast) * 10 / fast);
+        uart_puts("x");
+    }
+    /* memcmp没有NEON版本 */
+    if (op != OP_MEMCMP) {
+        uart_puts(", NEON ");
+        uart_put_dec(timer_counter_mbps(bytes, memops_run(op, IMPL_NEON, dst, src, n)));
+        uart_puts(" MB/s");
+    }
+    uart_puts("\r\n");
+}
+
+/* 各种长度和对齐组合下与逐字节版本比对结果 */
+static int memops_verify(uint8_t *a, uint8_t *b, uint8_t *ref) {
+    static const uint32_t lens[] = { 0, 1, 3, 15, 16, 17, 63, 64, 65, 100, 255, 1024, 1500 };
+    uint32_t flags;
+
+    for (uint32_t i = 0; i < 2048; i++) {
+        a[i] = (uint8_t)(i * 7 + 3);
+    }
+    for (uint32_t li = 0; li < sizeof(lens) / sizeof(lens[0]); li++) {
+        uint32_t n = lens[li];
+        for (uint32_t so = 0; so < 8; so++) {
+            for (uint32_t dof = 0; dof < 8; dof++) {
+                byte_memset(b, 0x5a, 2048);
+                byte_memset(ref, 0x5a, 2048);
+                memcpy(b + dof, a + so, n);
+                byte_memcpy(ref + dof, a + so, n);
+                if (byte_memcmp(b, ref, 2048) != 0) {
+                    return 1;
+                }
+                memset(b + dof, (int)(n + so), n);
+                byte_memset(ref + dof, (int)(n + so), n);
+                if (byte_memcmp(b, ref, 2048) != 0) {
+                    return 2;
+                }
+                byte_memcpy(b + dof, a + so, n);
+                if (memcmp(b + dof, a + so, n) != 0) {
+                    return 3;
+                }
+                if (n) {
+                    uint8_t *p = b + dof + n * 5 / 7;
+                    *p ^= 0x80;
+                    int r = memcmp(b + dof, a + so, n);
+                    int e = byte_memcmp(b + dof, a + so, n);
+                    if ((r < 0) != (e < 0) || (r > 0) != (e > 0)) {
+                        return 4;
+                    }
+                }
+
+                byte_memset(b, 0x5a, 2048);
+                byte_memset(ref, 0x5a, 2048);
+                byte_memcpy(ref + dof, a + so, n);
+                flags = kernel_neon_begin();
+                memcpy_neon(b + dof, a + so, n);
+                kernel_neon_end(flags);
+                if (byte_memcmp(b, ref, 2048) != 0) {
+                    return 5;
+                }
+                byte_memset(ref + dof, (int)(n + so), n);
+                flags = kernel_neon_begin();
+                memset_neon(b + dof, (int)(n + so), n);
+                kernel_neon_end(flags);
+                if (byte_memcmp(b, ref, 2048) != 0) {
+                    return 6;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+/* memops.S自检和与逐字节版本的吞吐量对比 */
+void test_memops(void) {
+    uint8_t *src = alloc_pages(MEMOPS_BENCH_PAGES);
+    uint8_t *dst = alloc_pages(MEMOPS_BENCH_PAGES);
+    uint8_t *ref = alloc_pages(1);
+    int err;
+
+    uart_puts("\r\n=== 内存操作基准 ===\r\n");
+    if (src == NULL || dst == NULL || ref == NULL) {
+        uart_puts("内存不足，跳过\r\n");
+        goto out;
+    }
+    err = memops_verify(src, dst, ref);
+    uart_puts("正确性校验: ");
+    if (err) {
+        uart_puts("失败 (类型 ");
+        uart_put_dec(err);
+        uart_puts(")\r\n");
+    } else {
+        uart_puts("通过\r\n");
+    }
+
+    uart_puts("对齐 (");
+    uart_put_dec(MEMOPS_BENCH_BYTES);
+    uart_puts(" 字节 x ");
+    uart_put_dec(MEMOPS_BENCH_ROUNDS);
+    uart_puts("):\r\n");
+    memops_bench("memcpy", OP_MEMCPY, dst, src, MEMOPS_BENCH_BYTES);
+    memops_bench("memset", OP_MEMSET, dst, src, MEMOPS_BENCH_BYTES);
+    memops_bench("memcmp", OP_MEMCMP, dst, dst, MEMOPS_BENCH_BYTES);
+    uart_puts("不对齐 (dst+3, src+1):\r\n");
+    memops_bench("memcpy", OP_MEMCPY, dst + 3, src + 1, MEMOPS_BENCH_BYTES - 4);
+    memops_bench("memset", OP_MEMSET, dst + 3, src, MEMOPS_BENCH_BYTES - 4);
+    memcpy(dst + 3, src + 1, MEMOPS_BENCH_BYTES - 4);
+    memops_bench("memcmp", OP_MEMCMP, dst + 3, src + 1, MEMOPS_BENCH_BYTES - 4);
+out:
+    if (src) {
+        free_pages(src, MEMOPS_BENCH_PAGES);
+    }
+    if (dst) {
+        free_pages(dst, MEMOPS_BENCH_PAGES);
+    }
+    if (ref) {
+        free_page(ref);
+    }
+    uart_puts("==================\r\n");
+}
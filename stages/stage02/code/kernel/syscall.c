@@ -7,6 +7,19 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "syscall.h"
+#include "vfs.h"
+#include "atomic.h"
+#include "spinlock.h"
+#include "rcu.h"
+#include "futex.h"
+#include "ipc.h"
+#include "pipe.h"
+#include "ring.h"
+#include "task.h"
+#include "vdso.h"
+#include "kprintf.h"
+#include "hal.h"
 
 /* 外部函数声明 */
 extern void uart_puts(const char *str);
@@ -14,60 +27,43 @@ extern void uart_putc(char c);
 extern void uart_put_hex(uint32_t value);
 extern uint32_t get_timer_ticks(void);
 
-/* 系统调用号定义 */
-#define SYS_INVALID 0
-#define SYS_WRITE   1
-#define SYS_READ    2
-#define SYS_EXIT    3
-#define SYS_GETTIME 4
-#define SYS_PRINT   5
-
-/* 系统调用参数结构 */
-struct syscall_regs {
-    uint32_t r0, r1, r2, r3, r4, r5, r6, r7;
-    uint32_t r8, r9, r10, r11, r12;
-    uint32_t lr;
-};
-
 /* 系统调用统计 */
-static uint32_t syscall_counts[16] = {0};
+static uint32_t syscall_counts[SYSCALL_MAX] = {0};
 static uint32_t total_syscalls = 0;
 
-/* 系统调用：写字符串到标准输出 */
+/* 系统调用：写数据到文件描述符 (0/1/2为控制台) */
 static uint32_t sys_write(uint32_t fd, const char *buf, uint32_t count) {
-    if (fd == 1) {  /* stdout */
-        uint32_t written = 0;
-        for (uint32_t i = 0; i < count; i++) {
-            if (buf[i] == '\0') break;  /* 遇到字符串结束符停止 */
-            uart_putc(buf[i]);
-            written++;
-        }
-        return written;
-    } else if (fd == 2) {  /* stderr */
-        uart_puts("[STDERR] ");
-        for (uint32_t i = 0; i < count; i++) {
-            if (buf[i] == '\0') break;
-            uart_putc(buf[i]);
-        }
-        return count;
-    }
-    return -1;  /* 无效的文件描述符 */
+    return (uint32_t)vfs_write((int)fd, buf, count);
 }
 
-/* 系统调用：从标准输入读取数据 (简化实现) */
+/* 系统调用：从文件描述符读取数据 */
 static uint32_t sys_read(uint32_t fd, char *buf, uint32_t count) {
-    if (fd == 0) {  /* stdin */
-        /* 简化实现：暂时不支持实际输入，返回模拟数据 */
-        const char *msg = "Hello from kernel input!\n";
-        uint32_t len = 0;
-        while (msg[len] && len < count - 1) {
-            buf[len] = msg[len];
-            len++;
-        }
-        buf[len] = '\0';
-        return len;
-    }
-    return -1;
+    return (uint32_t)vfs_read((int)fd, buf, count);
+}
+
+/* 系统调用：打开文件，返回文件描述符 */
+static uint32_t sys_open(const char *path, uint32_t flags) {
+    return (uint32_t)vfs_open(path, flags);
+}
+
+/* 系统调用：关闭文件描述符 */
+static uint32_t sys_close(uint32_t fd) {
+    return (uint32_t)vfs_close((int)fd);
+}
+
+/* 系统调用：移动文件读写位置 */
+static uint32_t sys_lseek(uint32_t fd, int32_t offset, uint32_t whence) {
+    return (uint32_t)vfs_lseek((int)fd, offset, whence);
+}
+
+/* 系统调用：映射文件 (简化参数：fd, 页对齐偏移, 长度)，返回映射地址 */
+static uint32_t sys_mmap(uint32_t fd, uint32_t offset, uint32_t len) {
+    return vfs_mmap((int)fd, offset, len);
+}
+
+/* 系统调用：解除映射 */
+static uint32_t sys_munmap(void *addr, uint32_t len) {
+    return (uint32_t)vfs_munmap(addr, len);
 }
 
 /* 系统调用：退出程序 */
@@ -82,7 +78,7 @@ static uint32_t sys_exit(uint32_t exit_code) {
     uart_puts("  Total syscalls: ");
     uart_put_hex(total_syscalls);
     uart_puts("\r\n");
-    for (int i = 1; i < 16; i++) {
+    for (int i = 1; i < SYSCALL_MAX; i++) {
         if (syscall_counts[i] > 0) {
             uart_puts("  Syscall ");
             uart_put_hex(i);
@@ -97,7 +93,7 @@ static uint32_t sys_exit(uint32_t exit_code) {
     /* 简单实现：进入死循环 */
     uart_puts("System halted by user exit.\r\n");
     while(1) {
-        asm volatile("wfi");
+        cpu_wfi();
     }
     return 0;
 }
@@ -114,128 +110,252 @@ static uint32_t sys_print(const char *str) {
     return sys_write(1, str, len);
 }
 
-/* 系统调用表 */
-typedef uint32_t (*syscall_func_t)(uint32_t, uint32_t, uint32_t, uint32_t);
+/*
+ * 系统调用表：运行时可注册/替换/注销。
+ * 表项是指向描述符的指针，分发路径在RCU读侧临界区内读取 (无锁、无原子操作)；
+ * 更新者持syscall_lock发布新描述符，旧描述符在宽限期后经call_rcu放回池中。
+ */
+struct syscall_desc {
+    syscall_func_t fn;
+    const char *name;
+    uint32_t flags;             /* SYSCALL_F_* */
+    struct rcu_head rcu;
+};
+
+#define SYSCALL_DESC(nr, f, n)  [nr] = { .fn = (syscall_func_t)(f), .name = (n) }
+#define SYSCALL_DESC_FLAGS(nr, f, n, fl) \
+    [nr] = { .fn = (syscall_func_t)(f), .name = (n), .flags = (fl) }
 
-static syscall_func_t syscall_table[] = {
-    [SYS_INVALID] = NULL,
-    [SYS_WRITE]   = (syscall_func_t)sys_write,
-    [SYS_READ]    = (syscall_func_t)sys_read,
-    [SYS_EXIT]    = (syscall_func_t)sys_exit,
-    [SYS_GETTIME] = (syscall_func_t)sys_gettime,
-    [SYS_PRINT]   = (syscall_func_t)sys_print,
+static struct syscall_desc syscall_builtin[] = {
+    /* read/write也用于管道数据传输，gettime会被用来计时，不打印调试输出 */
+    SYSCALL_DESC_FLAGS(SYS_WRITE, sys_write, "write", SYSCALL_F_NOTRACE),
+    SYSCALL_DESC_FLAGS(SYS_READ,  sys_read,  "read",  SYSCALL_F_NOTRACE),
+    SYSCALL_DESC(SYS_EXIT,    sys_exit,    "exit"),
+    SYSCALL_DESC_FLAGS(SYS_GETTIME, sys_gettime, "gettime", SYSCALL_F_NOTRACE),
+    SYSCALL_DESC(SYS_PRINT,   sys_print,   "print"),
+    SYSCALL_DESC(SYS_OPEN,    sys_open,    "open"),
+    SYSCALL_DESC(SYS_CLOSE,   sys_close,   "close"),
+    SYSCALL_DESC(SYS_LSEEK,   sys_lseek,   "lseek"),
+    SYSCALL_DESC(SYS_MMAP,    sys_mmap,    "mmap"),
+    SYSCALL_DESC(SYS_MUNMAP,  sys_munmap,  "munmap"),
+    SYSCALL_DESC(SYS_FUTEX,   sys_futex,   "futex"),
+    /* IPC：消息在r0-r7中传递，处理函数直接读写寄存器帧 */
+    SYSCALL_DESC_FLAGS(SYS_IPC_SEND,       ipc_send,       "ipc_send",
+                       SYSCALL_F_REGS | SYSCALL_F_NOTRACE),
+    SYSCALL_DESC_FLAGS(SYS_IPC_RECV,       ipc_recv,       "ipc_recv",
+                       SYSCALL_F_REGS | SYSCALL_F_NOTRACE),
+    SYSCALL_DESC_FLAGS(SYS_IPC_CALL,       ipc_call,       "ipc_call",
+                       SYSCALL_F_REGS | SYSCALL_F_NOTRACE),
+    SYSCALL_DESC_FLAGS(SYS_IPC_REPLY,      ipc_reply,      "ipc_reply",
+                       SYSCALL_F_REGS | SYSCALL_F_NOTRACE),
+    SYSCALL_DESC_FLAGS(SYS_IPC_REPLY_RECV, ipc_reply_recv, "ipc_reply_recv",
+                       SYSCALL_F_REGS | SYSCALL_F_NOTRACE),
+    /* 管道与共享环：环满/环空时的睡眠和唤醒是热路径 */
+    SYSCALL_DESC(SYS_PIPE,         sys_pipe,         "pipe"),
+    SYSCALL_DESC(SYS_RING_CREATE,  sys_ring_create,  "ring_create"),
+    SYSCALL_DESC(SYS_RING_DESTROY, sys_ring_destroy, "ring_destroy"),
+    SYSCALL_DESC_FLAGS(SYS_RING_WAIT, sys_ring_wait, "ring_wait", SYSCALL_F_NOTRACE),
+    SYSCALL_DESC_FLAGS(SYS_RING_WAKE, sys_ring_wake, "ring_wake", SYSCALL_F_NOTRACE),
+    SYSCALL_DESC(SYS_SCHED_SETAFFINITY, sys_sched_setaffinity, "sched_setaffinity"),
+    SYSCALL_DESC(SYS_SCHED_GETAFFINITY, sys_sched_getaffinity, "sched_getaffinity"),
+    SYSCALL_DESC(SYS_VDSO_PAGE,    sys_vdso_page,    "vdso_page"),
     /* 可以继续添加更多系统调用 */
 };
 
-#define SYSCALL_COUNT (sizeof(syscall_table) / sizeof(syscall_table[0]))
+#define SYSCALL_BUILTIN_COUNT   (sizeof(syscall_builtin) / sizeof(syscall_builtin[0]))
+#define SYSCALL_POOL_SIZE       16
 
-/* 系统调用名称表 (用于调试) */
-static const char* syscall_names[] = {
-    [SYS_INVALID] = "invalid",
-    [SYS_WRITE]   = "write",
-    [SYS_READ]    = "read", 
-    [SYS_EXIT]    = "exit",
-    [SYS_GETTIME] = "gettime",
-    [SYS_PRINT]   = "print",
-};
+static struct syscall_desc *syscall_table[SYSCALL_MAX];
+static struct syscall_desc syscall_pool[SYSCALL_POOL_SIZE];
+static uint8_t syscall_pool_used[SYSCALL_POOL_SIZE];
+static struct spinlock syscall_lock = SPINLOCK_INIT("syscall_table");
+static uint32_t syscall_updates = 0;
+
+/* boot/start.S的swi_handler查这个位图，置位的系统调用走完整保存r0-r12的入口 */
+uint32_t syscall_full_frame_mask = 0;
+
+void syscall_init(void) {
+    for (uint32_t i = 0; i < SYSCALL_BUILTIN_COUNT; i++) {
+        if (syscall_builtin[i].fn) {
+            syscall_table[i] = &syscall_builtin[i];
+        }
+        if (syscall_builtin[i].flags & SYSCALL_F_REGS) {
+            syscall_full_frame_mask |= 1u << i;
+        }
+    }
+}
+
+/* 宽限期结束后把动态注册的描述符放回池中 */
+static void syscall_desc_free(struct rcu_head *head) {
+    struct syscall_desc *d = container_of(head, struct syscall_desc, rcu);
+    uint32_t flags = spin_lock_irqsave(&syscall_lock);
+    syscall_pool_used[d - syscall_pool] = 0;
+    spin_unlock_irqrestore(&syscall_lock, flags);
+}
+
+/* 持有syscall_lock时替换表项，旧描述符 (内置的除外) 等宽限期后回收 */
+static void syscall_replace(uint32_t nr, struct syscall_desc *d) {
+    struct syscall_desc *old = syscall_table[nr];
+
+    rcu_assign_pointer(syscall_table[nr], d);
+    syscall_updates++;
+    if (old >= syscall_pool && old < syscall_pool + SYSCALL_POOL_SIZE) {
+        call_rcu(&old->rcu, syscall_desc_free);
+    }
+}
+
+/* 注册 (或替换) 系统调用，返回0成功，-1参数错误或描述符用完 */
+int syscall_register(uint32_t nr, syscall_func_t fn, const char *name) {
+    struct syscall_desc *d = NULL;
+    uint32_t flags;
+
+    if (nr == SYS_INVALID || nr >= SYSCALL_MAX || fn == NULL) {
+        return -1;
+    }
+    flags = spin_lock_irqsave(&syscall_lock);
+    for (uint32_t i = 0; i < SYSCALL_POOL_SIZE; i++) {
+        if (!syscall_pool_used[i]) {
+            syscall_pool_used[i] = 1;
+            d = &syscall_pool[i];
+            break;
+        }
+    }
+    if (d) {
+        d->fn = fn;
+        d->name = name;
+        d->flags = 0;
+        syscall_replace(nr, d);
+    }
+    spin_unlock_irqrestore(&syscall_lock, flags);
+    return d ? 0 : -1;
+}
+
+/* 注销系统调用，之后的调用返回错误 */
+int syscall_unregister(uint32_t nr) {
+    uint32_t flags;
+
+    if (nr == SYS_INVALID || nr >= SYSCALL_MAX) {
+        return -1;
+    }
+    flags = spin_lock_irqsave(&syscall_lock);
+    syscall_replace(nr, NULL);
+    spin_unlock_irqrestore(&syscall_lock, flags);
+    return 0;
+}
+
+/* 系统调用名 (调试输出用)，未注册时返回NULL */
+static const char *syscall_name(uint32_t nr) {
+    const struct syscall_desc *d;
+    const char *name = NULL;
+
+    rcu_read_lock();
+    d = rcu_dereference(syscall_table[nr]);
+    if (d) {
+        name = d->name;
+    }
+    rcu_read_unlock();
+    return name;
+}
+
+/* 累计系统调用次数 (基准测试统计陷入次数用) */
+uint32_t syscall_total_count(void) {
+    return READ_ONCE(total_syscalls);
+}
+
+/* 调试输出：系统调用号、名字和前四个参数 (写入日志环，由刷新工作输出) */
+static void syscall_trace(uint32_t syscall_num, const char *name,
+                          const struct syscall_regs *regs) {
+    kprintf("SWI #0x%08X%s%s%s called with args: 0x%08X, 0x%08X, 0x%08X, 0x%08X\n",
+            (unsigned int)syscall_num, name ? " (" : "", name ? name : "", name ? ")" : "",
+            (unsigned int)regs->r0, (unsigned int)regs->r1,
+            (unsigned int)regs->r2, (unsigned int)regs->r3);
+}
 
 /* SVC异常处理函数 */
 void handle_swi(uint32_t syscall_num, struct syscall_regs *regs) {
     uint32_t result = (uint32_t)-1;  /* 默认返回错误 */
+    const struct syscall_desc *desc;
+    syscall_func_t fn = NULL;
+    const char *name = NULL;
+    uint32_t flags = 0;
     
     /* 增加总的系统调用计数 */
-    total_syscalls++;
+    atomic_inc(&total_syscalls);
     
     /* 增加特定系统调用计数 */
-    if (syscall_num < 16) {
-        syscall_counts[syscall_num]++;
+    if (syscall_num < SYSCALL_MAX) {
+        atomic_inc(&syscall_counts[syscall_num]);
+    }
+    
+    /* 读侧临界区只覆盖取表项：处理函数本身可能让出CPU */
+    if (syscall_num < SYSCALL_MAX) {
+        rcu_read_lock();
+        desc = rcu_dereference(syscall_table[syscall_num]);
+        if (desc) {
+            fn = desc->fn;
+            name = desc->name;
+            flags = desc->flags;
+        }
+        rcu_read_unlock();
+    }
+    
+    /* IPC等热路径：不打印、不经过参数/返回值转换 */
+    if (flags & SYSCALL_F_REGS) {
+        ((syscall_regs_func_t)fn)(regs);
+        return;
     }
     
     /* 调试输出 */
-    uart_puts("SWI #");
-    uart_put_hex(syscall_num);
-    if (syscall_num < SYSCALL_COUNT && syscall_names[syscall_num]) {
-        uart_puts(" (");
-        uart_puts(syscall_names[syscall_num]);
-        uart_puts(")");
+    if (!(flags & SYSCALL_F_NOTRACE)) {
+        syscall_trace(syscall_num, name, regs);
     }
-    uart_puts(" called with args: ");
-    uart_put_hex(regs->r0);
-    uart_puts(", ");
-    uart_put_hex(regs->r1);
-    uart_puts(", ");
-    uart_put_hex(regs->r2);
-    uart_puts(", ");
-    uart_put_hex(regs->r3);
-    uart_puts("\r\n");
     
     /* 检查系统调用号是否有效 */
-    if (syscall_num < SYSCALL_COUNT && syscall_table[syscall_num] != NULL) {
+    if (fn != NULL) {
         /* 调用对应的系统调用函数 */
-        result = syscall_table[syscall_num](regs->r0, regs->r1, regs->r2, regs->r3);
+        result = fn(regs->r0, regs->r1, regs->r2, regs->r3);
     } else {
-        uart_puts("ERROR: Unknown system call number: ");
-        uart_put_hex(syscall_num);
-        uart_puts("\r\n");
+        pr_err("ERROR: Unknown system call number: 0x%08X\n", (unsigned int)syscall_num);
     }
     
     /* 将返回值放入r0寄存器 */
     regs->r0 = result;
 }
 
-/* 用户程序系统调用包装函数 */
-static inline uint32_t syscall(uint32_t num, uint32_t arg1, uint32_t arg2, uint32_t arg3) {
-    uint32_t result;
-    
-    asm volatile(
-        "mov r0, %1\n"     /* 系统调用号 */
-        "mov r1, %2\n"     /* 参数1 */
-        "mov r2, %3\n"     /* 参数2 */
-        "mov r3, %4\n"     /* 参数3 */
-        "svc #0\n"         /* 触发系统调用 */
-        "mov %0, r0\n"     /* 获取返回值 */
-        : "=r"(result)
-        : "r"(num), "r"(arg1), "r"(arg2), "r"(arg3)
-        : "r0", "r1", "r2", "r3"
-    );
-    
-    return result;
-}
-
 /* 测试系统调用 */
 void test_syscalls(void) {
     uart_puts("\r\n=== Testing System Calls ===\r\n");
     
     /* 测试写系统调用 */
     const char *msg1 = "Hello from syscall write!\r\n";
-    uint32_t result1 = syscall(SYS_WRITE, 1, (uint32_t)msg1, 28);
+    uint32_t result1 = syscall3(SYS_WRITE, 1, msg1, 28);
     uart_puts("Write syscall returned: ");
     uart_put_hex(result1);
     uart_puts("\r\n");
     
     /* 测试print系统调用 */
     const char *msg2 = "Hello from syscall print!\r\n";
-    uint32_t result2 = syscall(SYS_PRINT, (uint32_t)msg2, 0, 0);
+    uint32_t result2 = syscall1(SYS_PRINT, msg2);
     uart_puts("Print syscall returned: ");
     uart_put_hex(result2);
     uart_puts("\r\n");
     
     /* 测试获取时间系统调用 */
-    uint32_t time = syscall(SYS_GETTIME, 0, 0, 0);
+    uint32_t time = syscall0(SYS_GETTIME);
     uart_puts("Current time from syscall: ");
     uart_put_hex(time);
     uart_puts(" ticks\r\n");
     
     /* 测试stderr写入 */
     const char *err_msg = "This is an error message!\r\n";
-    uint32_t result3 = syscall(SYS_WRITE, 2, (uint32_t)err_msg, 28);
+    uint32_t result3 = syscall3(SYS_WRITE, 2, err_msg, 28);
     uart_puts("Stderr write returned: ");
     uart_put_hex(result3);
     uart_puts("\r\n");
     
     /* 测试读系统调用 */
     char buffer[64];
-    uint32_t result4 = syscall(SYS_READ, 0, (uint32_t)buffer, sizeof(buffer));
+    uint32_t result4 = syscall3(SYS_READ, 0, buffer, sizeof(buffer));
     uart_puts("Read syscall returned: ");
     uart_put_hex(result4);
     uart_puts(" bytes: \"");
@@ -243,7 +363,7 @@ void test_syscalls(void) {
     uart_puts("\"\r\n");
     
     /* 测试无效系统调用 */
-    uint32_t result5 = syscall(99, 0, 0, 0);
+    uint32_t result5 = syscall0(99);
     uart_puts("Invalid syscall returned: ");
     uart_put_hex(result5);
     uart_puts("\r\n");
@@ -258,11 +378,12 @@ void print_syscall_stats(void) {
     uart_put_hex(total_syscalls);
     uart_puts("\r\n");
     
-    for (uint32_t i = 1; i < SYSCALL_COUNT; i++) {
+    for (uint32_t i = 1; i < SYSCALL_MAX; i++) {
         if (syscall_counts[i] > 0) {
+            const char *name = syscall_name(i);
             uart_puts("  ");
-            if (i < sizeof(syscall_names)/sizeof(syscall_names[0]) && syscall_names[i]) {
-                uart_puts(syscall_names[i]);
+            if (name) {
+                uart_puts(name);
             } else {
                 uart_puts("syscall_");
                 uart_put_hex(i);
@@ -272,5 +393,8 @@ void print_syscall_stats(void) {
             uart_puts(" calls\r\n");
         }
     }
+    uart_puts("Table updates: ");
+    uart_put_hex(syscall_updates);
+    uart_puts("\r\n");
     uart_puts("==============================\r\n");
 } 
\ No newline at end of file
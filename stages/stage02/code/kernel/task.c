@@ -0,0 +1,974 @@
+/*
+ * SkyOS 内核线程
+ * 文件: kernel/task.c
+ *
+ * 1. 任务控制块来自静态数组，栈来自页分配器
+ * 2. 每个CPU一个就绪队列 (单链表FIFO，各自一把锁)，task_yield()把当前任务
+ *    放到本CPU队尾；定时器滴答不会在所有CPU之间争抢同一把锁
+ * 3. 切换时更新每个任务的虚拟PMU计数器
+ * 4. 退出的任务不能释放自己正在使用的栈，由下一个运行的任务回收
+ * 5. VFP/NEON寄存器不在这里保存，由kernel/fpu.c在首次使用时惰性切换
+ * 6. 阻塞的任务不在就绪队列中，task_wake把它放回某个CPU的队尾；
+ *    所有任务都阻塞时切换到本CPU的空闲任务 (kernel/idle.c)，
+ *    空闲任务创建之前在当前任务上wfi等待
+ * 7. 负载均衡：唤醒时缓存仍热 (最近运行过) 就回原CPU，否则选队列最短的
+ *    允许CPU；每SCHED_BALANCE_TICKS个滴答和CPU空闲时从最忙的CPU拉取任务，
+ *    刚运行过的任务和持有惰性FP状态的任务不迁移
+ *
+ * 加锁规则：rq->curr和队列只在持有rq->lock时修改，唤醒者在任务所在CPU的锁下
+ * 判断它是否还是该CPU的当前任务 (是则只改状态，由它自己的调度循环发现)。
+ * 切出中的任务on_cpu仍为1，其他CPU切换到它之前要等切出完成。
+ * 同时持有两把就绪队列锁时按CPU号从小到大获取。
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "task.h"
+#include "page_alloc.h"
+#include "irqflags.h"
+#include "kstring.h"
+#include "rcu.h"
+#include "atomic.h"
+#include "spinlock.h"
+#include "syscall.h"
+#include "hal.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_hex(uint32_t value);
+extern void uart_put_dec(uint32_t value);
+extern void enable_irq(void);
+extern void cpu_switch_to(struct task_context *prev, struct task_context *next);
+extern uint32_t get_timer_ticks(void);
+extern int gic_request_irq(uint32_t irq_id, void (*handler)(uint32_t, void *), void *data);
+extern void gic_send_sgi(uint32_t sgi_id, uint32_t target_cpu_mask);
+
+#define SCHED_BALANCE_TICKS     10      /* 周期均衡间隔 (100ms) */
+#define SCHED_HOT_TICKS         2       /* 切出后20ms内认为缓存仍热 */
+#define SCHED_HOT_FAIL_MAX      3       /* 连续几次因缓存热度拉不到任务后忽略热度 */
+#define SCHED_LOAD_SHIFT        8       /* 负载定点：256 = 1个可运行任务 */
+#define SCHED_IPI_SGI           3       /* 唤醒远端CPU的空闲wfi */
+
+struct runqueue {
+    struct spinlock lock;
+    struct task *head;
+    struct task *tail;
+    struct task *curr;          /* 正在运行的任务 */
+    struct task *prev;          /* 最近一次被切出的任务 (切换完成后清on_cpu) */
+    struct task *idle;          /* 空闲任务 (创建之前为该CPU的启动上下文)，固定在本CPU */
+    uint32_t cpu;
+    uint32_t nr_queued;
+    uint32_t load_avg;          /* 可运行任务数的指数平均 (定点) */
+    uint32_t ticks;
+    uint32_t balance_failed;
+    /* 统计 */
+    uint32_t switches;
+    uint32_t idle_waits;
+    uint32_t migrations_in;
+    uint32_t migrations_out;
+    uint32_t balance_runs;
+    uint32_t idle_pulls;
+} __attribute__((aligned(64)));
+
+static struct task tasks[TASK_MAX];
+static struct runqueue runqueues[SCHED_NR_CPUS];
+static uint32_t sched_online_mask = 0;
+static struct spinlock task_lock = SPINLOCK_INIT("tasks");
+static uint32_t next_task_id = 0;
+
+/* 统计 */
+static uint32_t stat_switches = 0;
+static uint32_t stat_created = 0;
+static uint32_t stat_reaped = 0;
+static uint32_t stat_blocks = 0;
+static uint32_t stat_wakeups = 0;
+static uint32_t stat_handoffs = 0;
+static uint32_t stat_hot_skips = 0;         /* 因缓存热度没有迁移 */
+static uint32_t stat_wake_remote = 0;       /* 唤醒到其他CPU */
+static uint32_t stat_ipis = 0;
+
+static inline struct runqueue *this_rq(void) {
+    return &runqueues[cpu_id()];
+}
+
+/* 以下runq_*调用者持有rq->lock */
+static void runq_push(struct runqueue *rq, struct task *t) {
+    t->run_next = NULL;
+    if (rq->tail) {
+        rq->tail->run_next = t;
+    } else {
+        rq->head = t;
+    }
+    rq->tail = t;
+    t->cpu = rq->cpu;
+    t->on_rq = 1;
+    rq->nr_queued++;
+}
+
+static struct task *runq_pop(struct runqueue *rq) {
+    struct task *t = rq->head;
+    if (t) {
+        rq->head = t->run_next;
+        if (rq->head == NULL) {
+            rq->tail = NULL;
+        }
+        t->run_next = NULL;
+        t->on_rq = 0;
+        rq->nr_queued--;
+    }
+    return t;
+}
+
+/* 返回t是否在rq中并已移出 */
+static int runq_remove(struct runqueue *rq, struct task *t) {
+    struct task **pp = &rq->head;
+    struct task *prev = NULL;
+
+    while (*pp && *pp != t) {
+        prev = *pp;
+        pp = &(*pp)->run_next;
+    }
+    if (*pp == NULL) {
+        return 0;
+    }
+    *pp = t->run_next;
+    if (rq->tail == t) {
+        rq->tail = prev;
+    }
+    t->run_next = NULL;
+    t->on_rq = 0;
+    rq->nr_queued--;
+    return 1;
+}
+
+/* 按CPU号顺序获取两把就绪队列锁 */
+static void double_rq_lock(struct runqueue *a, struct runqueue *b) {
+    if (a < b) {
+        spin_lock(&a->lock);
+        spin_lock(&b->lock);
+    } else {
+        spin_lock(&b->lock);
+        spin_lock(&a->lock);
+    }
+}
+
+static void double_rq_unlock(struct runqueue *a, struct runqueue *b) {
+    spin_unlock(&a->lock);
+    spin_unlock(&b->lock);
+}
+
+/* 让远端CPU从空闲wfi中醒来检查队列 */
+static void sched_kick(uint32_t cpu) {
+    if (cpu != cpu_id()) {
+        stat_ipis++;
+        gic_send_sgi(SCHED_IPI_SGI, 1u << cpu);
+    }
+}
+
+static void sched_ipi(uint32_t irq_id, void *data) {
+    (void)irq_id;
+    (void)data;
+}
+
+/* 切出后不久的任务缓存仍热 */
+static int task_cache_hot(const struct task *t) {
+    return get_timer_ticks() - t->last_ran < SCHED_HOT_TICKS;
+}
+
+/*
+ * 为可运行的t选择CPU：缓存仍热或原CPU空闲时留在原CPU，否则选队列最短的允许CPU。
+ * t持有惰性FP状态时寄存器只在原CPU上，只有原CPU能保存，总是留在原CPU
+ * (亲和性已不允许原CPU时，t在那里切出时由fpu_task_switch保存状态后再迁移)
+ */
+static uint32_t select_task_rq(const struct task *t) {
+    uint32_t allowed = t->affinity & sched_online_mask;
+    uint32_t best = t->cpu;
+    uint32_t best_load = 0xFFFFFFFF;
+
+    if (fpu_task_owns(t)) {
+        return t->cpu;
+    }
+    if (allowed == 0) {
+        allowed = sched_online_mask;
+    }
+    if ((allowed & (1u << t->cpu)) &&
+        (task_cache_hot(t) || READ_ONCE(runqueues[t->cpu].nr_queued) == 0)) {
+        return t->cpu;
+    }
+    for (uint32_t cpu = 0; cpu < SCHED_NR_CPUS; cpu++) {
+        uint32_t load = READ_ONCE(runqueues[cpu].nr_queued);
+        if ((allowed & (1u << cpu)) && (load < best_load || (load == best_load && cpu == t->cpu))) {
+            best = cpu;
+            best_load = load;
+        }
+    }
+    return best;
+}
+
+/* 把可运行的t放入cpu的就绪队列 (调用者已屏蔽IRQ，不持有就绪队列锁) */
+static void enqueue_task(struct task *t, uint32_t cpu) {
+    struct runqueue *rq = &runqueues[cpu];
+
+    if (t->cpu != cpu) {
+        t->migrations++;
+        runqueues[t->cpu].migrations_out++;
+        rq->migrations_in++;
+        stat_wake_remote++;
+    }
+    spin_lock(&rq->lock);
+    runq_push(rq, t);
+    spin_unlock(&rq->lock);
+    sched_kick(cpu);
+}
+
+/* 回收已退出任务的栈 (切出已完成) */
+static void task_reap(void) {
+    spin_lock(&task_lock);
+    for (uint32_t i = 0; i < TASK_MAX; i++) {
+        struct task *t = &tasks[i];
+        if (t->state == TASK_DEAD && !READ_ONCE(t->on_cpu) && t->stack) {
+            free_pages(t->stack, TASK_STACK_PAGES);
+            t->stack = NULL;
+            t->entry = NULL;
+            stat_reaped++;
+        }
+    }
+    spin_unlock(&task_lock);
+}
+
+/* 切换完成后在新任务上执行：此时prev的上下文已保存，可以在别的CPU上运行 */
+static void task_finish_switch(void) {
+    struct runqueue *rq = this_rq();
+
+    smp_mb();
+    WRITE_ONCE(rq->prev->on_cpu, 0);
+    task_reap();
+}
+
+/*
+ * 持有rq->lock (IRQ已屏蔽) 时切换到next，函数内释放锁；
+ * 返回时已重新切回当前任务 (可能在另一个CPU上)
+ */
+static void task_switch_locked(struct runqueue *rq, struct task *next) {
+    struct task *prev = rq->curr;
+
+    if (next == prev) {
+        spin_unlock(&rq->lock);
+        return;
+    }
+    /* 刚从其他CPU迁来的任务可能还没在原CPU上完成切出 */
+    while (READ_ONCE(next->on_cpu)) {
+    }
+    prev->last_ran = get_timer_ticks();
+    next->on_cpu = 1;
+    next->cpu = rq->cpu;
+    rq->prev = prev;
+    rq->curr = next;
+    rq->switches++;
+    spin_unlock(&rq->lock);
+
+    pmu_task_switch(&prev->pmu, &next->pmu);
+    fpu_task_switch(prev, next);
+    next->switches++;
+    stat_switches++;
+    cpu_switch_to(&prev->ctx, &next->ctx);
+    task_finish_switch();
+}
+
+/* 新任务的第一条执行路径 (由cpu_switch_to的bx lr进入) */
+static void task_start(void) {
+    struct task *cur;
+
+    task_finish_switch();
+    enable_irq();
+    cur = task_current();
+    cur->entry(cur->arg);
+    task_exit();
+}
+
+static struct task *task_alloc(void) {
+    for (uint32_t i = 0; i < TASK_MAX; i++) {
+        struct task *t = &tasks[i];
+        if (t->entry == NULL && t->state != TASK_RUNNABLE && t->state != TASK_BLOCKED) {
+            return t;
+        }
+    }
+    return NULL;
+}
+
+/* 把当前CPU的启动上下文登记为任务，作为该CPU的idle (固定在本CPU) */
+static struct task *task_register_boot(const char *name) {
+    struct runqueue *rq = this_rq();
+    struct task *t;
+    uint32_t len = strlen(name);
+
+    spin_lock(&task_lock);
+    t = task_alloc();
+    if (t == NULL) {
+        spin_unlock(&task_lock);
+        return NULL;
+    }
+    memset(t, 0, sizeof(*t));
+    t->id = next_task_id++;
+    t->state = TASK_RUNNABLE;
+    spin_unlock(&task_lock);
+
+    memcpy(t->name, name, len < TASK_NAME_MAX ? len + 1 : TASK_NAME_MAX - 1);
+    t->cpu = rq->cpu;
+    t->affinity = 1u << rq->cpu;
+    t->on_cpu = 1;
+    pmu_read(&t->pmu.start);
+
+    spin_lock(&rq->lock);
+    rq->curr = t;
+    rq->prev = t;
+    rq->idle = t;
+    spin_unlock(&rq->lock);
+    sched_online_mask |= 1u << rq->cpu;
+    return t;
+}
+
+/* 把正在运行的main()登记为0号任务 */
+void task_init(void) {
+    for (uint32_t i = 0; i < TASK_MAX; i++) {
+        tasks[i].state = TASK_DEAD;
+    }
+    for (uint32_t cpu = 0; cpu < SCHED_NR_CPUS; cpu++) {
+        spin_lock_init(&runqueues[cpu].lock, "runqueue");
+        runqueues[cpu].cpu = cpu;
+    }
+    task_register_boot("main");
+    gic_request_irq(SCHED_IPI_SGI, sched_ipi, NULL);
+}
+
+/* 从核启动后在该核上调用：登记启动上下文，之后参与调度和均衡 (再调用idle_init创建空闲任务) */
+void task_cpu_online(void) {
+    char name[TASK_NAME_MAX] = "boot/0";
+    uint32_t flags = local_irq_save();
+
+    name[5] = (char)('0' + cpu_id());
+    task_register_boot(name);
+    rcu_cpu_online(cpu_id());
+    local_irq_restore(flags);
+}
+
+struct task *task_current(void) {
+    return this_rq()->curr;
+}
+
+/* 分配任务控制块和栈并初始化上下文 (调用者已屏蔽IRQ)，不放入就绪队列 */
+static struct task *task_setup(const char *name, void (*entry)(void *arg), void *arg) {
+    struct task *t;
+    void *stack;
+    uint32_t len;
+
+    spin_lock(&task_lock);
+    t = task_alloc();
+    if (t == NULL || (stack = alloc_pages(TASK_STACK_PAGES)) == NULL) {
+        spin_unlock(&task_lock);
+        return NULL;
+    }
+    memset(t, 0, sizeof(*t));
+    t->id = next_task_id++;
+    t->state = TASK_RUNNABLE;
+    t->entry = entry;
+    spin_unlock(&task_lock);
+
+    len = strlen(name);
+    if (len >= TASK_NAME_MAX) {
+        len = TASK_NAME_MAX - 1;
+    }
+    memcpy(t->name, name, len);
+    t->arg = arg;
+    t->stack = stack;
+    t->ctx.sp = (uint32_t)stack + TASK_STACK_PAGES * PAGE_SIZE;
+    t->ctx.lr = (uint32_t)task_start;
+    t->cpu = cpu_id();
+    t->affinity = SCHED_ALL_CPUS;
+    t->last_ran = get_timer_ticks() - SCHED_HOT_TICKS;   /* 新任务不算缓存热 */
+    stat_created++;
+    return t;
+}
+
+/* 创建内核线程并放入就绪队列，失败返回NULL */
+struct task *task_create(const char *name, void (*entry)(void *arg), void *arg) {
+    uint32_t flags = local_irq_save();
+    struct task *t = task_setup(name, entry, arg);
+
+    if (t) {
+        t->cpu = select_task_rq(t);
+        enqueue_task(t, t->cpu);
+    }
+    local_irq_restore(flags);
+    return t;
+}
+
+/*
+ * 创建本CPU的空闲任务：没有其他可运行任务时调度器切换到它，
+ * 它不进入就绪队列、不参与负载均衡，也不计入负载
+ */
+struct task *task_create_idle(void (*entry)(void *arg), void *arg) {
+    uint32_t flags = local_irq_save();
+    struct runqueue *rq = this_rq();
+    char name[TASK_NAME_MAX] = "idle/0";
+    struct task *t;
+
+    name[5] = (char)('0' + rq->cpu);
+    t = task_setup(name, entry, arg);
+    if (t) {
+        t->idle = 1;
+        t->cpu = rq->cpu;
+        t->affinity = 1u << rq->cpu;
+        spin_lock(&rq->lock);
+        rq->idle = t;
+        spin_unlock(&rq->lock);
+    }
+    local_irq_restore(flags);
+    return t;
+}
+
+/* 让出CPU给本CPU就绪队列中的下一个任务 */
+void task_yield(void) {
+    struct runqueue *rq;
+    struct task *cur, *next;
+    uint32_t flags;
+
+    if (task_current() == NULL) {
+        return;     /* task_init之前 */
+    }
+    /* 主动让出CPU说明不在RCU读侧临界区内 */
+    rcu_note_qs();
+    flags = local_irq_save();
+    rq = this_rq();
+    cur = rq->curr;
+
+    if (cur->state == TASK_RUNNABLE && !(cur->affinity & (1u << rq->cpu))) {
+        /* 亲和性已不允许本CPU：保存FP状态，排到允许的CPU上，再切走 (那边等切出完成) */
+        fpu_task_release(cur);
+        enqueue_task(cur, select_task_rq(cur));
+        spin_lock(&rq->lock);
+        next = runq_pop(rq);
+        task_switch_locked(rq, next ? next : rq->idle);
+        local_irq_restore(flags);
+        return;
+    }
+
+    spin_lock(&rq->lock);
+    next = runq_pop(rq);
+    if (next) {
+        if (cur->state == TASK_RUNNABLE && !cur->idle) {
+            runq_push(rq, cur);
+        }
+        task_switch_locked(rq, next);
+    } else {
+        spin_unlock(&rq->lock);
+    }
+    local_irq_restore(flags);
+}
+
+/*
+ * 没有可运行的任务时在当前任务上空闲等待中断 (调用者已屏蔽IRQ)：
+ * wfi在IRQ屏蔽时也会被挂起的中断唤醒，短暂打开IRQ让处理程序执行
+ */
+static void task_idle_wait(struct runqueue *rq) {
+    rq->idle_waits++;
+    rcu_note_qs();
+    cpu_wfi();
+    local_irq_window();
+}
+
+/*
+ * 从最忙的CPU拉取任务到rq (调用者已屏蔽IRQ，不持有锁)。
+ * idle为真时本CPU没有任务可运行，只要对方队列非空就拉一个；
+ * 否则差距至少为2时拉走一半差距。返回拉取的任务数。
+ */
+static uint32_t sched_balance(struct runqueue *rq, int idle) {
+    struct runqueue *busiest = NULL;
+    uint32_t max = 0, mine, want, moved = 0, hot = 0;
+    int ignore_hot = rq->balance_failed >= SCHED_HOT_FAIL_MAX;
+
+    rq->balance_runs++;
+    for (uint32_t cpu = 0; cpu < SCHED_NR_CPUS; cpu++) {
+        uint32_t n = READ_ONCE(runqueues[cpu].nr_queued);
+        if (cpu != rq->cpu && (sched_online_mask & (1u << cpu)) && n > max) {
+            busiest = &runqueues[cpu];
+            max = n;
+        }
+    }
+    mine = READ_ONCE(rq->nr_queued);
+    if (busiest == NULL || (idle ? max == 0 : max < mine + 2)) {
+        return 0;
+    }
+    want = idle ? 1 : (max - mine) / 2;
+
+    double_rq_lock(rq, busiest);
+    for (struct task *t = busiest->head, *n; t && moved < want; t = n) {
+        n = t->run_next;
+        if (!(t->affinity & (1u << rq->cpu)) || fpu_task_owns(t)) {
+            continue;
+        }
+        if (!ignore_hot && task_cache_hot(t)) {
+            hot++;
+            continue;
+        }
+        runq_remove(busiest, t);
+        runq_push(rq, t);
+        t->migrations++;
+        busiest->migrations_out++;
+        rq->migrations_in++;
+        moved++;
+    }
+    double_rq_unlock(rq, busiest);
+
+    stat_hot_skips += hot;
+    rq->balance_failed = (moved == 0 && hot) ? rq->balance_failed + 1 : 0;
+    if (idle) {
+        rq->idle_pulls += moved;
+    }
+    return moved;
+}
+
+/*
+ * 调用者已把当前任务设为TASK_BLOCKED (如wait_prepare)，切换到其他任务，
+ * 直到被task_wake唤醒后返回。调用前已被唤醒则立即返回。
+ */
+void task_schedule(void) {
+    uint32_t flags = local_irq_save();
+    struct runqueue *rq = this_rq();
+    struct task *cur = rq->curr;
+
+    if (cur->state == TASK_BLOCKED) {
+        cur->blocks++;
+        stat_blocks++;
+    }
+    for (;;) {
+        struct task *next;
+
+        rq = this_rq();
+        spin_lock(&rq->lock);
+        if (READ_ONCE(cur->state) != TASK_BLOCKED) {
+            spin_unlock(&rq->lock);
+            break;
+        }
+        next = runq_pop(rq);
+        if (next == NULL && rq->idle->idle && rq->idle != cur) {
+            next = rq->idle;    /* 空闲任务负责从其他CPU拉任务和等待中断 */
+        }
+        if (next) {
+            task_switch_locked(rq, next);
+            continue;
+        }
+        spin_unlock(&rq->lock);
+        /* 空闲任务创建之前：先尝试从其他CPU拉任务 */
+        if (sched_balance(rq, 1) == 0) {
+            task_idle_wait(rq);
+        }
+    }
+    local_irq_restore(flags);
+}
+
+/* 唤醒阻塞的任务 (可在中断中、任何CPU上调用)，返回是否唤醒 */
+int task_wake(struct task *t) {
+    uint32_t flags = local_irq_save();
+    struct runqueue *rq = &runqueues[t->cpu];
+    int woken = 0;
+
+    spin_lock(&rq->lock);
+    if (atomic_cmpxchg(&t->state, TASK_BLOCKED, TASK_RUNNABLE) == TASK_BLOCKED) {
+        woken = 1;
+        stat_wakeups++;
+        if (rq->curr == t) {
+            /* 还没切走 (在task_schedule中空闲等待或尚未调用)，不入队 */
+            spin_unlock(&rq->lock);
+            sched_kick(rq->cpu);
+            local_irq_restore(flags);
+            return woken;
+        }
+    }
+    spin_unlock(&rq->lock);
+    if (woken) {
+        enqueue_task(t, select_task_rq(t));
+    }
+    local_irq_restore(flags);
+    return woken;
+}
+
+/*
+ * 唤醒阻塞的next并直接切换过去，不经过就绪队列 (IPC快速路径)。
+ * 当前任务已设为TASK_BLOCKED时等到被唤醒才返回，否则排到就绪队列队尾。
+ * next必须最近在本CPU上运行且允许在本CPU运行，否则退化为普通唤醒。
+ */
+void task_handoff(struct task *next) {
+    uint32_t flags = local_irq_save();
+    struct runqueue *rq = this_rq();
+    struct task *cur = rq->curr;
+
+    spin_lock(&rq->lock);
+    if (next == cur || next->cpu != rq->cpu || !(next->affinity & (1u << rq->cpu)) ||
+        atomic_cmpxchg(&next->state, TASK_BLOCKED, TASK_RUNNABLE) != TASK_BLOCKED) {
+        /* next已被唤醒或在其他CPU上：退化为普通唤醒 + 阻塞 */
+        spin_unlock(&rq->lock);
+        task_wake(next);
+        task_schedule();
+        local_irq_restore(flags);
+        return;
+    }
+    stat_wakeups++;
+    stat_handoffs++;
+    if (cur->state == TASK_BLOCKED) {
+        cur->blocks++;
+        stat_blocks++;
+    } else if (!cur->idle) {
+        runq_push(rq, cur);
+    }
+    task_switch_locked(rq, next);
+    /* 被唤醒时可能回到了另一个CPU，仍阻塞则继续等待 */
+    if (cur->state == TASK_BLOCKED) {
+        task_schedule();
+    }
+    local_irq_restore(flags);
+}
+
+/* 按任务号查找 (已退出的任务返回NULL) */
+struct task *task_find(uint32_t id) {
+    for (uint32_t i = 0; i < TASK_MAX; i++) {
+        if (tasks[i].id == id && tasks[i].state != TASK_DEAD) {
+            return &tasks[i];
+        }
+    }
+    return NULL;
+}
+
+/* 结束当前任务，栈由下一个运行的任务回收 */
+void task_exit(void) {
+    struct runqueue *rq;
+    struct task *cur, *next;
+
+    local_irq_save();
+    rq = this_rq();
+    cur = rq->curr;
+    fpu_task_exit(cur);
+    spin_lock(&rq->lock);
+    cur->state = TASK_DEAD;
+    /* 没有其他可运行任务时回到本CPU的idle上下文 (它在自己的调度循环中等待) */
+    next = runq_pop(rq);
+    task_switch_locked(rq, next ? next : rq->idle);
+    while (1) {
+        /* 不会到达 */
+    }
+}
+
+/*
+ * 修改亲和性；t在就绪队列中且不再允许所在CPU时立即迁移，当前任务在让出时迁移。
+ * 持有惰性FP状态的t不立即迁移，在原CPU上再运行一次，切出时保存状态后迁移
+ */
+int task_set_affinity(struct task *t, uint32_t mask) {
+    struct runqueue *rq;
+    uint32_t flags, cpu;
+    int requeue = 0;
+
+    mask &= SCHED_ALL_CPUS;
+    if ((mask & sched_online_mask) == 0) {
+        return -SCHED_EINVAL;
+    }
+    flags = local_irq_save();
+    /* 加锁前t可能被其他CPU迁走：锁住后t->cpu变了就换队列重试 */
+    for (;;) {
+        cpu = READ_ONCE(t->cpu);
+        rq = &runqueues[cpu];
+        spin_lock(&rq->lock);
+        if (READ_ONCE(t->cpu) == cpu) {
+            break;
+        }
+        spin_unlock(&rq->lock);
+    }
+    if (t == rq->idle && !(mask & (1u << cpu))) {
+        spin_unlock(&rq->lock);
+        local_irq_restore(flags);
+        return -SCHED_EINVAL;       /* CPU的启动上下文不能离开该CPU */
+    }
+    t->affinity = mask;
+    if (t->on_rq && !(mask & (1u << cpu)) && !fpu_task_owns(t)) {
+        /* 只有确实从本队列移出时才重新入队 (t可能刚被唤醒到其他CPU的队列) */
+        requeue = runq_remove(rq, t);
+    }
+    spin_unlock(&rq->lock);
+    if (requeue) {
+        enqueue_task(t, select_task_rq(t));
+    }
+    local_irq_restore(flags);
+
+    if (t == task_current() && !(mask & (1u << t->cpu))) {
+        task_yield();
+    }
+    return 0;
+}
+
+/* 系统调用：设置任务 (0为当前任务) 的CPU亲和性 */
+uint32_t sys_sched_setaffinity(uint32_t tid, uint32_t mask) {
+    struct task *t = tid ? task_find(tid) : task_current();
+
+    if (t == NULL) {
+        return (uint32_t)-SCHED_ESRCH;
+    }
+    return (uint32_t)task_set_affinity(t, mask);
+}
+
+/* 系统调用：读取任务 (0为当前任务) 的CPU亲和性 */
+uint32_t sys_sched_getaffinity(uint32_t tid) {
+    struct task *t = tid ? task_find(tid) : task_current();
+
+    if (t == NULL) {
+        return (uint32_t)-SCHED_ESRCH;
+    }
+    return t->affinity;
+}
+
+/*
+ * 空闲任务调用 (已屏蔽IRQ)：本CPU有可运行任务或能从其他CPU拉来时切换过去，
+ * 切回空闲任务后返回1；没有任务可运行时返回0，由调用者进入空闲状态
+ */
+int sched_idle_switch(void) {
+    struct runqueue *rq = this_rq();
+    struct task *next;
+
+    spin_lock(&rq->lock);
+    next = runq_pop(rq);
+    if (next == NULL) {
+        spin_unlock(&rq->lock);
+        if (sched_balance(rq, 1) == 0) {
+            return 0;
+        }
+        spin_lock(&rq->lock);
+        next = runq_pop(rq);
+        if (next == NULL) {
+            spin_unlock(&rq->lock);
+            return 0;
+        }
+    }
+    task_switch_locked(rq, next);
+    return 1;
+}
+
+/* 本CPU的就绪队列非空 (空闲轮询时检查) */
+int sched_need_resched(void) {
+    return READ_ONCE(this_rq()->nr_queued) != 0;
+}
+
+/* 所有CPU上可运行 (排队或正在运行) 的任务数，不含空闲任务 */
+uint32_t sched_nr_running(void) {
+    uint32_t n = 0;
+
+    for (uint32_t cpu = 0; cpu < SCHED_NR_CPUS; cpu++) {
+        struct runqueue *rq = &runqueues[cpu];
+        struct task *curr = READ_ONCE(rq->curr);
+
+        if (!(sched_online_mask & (1u << cpu))) {
+            continue;
+        }
+        n += READ_ONCE(rq->nr_queued);
+        if (curr && !curr->idle && curr->state == TASK_RUNNABLE) {
+            n++;
+        }
+    }
+    return n;
+}
+
+/* 定时器中断中调用：更新本CPU负载，周期性地均衡 */
+void sched_tick(void) {
+    struct runqueue *rq = this_rq();
+    uint32_t sample;
+
+    if (rq->curr == NULL) {
+        return;     /* 本CPU尚未参与调度 */
+    }
+    spin_lock(&rq->lock);
+    sample = rq->nr_queued + (rq->curr->state == TASK_RUNNABLE && !rq->curr->idle);
+    /* load = load * 7/8 + sample/8 */
+    rq->load_avg = rq->load_avg - (rq->load_avg >> 3) + (sample << (SCHED_LOAD_SHIFT - 3));
+    spin_unlock(&rq->lock);
+
+    if (++rq->ticks % SCHED_BALANCE_TICKS == 0 && (sched_online_mask & ~(1u << rq->cpu))) {
+        sched_balance(rq, 0);
+    }
+}
+
+/* 打印任务表和每个任务的性能计数 */
+void task_print_stats(void) {
+    static const char *const state_names[] = { "就绪", "阻塞", "退出" };
+    struct task *cur = task_current();
+    struct pmu_counts c;
+
+    uart_puts("\r\n=== 任务统计 ===\r\n");
+    for (uint32_t i = 0; i < TASK_MAX; i++) {
+        struct task *t = &tasks[i];
+        if (t->state == TASK_DEAD && t->switches == 0 && t != &tasks[0]) {
+            continue;
+        }
+        uart_puts("  [");
+        uart_put_dec(t->id);
+        uart_puts("] ");
+        uart_puts(t->name);
+        uart_puts(" ");
+        uart_puts(state_names[t->state]);
+        uart_puts(t == cur ? " (运行中)" : "");
+        uart_puts(", CPU");
+        uart_put_dec(t->cpu);
+        uart_puts(", 切入 ");
+        uart_put_dec(t->switches);
+        uart_puts(", 阻塞 ");
+        uart_put_dec(t->blocks);
+        if (t->migrations) {
+            uart_puts(", 迁移 ");
+            uart_put_dec(t->migrations);
+        }
+        if (t->fpu.used) {
+            uart_puts(", FP陷入 ");
+            uart_put_dec(t->fpu.traps);
+        }
+        uart_puts("\r\n      ");
+        pmu_task_read(&t->pmu, t == cur, &c);
+        pmu_print_counts(&c);
+    }
+    uart_puts("切换次数: ");
+    uart_put_dec(stat_switches);
+    uart_puts(", 创建: ");
+    uart_put_dec(stat_created);
+    uart_puts(", 回收: ");
+    uart_put_dec(stat_reaped);
+    uart_puts("\r\n");
+    uart_puts("阻塞: ");
+    uart_put_dec(stat_blocks);
+    uart_puts(", 唤醒: ");
+    uart_put_dec(stat_wakeups);
+    uart_puts(", 直接切换: ");
+    uart_put_dec(stat_handoffs);
+    uart_puts("\r\n");
+    uart_puts("================\r\n");
+}
+
+/* 打印每个CPU的负载、迁移和均衡统计 */
+void sched_print_stats(void) {
+    uart_puts("\r\n=== 调度器统计 ===\r\n");
+    for (uint32_t cpu = 0; cpu < SCHED_NR_CPUS; cpu++) {
+        struct runqueue *rq = &runqueues[cpu];
+        uint32_t load = rq->load_avg;
+
+        if (!(sched_online_mask & (1u << cpu))) {
+            continue;
+        }
+        uart_puts("  CPU");
+        uart_put_dec(cpu);
+        uart_puts(": 当前 ");
+        uart_puts(rq->curr ? rq->curr->name : "-");
+        uart_puts(", 排队 ");
+        uart_put_dec(rq->nr_queued);
+        uart_puts(", 负载 ");
+        uart_put_dec(load >> SCHED_LOAD_SHIFT);
+        uart_puts(".");
+        uart_put_dec(((load & ((1u << SCHED_LOAD_SHIFT) - 1)) * 100) >> SCHED_LOAD_SHIFT);
+        uart_puts(", 切换 ");
+        uart_put_dec(rq->switches);
+        uart_puts(", 空闲等待 ");
+        uart_put_dec(rq->idle_waits);
+        uart_puts("\r\n        迁入 ");
+        uart_put_dec(rq->migrations_in);
+        uart_puts(", 迁出 ");
+        uart_put_dec(rq->migrations_out);
+        uart_puts(", 均衡 ");
+        uart_put_dec(rq->balance_runs);
+        uart_puts(", 空闲拉取 ");
+        uart_put_dec(rq->idle_pulls);
+        uart_puts("\r\n");
+    }
+    uart_puts("在线CPU: ");
+    uart_put_hex(sched_online_mask);
+    uart_puts(", 缓存热跳过: ");
+    uart_put_dec(stat_hot_skips);
+    uart_puts(", 跨CPU唤醒: ");
+    uart_put_dec(stat_wake_remote);
+    uart_puts(", IPI: ");
+    uart_put_dec(stat_ipis);
+    uart_puts("\r\n");
+    uart_puts("==================\r\n");
+}
+
+/*
+ * 自检：亲和性系统调用的参数检查，以及绑定到某个CPU的任务只在该CPU上运行。
+ * 只有0号CPU在线时迁移和均衡路径不会触发，统计中迁移数为0；
+ * 这些路径由主机测试 (host/sched/test_task.c) 模拟两个CPU覆盖。
+ */
+#define SCHED_TEST_TASKS    3
+#define SCHED_TEST_ROUNDS   20
+
+struct sched_test_arg {
+    uint32_t seen_mask;         /* 运行过的CPU */
+    uint32_t rounds;
+};
+
+static void sched_test_task(void *arg) {
+    struct sched_test_arg *a = arg;
+
+    for (uint32_t i = 0; i < SCHED_TEST_ROUNDS; i++) {
+        a->seen_mask |= 1u << cpu_id();
+        a->rounds++;
+        task_yield();
+    }
+}
+
+void test_sched(void) {
+    static struct sched_test_arg args[SCHED_TEST_TASKS];
+    struct task *t[SCHED_TEST_TASKS];
+    uint32_t offline = SCHED_ALL_CPUS & ~sched_online_mask;
+    uint32_t first = sched_online_mask & -sched_online_mask;
+    uint32_t ok = 1, done;
+
+    uart_puts("\r\n=== SMP调度自检 ===\r\n");
+
+    /* 参数检查 */
+    ok &= (syscall1(SYS_SCHED_GETAFFINITY, 0) & (1u << cpu_id())) != 0;
+    ok &= syscall2(SYS_SCHED_SETAFFINITY, 0, 0) == (uint32_t)-SCHED_EINVAL;
+    if (offline) {
+        ok &= syscall2(SYS_SCHED_SETAFFINITY, 0, offline) == (uint32_t)-SCHED_EINVAL;
+    }
+    ok &= syscall2(SYS_SCHED_SETAFFINITY, 9999, first) == (uint32_t)-SCHED_ESRCH;
+    uart_puts("亲和性参数检查: ");
+    uart_puts(ok ? "通过" : "失败");
+    uart_puts("\r\n");
+
+    /* 绑定到第一个在线CPU的任务和不限CPU的任务 */
+    for (uint32_t i = 0; i < SCHED_TEST_TASKS; i++) {
+        args[i].seen_mask = 0;
+        args[i].rounds = 0;
+        t[i] = task_create("sched-test", sched_test_task, &args[i]);
+        if (t[i] == NULL) {
+            ok = 0;
+        }
+    }
+    if (t[0]) {
+        ok &= syscall2(SYS_SCHED_SETAFFINITY, t[0]->id, first) == 0;
+        ok &= syscall1(SYS_SCHED_GETAFFINITY, t[0]->id) == first;
+    }
+    do {
+        task_yield();
+        done = 0;
+        for (uint32_t i = 0; i < SCHED_TEST_TASKS; i++) {
+            done += t[i] == NULL || args[i].rounds == SCHED_TEST_ROUNDS;
+        }
+    } while (done < SCHED_TEST_TASKS);
+
+    for (uint32_t i = 0; i < SCHED_TEST_TASKS; i++) {
+        uart_puts("  任务");
+        uart_put_dec(i);
+        uart_puts(i == 0 ? " (绑定)" : "");
+        uart_puts(": 运行过的CPU ");
+        uart_put_hex(args[i].seen_mask);
+        uart_puts("\r\n");
+    }
+    ok &= (args[0].seen_mask & ~first) == 0;
+
+    uart_puts("结果: ");
+    uart_puts(ok ? "通过" : "失败");
+    uart_puts("\r\n===================\r\n");
+    sched_print_stats();
+}
@@ -3,57 +3,70 @@
  * 文件: kernel/timer.c
  * 
  * 实现ARM Generic Timer的配置和中断处理
+ *
+ * 周期滴答按CNTP_CVAL设定绝对截止时间，不随中断延迟漂移。空闲任务可以用
+ * timer_stop_tick停掉若干个滴答 (到下一个定时事件为止)，醒来后中断处理
+ * 根据计数器补上错过的滴答数。
  */
 
 #include <stdint.h>
+#include <stddef.h>
+#include "driver.h"
+#include "timer.h"
+#include "task.h"
+#include "atomic.h"
+#include "rcu.h"
+#include "spinlock.h"
+#include "vdso.h"
+#include "idle.h"
+#include "kprintf.h"
+#include "hal.h"
 
 /* 外部函数声明 */
 extern void uart_puts(const char *str);
 extern void uart_put_hex(uint32_t value);
+extern void uart_put_dec(uint32_t value);
+extern void gic_setup_timer_irq(uint32_t irq_id);
 
-/* ARM Generic Timer寄存器访问函数 */
-static inline uint32_t read_cntfrq(void) {
-    uint32_t freq;
-    asm volatile("mrc p15, 0, %0, c14, c0, 0" : "=r"(freq));
-    return freq;
-}
-
-static inline uint64_t read_cntpct(void) {
-    uint64_t val;
-    asm volatile("mrrc p15, 0, %Q0, %R0, c14" : "=r"(val));
-    return val;
-}
-
-static inline uint32_t read_cntp_tval(void) {
-    uint32_t tval;
-    asm volatile("mrc p15, 0, %0, c14, c2, 0" : "=r"(tval));
-    return tval;
-}
-
-static inline void write_cntp_tval(uint32_t tval) {
-    asm volatile("mcr p15, 0, %0, c14, c2, 0" : : "r"(tval));
-}
-
-static inline uint32_t read_cntp_ctl(void) {
-    uint32_t ctl;
-    asm volatile("mrc p15, 0, %0, c14, c2, 1" : "=r"(ctl));
-    return ctl;
-}
-
-static inline void write_cntp_ctl(uint32_t ctl) {
-    asm volatile("mcr p15, 0, %0, c14, c2, 1" : : "r"(ctl));
-}
+/* 定时器节点interrupts顺序: 安全物理、非安全物理、虚拟、Hyp，使用非安全物理定时器 */
+#define TIMER_DT_IRQ_INDEX  1
+#define TIMER_IRQ_DEFAULT   30
 
 /* Timer Control register bits */
 #define CNTP_CTL_ENABLE     (1 << 0)   /* Timer enable */
 #define CNTP_CTL_IMASK      (1 << 1)   /* Timer interrupt mask */
 #define CNTP_CTL_ISTATUS    (1 << 2)   /* Timer interrupt status */
 
+/* 周期回调 (在定时器中断上下文中执行，必须短小且不能阻塞) */
+#define TIMER_MAX_CALLBACKS 8
+
+/* 空闲时最多停掉的滴答数 (0.5秒)，补滴答的循环次数有界 */
+#define TIMER_MAX_IDLE_TICKS    50
+
+typedef void (*timer_callback_t)(void *data);
+
+struct timer_callback {
+    timer_callback_t fn;
+    void *data;
+    uint32_t period;            /* 周期 (滴答) */
+    uint32_t next;              /* 下次触发的滴答数 */
+};
+
 /* 全局变量 */
+static struct timer_callback timer_callbacks[TIMER_MAX_CALLBACKS];
 static uint32_t timer_frequency = 0;
 static volatile uint32_t timer_ticks = 0;
 static volatile uint32_t timer_interrupts = 0;
+
+/* 定时睡眠的任务，按唤醒滴答升序 */
+static struct task *sleep_head = NULL;
+static struct spinlock sleep_lock = SPINLOCK_INIT("timer_sleep");
+static uint32_t stat_sleeps = 0;
 static uint32_t timer_interval = 0;
+static uint64_t timer_last_tick = 0;        /* 最近一个滴答的截止时间 (计数器值) */
+static volatile uint32_t timer_tick_stopped = 0;
+static uint32_t stat_tick_stops = 0;
+static uint32_t stat_ticks_skipped = 0;     /* 停滴答期间省掉的中断数 */
 
 /* 获取定时器频率 */
 uint32_t timer_get_frequency(void) {
@@ -88,10 +101,17 @@ void timer_set_control(uint32_t ctl) {
     write_cntp_ctl(ctl);
 }
 
-/* 初始化ARM Generic Timer */
-void timer_init(void) {
+/* 初始化ARM Generic Timer (平台驱动probe，依赖GIC) */
+static int timer_probe(struct platform_device *pdev) {
+    uint32_t irq = TIMER_IRQ_DEFAULT;
+    
     uart_puts("初始化ARM Generic Timer...\r\n");
     
+    if (pdev->node->nr_irqs > TIMER_DT_IRQ_INDEX) {
+        irq = pdev->node->irqs[TIMER_DT_IRQ_INDEX];
+    }
+    gic_setup_timer_irq(irq);
+    
     /* 获取定时器频率 */
     timer_frequency = timer_get_frequency();
     uart_puts("定时器频率: ");
@@ -103,37 +123,184 @@ void timer_init(void) {
     uart_puts("定时器间隔: ");
     uart_put_hex(timer_interval);
     uart_puts(" 计数 (10ms)\r\n");
+    vdso_init(timer_frequency);
     
     /* 禁用定时器中断并清除状态 */
     timer_set_control(0);
     
-    /* 设置定时器值 */
-    timer_set_tval(timer_interval);
+    /* 第一个滴答的截止时间 */
+    timer_last_tick = timer_get_counter();
+    write_cntp_cval(timer_last_tick + timer_interval);
     
     /* 启用定时器，不屏蔽中断 */
     timer_set_control(CNTP_CTL_ENABLE);
     
     uart_puts("ARM Generic Timer 初始化完成\r\n");
+    return 0;
+}
+
+static const char *const timer_match[] = { "arm,armv7-timer", NULL };
+static const char *const timer_depends[] = { "gic", NULL };
+
+PLATFORM_DRIVER(timer_driver) = {
+    .name = "timer",
+    .match = timer_match,
+    .depends = timer_depends,
+    .probe = timer_probe,
+};
+
+/* 注册周期回调，每period_ticks个滴答调用一次 */
+int timer_register_callback(timer_callback_t fn, void *data, uint32_t period_ticks) {
+    for (uint32_t i = 0; i < TIMER_MAX_CALLBACKS; i++) {
+        if (timer_callbacks[i].fn == 0) {
+            timer_callbacks[i].data = data;
+            timer_callbacks[i].period = period_ticks ? period_ticks : 1;
+            timer_callbacks[i].next = timer_ticks + timer_callbacks[i].period;
+            timer_callbacks[i].fn = fn;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/* 执行到期的周期回调 */
+static void timer_run_callbacks(void) {
+    for (uint32_t i = 0; i < TIMER_MAX_CALLBACKS; i++) {
+        struct timer_callback *cb = &timer_callbacks[i];
+        if (cb->fn && (int32_t)(timer_ticks - cb->next) >= 0) {
+            cb->next = timer_ticks + cb->period;
+            cb->fn(cb->data);
+        }
+    }
+}
+
+/* 唤醒到期的睡眠任务 (定时器中断中调用) */
+static void timer_wake_sleepers(void) {
+    if (READ_ONCE(sleep_head) == NULL) {
+        return;
+    }
+    spin_lock(&sleep_lock);
+    while (sleep_head && (int32_t)(timer_ticks - sleep_head->wake_tick) >= 0) {
+        struct task *t = sleep_head;
+        sleep_head = t->sleep_next;
+        t->sleep_next = NULL;
+        task_wake(t);
+    }
+    spin_unlock(&sleep_lock);
+}
+
+/* 当前任务睡眠到wake_tick，由定时器中断唤醒 */
+static void timer_sleep_until(uint32_t wake_tick) {
+    struct task *cur = task_current();
+    struct task **pp;
+    uint32_t flags = spin_lock_irqsave(&sleep_lock);
+
+    cur->wake_tick = wake_tick;
+    pp = &sleep_head;
+    while (*pp && (int32_t)((*pp)->wake_tick - wake_tick) <= 0) {
+        pp = &(*pp)->sleep_next;
+    }
+    cur->sleep_next = *pp;
+    *pp = cur;
+    cur->state = TASK_BLOCKED;
+    stat_sleeps++;
+    spin_unlock_irqrestore(&sleep_lock, flags);
+    task_schedule();
+}
+
+/* 从最近一个滴答到now经过的完整滴答数，同时推进timer_last_tick */
+static uint32_t timer_advance_ticks(uint64_t now) {
+    uint32_t n = 0;
+
+    while (timer_last_tick + timer_interval <= now) {
+        timer_last_tick += timer_interval;
+        n++;
+    }
+    return n;
+}
+
+/*
+ * 空闲任务调用 (IRQ已屏蔽)：停掉周期滴答，ticks个滴答之后才产生定时器中断。
+ * 被其他中断提前唤醒时调用timer_restart_tick恢复
+ */
+void timer_stop_tick(uint32_t ticks) {
+    if (ticks > TIMER_MAX_IDLE_TICKS) {
+        ticks = TIMER_MAX_IDLE_TICKS;
+    }
+    if (ticks < 2 || timer_interval == 0) {
+        return;
+    }
+    timer_tick_stopped = 1;
+    stat_tick_stops++;
+    write_cntp_cval(timer_last_tick + (uint64_t)ticks * timer_interval);
+}
+
+/* 恢复周期滴答：错过的滴答已经到期时中断立即触发，由中断处理补上 */
+void timer_restart_tick(void) {
+    if (!timer_tick_stopped) {
+        return;
+    }
+    timer_tick_stopped = 0;
+    write_cntp_cval(timer_last_tick + timer_interval);
+}
+
+/* 距离下一个定时事件 (睡眠任务唤醒、周期回调) 的滴答数，没有事件时为上限 */
+uint32_t timer_next_event(void) {
+    uint32_t now = timer_ticks;
+    uint32_t next = TIMER_MAX_IDLE_TICKS;
+    struct task *t = READ_ONCE(sleep_head);
+
+    if (t) {
+        int32_t d = (int32_t)(t->wake_tick - now);
+        if (d < (int32_t)next) {
+            next = d > 0 ? (uint32_t)d : 0;
+        }
+    }
+    for (uint32_t i = 0; i < TIMER_MAX_CALLBACKS; i++) {
+        struct timer_callback *cb = &timer_callbacks[i];
+        if (cb->fn) {
+            int32_t d = (int32_t)(cb->next - now);
+            if (d < (int32_t)next) {
+                next = d > 0 ? (uint32_t)d : 0;
+            }
+        }
+    }
+    return next;
 }
 
 /* 定时器中断处理函数 */
 void timer_handle_interrupt(void) {
+    uint32_t n, old_ticks = timer_ticks;
+    
     /* 增加中断计数 */
-    timer_interrupts++;
-    timer_ticks++;
+    atomic_inc(&timer_interrupts);
     
-    /* 重新设置下次中断 */
-    timer_set_tval(timer_interval);
+    /* 补上停滴答 (或中断被长时间屏蔽) 期间错过的滴答，设定下一个截止时间 */
+    n = timer_advance_ticks(timer_get_counter());
+    if (n == 0) {
+        /* 截止时间还没到 (如刚恢复滴答时的残留中断)，重新设定后返回 */
+        write_cntp_cval(timer_last_tick + timer_interval);
+        return;
+    }
+    if (n > 1) {
+        stat_ticks_skipped += n - 1;
+    }
+    timer_tick_stopped = 0;
+    write_cntp_cval(timer_last_tick + timer_interval);
+    atomic_add_return(&timer_ticks, n);
+    vdso_update(timer_ticks);
+    
+    timer_wake_sleepers();
+    timer_run_callbacks();
+    rcu_tick();
+    sched_tick();
+    idle_tick(n);
     
-    /* 每秒输出一次统计信息 (100次中断 = 1秒) */
-    if (timer_ticks % 100 == 0) {
-        uart_puts("⏰ 定时器: ");
-        uart_put_hex(timer_ticks / 100);
-        uart_puts("秒 (");
-        uart_put_hex(timer_ticks);
-        uart_puts(" 滴答, ");
-        uart_put_hex(timer_interrupts);
-        uart_puts(" 中断)\r\n");
+    /* 每秒输出一次统计信息 (100个滴答 = 1秒) */
+    if (old_ticks / 100 != timer_ticks / 100) {
+        kprintf("⏰ 定时器: %u秒 (%u 滴答, %u 中断)\n",
+                (unsigned int)(timer_ticks / 100), (unsigned int)timer_ticks,
+                (unsigned int)timer_interrupts);
     }
 }
 
@@ -199,17 +366,36 @@ void timer_print_status(void) {
     uart_put_hex((timer_ticks % 100) / 10);
     uart_puts(" 秒\r\n");
     
+    uart_puts("停滴答: ");
+    uart_put_dec(stat_tick_stops);
+    uart_puts(" 次, 省掉中断 ");
+    uart_put_dec(stat_ticks_skipped);
+    uart_puts(" 次\r\n");
+    
+    /* 1/5/15分钟平均可运行任务数和本CPU时间分布 */
+    idle_print_load();
+    
     uart_puts("=============================\r\n");
 }
 
-/* 延时函数 (基于定时器) */
+/*
+ * 延时函数 (基于定时器)
+ * 有任务上下文且IRQ打开时睡眠到期由定时器中断唤醒，期间运行其他任务；
+ * task_init之前或IRQ被屏蔽时退化为wfi等待
+ */
 void timer_delay_ms(uint32_t milliseconds) {
     uint32_t start_ticks = timer_ticks;
     uint32_t target_ticks = start_ticks + (milliseconds / 10); /* 10ms per tick */
     
-    while (timer_ticks < target_ticks) {
-        /* 等待定时器中断 */
-        asm volatile("wfi");
+    if (task_current() && !irqs_disabled()) {
+        if (target_ticks != start_ticks) {
+            timer_sleep_until(target_ticks);
+        }
+        return;
+    }
+    while ((int32_t)(timer_ticks - target_ticks) < 0) {
+        rcu_note_qs();
+        cpu_wfi();
     }
 }
 
@@ -235,16 +421,33 @@ uint64_t timer_get_timestamp_us(void) {
     return counter_low / freq_mhz;
 }
 
-/* 性能测量辅助函数 */
-typedef struct {
-    uint64_t start_counter;
-    const char *name;
-} timer_benchmark_t;
+/* 计数器差值换算成纳秒 (只用32位除法，自检和统计打印用) */
+uint32_t timer_counter_to_ns(uint32_t delta) {
+    uint32_t mhz = timer_get_frequency() / 1000000;
 
-/* 开始性能测量 */
+    if (mhz == 0) {
+        return 0;
+    }
+    return delta / mhz * 1000 + (delta % mhz) * 1000 / mhz;
+}
+
+/* 用时delta个计数处理bytes字节的吞吐量 (字节/微秒 = MB/s) */
+uint32_t timer_counter_mbps(uint32_t bytes, uint32_t delta) {
+    uint32_t mhz = timer_get_frequency() / 1000000;
+    uint32_t us;
+
+    if (mhz == 0) {
+        mhz = 1;
+    }
+    us = delta / mhz;
+    return us ? bytes / us : 0;
+}
+
+/* 开始性能测量 (同时记录PMU计数) */
 timer_benchmark_t timer_benchmark_start(const char *name) {
     timer_benchmark_t bench;
     bench.name = name;
+    pmu_read(&bench.start_pmu);
     bench.start_counter = timer_get_counter();
     return bench;
 }
@@ -252,6 +455,10 @@ timer_benchmark_t timer_benchmark_start(const char *name) {
 /* 结束性能测量并输出结果 */
 void timer_benchmark_end(timer_benchmark_t bench) {
     uint64_t end_counter = timer_get_counter();
+    struct pmu_counts end_pmu, delta;
+    
+    pmu_read(&end_pmu);
+    pmu_sub(&delta, &end_pmu, &bench.start_pmu);
     uint32_t elapsed_cycles = (uint32_t)(end_counter - bench.start_counter);
     /* 使用32位计算避免64位除法 */
     uint32_t freq_mhz = timer_frequency / 1000000; /* 频率转为MHz */
@@ -265,4 +472,8 @@ void timer_benchmark_end(timer_benchmark_t bench) {
     uart_puts(" 周期, ");
     uart_put_hex(elapsed_us);
     uart_puts(" 微秒\r\n");
+    
+    /* CPU周期、指令数、IPC、L1D缺失率、分支预测失败率 */
+    uart_puts("    ");
+    pmu_print_counts(&delta);
 } 
\ No newline at end of file
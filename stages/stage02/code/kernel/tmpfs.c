@@ -0,0 +1,539 @@
+/*
+ * SkyOS tmpfs 内存文件系统
+ * 文件: kernel/tmpfs.c
+ *
+ * 文件数据直接存放在页分配器分配的物理页中，不经过块设备：
+ * - 两级页索引 (顶层页 -> 索引页 -> 数据页)，按页号O(1)定位
+ * - 稀疏文件：未写过的页不分配，读出为0
+ * - 追加写只触及尾页，O(1)
+ * - mmap直接返回后备页地址 (零拷贝)；多页映射要求物理连续，
+ *   不连续时一次性把这些页迁移到一段连续页中，之后read/write/mmap
+ *   访问的都是同一份内存
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "vfs.h"
+#include "page_alloc.h"
+#include "kstring.h"
+#include "syscall.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_hex(uint32_t value);
+
+#define TMPFS_MAX_INODES    VFS_MAX_INODES
+#define TMPFS_MAX_DIRENTS   64
+#define TMPFS_PTRS_PER_PAGE (PAGE_SIZE / sizeof(void *))
+#define TMPFS_INDEX_SHIFT   10      /* log2(TMPFS_PTRS_PER_PAGE) */
+
+struct tmpfs_dirent {
+    char name[VFS_NAME_MAX];
+    struct inode *inode;
+    struct tmpfs_dirent *next;
+};
+
+struct tmpfs_inode {
+    uint32_t used;
+    void ***dir;                    /* 顶层页：指向索引页的指针数组 */
+    uint32_t nr_pages;              /* 已分配的数据页数 */
+    uint32_t mapcount;              /* 活动映射数，>0时页不能移动或释放 */
+    struct tmpfs_dirent *entries;   /* 目录项 (仅目录) */
+    struct tmpfs_dirent *last;
+};
+
+static struct tmpfs_inode tmpfs_inodes[TMPFS_MAX_INODES];
+static struct tmpfs_dirent tmpfs_dirents[TMPFS_MAX_DIRENTS];
+static uint32_t tmpfs_next_ino = 1;
+
+/* 统计 */
+static uint32_t stat_data_pages = 0;
+static uint32_t stat_index_pages = 0;
+static uint32_t stat_mmaps = 0;
+static uint32_t stat_migrations = 0;
+
+static const struct inode_ops tmpfs_dir_iops;
+static const struct inode_ops tmpfs_file_iops;
+static const struct file_ops tmpfs_dir_fops;
+static const struct file_ops tmpfs_file_fops;
+
+static void *tmpfs_zalloc_page(void) {
+    void *page = alloc_page();
+    if (page) {
+        memset(page, 0, PAGE_SIZE);
+    }
+    return page;
+}
+
+/*
+ * 取文件第idx页的数据页指针所在的槽位；create为0且索引页不存在时返回NULL
+ */
+static void **tmpfs_slot(struct tmpfs_inode *ti, uint32_t idx, int create) {
+    uint32_t top = idx >> TMPFS_INDEX_SHIFT;
+
+    if (ti->dir == NULL) {
+        if (!create || (ti->dir = tmpfs_zalloc_page()) == NULL) {
+            return NULL;
+        }
+        stat_index_pages++;
+    }
+    if (ti->dir[top] == NULL) {
+        if (!create || (ti->dir[top] = tmpfs_zalloc_page()) == NULL) {
+            return NULL;
+        }
+        stat_index_pages++;
+    }
+    return &ti->dir[top][idx & (TMPFS_PTRS_PER_PAGE - 1)];
+}
+
+static uint8_t *tmpfs_get_page(struct tmpfs_inode *ti, uint32_t idx, int create) {
+    void **slot = tmpfs_slot(ti, idx, create);
+
+    if (slot == NULL) {
+        return NULL;
+    }
+    if (*slot == NULL && create) {
+        *slot = tmpfs_zalloc_page();
+        if (*slot) {
+            ti->nr_pages++;
+            stat_data_pages++;
+        }
+    }
+    return *slot;
+}
+
+/* 释放页号 >= first 的所有数据页 (以及变空的索引页) */
+static void tmpfs_free_from(struct tmpfs_inode *ti, uint32_t first) {
+    if (ti->dir == NULL) {
+        return;
+    }
+    for (uint32_t top = first >> TMPFS_INDEX_SHIFT; top < TMPFS_PTRS_PER_PAGE; top++) {
+        void **index = ti->dir[top];
+        uint32_t start = 0;
+
+        if (index == NULL) {
+            continue;
+        }
+        if (top == (first >> TMPFS_INDEX_SHIFT)) {
+            start = first & (TMPFS_PTRS_PER_PAGE - 1);
+        }
+        for (uint32_t i = start; i < TMPFS_PTRS_PER_PAGE; i++) {
+            if (index[i]) {
+                free_page(index[i]);
+                index[i] = NULL;
+                ti->nr_pages--;
+                stat_data_pages--;
+            }
+        }
+        if (start == 0) {
+            free_page(index);
+            ti->dir[top] = NULL;
+            stat_index_pages--;
+        }
+    }
+    if (first == 0) {
+        free_page(ti->dir);
+        ti->dir = NULL;
+        stat_index_pages--;
+    }
+}
+
+/* ---------------- inode ---------------- */
+
+static struct inode *tmpfs_new_inode(struct super_block *sb, uint32_t mode) {
+    struct tmpfs_inode *ti = NULL;
+
+    for (uint32_t i = 0; i < TMPFS_MAX_INODES; i++) {
+        if (!tmpfs_inodes[i].used) {
+            ti = &tmpfs_inodes[i];
+            break;
+        }
+    }
+    if (ti == NULL) {
+        return NULL;
+    }
+
+    struct inode *inode = vfs_alloc_inode(sb, tmpfs_next_ino++, mode);
+    if (inode == NULL) {
+        return NULL;
+    }
+    memset(ti, 0, sizeof(*ti));
+    ti->used = 1;
+    inode->private_data = ti;
+    if (mode == VFS_IFDIR) {
+        inode->i_op = &tmpfs_dir_iops;
+        inode->f_op = &tmpfs_dir_fops;
+    } else {
+        inode->i_op = &tmpfs_file_iops;
+        inode->f_op = &tmpfs_file_fops;
+    }
+    return inode;
+}
+
+static void tmpfs_evict_inode(struct inode *inode) {
+    struct tmpfs_inode *ti = inode->private_data;
+
+    if (ti) {
+        tmpfs_free_from(ti, 0);
+        ti->used = 0;
+        inode->private_data = NULL;
+    }
+}
+
+static struct inode *tmpfs_lookup(struct inode *dir, const char *name, uint32_t len) {
+    struct tmpfs_inode *ti = dir->private_data;
+
+    for (struct tmpfs_dirent *de = ti->entries; de; de = de->next) {
+        if (strncmp(de->name, name, len) == 0 && de->name[len] == '\0') {
+            return vfs_iget(de->inode);
+        }
+    }
+    return NULL;
+}
+
+static struct inode *tmpfs_create(struct inode *dir, const char *name, uint32_t len) {
+    struct tmpfs_inode *ti = dir->private_data;
+    struct tmpfs_dirent *de = NULL;
+
+    for (uint32_t i = 0; i < TMPFS_MAX_DIRENTS; i++) {
+        if (tmpfs_dirents[i].inode == NULL) {
+            de = &tmpfs_dirents[i];
+            break;
+        }
+    }
+    if (de == NULL) {
+        return NULL;
+    }
+
+    struct inode *inode = tmpfs_new_inode(dir->sb, VFS_IFREG);
+    if (inode == NULL) {
+        return NULL;
+    }
+
+    /* 目录项持有一个引用，文件在被删除前一直存在 */
+    memcpy(de->name, name, len);
+    de->name[len] = '\0';
+    de->inode = inode;
+    de->next = NULL;
+    if (ti->last) {
+        ti->last->next = de;
+    } else {
+        ti->entries = de;
+    }
+    ti->last = de;
+    dir->size++;
+
+    return vfs_iget(inode);
+}
+
+static int tmpfs_truncate(struct inode *inode, uint32_t size) {
+    struct tmpfs_inode *ti = inode->private_data;
+
+    if (size < inode->size) {
+        if (ti->mapcount) {
+            return -VFS_EBUSY;
+        }
+        tmpfs_free_from(ti, PAGE_ALIGN(size) >> PAGE_SHIFT);
+        /* 尾页中size之后的部分清零，之后再扩展时读到的是0 */
+        if (size & (PAGE_SIZE - 1)) {
+            uint8_t *page = tmpfs_get_page(ti, size >> PAGE_SHIFT, 0);
+            if (page) {
+                memset(page + (size & (PAGE_SIZE - 1)), 0, PAGE_SIZE - (size & (PAGE_SIZE - 1)));
+            }
+        }
+    }
+    inode->size = size;
+    return 0;
+}
+
+/* ---------------- 文件读写 ---------------- */
+
+static int tmpfs_read(struct file *file, void *buf, uint32_t count) {
+    struct inode *inode = file->inode;
+    struct tmpfs_inode *ti = inode->private_data;
+    uint8_t *dst = buf;
+    uint32_t done = 0;
+
+    if (file->pos >= inode->size) {
+        return 0;
+    }
+    if (count > inode->size - file->pos) {
+        count = inode->size - file->pos;
+    }
+
+    while (done < count) {
+        uint32_t off = file->pos & (PAGE_SIZE - 1);
+        uint32_t len = PAGE_SIZE - off;
+        if (len > count - done) len = count - done;
+
+        uint8_t *page = tmpfs_get_page(ti, file->pos >> PAGE_SHIFT, 0);
+        if (page) {
+            memcpy(dst + done, page + off, len);
+        } else {
+            memset(dst + done, 0, len);     /* 空洞 */
+        }
+        done += len;
+        file->pos += len;
+    }
+    return (int)done;
+}
+
+static int tmpfs_write(struct file *file, const void *buf, uint32_t count) {
+    struct inode *inode = file->inode;
+    struct tmpfs_inode *ti = inode->private_data;
+    const uint8_t *src = buf;
+    uint32_t done = 0;
+
+    while (done < count) {
+        uint32_t off = file->pos & (PAGE_SIZE - 1);
+        uint32_t len = PAGE_SIZE - off;
+        if (len > count - done) len = count - done;
+
+        uint8_t *page = tmpfs_get_page(ti, file->pos >> PAGE_SHIFT, 1);
+        if (page == NULL) {
+            break;
+        }
+        memcpy(page + off, src + done, len);
+        done += len;
+        file->pos += len;
+        if (file->pos > inode->size) {
+            inode->size = file->pos;
+        }
+    }
+    if (done == 0 && count > 0) {
+        return -VFS_ENOSPC;
+    }
+    return (int)done;
+}
+
+/*
+ * 把[first, first+n)页迁移到一段物理连续的页中。
+ * 只在文件没有其他映射时调用，所以旧页可以直接释放。
+ */
+static int tmpfs_make_contiguous(struct tmpfs_inode *ti, uint32_t first, uint32_t n) {
+    uint8_t *base = alloc_pages(n);
+
+    if (base == NULL) {
+        return -VFS_ENOMEM;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        void **slot = tmpfs_slot(ti, first + i, 1);
+        if (slot == NULL) {
+            free_pages(base, n);
+            return -VFS_ENOMEM;
+        }
+        if (*slot) {
+            memcpy(base + i * PAGE_SIZE, *slot, PAGE_SIZE);
+            free_page(*slot);
+        } else {
+            memset(base + i * PAGE_SIZE, 0, PAGE_SIZE);
+            ti->nr_pages++;
+            stat_data_pages++;
+        }
+        *slot = base + i * PAGE_SIZE;
+    }
+    stat_migrations++;
+    return 0;
+}
+
+static int tmpfs_mmap(struct file *file, uint32_t offset, uint32_t len, void **addr) {
+    struct tmpfs_inode *ti = file->inode->private_data;
+    uint32_t first = offset >> PAGE_SHIFT;
+    uint32_t n = PAGE_ALIGN(len) >> PAGE_SHIFT;
+    int contiguous = 1;
+    uint8_t *prev = NULL;
+
+    if (offset & (PAGE_SIZE - 1)) {
+        return -VFS_EINVAL;
+    }
+
+    /* 空洞先补上页，映射后通过指针写入的数据才会落在文件里 */
+    for (uint32_t i = 0; i < n; i++) {
+        uint8_t *page = tmpfs_get_page(ti, first + i, 1);
+        if (page == NULL) {
+            return -VFS_ENOMEM;
+        }
+        if (prev && page != prev + PAGE_SIZE) {
+            contiguous = 0;
+        }
+        prev = page;
+    }
+
+    if (!contiguous) {
+        if (ti->mapcount) {
+            return -VFS_EBUSY;      /* 已有映射固定了这些页 */
+        }
+        int ret = tmpfs_make_contiguous(ti, first, n);
+        if (ret < 0) {
+            return ret;
+        }
+    }
+
+    *addr = tmpfs_get_page(ti, first, 0);
+    ti->mapcount++;
+    stat_mmaps++;
+    return 0;
+}
+
+static void tmpfs_munmap(struct file *file, void *addr, uint32_t len) {
+    struct tmpfs_inode *ti = file->inode->private_data;
+    (void)addr;
+    (void)len;
+
+    if (ti->mapcount) {
+        ti->mapcount--;
+    }
+}
+
+static int tmpfs_readdir(struct file *file, struct vfs_dirent *dirent) {
+    struct tmpfs_inode *ti = file->inode->private_data;
+    struct tmpfs_dirent *de = ti->entries;
+
+    for (uint32_t i = 0; de && i < file->pos; i++) {
+        de = de->next;
+    }
+    if (de == NULL) {
+        return 0;
+    }
+    memcpy(dirent->name, de->name, VFS_NAME_MAX);
+    dirent->type = de->inode->mode;
+    dirent->size = de->inode->size;
+    file->pos++;
+    return 1;
+}
+
+static const struct inode_ops tmpfs_dir_iops = {
+    .lookup = tmpfs_lookup,
+    .create = tmpfs_create,
+};
+
+static const struct inode_ops tmpfs_file_iops = {
+    .truncate = tmpfs_truncate,
+};
+
+static const struct file_ops tmpfs_dir_fops = {
+    .readdir = tmpfs_readdir,
+};
+
+static const struct file_ops tmpfs_file_fops = {
+    .read = tmpfs_read,
+    .write = tmpfs_write,
+    .mmap = tmpfs_mmap,
+    .munmap = tmpfs_munmap,
+};
+
+static const struct super_ops tmpfs_sops = {
+    .evict_inode = tmpfs_evict_inode,
+};
+
+static int tmpfs_mount(struct super_block *sb, struct blk_device *dev) {
+    (void)dev;
+
+    sb->s_op = &tmpfs_sops;
+    sb->readonly = 0;
+
+    struct inode *root = tmpfs_new_inode(sb, VFS_IFDIR);
+    if (root == NULL) {
+        return -VFS_ENOMEM;
+    }
+    sb->root = vfs_make_root(sb, root);
+    if (sb->root == NULL) {
+        vfs_iput(root);
+        return -VFS_ENOMEM;
+    }
+    return 0;
+}
+
+static struct file_system_type tmpfs_fs_type = {
+    .name = "tmpfs",
+    .mount = tmpfs_mount,
+};
+
+void tmpfs_init(void) {
+    vfs_register_filesystem(&tmpfs_fs_type);
+}
+
+void tmpfs_print_stats(void) {
+    uart_puts("\r\n=== tmpfs统计 ===\r\n");
+    uart_puts("数据页: ");
+    uart_put_hex(stat_data_pages);
+    uart_puts(", 索引页: ");
+    uart_put_hex(stat_index_pages);
+    uart_puts("\r\n");
+    uart_puts("mmap: ");
+    uart_put_hex(stat_mmaps);
+    uart_puts(", 连续化迁移: ");
+    uart_put_hex(stat_migrations);
+    uart_puts("\r\n");
+    uart_puts("=================\r\n");
+}
+
+/* 测试tmpfs：追加写、稀疏文件、mmap零拷贝，全部经由系统调用 */
+void test_tmpfs(void) {
+    static char buf[128];
+    static const char line[] = "tmpfs log line\n";
+
+    uart_puts("\r\n=== 测试tmpfs ===\r\n");
+
+    /* 追加写 */
+    int fd = (int)syscall2(SYS_OPEN, "/tmp/log.txt", O_CREAT | O_WRONLY | O_APPEND);
+    if (fd < 0) {
+        uart_puts("打开/tmp/log.txt失败: ");
+        uart_put_hex((uint32_t)fd);
+        uart_puts("\r\n");
+        uart_puts("=================\r\n");
+        return;
+    }
+    for (int i = 0; i < 300; i++) {
+        vfs_write(fd, line, sizeof(line) - 1);
+    }
+    uart_puts("追加300行后大小: ");
+    uart_put_hex(vfs_get_file(fd)->inode->size);
+    uart_puts("\r\n");
+    syscall1(SYS_CLOSE, fd);
+
+    /* 稀疏文件：在1MB处写4字节，只分配一个数据页 */
+    uint32_t pages_before = stat_data_pages;
+    fd = (int)syscall2(SYS_OPEN, "/tmp/sparse", O_CREAT | O_RDWR);
+    syscall3(SYS_LSEEK, fd, 1024 * 1024, SEEK_SET);
+    syscall3(SYS_WRITE, fd, "END", 4);
+    syscall3(SYS_LSEEK, fd, 4096, SEEK_SET);
+    buf[0] = 0x55;
+    syscall3(SYS_READ, fd, buf, 16);
+    uart_puts("稀疏文件大小: ");
+    uart_put_hex(vfs_get_file(fd)->inode->size);
+    uart_puts(", 新增数据页: ");
+    uart_put_hex(stat_data_pages - pages_before);
+    uart_puts(", 空洞读出: ");
+    uart_put_hex((uint8_t)buf[0]);
+    uart_puts("\r\n");
+    syscall1(SYS_CLOSE, fd);
+
+    /* mmap：通过映射写入，再用read读回 */
+    fd = (int)syscall2(SYS_OPEN, "/tmp/log.txt", O_RDWR);
+    uint32_t addr = syscall3(SYS_MMAP, fd, 0, 2 * PAGE_SIZE);
+    if (VFS_IS_ERR(addr)) {
+        uart_puts("mmap失败: ");
+        uart_put_hex(addr);
+        uart_puts("\r\n");
+    } else {
+        char *map = (char *)addr;
+        map[0] = 'T';
+        map[PAGE_SIZE] = 'X';       /* 跨页写入，要求映射物理连续 */
+
+        syscall3(SYS_LSEEK, fd, 0, SEEK_SET);
+        syscall3(SYS_READ, fd, buf, 4);
+        syscall3(SYS_LSEEK, fd, PAGE_SIZE, SEEK_SET);
+        syscall3(SYS_READ, fd, buf + 4, 1);
+        uart_puts("mmap地址: ");
+        uart_put_hex(addr);
+        uart_puts(", read读回: ");
+        buf[5] = '\0';
+        uart_puts(buf);
+        uart_puts(buf[0] == 'T' && buf[4] == 'X' ? " ✅\r\n" : " ❌\r\n");
+        syscall2(SYS_MUNMAP, addr, 2 * PAGE_SIZE);
+    }
+    syscall1(SYS_CLOSE, fd);
+
+    tmpfs_print_stats();
+}
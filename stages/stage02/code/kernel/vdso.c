@@ -0,0 +1,181 @@
+/*
+ * SkyOS 共享时间页 (vDSO风格)
+ * 文件: kernel/vdso.c
+ *
+ * 1. 时间页是页对齐的静态页，定时器驱动初始化时计算mult/shift并打开PL0计数器访问
+ * 2. 每个滴答在定时器中断中按序号锁更新：ns_last累加上一个滴答的计数器差值，
+ *    与用户库的换算公式相同，读者看到的时间单调不减
+ * 3. mult/shift只用32位运算求出 (内核不链接libgcc，没有64位除法)
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "vdso.h"
+#include "page_alloc.h"
+#include "timer.h"
+#include "hal.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_hex(uint32_t value);
+extern void uart_put_dec(uint32_t value);
+
+#define NSEC_PER_SEC        1000000000u
+#define CNTKCTL_PL0PCTEN    (1 << 0)    /* PL0可读CNTPCT */
+#define CNTKCTL_PL0VCTEN    (1 << 1)    /* PL0可读CNTVCT */
+
+#define VDSO_BENCH_LOOPS    1000
+
+static struct vdso_time_page vdso_time __attribute__((aligned(PAGE_SIZE)));
+
+/* 统计 */
+static uint32_t stat_updates = 0;
+static uint32_t stat_page_lookups = 0;
+
+/*
+ * 求mult/shift使 ns = cycles * mult >> shift：整数部分为1e9/freq，
+ * 小数部分逐位做长除法。shift取不超过VDSO_MAX_SHIFT且mult不溢出32位的最大值
+ */
+static void vdso_calc_mult(uint32_t freq, uint32_t *mult, uint32_t *shift) {
+    uint32_t integer = NSEC_PER_SEC / freq;
+    uint32_t rem = NSEC_PER_SEC % freq;
+    uint32_t s = VDSO_MAX_SHIFT;
+    uint32_t m;
+
+    while (s > 0 && (integer >> (32 - s)) != 0) {
+        s--;
+    }
+    m = integer;
+    for (uint32_t i = 0; i < s; i++) {
+        /* rem * 2 可能超过32位，改为和 freq - rem 比较 */
+        uint32_t bit = rem >= freq - rem;
+        rem = bit ? rem - (freq - rem) : rem * 2;
+        m = (m << 1) | bit;
+    }
+    *mult = m;
+    *shift = s;
+}
+
+/* 定时器驱动probe时调用 */
+void vdso_init(uint32_t freq) {
+    struct vdso_time_page *p = &vdso_time;
+
+    if (freq == 0) {
+        return;
+    }
+    write_cntkctl(read_cntkctl() | CNTKCTL_PL0VCTEN);
+    p->seq++;
+    smp_wmb();
+    p->freq = freq;
+    vdso_calc_mult(freq, &p->mult, &p->shift);
+    p->cycle_last = vdso_read_cntvct();
+    p->ns_last = 0;
+    smp_wmb();
+    p->seq++;
+
+    uart_puts("vDSO时间页: ");
+    uart_put_hex((uint32_t)p);
+    uart_puts(", mult ");
+    uart_put_dec(p->mult);
+    uart_puts(", shift ");
+    uart_put_dec(p->shift);
+    uart_puts("\r\n");
+}
+
+/* 定时器中断中调用 (唯一的写者) */
+void vdso_update(uint32_t ticks) {
+    struct vdso_time_page *p = &vdso_time;
+    uint64_t now;
+
+    if (p->mult == 0) {
+        return;
+    }
+    now = vdso_read_cntvct();
+    p->seq++;
+    smp_wmb();
+    p->ns_last += ((uint64_t)(uint32_t)(now - p->cycle_last) * p->mult) >> p->shift;
+    p->cycle_last = now;
+    p->ticks = ticks;
+    smp_wmb();
+    p->seq++;
+    stat_updates++;
+}
+
+/* 系统调用：返回时间页地址 */
+uint32_t sys_vdso_page(void) {
+    stat_page_lookups++;
+    return (uint32_t)&vdso_time;
+}
+
+void vdso_print_stats(void) {
+    uart_puts("\r\n=== vDSO时间页统计 ===\r\n");
+    uart_puts("更新: ");
+    uart_put_dec(stat_updates);
+    uart_puts(", 取页地址: ");
+    uart_put_dec(stat_page_lookups);
+    uart_puts(", 当前纳秒: ");
+    uart_put_hex((uint32_t)(vdso_time.ns_last >> 32));
+    uart_put_hex((uint32_t)vdso_time.ns_last);
+    uart_puts("\r\n");
+    uart_puts("======================\r\n");
+}
+
+/* 把计数器周期换算成纳秒 (用于打印基准结果) */
+static uint32_t vdso_cycles_to_ns(uint32_t cycles) {
+    return (uint32_t)(((uint64_t)cycles * vdso_time.mult) >> vdso_time.shift);
+}
+
+/* 自检：时间页与系统调用一致、时间单调，以及两种读时间方式的开销 */
+void test_vdso(void) {
+    uint64_t prev, now, start;
+    uint32_t ok = 1, t_sys, t_vdso, ticks;
+    volatile uint32_t sink = 0;
+
+    uart_puts("\r\n=== vDSO时间页自检 ===\r\n");
+    if (vdso_page()->mult == 0) {
+        uart_puts("时间页未初始化 (定时器未探测)\r\n");
+        return;
+    }
+
+    /* 滴答数与SYS_GETTIME一致 (中间可能恰好跨过一个滴答) */
+    ticks = vdso_ticks();
+    ok &= syscall0(SYS_GETTIME) - ticks <= 1;
+
+    /* 单调不减 */
+    prev = vdso_clock_ns();
+    for (uint32_t i = 0; i < VDSO_BENCH_LOOPS; i++) {
+        now = vdso_clock_ns();
+        if (now < prev) {
+            ok = 0;
+        }
+        prev = now;
+    }
+    uart_puts("一致性/单调性: ");
+    uart_puts(ok ? "通过" : "失败");
+    uart_puts("\r\n");
+
+    start = timer_get_counter();
+    for (uint32_t i = 0; i < VDSO_BENCH_LOOPS; i++) {
+        sink += syscall0(SYS_GETTIME);
+    }
+    t_sys = (uint32_t)(timer_get_counter() - start);
+
+    start = timer_get_counter();
+    for (uint32_t i = 0; i < VDSO_BENCH_LOOPS; i++) {
+        sink += (uint32_t)vdso_clock_ns();
+    }
+    t_vdso = (uint32_t)(timer_get_counter() - start);
+    (void)sink;
+
+    uart_puts("SYS_GETTIME: 每次 ");
+    uart_put_dec(vdso_cycles_to_ns(t_sys) / VDSO_BENCH_LOOPS);
+    uart_puts(" ns\r\n");
+    uart_puts("vDSO读取:    每次 ");
+    uart_put_dec(vdso_cycles_to_ns(t_vdso) / VDSO_BENCH_LOOPS);
+    uart_puts(" ns, 快 ");
+    uart_put_dec(t_vdso ? t_sys / t_vdso : 0);
+    uart_puts(" 倍\r\n");
+    uart_puts("结果: ");
+    uart_puts(ok ? "通过" : "失败");
+    uart_puts("\r\n======================\r\n");
+}
@@ -0,0 +1,768 @@
+/*
+ * SkyOS 虚拟文件系统 (VFS)
+ * 文件: kernel/vfs.c
+ *
+ * 功能：
+ * - 文件系统注册与挂载 (按最长路径前缀选择挂载点)
+ * - 路径解析与dentry缓存 (哈希索引，空闲项按需回收)
+ * - inode引用计数
+ * - 打开文件表与文件描述符表 (0/1/2绑定到控制台)
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "vfs.h"
+#include "kstring.h"
+#include "syscall.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_putc(char c);
+extern void uart_put_hex(uint32_t value);
+
+#define VFS_DHASH_SIZE      32
+#define VFS_MOUNT_PATH_MAX  32
+
+/* 已建立的文件映射 (无MMU，映射即文件后备内存的地址) */
+struct vfs_mapping {
+    void *addr;
+    uint32_t len;
+    struct file *file;
+};
+
+struct vfs_mount {
+    char path[VFS_MOUNT_PATH_MAX];
+    uint32_t len;
+    struct super_block *sb;
+};
+
+static struct file_system_type *vfs_filesystems = NULL;
+static struct super_block vfs_supers[VFS_MAX_MOUNTS];
+static struct vfs_mount vfs_mounts[VFS_MAX_MOUNTS];
+static uint32_t vfs_mount_count = 0;
+
+static struct inode vfs_inodes[VFS_MAX_INODES];
+static struct dentry vfs_dentries[VFS_MAX_DENTRIES];
+static struct dentry *vfs_dhash[VFS_DHASH_SIZE];
+static struct file vfs_files[VFS_MAX_FILES];
+static struct file *vfs_fds[VFS_MAX_FDS];
+static struct vfs_mapping vfs_mappings[VFS_MAX_MAPPINGS];
+
+/* 统计 */
+static uint32_t vfs_stat_dcache_hits = 0;
+static uint32_t vfs_stat_dcache_misses = 0;
+static uint32_t vfs_stat_dcache_evictions = 0;
+static uint32_t vfs_stat_opens = 0;
+static uint32_t vfs_stat_mmaps = 0;
+
+/* ---------------- 控制台字符设备 ---------------- */
+
+#define CONSOLE_STDIN   0
+#define CONSOLE_STDOUT  1
+#define CONSOLE_STDERR  2
+
+static int console_read(struct file *file, void *buf, uint32_t count) {
+    char *dst = buf;
+
+    if ((uint32_t)file->private_data != CONSOLE_STDIN || count == 0) {
+        return -VFS_EBADF;
+    }
+
+    /* 简化实现：暂时不支持实际输入，返回模拟数据 */
+    const char *msg = "Hello from kernel input!\n";
+    uint32_t len = 0;
+    while (msg[len] && len < count - 1) {
+        dst[len] = msg[len];
+        len++;
+    }
+    dst[len] = '\0';
+    return len;
+}
+
+static int console_write(struct file *file, const void *buf, uint32_t count) {
+    const char *src = buf;
+    uint32_t stream = (uint32_t)file->private_data;
+    uint32_t written = 0;
+
+    if (stream == CONSOLE_STDIN) {
+        return -VFS_EBADF;
+    }
+    if (stream == CONSOLE_STDERR) {
+        uart_puts("[STDERR] ");
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (src[i] == '\0') break;  /* 遇到字符串结束符停止 */
+        uart_putc(src[i]);
+        written++;
+    }
+    return stream == CONSOLE_STDERR ? (int)count : (int)written;
+}
+
+static const struct file_ops console_fops = {
+    .read = console_read,
+    .write = console_write,
+};
+
+static struct inode console_inode = {
+    .ino = 0,
+    .mode = VFS_IFCHR,
+    .refcnt = 1,
+    .f_op = &console_fops,
+};
+
+/* ---------------- inode ---------------- */
+
+struct inode *vfs_alloc_inode(struct super_block *sb, uint32_t ino, uint32_t mode) {
+    for (uint32_t i = 0; i < VFS_MAX_INODES; i++) {
+        struct inode *inode = &vfs_inodes[i];
+        if (inode->refcnt == 0) {
+            memset(inode, 0, sizeof(*inode));
+            inode->sb = sb;
+            inode->ino = ino;
+            inode->mode = mode;
+            inode->refcnt = 1;
+            return inode;
+        }
+    }
+    return NULL;
+}
+
+struct inode *vfs_iget(struct inode *inode) {
+    if (inode) {
+        inode->refcnt++;
+    }
+    return inode;
+}
+
+void vfs_iput(struct inode *inode) {
+    if (inode == NULL || inode->refcnt == 0) {
+        return;
+    }
+    if (--inode->refcnt == 0 && inode->sb && inode->sb->s_op &&
+        inode->sb->s_op->evict_inode) {
+        inode->sb->s_op->evict_inode(inode);
+    }
+}
+
+/* ---------------- dentry缓存 ---------------- */
+
+static uint32_t vfs_dhashfn(struct dentry *parent, const char *name, uint32_t len) {
+    uint32_t h = (uint32_t)parent;
+    for (uint32_t i = 0; i < len; i++) {
+        h = h * 31 + (uint8_t)name[i];
+    }
+    return (h ^ (h >> 16)) % VFS_DHASH_SIZE;
+}
+
+static void vfs_dhash_remove(struct dentry *d) {
+    uint32_t h = vfs_dhashfn(d->parent, d->name, d->len);
+    struct dentry **pp = &vfs_dhash[h];
+    while (*pp) {
+        if (*pp == d) {
+            *pp = d->hash_next;
+            break;
+        }
+        pp = &(*pp)->hash_next;
+    }
+    d->hash_next = NULL;
+}
+
+/* 回收一个未被使用的叶子dentry (无引用、无缓存子项) */
+static int vfs_dentry_evict_one(void) {
+    for (uint32_t i = 0; i < VFS_MAX_DENTRIES; i++) {
+        struct dentry *d = &vfs_dentries[i];
+        if (d->inode && d->parent && d->refcnt == 0 && d->children == 0) {
+            vfs_dhash_remove(d);
+            d->parent->children--;
+            vfs_iput(d->inode);
+            d->inode = NULL;
+            vfs_stat_dcache_evictions++;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static struct dentry *vfs_dentry_alloc(void) {
+    for (int pass = 0; pass < 2; pass++) {
+        for (uint32_t i = 0; i < VFS_MAX_DENTRIES; i++) {
+            if (vfs_dentries[i].inode == NULL) {
+                memset(&vfs_dentries[i], 0, sizeof(vfs_dentries[i]));
+                return &vfs_dentries[i];
+            }
+        }
+        if (!vfs_dentry_evict_one()) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+struct dentry *vfs_make_root(struct super_block *sb, struct inode *root) {
+    struct dentry *d = vfs_dentry_alloc();
+    if (d == NULL) {
+        return NULL;
+    }
+    d->name[0] = '/';
+    d->len = 1;
+    d->refcnt = 1;              /* 根目录常驻 */
+    d->inode = root;
+    d->sb = sb;
+    return d;
+}
+
+static struct dentry *vfs_d_lookup(struct dentry *parent, const char *name, uint32_t len) {
+    struct dentry *d = vfs_dhash[vfs_dhashfn(parent, name, len)];
+    while (d) {
+        if (d->parent == parent && d->len == len && memcmp(d->name, name, len) == 0) {
+            return d;
+        }
+        d = d->hash_next;
+    }
+    return NULL;
+}
+
+static struct dentry *vfs_d_add(struct dentry *parent, const char *name, uint32_t len,
+                                struct inode *inode) {
+    /* 先固定父目录，防止为新项腾位置时被回收 */
+    parent->refcnt++;
+    struct dentry *d = vfs_dentry_alloc();
+    parent->refcnt--;
+    if (d == NULL) {
+        return NULL;
+    }
+    memcpy(d->name, name, len);
+    d->name[len] = '\0';
+    d->len = len;
+    d->parent = parent;
+    d->inode = inode;
+    d->sb = parent->sb;
+    parent->children++;
+
+    uint32_t h = vfs_dhashfn(parent, name, len);
+    d->hash_next = vfs_dhash[h];
+    vfs_dhash[h] = d;
+    return d;
+}
+
+/* 查找目录项：先查dcache，未命中再调用文件系统的lookup */
+static struct dentry *vfs_lookup_child(struct dentry *parent, const char *name,
+                                       uint32_t len, int create) {
+    struct inode *dir = parent->inode;
+    struct dentry *d = vfs_d_lookup(parent, name, len);
+    if (d) {
+        vfs_stat_dcache_hits++;
+        return d;
+    }
+    vfs_stat_dcache_misses++;
+
+    if (dir->mode != VFS_IFDIR || dir->i_op == NULL || dir->i_op->lookup == NULL) {
+        return NULL;
+    }
+
+    struct inode *inode = dir->i_op->lookup(dir, name, len);
+    if (inode == NULL && create) {
+        if (parent->sb->readonly || dir->i_op->create == NULL) {
+            return NULL;
+        }
+        inode = dir->i_op->create(dir, name, len);
+    }
+    if (inode == NULL) {
+        return NULL;
+    }
+
+    d = vfs_d_add(parent, name, len, inode);
+    if (d == NULL) {
+        vfs_iput(inode);
+    }
+    return d;
+}
+
+/* ---------------- 挂载 ---------------- */
+
+int vfs_register_filesystem(struct file_system_type *fs) {
+    fs->next = vfs_filesystems;
+    vfs_filesystems = fs;
+    return 0;
+}
+
+int vfs_mount(const char *path, const char *fstype, struct blk_device *dev) {
+    struct file_system_type *fs = vfs_filesystems;
+    uint32_t len = strlen(path);
+
+    while (fs && strcmp(fs->name, fstype) != 0) {
+        fs = fs->next;
+    }
+    if (fs == NULL) {
+        return -VFS_ENOENT;
+    }
+    if (vfs_mount_count >= VFS_MAX_MOUNTS || len >= VFS_MOUNT_PATH_MAX) {
+        return -VFS_ENOMEM;
+    }
+
+    struct super_block *sb = &vfs_supers[vfs_mount_count];
+    memset(sb, 0, sizeof(*sb));
+    sb->type = fs;
+    sb->dev = dev;
+
+    int ret = fs->mount(sb, dev);
+    if (ret < 0 || sb->root == NULL) {
+        uart_puts("VFS: 挂载失败 ");
+        uart_puts(fstype);
+        uart_puts(" -> ");
+        uart_puts(path);
+        uart_puts("\r\n");
+        return ret < 0 ? ret : -VFS_EIO;
+    }
+
+    struct vfs_mount *m = &vfs_mounts[vfs_mount_count++];
+    memcpy(m->path, path, len + 1);
+    /* 根挂载点前缀长度记为0，使"/xxx"都能匹配 */
+    m->len = (len == 1 && path[0] == '/') ? 0 : len;
+    m->sb = sb;
+
+    uart_puts("VFS: 已挂载 ");
+    uart_puts(fstype);
+    uart_puts(" 于 ");
+    uart_puts(path);
+    uart_puts("\r\n");
+    return 0;
+}
+
+/* 找到最长前缀匹配的挂载点，返回剩余路径 */
+static struct vfs_mount *vfs_find_mount(const char *path, const char **rest) {
+    struct vfs_mount *best = NULL;
+
+    for (uint32_t i = 0; i < vfs_mount_count; i++) {
+        struct vfs_mount *m = &vfs_mounts[i];
+        if (strncmp(path, m->path, m->len) != 0) {
+            continue;
+        }
+        if (path[m->len] != '\0' && path[m->len] != '/') {
+            continue;
+        }
+        if (best == NULL || m->len > best->len) {
+            best = m;
+        }
+    }
+    if (best) {
+        *rest = path + best->len;
+    }
+    return best;
+}
+
+/* 路径解析：返回最后一个分量的dentry */
+static struct dentry *vfs_path_walk(const char *path, int create, int *err) {
+    const char *p;
+    struct vfs_mount *m;
+
+    if (path == NULL || path[0] != '/') {
+        *err = -VFS_EINVAL;
+        return NULL;
+    }
+    m = vfs_find_mount(path, &p);
+    if (m == NULL) {
+        *err = -VFS_ENOENT;
+        return NULL;
+    }
+
+    struct dentry *d = m->sb->root;
+    while (*p) {
+        while (*p == '/') p++;
+        if (*p == '\0') break;
+
+        const char *name = p;
+        while (*p && *p != '/') p++;
+        uint32_t len = p - name;
+        const char *next = p;
+        while (*next == '/') next++;
+        int last = (*next == '\0');
+
+        if (len >= VFS_NAME_MAX) {
+            *err = -VFS_ENAMETOOLONG;
+            return NULL;
+        }
+        if (len == 1 && name[0] == '.') {
+            continue;
+        }
+        if (len == 2 && name[0] == '.' && name[1] == '.') {
+            if (d->parent) d = d->parent;
+            continue;
+        }
+        if (d->inode->mode != VFS_IFDIR) {
+            *err = -VFS_ENOTDIR;
+            return NULL;
+        }
+
+        d = vfs_lookup_child(d, name, len, create && last);
+        if (d == NULL) {
+            *err = -VFS_ENOENT;
+            return NULL;
+        }
+    }
+    return d;
+}
+
+/* ---------------- 文件描述符 ---------------- */
+
+static struct file *vfs_file_alloc(void) {
+    for (uint32_t i = 0; i < VFS_MAX_FILES; i++) {
+        if (vfs_files[i].refcnt == 0) {
+            memset(&vfs_files[i], 0, sizeof(vfs_files[i]));
+            vfs_files[i].refcnt = 1;
+            return &vfs_files[i];
+        }
+    }
+    return NULL;
+}
+
+static int vfs_fd_alloc(struct file *file) {
+    for (int fd = 0; fd < VFS_MAX_FDS; fd++) {
+        if (vfs_fds[fd] == NULL) {
+            vfs_fds[fd] = file;
+            return fd;
+        }
+    }
+    return -VFS_EMFILE;
+}
+
+struct file *vfs_get_file(int fd) {
+    if (fd < 0 || fd >= VFS_MAX_FDS) {
+        return NULL;
+    }
+    return vfs_fds[fd];
+}
+
+static void vfs_file_put(struct file *file) {
+    if (--file->refcnt > 0) {
+        return;
+    }
+    if (file->f_op && file->f_op->release) {
+        file->f_op->release(file);
+    }
+    if (file->dentry) {
+        file->dentry->refcnt--;
+    }
+}
+
+int vfs_open(const char *path, uint32_t flags) {
+    int err = 0;
+    struct dentry *d = vfs_path_walk(path, flags & O_CREAT, &err);
+    if (d == NULL) {
+        return err;
+    }
+
+    struct inode *inode = d->inode;
+    uint32_t acc = flags & O_ACCMODE;
+    if (inode->mode == VFS_IFDIR && acc != O_RDONLY) {
+        return -VFS_EISDIR;
+    }
+    if (acc != O_RDONLY && d->sb->readonly) {
+        return -VFS_EROFS;
+    }
+
+    struct file *file = vfs_file_alloc();
+    if (file == NULL) {
+        return -VFS_ENFILE;
+    }
+    file->inode = inode;
+    file->dentry = d;
+    file->flags = flags;
+    file->f_op = inode->f_op;
+    d->refcnt++;
+
+    if ((flags & O_TRUNC) && acc != O_RDONLY && inode->i_op && inode->i_op->truncate) {
+        inode->i_op->truncate(inode, 0);
+    }
+    if (file->f_op && file->f_op->open) {
+        err = file->f_op->open(inode, file);
+        if (err < 0) {
+            d->refcnt--;
+            file->refcnt = 0;
+            return err;
+        }
+    }
+
+    int fd = vfs_fd_alloc(file);
+    if (fd < 0) {
+        vfs_file_put(file);
+        return fd;
+    }
+    vfs_stat_opens++;
+    return fd;
+}
+
+/* 为不在目录树中的inode (如管道) 打开文件并分配描述符 */
+int vfs_open_anon(struct inode *inode, uint32_t flags, void *private_data) {
+    struct file *file = vfs_file_alloc();
+    int fd;
+
+    if (file == NULL) {
+        return -VFS_ENFILE;
+    }
+    file->inode = inode;
+    file->flags = flags;
+    file->f_op = inode->f_op;
+    file->private_data = private_data;
+    fd = vfs_fd_alloc(file);
+    if (fd < 0) {
+        file->refcnt = 0;
+        return fd;
+    }
+    vfs_stat_opens++;
+    return fd;
+}
+
+int vfs_close(int fd) {
+    struct file *file = vfs_get_file(fd);
+    if (file == NULL) {
+        return -VFS_EBADF;
+    }
+    vfs_fds[fd] = NULL;
+    vfs_file_put(file);
+    return 0;
+}
+
+int vfs_read(int fd, void *buf, uint32_t count) {
+    struct file *file = vfs_get_file(fd);
+    if (file == NULL || (file->flags & O_ACCMODE) == O_WRONLY) {
+        return -VFS_EBADF;
+    }
+    if (file->inode->mode == VFS_IFDIR) {
+        return -VFS_EISDIR;
+    }
+    if (file->f_op == NULL || file->f_op->read == NULL) {
+        return -VFS_EINVAL;
+    }
+    return file->f_op->read(file, buf, count);
+}
+
+int vfs_write(int fd, const void *buf, uint32_t count) {
+    struct file *file = vfs_get_file(fd);
+    if (file == NULL || (file->flags & O_ACCMODE) == O_RDONLY) {
+        return -VFS_EBADF;
+    }
+    if (file->f_op == NULL || file->f_op->write == NULL) {
+        return -VFS_EINVAL;
+    }
+    if (file->flags & O_APPEND) {
+        file->pos = file->inode->size;
+    }
+    return file->f_op->write(file, buf, count);
+}
+
+int vfs_lseek(int fd, int32_t offset, uint32_t whence) {
+    struct file *file = vfs_get_file(fd);
+    int32_t base;
+
+    if (file == NULL) {
+        return -VFS_EBADF;
+    }
+    switch (whence) {
+        case SEEK_SET: base = 0; break;
+        case SEEK_CUR: base = (int32_t)file->pos; break;
+        case SEEK_END: base = (int32_t)file->inode->size; break;
+        default: return -VFS_EINVAL;
+    }
+    if (base + offset < 0) {
+        return -VFS_EINVAL;
+    }
+    file->pos = (uint32_t)(base + offset);
+    return (int)file->pos;
+}
+
+int vfs_readdir(int fd, struct vfs_dirent *dirent) {
+    struct file *file = vfs_get_file(fd);
+    if (file == NULL) {
+        return -VFS_EBADF;
+    }
+    if (file->inode->mode != VFS_IFDIR) {
+        return -VFS_ENOTDIR;
+    }
+    if (file->f_op == NULL || file->f_op->readdir == NULL) {
+        return -VFS_EINVAL;
+    }
+    return file->f_op->readdir(file, dirent);
+}
+
+/*
+ * 映射文件：成功返回映射地址，失败返回-errno (用VFS_IS_ERR判断)。
+ * 映射持有file引用，关闭fd后映射仍然有效，直到vfs_munmap。
+ */
+uint32_t vfs_mmap(int fd, uint32_t offset, uint32_t len) {
+    struct file *file = vfs_get_file(fd);
+    struct vfs_mapping *m = NULL;
+    void *addr;
+
+    if (file == NULL) {
+        return (uint32_t)-VFS_EBADF;
+    }
+    if (file->f_op == NULL || file->f_op->mmap == NULL || len == 0) {
+        return (uint32_t)-VFS_EINVAL;
+    }
+    for (uint32_t i = 0; i < VFS_MAX_MAPPINGS; i++) {
+        if (vfs_mappings[i].file == NULL) {
+            m = &vfs_mappings[i];
+            break;
+        }
+    }
+    if (m == NULL) {
+        return (uint32_t)-VFS_ENOMEM;
+    }
+
+    int ret = file->f_op->mmap(file, offset, len, &addr);
+    if (ret < 0) {
+        return (uint32_t)ret;
+    }
+    m->addr = addr;
+    m->len = len;
+    m->file = file;
+    file->refcnt++;
+    vfs_stat_mmaps++;
+    return (uint32_t)addr;
+}
+
+int vfs_munmap(void *addr, uint32_t len) {
+    for (uint32_t i = 0; i < VFS_MAX_MAPPINGS; i++) {
+        struct vfs_mapping *m = &vfs_mappings[i];
+        if (m->file && m->addr == addr && m->len == len) {
+            struct file *file = m->file;
+            if (file->f_op->munmap) {
+                file->f_op->munmap(file, addr, len);
+            }
+            m->file = NULL;
+            vfs_file_put(file);
+            return 0;
+        }
+    }
+    return -VFS_EINVAL;
+}
+
+/* 初始化VFS，把fd 0/1/2绑定到控制台 */
+void vfs_init(void) {
+    static const uint32_t console_flags[3] = { O_RDONLY, O_WRONLY, O_WRONLY };
+
+    for (uint32_t i = 0; i < 3; i++) {
+        struct file *file = vfs_file_alloc();
+        file->inode = &console_inode;
+        file->flags = console_flags[i];
+        file->f_op = console_inode.f_op;
+        file->private_data = (void *)i;
+        vfs_fds[i] = file;
+    }
+    uart_puts("VFS初始化完成 (fd 0/1/2 -> 控制台)\r\n");
+}
+
+void vfs_print_stats(void) {
+    uint32_t inodes = 0, dentries = 0, files = 0;
+
+    for (uint32_t i = 0; i < VFS_MAX_INODES; i++) {
+        if (vfs_inodes[i].refcnt) inodes++;
+    }
+    for (uint32_t i = 0; i < VFS_MAX_DENTRIES; i++) {
+        if (vfs_dentries[i].inode) dentries++;
+    }
+    for (uint32_t i = 0; i < VFS_MAX_FILES; i++) {
+        if (vfs_files[i].refcnt) files++;
+    }
+
+    uart_puts("\r\n=== VFS统计 ===\r\n");
+    uart_puts("挂载点: ");
+    uart_put_hex(vfs_mount_count);
+    uart_puts(", inode: ");
+    uart_put_hex(inodes);
+    uart_puts(", dentry: ");
+    uart_put_hex(dentries);
+    uart_puts(", 打开文件: ");
+    uart_put_hex(files);
+    uart_puts("\r\n");
+    uart_puts("dcache命中: ");
+    uart_put_hex(vfs_stat_dcache_hits);
+    uart_puts(", 未命中: ");
+    uart_put_hex(vfs_stat_dcache_misses);
+    uart_puts(", 回收: ");
+    uart_put_hex(vfs_stat_dcache_evictions);
+    uart_puts(", open次数: ");
+    uart_put_hex(vfs_stat_opens);
+    uart_puts(", mmap次数: ");
+    uart_put_hex(vfs_stat_mmaps);
+    uart_puts("\r\n");
+    uart_puts("===============\r\n");
+}
+
+/* 测试VFS：列出根目录，并用系统调用顺序读取第一个普通文件 */
+void test_vfs(void) {
+    static uint8_t read_buf[32 * 1024] __attribute__((aligned(64)));
+    struct vfs_dirent dirent;
+    char path[VFS_NAME_MAX + 2];
+    int found = 0;
+
+    uart_puts("\r\n=== 测试VFS ===\r\n");
+
+    int dfd = (int)syscall2(SYS_OPEN, "/", O_RDONLY);
+    if (dfd < 0) {
+        uart_puts("根文件系统未挂载，跳过 (可用 make fat-disk 生成FAT32镜像)\r\n");
+        uart_puts("===============\r\n");
+        return;
+    }
+    while (vfs_readdir(dfd, &dirent) > 0) {
+        uart_puts(dirent.type == VFS_IFDIR ? "  [DIR]  " : "  [FILE] ");
+        uart_puts(dirent.name);
+        uart_puts("  ");
+        uart_put_hex(dirent.size);
+        uart_puts("\r\n");
+        if (!found && dirent.type == VFS_IFREG && dirent.size > 0) {
+            uint32_t len = strlen(dirent.name);
+            path[0] = '/';
+            memcpy(path + 1, dirent.name, len + 1);
+            found = 1;
+        }
+    }
+    syscall1(SYS_CLOSE, dfd);
+
+    if (!found) {
+        uart_puts("根目录中没有普通文件\r\n");
+        uart_puts("===============\r\n");
+        return;
+    }
+
+    int fd = (int)syscall2(SYS_OPEN, path, O_RDONLY);
+    if (fd < 0) {
+        uart_puts("打开失败: ");
+        uart_puts(path);
+        uart_puts("\r\n");
+        uart_puts("===============\r\n");
+        return;
+    }
+
+    struct blk_device *dev = vfs_get_file(fd)->inode->sb->dev;
+    uint32_t reqs_before = dev->stat_requests;
+    uint32_t total = 0, sum = 0;
+    int n;
+    while ((n = (int)syscall3(SYS_READ, fd, read_buf, sizeof(read_buf))) > 0) {
+        for (int i = 0; i < n; i++) {
+            sum += read_buf[i];
+        }
+        total += n;
+    }
+
+    uart_puts("顺序读取 ");
+    uart_puts(path);
+    uart_puts(": ");
+    uart_put_hex(total);
+    uart_puts(" 字节, 块请求 ");
+    uart_put_hex(dev->stat_requests - reqs_before);
+    uart_puts(", 校验和 ");
+    uart_put_hex(sum);
+    uart_puts("\r\n");
+
+    /* 不对齐的小读取走缓冲区缓存 */
+    syscall3(SYS_LSEEK, fd, 1, SEEK_SET);
+    n = (int)syscall3(SYS_READ, fd, read_buf, 16);
+    uart_puts("偏移1处读取16字节返回: ");
+    uart_put_hex((uint32_t)n);
+    uart_puts("\r\n");
+
+    syscall1(SYS_CLOSE, fd);
+    uart_puts("===============\r\n");
+}
@@ -0,0 +1,94 @@
+/*
+ * SkyOS 等待队列
+ * 文件: kernel/wait.c
+ *
+ * 队列为单链表，按入队顺序唤醒。唤醒时把等待项摘下并task_wake对应任务，
+ * 等待者下一轮wait_prepare会重新入队。队列锁用irqsave获取，
+ * 中断处理程序 (如块设备完成、定时器) 可以直接唤醒。
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "wait.h"
+
+void wait_queue_init(struct wait_queue *wq, const char *name) {
+    spin_lock_init(&wq->lock, name);
+    wq->head = NULL;
+    wq->waits = 0;
+    wq->wakeups = 0;
+}
+
+/* 持有wq->lock时把e从队列中摘下 */
+static void wait_unlink(struct wait_queue *wq, struct wait_entry *e) {
+    struct wait_entry **pp = &wq->head;
+
+    while (*pp) {
+        if (*pp == e) {
+            *pp = e->next;
+            break;
+        }
+        pp = &(*pp)->next;
+    }
+    e->next = NULL;
+    e->queued = 0;
+}
+
+/* 入队 (尚未在队列中时) 并把当前任务设为阻塞，之后再检查等待条件 */
+void wait_prepare(struct wait_queue *wq, struct wait_entry *e, uint32_t key) {
+    struct task *cur = task_current();
+    uint32_t flags = spin_lock_irqsave(&wq->lock);
+
+    if (!e->queued) {
+        struct wait_entry **pp = &wq->head;
+        e->task = cur;
+        e->key = key;
+        e->next = NULL;
+        e->queued = 1;
+        while (*pp) {
+            pp = &(*pp)->next;
+        }
+        *pp = e;
+    }
+    cur->state = TASK_BLOCKED;
+    spin_unlock_irqrestore(&wq->lock, flags);
+}
+
+/* 条件已成立：恢复为就绪并出队 (已被唤醒时不在队列中) */
+void wait_finish(struct wait_queue *wq, struct wait_entry *e) {
+    uint32_t flags = spin_lock_irqsave(&wq->lock);
+
+    e->task->state = TASK_RUNNABLE;
+    if (e->queued) {
+        wait_unlink(wq, e);
+    }
+    spin_unlock_irqrestore(&wq->lock, flags);
+}
+
+/* 阻塞直到被唤醒 */
+void wait_schedule(struct wait_queue *wq) {
+    wq->waits++;
+    task_schedule();
+}
+
+/* 唤醒key匹配 (key为0时不区分) 的最多n个等待者，返回唤醒数 */
+uint32_t wake_up_key(struct wait_queue *wq, uint32_t key, uint32_t n) {
+    uint32_t flags = spin_lock_irqsave(&wq->lock);
+    struct wait_entry **pp = &wq->head;
+    uint32_t woken = 0;
+
+    while (*pp && woken < n) {
+        struct wait_entry *e = *pp;
+        if (key != 0 && e->key != key) {
+            pp = &e->next;
+            continue;
+        }
+        *pp = e->next;
+        e->next = NULL;
+        e->queued = 0;
+        task_wake(e->task);
+        woken++;
+    }
+    wq->wakeups += woken;
+    spin_unlock_irqrestore(&wq->lock, flags);
+    return woken;
+}
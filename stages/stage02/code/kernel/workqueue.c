@@ -0,0 +1,469 @@
+/*
+ * SkyOS 工作窃取工作队列
+ * 文件: kernel/workqueue.c
+ *
+ * Chase-Lev双端队列：bottom只由所有者修改，top由窃取者用CAS推进。
+ * 所有者是"在该CPU上屏蔽IRQ执行的代码"：queue_work (任意上下文) 和
+ * 本CPU的工作线程都在屏蔽IRQ后操作底部，所以中断里排入工作不会和
+ * 工作线程的取出交错。窃取只做CAS，可以从任何CPU、任何线程进行。
+ * 工作线程可能被调度器迁移到其他CPU，取出时总是用当前CPU的队列
+ * (wq_workers[cpu_id()].dq)，而不是线程创建时对应的队列。
+ *
+ * 当前只启动了0号CPU：所有工作线程都在它上面协作运行，排入的工作
+ * 都进入0号队列，其余工作线程靠窃取分担，协议本身不依赖单核。
+ * 工作线程每执行完一项就让出CPU；取到工作后如果还有剩余，再唤醒
+ * 一个空闲的工作线程，突发工作逐个扩散到所有线程。
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "workqueue.h"
+#include "wait.h"
+#include "task.h"
+#include "timer.h"
+#include "atomic.h"
+#include "spinlock.h"
+#include "hal.h"
+
+/* 外部函数声明 */
+extern void uart_puts(const char *str);
+extern void uart_put_hex(uint32_t value);
+extern void uart_put_dec(uint32_t value);
+extern int gic_request_irq(uint32_t irq_id, void (*handler)(uint32_t, void *), void *data);
+extern void gic_free_irq(uint32_t irq_id);
+extern void gic_send_sgi(uint32_t sgi_id, uint32_t target_cpu_mask);
+
+#define WQ_DEQUE_MASK       (WQ_DEQUE_SIZE - 1)
+
+struct wq_deque {
+    volatile uint32_t top;                      /* 窃取端 (CAS) */
+    uint32_t pad[15];                           /* top和bottom放在不同缓存行 */
+    volatile uint32_t bottom;                   /* 所有者端 */
+    struct work_struct *buf[WQ_DEQUE_SIZE];
+} __attribute__((aligned(64)));
+
+struct wq_worker {
+    struct wq_deque dq;
+    struct task *task;
+    uint32_t id;
+    /* 统计 */
+    uint32_t queued;            /* 排入本队列的工作数 */
+    uint32_t executed;          /* 执行的工作数 */
+    uint32_t stolen;            /* 其中窃取来的 */
+    uint32_t steal_races;       /* CAS失败 (与所有者或其他窃取者竞争) */
+    uint32_t sleeps;            /* 无工作可做而睡眠的次数 */
+    uint64_t busy_cycles;       /* 执行工作的CNTPCT计数 */
+    uint64_t start_cycles;
+};
+
+static struct wq_worker wq_workers[WQ_NR_WORKERS];
+static uint32_t wq_running = 0;
+static volatile uint32_t wq_outstanding = 0;        /* 已排入尚未执行完的工作 */
+
+static struct wait_queue wq_idle_wq = WAIT_QUEUE_INIT("wq_idle");
+static struct wait_queue wq_flush_wq = WAIT_QUEUE_INIT("wq_flush");
+
+/* 所有队列都满时的溢出链表 */
+static struct spinlock wq_overflow_lock = SPINLOCK_INIT("wq_overflow");
+static struct work_struct *wq_overflow_head = NULL;
+static struct work_struct **wq_overflow_tail = &wq_overflow_head;
+
+/* 统计 */
+static uint32_t stat_already_pending = 0;
+static uint32_t stat_overflows = 0;
+static uint32_t stat_flushes = 0;
+
+/* 所有者：压入底部，队列满返回-1 */
+static int wq_push(struct wq_deque *dq, struct work_struct *work) {
+    uint32_t b = dq->bottom;
+    uint32_t t = READ_ONCE(dq->top);
+
+    if ((int32_t)(b - t) >= WQ_DEQUE_SIZE) {
+        return -1;
+    }
+    dq->buf[b & WQ_DEQUE_MASK] = work;
+    smp_wmb();                  /* 先写槽位再发布bottom */
+    WRITE_ONCE(dq->bottom, b + 1);
+    return 0;
+}
+
+/* 所有者：从底部取出，与窃取者争最后一项时用CAS裁决 */
+static struct work_struct *wq_pop(struct wq_deque *dq) {
+    uint32_t b = dq->bottom - 1;
+    uint32_t t;
+    struct work_struct *work;
+
+    WRITE_ONCE(dq->bottom, b);
+    smp_mb();                   /* 先声明要取b，再读top */
+    t = READ_ONCE(dq->top);
+    if ((int32_t)(b - t) < 0) {
+        WRITE_ONCE(dq->bottom, b + 1);      /* 空 */
+        return NULL;
+    }
+    work = dq->buf[b & WQ_DEQUE_MASK];
+    if (b == t) {
+        /* 最后一项：和窃取者一样推进top，失败说明已被窃取 */
+        if (atomic_cmpxchg(&dq->top, t, t + 1) != t) {
+            work = NULL;
+        }
+        WRITE_ONCE(dq->bottom, b + 1);
+    }
+    return work;
+}
+
+/* 窃取者：从顶部取一项，*raced表示CAS失败 (应重试或换一个队列) */
+static struct work_struct *wq_steal(struct wq_deque *dq, int *raced) {
+    uint32_t t = READ_ONCE(dq->top);
+    uint32_t b;
+    struct work_struct *work;
+
+    smp_mb();                   /* 先读top再读bottom */
+    b = READ_ONCE(dq->bottom);
+    if ((int32_t)(b - t) <= 0) {
+        return NULL;
+    }
+    work = dq->buf[t & WQ_DEQUE_MASK];
+    if (atomic_cmpxchg(&dq->top, t, t + 1) != t) {
+        *raced = 1;
+        return NULL;
+    }
+    return work;
+}
+
+static int wq_deque_empty(struct wq_deque *dq) {
+    return (int32_t)(READ_ONCE(dq->bottom) - READ_ONCE(dq->top)) <= 0;
+}
+
+/* 是否还有待执行的工作 (wait_event条件，不加锁) */
+static int wq_has_work(void) {
+    for (uint32_t i = 0; i < WQ_NR_WORKERS; i++) {
+        if (!wq_deque_empty(&wq_workers[i].dq)) {
+            return 1;
+        }
+    }
+    return READ_ONCE(wq_overflow_head) != NULL;
+}
+
+/* 排入本CPU的队列；返回1已排入，0已在队列中，-1工作队列尚未启动 */
+int queue_work(struct work_struct *work) {
+    struct wq_worker *wk;
+    uint32_t old, flags;
+
+    if (!wq_running) {
+        return -1;
+    }
+    do {
+        old = READ_ONCE(work->state);
+        if (old & WORK_PENDING) {
+            stat_already_pending++;
+            return 0;
+        }
+    } while (atomic_cmpxchg(&work->state, old, old | WORK_PENDING) != old);
+    atomic_add_return(&wq_outstanding, 1);
+
+    flags = local_irq_save();
+    wk = &wq_workers[cpu_id()];
+    if (wq_push(&wk->dq, work) < 0) {
+        spin_lock(&wq_overflow_lock);
+        work->next = NULL;
+        *wq_overflow_tail = work;
+        wq_overflow_tail = &work->next;
+        stat_overflows++;
+        spin_unlock(&wq_overflow_lock);
+    }
+    wk->queued++;
+    local_irq_restore(flags);
+
+    /* 与工作线程"先入等待队列再检查wq_has_work"配对 */
+    smp_mb();
+    if (READ_ONCE(wq_idle_wq.head)) {
+        wake_up(&wq_idle_wq, 1);
+    }
+    return 1;
+}
+
+static struct work_struct *wq_overflow_pop(void) {
+    struct work_struct *work;
+    uint32_t flags;
+
+    if (READ_ONCE(wq_overflow_head) == NULL) {
+        return NULL;
+    }
+    flags = spin_lock_irqsave(&wq_overflow_lock);
+    work = wq_overflow_head;
+    if (work) {
+        wq_overflow_head = work->next;
+        if (wq_overflow_head == NULL) {
+            wq_overflow_tail = &wq_overflow_head;
+        }
+        work->next = NULL;
+    }
+    spin_unlock_irqrestore(&wq_overflow_lock, flags);
+    return work;
+}
+
+/* 先取本CPU的队列，再从其他队列窃取，最后看溢出链表 */
+static struct work_struct *wq_find_work(struct wq_worker *wk) {
+    struct work_struct *work;
+    uint32_t flags = local_irq_save();
+    uint32_t cpu = cpu_id();
+
+    work = wq_pop(&wq_workers[cpu].dq);
+    local_irq_restore(flags);
+    if (work) {
+        return work;
+    }
+    for (uint32_t n = 1; n < WQ_NR_WORKERS; n++) {
+        struct wq_worker *victim = &wq_workers[(cpu + n) % WQ_NR_WORKERS];
+        int raced;
+
+        do {
+            raced = 0;
+            work = wq_steal(&victim->dq, &raced);
+            if (raced) {
+                wk->steal_races++;
+            }
+        } while (raced);
+        if (work) {
+            wk->stolen++;
+            return work;
+        }
+    }
+    return wq_overflow_pop();
+}
+
+/* 执行一项工作并维护PENDING/RUNNING状态 */
+static void wq_run(struct wq_worker *wk, struct work_struct *work) {
+    uint64_t start = timer_get_counter();
+    uint32_t old;
+
+    /* 执行前清除PENDING，处理函数或中断可以重新排入它 */
+    do {
+        old = READ_ONCE(work->state);
+    } while (atomic_cmpxchg(&work->state, old,
+                            (old & ~WORK_PENDING) | WORK_RUNNING) != old);
+    work->func(work);
+    do {
+        old = READ_ONCE(work->state);
+    } while (atomic_cmpxchg(&work->state, old, old & ~WORK_RUNNING) != old);
+
+    wk->executed++;
+    wk->busy_cycles += timer_get_counter() - start;
+    atomic_add_return(&wq_outstanding, (uint32_t)-1);
+
+    /* 与flush_work"先入等待队列再检查状态"配对 */
+    smp_mb();
+    if (READ_ONCE(wq_flush_wq.head)) {
+        wake_up_all(&wq_flush_wq);
+    }
+}
+
+static void wq_worker_thread(void *arg) {
+    struct wq_worker *wk = arg;
+
+    for (;;) {
+        struct work_struct *work = wq_find_work(wk);
+
+        if (work == NULL) {
+            wk->sleeps++;
+            wait_event(&wq_idle_wq, wq_has_work());
+            continue;
+        }
+        /* 还有剩余工作：叫醒另一个空闲线程来窃取 */
+        if (wq_has_work() && READ_ONCE(wq_idle_wq.head)) {
+            wake_up(&wq_idle_wq, 1);
+        }
+        wq_run(wk, work);
+        task_yield();
+    }
+}
+
+/* 创建工作线程 (task_init之后调用) */
+void workqueue_init(void) {
+    char name[TASK_NAME_MAX] = "kworker/0";
+
+    for (uint32_t i = 0; i < WQ_NR_WORKERS; i++) {
+        struct wq_worker *wk = &wq_workers[i];
+
+        wk->id = i;
+        wk->start_cycles = timer_get_counter();
+        name[8] = (char)('0' + i);
+        wk->task = task_create(name, wq_worker_thread, wk);
+        if (wk->task == NULL) {
+            uart_puts("❌ 工作线程创建失败\r\n");
+        }
+    }
+    wq_running = 1;
+}
+
+/* 等待work执行完 (调用时未排队也未执行则立即返回) */
+void flush_work(struct work_struct *work) {
+    stat_flushes++;
+    wait_event(&wq_flush_wq, READ_ONCE(work->state) == 0);
+}
+
+/* 等待目前排入的所有工作执行完 */
+void flush_workqueue(void) {
+    stat_flushes++;
+    wait_event(&wq_flush_wq, READ_ONCE(wq_outstanding) == 0);
+}
+
+/* part/whole的百分比 (避免64位除法) */
+static uint32_t wq_percent(uint64_t part, uint64_t whole) {
+    while (whole >> 25) {
+        part >>= 1;
+        whole >>= 1;
+    }
+    return whole ? (uint32_t)part * 100 / (uint32_t)whole : 0;
+}
+
+void wq_print_stats(void) {
+    uint64_t now = timer_get_counter();
+
+    uart_puts("\r\n=== 工作队列统计 ===\r\n");
+    for (uint32_t i = 0; i < WQ_NR_WORKERS; i++) {
+        struct wq_worker *wk = &wq_workers[i];
+
+        uart_puts("  kworker/");
+        uart_put_dec(i);
+        uart_puts(": 排入 ");
+        uart_put_dec(wk->queued);
+        uart_puts(", 执行 ");
+        uart_put_dec(wk->executed);
+        uart_puts(" (窃取 ");
+        uart_put_dec(wk->stolen);
+        uart_puts(", 竞争 ");
+        uart_put_dec(wk->steal_races);
+        uart_puts("), 睡眠 ");
+        uart_put_dec(wk->sleeps);
+        uart_puts(", 利用率 ");
+        uart_put_dec(wq_percent(wk->busy_cycles, now - wk->start_cycles));
+        uart_puts("%\r\n");
+    }
+    uart_puts("未完成: ");
+    uart_put_dec(wq_outstanding);
+    uart_puts(", 重复排入: ");
+    uart_put_dec(stat_already_pending);
+    uart_puts(", 溢出: ");
+    uart_put_dec(stat_overflows);
+    uart_puts(", flush: ");
+    uart_put_dec(stat_flushes);
+    uart_puts("\r\n");
+    uart_puts("====================\r\n");
+}
+
+/*
+ * 自检：SGI处理程序一次排入一批工作 (全部进入本CPU的队列)，
+ * 检查每项恰好执行一次，并显示各工作线程分担的数量
+ */
+#define WQ_TEST_SGI         2
+#define WQ_TEST_ITEMS       48
+#define WQ_TEST_SPIN        20000
+
+struct wq_test_item {
+    struct work_struct work;
+    uint32_t runs;
+    uint32_t worker;
+};
+
+static struct wq_test_item wq_test_items[WQ_TEST_ITEMS];
+static volatile uint32_t wq_test_sink = 0;
+static volatile uint32_t wq_test_queued = 0;
+
+static void wq_test_func(struct work_struct *work) {
+    struct wq_test_item *item = container_of(work, struct wq_test_item, work);
+    struct task *cur = task_current();
+    uint32_t x = 0;
+
+    for (uint32_t i = 0; i < WQ_TEST_SPIN; i++) {
+        x = x * 33 + i;
+    }
+    wq_test_sink = x;
+    item->runs++;
+    for (uint32_t i = 0; i < WQ_NR_WORKERS; i++) {
+        if (wq_workers[i].task == cur) {
+            item->worker = i;
+        }
+    }
+}
+
+static void wq_test_sgi(uint32_t irq_id, void *data) {
+    (void)irq_id;
+    (void)data;
+    for (uint32_t i = 0; i < WQ_TEST_ITEMS; i++) {
+        if (queue_work(&wq_test_items[i].work) == 1) {
+            wq_test_queued++;
+        }
+    }
+}
+
+void test_workqueue(void) {
+    uint32_t per_worker[WQ_NR_WORKERS] = { 0 };
+    uint32_t stolen_before = 0, stolen = 0;
+    uint32_t used = 0, ok = 1;
+    uint64_t start;
+
+    uart_puts("\r\n=== 工作队列自检 ===\r\n");
+    if (!wq_running) {
+        uart_puts("工作队列未启动\r\n");
+        return;
+    }
+    for (uint32_t i = 0; i < WQ_TEST_ITEMS; i++) {
+        init_work(&wq_test_items[i].work, wq_test_func);
+        wq_test_items[i].runs = 0;
+        wq_test_items[i].worker = WQ_NR_WORKERS;
+    }
+    for (uint32_t i = 0; i < WQ_NR_WORKERS; i++) {
+        stolen_before += wq_workers[i].stolen;
+    }
+
+    /* 中断里排入的突发工作 */
+    wq_test_queued = 0;
+    start = timer_get_counter();
+    if (gic_request_irq(WQ_TEST_SGI, wq_test_sgi, NULL) == 0) {
+        gic_send_sgi(WQ_TEST_SGI, 1u << cpu_id());
+        for (uint32_t i = 0; i < 100000 && wq_test_queued == 0; i++) {
+            asm volatile("nop");
+        }
+        gic_free_irq(WQ_TEST_SGI);
+    }
+    flush_workqueue();
+
+    for (uint32_t i = 0; i < WQ_TEST_ITEMS; i++) {
+        ok &= wq_test_items[i].runs == 1;
+        if (wq_test_items[i].worker < WQ_NR_WORKERS) {
+            per_worker[wq_test_items[i].worker]++;
+        }
+    }
+    for (uint32_t i = 0; i < WQ_NR_WORKERS; i++) {
+        stolen += wq_workers[i].stolen;
+        used += per_worker[i] != 0;
+    }
+    stolen -= stolen_before;
+    uart_puts("中断中排入: ");
+    uart_put_dec(wq_test_queued);
+    uart_puts(", 耗时 ");
+    uart_put_dec((uint32_t)(timer_get_counter() - start));
+    uart_puts(" 计数, 窃取 ");
+    uart_put_dec(stolen);
+    uart_puts("\r\n分布:");
+    for (uint32_t i = 0; i < WQ_NR_WORKERS; i++) {
+        uart_puts(" ");
+        uart_put_dec(per_worker[i]);
+    }
+    uart_puts(" (");
+    uart_put_dec(used);
+    uart_puts(" 个工作线程参与)\r\n");
+    ok &= wq_test_queued == WQ_TEST_ITEMS;
+
+    /* 重复排入和flush_work */
+    wq_test_items[0].runs = 0;
+    ok &= queue_work(&wq_test_items[0].work) == 1;
+    ok &= queue_work(&wq_test_items[0].work) == 0;
+    flush_work(&wq_test_items[0].work);
+    ok &= wq_test_items[0].runs == 1 && wq_test_items[0].work.state == 0;
+
+    uart_puts("结果: ");
+    uart_puts(ok ? "通过" : "失败");
+    uart_puts("\r\n====================\r\n");
+}
@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+"""
+SkyOS构建配置对比工具
+比较不同构建配置 (make PROFILE=...) 的镜像大小和串口日志中的基准结果
+
+使用方法:
+1. 大小: make size-report
+   等价于 python3 build_profiles.py size default=build/skyos.elf thumb=build/thumb/skyos.elf ...
+2. 基准: make bench-report (每个配置在QEMU中运行BENCH_SECONDS秒并保存日志)
+   等价于 python3 build_profiles.py bench default=build/bench.log thumb=build/thumb/bench.log ...
+
+第一个配置作为基线，其余配置输出相对基线的变化。
+识别的基准输出:
+    ⏱️  <名称>: 0x<周期> 周期, 0x<微秒> 微秒          (timer_benchmark_end，越小越好)
+      <名称>: 逐字节 <a> MB/s, 优化 <b> MB/s          (内存操作基准，越大越好)
+    <名称>: <旧> -> <新> 周期                          (异常向量延迟对比，越小越好)
+    vDSO读取: 每次 <n> ns                              (越小越好)
+"""
+
+import sys
+import re
+import argparse
+import subprocess
+from collections import OrderedDict
+from typing import Dict, List, Tuple
+
+# (正则, 取值函数, 越大越好)
+PATTERNS = [
+    (re.compile(r'^⏱️\s+(.+?): 0x([0-9A-Fa-f]+) 周期'),
+     lambda m: (m.group(1), int(m.group(2), 16)), False),
+    (re.compile(r'^\s*(\S+): 逐字节 \d+ MB/s, 优化 (\d+) MB/s'),
+     lambda m: (m.group(1) + " MB/s", int(m.group(2))), True),
+    (re.compile(r'^(\S+): \d+ -> (\d+) 周期'),
+     lambda m: (m.group(1), int(m.group(2))), False),
+    (re.compile(r'^(vDSO读取):\s+每次 (\d+) ns'),
+     lambda m: (m.group(1) + " ns", int(m.group(2))), False),
+]
+
+BOOT_PROFILE = re.compile(r'^构建配置: (\S+)')
+
+
+def parse_pairs(pairs: List[str]) -> List[Tuple[str, str]]:
+    result = []
+    for p in pairs:
+        name, sep, path = p.partition("=")
+        if not sep:
+            raise SystemExit(f"参数格式应为 <配置>=<文件>: {p}")
+        result.append((name, path))
+    return result
+
+
+def delta(base: int, value: int) -> str:
+    if base == 0:
+        return ""
+    return f"{(value - base) * 100.0 / base:+.1f}%"
+
+
+def elf_size(size_tool: str, path: str) -> Tuple[int, int, int]:
+    """Berkeley格式: text data bss dec hex filename"""
+    out = subprocess.run([size_tool, path], check=True, capture_output=True, text=True).stdout
+    fields = out.strip().splitlines()[-1].split()
+    return int(fields[0]), int(fields[1]), int(fields[2])
+
+
+def cmd_size(args) -> int:
+    rows = [(name, elf_size(args.size_tool, path)) for name, path in parse_pairs(args.files)]
+    base = rows[0][1]
+    print(f"{'配置':<10} {'text':>9} {'data':>8} {'bss':>9}  text变化")
+    for name, (text, data, bss) in rows:
+        print(f"{name:<10} {text:9d} {data:8d} {bss:9d}  {delta(base[0], text)}")
+    return 0
+
+
+def parse_bench(path: str) -> Tuple[str, Dict[str, Tuple[int, bool]]]:
+    results: Dict[str, Tuple[int, bool]] = OrderedDict()
+    profile = "?"
+    with open(path, encoding="utf-8", errors="replace") as f:
+        for line in f:
+            line = line.rstrip("\r\n")
+            m = BOOT_PROFILE.match(line)
+            if m:
+                profile = m.group(1)
+                continue
+            for pattern, extract, higher_better in PATTERNS:
+                m = pattern.match(line)
+                if not m:
+                    continue
+                key, value = extract(m)
+                # 同名基准 (如对齐/不对齐各一组) 依次编号
+                n = 2
+                unique = key
+                while unique in results:
+                    unique = f"{key} #{n}"
+                    n += 1
+                results[unique] = (value, higher_better)
+                break
+    return profile, results
+
+
+def cmd_bench(args) -> int:
+    runs = []
+    for name, path in parse_pairs(args.files):
+        profile, results = parse_bench(path)
+        if profile not in ("?", name):
+            print(f"警告: {path} 是 {profile} 配置的日志", file=sys.stderr)
+        runs.append((name, results))
+
+    base_name, base = runs[0]
+    if not base:
+        print(f"{base_name} 的日志中没有基准结果", file=sys.stderr)
+        return 1
+    width = max(len(k) for k in base) + 2
+    print(f"{'基准':<{width}}" + "".join(f"{name:>16}" for name, _ in runs))
+    for key, (base_value, higher_better) in base.items():
+        line = f"{key:<{width}}{base_value:>16}"
+        for _, results in runs[1:]:
+            if key not in results:
+                line += f"{'-':>16}"
+                continue
+            value = results[key][0]
+            d = delta(base_value, value)
+            better = (value > base_value) == higher_better and value != base_value
+            line += f"{value:>8} {d:>6}{'*' if better else ' '}"
+        print(line)
+    print("(* 表示优于基线)")
+    return 0
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="SkyOS构建配置对比工具")
+    sub = parser.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("size", help="比较各配置的镜像段大小")
+    p.add_argument("--size-tool", default="arm-none-eabi-size")
+    p.add_argument("files", nargs="+", help="<配置>=<skyos.elf>")
+    p.set_defaults(func=cmd_size)
+
+    p = sub.add_parser("bench", help="比较各配置串口日志中的基准结果")
+    p.add_argument("files", nargs="+", help="<配置>=<串口日志>")
+    p.set_defaults(func=cmd_bench)
+
+    args = parser.parse_args()
+    return args.func(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""
+SkyOS采样分析器符号化工具
+把内核profiler_dump()输出的原始样本映射到函数名，生成函数热点表和火焰图折叠格式
+
+使用方法:
+1. 运行内核并保存串口输出: make run | tee build/profile.log
+2. 生成符号表: make symbols (objdump -t 输出 build/skyos.symbols)
+3. 符号化: python3 profile_symbolize.py --symbols build/skyos.symbols build/profile.log
+   或直接: make profile-report
+4. 火焰图: flamegraph.pl build/profile.folded > profile.svg
+5. 热点布局: --hot-list build/hot.list 输出占比不低于--hot-min的函数名，
+   make PROFILE=hot 按此列表把这些函数集中到.text.hot
+
+样本格式 (位于PROF-BEGIN与PROF-END之间):
+    S <cpu> <task> <mode> <pc> <lr>
+"""
+
+import sys
+import re
+import bisect
+import argparse
+from collections import Counter
+from dataclasses import dataclass
+from typing import List, Optional, TextIO
+
+MODE_NAMES = {
+    0x10: "usr",
+    0x11: "fiq",
+    0x12: "irq",
+    0x13: "svc",
+    0x17: "abt",
+    0x1B: "und",
+    0x1F: "sys",
+}
+
+
+@dataclass
+class Symbol:
+    addr: int
+    size: int
+    name: str
+
+
+@dataclass
+class Sample:
+    cpu: int
+    task: int
+    mode: int
+    pc: int
+    lr: int
+
+
+class SymbolTable:
+    """objdump -t 输出的函数符号表，按地址二分查找"""
+
+    # 例: 40000f20 g     F .text	00000058 uart_puts
+    LINE = re.compile(r'^([0-9a-fA-F]{8}) (.{7}) (\S+)\s+([0-9a-fA-F]{8})\s+(\S+)\s*$')
+
+    def __init__(self, symbols: List[Symbol]):
+        self.symbols = sorted(symbols, key=lambda s: s.addr)
+        self.addrs = [s.addr for s in self.symbols]
+
+    @classmethod
+    def from_objdump(cls, f: TextIO) -> "SymbolTable":
+        symbols = []
+        for line in f:
+            m = cls.LINE.match(line.rstrip('\n'))
+            if not m:
+                continue
+            addr, flags, section, size, name = m.groups()
+            # 只要代码段中的函数符号和汇编标签
+            if not section.startswith('.text') and section != '.vectors':
+                continue
+            if 'F' not in flags and 'd' in flags:
+                continue
+            symbols.append(Symbol(int(addr, 16), int(size, 16), name))
+        return cls(symbols)
+
+    def lookup(self, addr: int) -> Optional[str]:
+        i = bisect.bisect_right(self.addrs, addr) - 1
+        if i < 0:
+            return None
+        sym = self.symbols[i]
+        # 有大小的函数符号要求落在范围内；汇编标签(大小为0)取最近的前一个
+        if sym.size and addr >= sym.addr + sym.size:
+            return None
+        return sym.name
+
+    def name(self, addr: int) -> str:
+        return self.lookup(addr) or f"0x{addr:08x}"
+
+
+def parse_samples(f: TextIO) -> List[Sample]:
+    samples = []
+    inside = False
+    for line in f:
+        line = line.strip()
+        if line == "PROF-BEGIN":
+            inside = True
+            continue
+        if line == "PROF-END":
+            inside = False
+            continue
+        if not inside or not line.startswith("S "):
+            continue
+        parts = line.split()
+        if len(parts) != 6:
+            continue
+        try:
+            cpu, task = int(parts[1]), int(parts[2])
+            mode, pc, lr = (int(x, 16) for x in parts[3:6])
+        except ValueError:
+            continue
+        samples.append(Sample(cpu, task, mode, pc, lr))
+    return samples
+
+
+def fold(samples: List[Sample], syms: SymbolTable) -> Counter:
+    """生成 "task-N;模式;调用者;函数" 折叠栈。LR只在叶函数中可靠，
+    与PC同名 (函数内部跳转) 或无法解析时省略调用者一帧"""
+    stacks: Counter = Counter()
+    for s in samples:
+        frames = [f"task-{s.task}", MODE_NAMES.get(s.mode, f"mode-{s.mode:x}")]
+        pc_name = syms.name(s.pc)
+        lr_name = syms.lookup(s.lr) if s.lr else None
+        if lr_name and lr_name != pc_name:
+            frames.append(lr_name)
+        frames.append(pc_name)
+        stacks[";".join(frames)] += 1
+    return stacks
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="SkyOS采样分析器符号化工具")
+    parser.add_argument("log", help="包含PROF-BEGIN/PROF-END的串口日志")
+    parser.add_argument("--symbols", required=True, help="objdump -t 输出 (make symbols)")
+    parser.add_argument("--folded", help="火焰图折叠格式输出文件 (默认输出到stdout)")
+    parser.add_argument("--top", type=int, default=20, help="热点函数表行数")
+    parser.add_argument("--hot-list", help="热点函数列表输出文件 (每行一个函数名)")
+    parser.add_argument("--hot-min", type=float, default=1.0, help="写入热点列表的最低样本占比 (%%)")
+    args = parser.parse_args()
+
+    with open(args.symbols, encoding="utf-8", errors="replace") as f:
+        syms = SymbolTable.from_objdump(f)
+    with open(args.log, encoding="utf-8", errors="replace") as f:
+        samples = parse_samples(f)
+
+    if not samples:
+        print("日志中没有采样数据 (PROF-BEGIN ... PROF-END)", file=sys.stderr)
+        return 1
+
+    total = len(samples)
+    hot = Counter(syms.name(s.pc) for s in samples)
+    print(f"样本数: {total}, 符号数: {len(syms.symbols)}", file=sys.stderr)
+    print(f"{'样本':>8} {'占比':>7}  函数", file=sys.stderr)
+    for name, count in hot.most_common(args.top):
+        print(f"{count:8d} {count * 100.0 / total:6.2f}%  {name}", file=sys.stderr)
+
+    if args.hot_list:
+        # 未解析的地址跳过；汇编标签没有单独的段，写入列表也不会匹配
+        names = [name for name, count in hot.most_common()
+                 if count * 100.0 / total >= args.hot_min and not name.startswith("0x")]
+        with open(args.hot_list, "w", encoding="utf-8") as f:
+            f.write("".join(f"{name}\n" for name in names))
+        print(f"热点函数 {len(names)} 个写入 {args.hot_list}", file=sys.stderr)
+
+    stacks = fold(samples, syms)
+    lines = [f"{stack} {count}" for stack, count in sorted(stacks.items())]
+    if args.folded:
+        with open(args.folded, "w", encoding="utf-8") as f:
+            f.write("\n".join(lines) + "\n")
+    else:
+        print("\n".join(lines))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())